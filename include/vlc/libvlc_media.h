@@ -145,9 +145,33 @@ typedef struct libvlc_media_stats_t
     int         i_sent_packets;
     int         i_sent_bytes;
     float       f_send_bitrate;
+
+    /* Transport stream analysis (MPEG-TS inputs only) */
+    int         i_ts_packets;
+    int         i_ts_sync_losses;
+    int         i_ts_cc_errors;     /**< continuity counter errors */
+    int         i_ts_pcr_errors;    /**< PCR intervals above 40ms or jumps */
+    int         i_ts_pcr_accuracy;  /**< worst PCR deviation, in ns */
+    int         i_ts_psi_errors;    /**< PAT/PMT intervals above 500ms */
+    int         i_ts_scrambled;     /**< scrambled packets */
 } libvlc_media_stats_t;
 /** @}*/
 
+/**
+ * Progress of the media parsing of a LibVLC instance.
+ * The throughput is the difference of i_parsed between two calls to
+ * libvlc_media_parse_get_stats(), divided by the time between them.
+ */
+typedef struct libvlc_media_parse_stats_t
+{
+    unsigned        i_pending;    /**< media not parsed yet */
+    unsigned        i_running;    /**< media being parsed */
+    uint64_t        i_parsed;     /**< media parsed, including timed out ones */
+    uint64_t        i_timed_out;  /**< media whose parsing was aborted */
+    libvlc_time_t   i_parse_time; /**< total parsing time of all the threads,
+                                       in ms */
+} libvlc_media_parse_stats_t;
+
 typedef struct libvlc_media_track_info_t
 {
     /* Codec fourcc */
@@ -678,6 +702,20 @@ LIBVLC_API int
 libvlc_media_parse_with_options( libvlc_media_t *p_md,
                                  libvlc_media_parse_flag_t parse_flag );
 
+/**
+ * Get the progress of the media parsing.
+ *
+ * Media are parsed by several threads (see the "preparse-threads" option),
+ * and parsing one is aborted after "preparse-timeout" milliseconds.
+ *
+ * \param p_instance the instance parsing the media
+ * \param p_stats structure that will be filled
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API void
+libvlc_media_parse_get_stats( libvlc_instance_t *p_instance,
+                              libvlc_media_parse_stats_t *p_stats );
+
 /**
  * Get Parsed status for media descriptor object.
  *
@@ -691,6 +729,47 @@ libvlc_media_parse_with_options( libvlc_media_t *p_md,
 LIBVLC_API int
    libvlc_media_is_parsed( libvlc_media_t *p_md );
 
+/**
+ * Callback prototype for libvlc_media_thumbnails().
+ *
+ * \param opaque private pointer as passed to libvlc_media_thumbnails() [IN]
+ * \param index index of the thumbnail time in the array of times [IN]
+ * \param pixels thumbnail pixels, only valid during the call [IN]
+ * \param width thumbnail width in pixels [IN]
+ * \param height thumbnail height in pixels [IN]
+ * \param pitch length of a thumbnail row in bytes [IN]
+ */
+typedef void (*libvlc_media_thumbnail_cb)(void *opaque, unsigned index,
+                                          const void *pixels,
+                                          unsigned width, unsigned height,
+                                          unsigned pitch);
+
+/**
+ * Extract thumbnails from a media.
+ *
+ * For each time, the media is seeked to the nearest keyframe and only that
+ * frame is decoded and converted. Nothing is played, so this is much faster
+ * than a media player with video memory callbacks. Only regular files and
+ * streams are supported. The method is synchronous. Times that cannot be
+ * seeked to are skipped, except time 0 as long as nothing was decoded yet.
+ *
+ * \param p_md media descriptor object
+ * \param times times of the thumbnails (in ms) [IN]
+ * \param count number of times
+ * \param chroma a packed chroma, such as "RV32" or "RV24"
+ * \param width thumbnail width, 0 to keep the aspect ratio
+ * \param height thumbnail height, 0 to keep the aspect ratio
+ * \param cb callback receiving the thumbnails, in order
+ * \param opaque private pointer for the callback
+ * \return the number of thumbnails extracted, or -1 on error
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API int
+libvlc_media_thumbnails( libvlc_media_t *p_md, const libvlc_time_t *times,
+                         unsigned count, const char *chroma,
+                         unsigned width, unsigned height,
+                         libvlc_media_thumbnail_cb cb, void *opaque );
+
 /**
  * Sets media descriptor's user_data. user_data is specialized data
  * accessed by the host application, VLC.framework uses it as a pointer to
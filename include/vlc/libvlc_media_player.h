@@ -406,6 +406,89 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Callback prototype to register a picture buffer.
+ *
+ * It is invoked once for each buffer, after the format callback, when the
+ * video output starts. The buffer must stay valid until the cleanup callback
+ * and until all the frames it holds are released. The planes must be
+ * aligned on 32-bytes boundaries.
+ *
+ * \param opaque private pointer as set by the @ref libvlc_video_format_cb
+ *               callback [IN]
+ * \param index index of the buffer, less than the number of buffers returned
+ *              by the @ref libvlc_video_format_cb callback [IN]
+ * \param planes start address of the pixel planes (LibVLC allocates the array
+ *             of void pointers, this callback must initialize the array) [OUT]
+ */
+typedef void (*libvlc_video_buffer_cb)(void *opaque, unsigned index,
+                                       void **planes);
+
+/**
+ * A decoded video frame in a registered picture buffer.
+ */
+typedef struct libvlc_video_frame_t libvlc_video_frame_t;
+
+/**
+ * Callback prototype to receive a decoded video frame.
+ *
+ * The frame is handed over ahead of its display deadline. The picture buffer
+ * belongs to the application until the frame is released with
+ * libvlc_video_frame_release(), possibly from another thread; LibVLC does not
+ * write into it in the mean time. Decoding stalls while all buffers are held.
+ *
+ * \param opaque private pointer as set by the @ref libvlc_video_format_cb
+ *               callback [IN]
+ * \param frame the frame, to be released [IN]
+ * \param index index of the picture buffer holding the frame [IN]
+ * \param pts presentation timestamp of the frame in the media
+ *            (in microseconds), or -1 if unknown [IN]
+ * \param deadline date at which the frame is due for display
+ *                 (as per libvlc_clock()) [IN]
+ */
+typedef void (*libvlc_video_frame_cb)(void *opaque,
+                                      libvlc_video_frame_t *frame,
+                                      unsigned index, int64_t pts,
+                                      int64_t deadline);
+
+/**
+ * Set callbacks to render decoded video into buffers owned by the
+ * application, without any copy.
+ *
+ * The format callback selects the format and the number of buffers, then the
+ * buffer callback registers each of them. If the format callback keeps the
+ * proposed chroma and dimensions, and enough buffers are registered (about
+ * 20 for common codecs), the decoders write directly into them. Otherwise,
+ * LibVLC converts the video into the buffers.
+ *
+ * This is mutually exclusive with libvlc_video_set_callbacks().
+ *
+ * \param mp the media player
+ * \param setup callback to select the video format (cannot be NULL)
+ * \param buffer callback to register the picture buffers (cannot be NULL)
+ * \param frame callback to receive the decoded frames (cannot be NULL)
+ * \param cleanup callback to release any allocated resources (or NULL)
+ * \param opaque private pointer for the callbacks (as first parameter)
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_buffer_callbacks( libvlc_media_player_t *mp,
+                                        libvlc_video_format_cb setup,
+                                        libvlc_video_buffer_cb buffer,
+                                        libvlc_video_frame_cb frame,
+                                        libvlc_video_cleanup_cb cleanup,
+                                        void *opaque );
+
+/**
+ * Release a frame received by the @ref libvlc_video_frame_cb callback, giving
+ * its picture buffer back to LibVLC.
+ *
+ * \param frame the frame
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_frame_release( libvlc_video_frame_t *frame );
+
 /**
  * Set the NSView handler where the media player should render its video output.
  *
@@ -555,6 +638,8 @@ LIBVLC_API void libvlc_media_player_set_android_context( libvlc_media_player_t *
  * Callback prototype for audio playback.
  * \param data data pointer as passed to libvlc_audio_set_callbacks() [IN]
  * \param samples pointer to the first audio sample to play back [IN]
+ *                With the planar "FLTP" format, the planes of the channels
+ *                follow each other, each of count samples.
  * \param count number of audio samples to play back
  * \param pts expected play time stamp (see libvlc_delay())
  */
@@ -679,7 +764,7 @@ void libvlc_audio_set_format_callbacks( libvlc_media_player_t *mp,
  *
  * \param mp the media player
  * \param format a four-characters string identifying the sample format
- *               (e.g. "S16N" or "FL32")
+ *               (e.g. "S16N", "FL32" or the planar "FLTP")
  * \param rate sample rate (expressed in Hz)
  * \param channels channels count
  * \version LibVLC 2.0.0 or later
@@ -688,6 +773,42 @@ LIBVLC_API
 void libvlc_audio_set_format( libvlc_media_player_t *mp, const char *format,
                               unsigned rate, unsigned channels );
 
+/**
+ * Set the number of samples per audio playback callback.
+ * This only works in combination with libvlc_audio_set_callbacks().
+ *
+ * Decoded audio is coalesced, and the play callback is invoked with exactly
+ * that many samples, with the time stamp of the first one. Only the last
+ * period before a drain may be shorter. Samples of an incomplete period are
+ * discarded on flush.
+ *
+ * \param mp the media player
+ * \param samples number of samples per period, or 0 to play back the samples
+ *                as they are decoded (default)
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_audio_set_period( libvlc_media_player_t *mp, unsigned samples );
+
+/**
+ * Set a ring buffer to receive the decoded audio samples.
+ * This only works in combination with libvlc_audio_set_period().
+ *
+ * Periods are written one after the other into the buffer, wrapping around
+ * at its end. The play callback points into the buffer, so that the samples
+ * of a period remain readable until the ring wraps around to it.
+ *
+ * \param mp the media player
+ * \param buffer buffer of at least periods times the period size in bytes,
+ *               for the largest channels count accepted by the format callback,
+ *               or NULL to use an internal buffer (default)
+ * \param periods number of periods in the buffer
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_audio_set_ring_buffer( libvlc_media_player_t *mp, void *buffer,
+                                   unsigned periods );
+
 /** \bug This might go away ... to be replaced by a broader system */
 
 /**
@@ -715,6 +836,25 @@ LIBVLC_API libvlc_time_t libvlc_media_player_get_time( libvlc_media_player_t *p_
  */
 LIBVLC_API void libvlc_media_player_set_time( libvlc_media_player_t *p_mi, libvlc_time_t i_time );
 
+/**
+ * Set the movie time (in ms) with frame accuracy.
+ *
+ * Unlike libvlc_media_player_set_time(), this always seeks precisely, even
+ * if fast seeking is enabled. Decoding restarts from the key frame before
+ * the requested time; the frames in between are decoded, without decoding
+ * the non-reference ones when the decoder can skip them, but are neither
+ * filtered nor displayed. The first video frame output is thus the first
+ * one whose timestamp is not before \p i_time.
+ * This is slower than libvlc_media_player_set_time() with long GOPs.
+ * This has no effect if no media is being played.
+ *
+ * \param p_mi the Media Player
+ * \param i_time the movie time (in ms).
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API void libvlc_media_player_set_time_exact( libvlc_media_player_t *p_mi,
+                                                    libvlc_time_t i_time );
+
 /**
  * Get movie position as percentage between 0.0 and 1.0.
  *
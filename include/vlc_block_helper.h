@@ -25,6 +25,9 @@
 #define VLC_BLOCK_HELPER_H 1
 
 #include <vlc_block.h>
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
 
 typedef struct block_bytestream_t
 {
@@ -438,6 +441,77 @@ static inline int block_PeekOffsetBytes( block_bytestream_t *p_bytestream,
     return VLC_SUCCESS;
 }
 
+/* Checks for a startcode at p, possibly cut by the end of the buffer */
+static inline bool block_StartcodeMatches( const uint8_t *p, const uint8_t *end,
+                                           const uint8_t *p_startcode,
+                                           int i_startcode_length )
+{
+    for( int i = 0; i < i_startcode_length && p + i < end; i++ )
+        if( p[i] != p_startcode[i] )
+            return false;
+    return true;
+}
+
+/**
+ * Finds the first position in [p, end) where a startcode begins, either
+ * completely or cut by the end of the buffer.
+ * Startcodes beginning with two zero bytes (MPEG, Annex B) are searched
+ * for several bytes at a time.
+ * \return the position, or end if there is none.
+ */
+static inline const uint8_t *block_FindStartcodeCandidate(
+    const uint8_t *p, const uint8_t *end,
+    const uint8_t *p_startcode, int i_startcode_length )
+{
+    if( i_startcode_length < 2 || p_startcode[0] != 0 || p_startcode[1] != 0 )
+    {
+        while( p < end &&
+               (p = (const uint8_t *)memchr( p, p_startcode[0], end - p )) )
+        {
+            if( block_StartcodeMatches( p, end, p_startcode, i_startcode_length ) )
+                return p;
+            p++;
+        }
+        return end;
+    }
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for( ; end - p >= 16; p += 16 )
+    {
+        const __m128i v = _mm_loadu_si128( (const __m128i *)p );
+        unsigned mask = _mm_movemask_epi8( _mm_cmpeq_epi8( v, zero ) );
+        /* Zero bytes followed by a zero byte, or by the next vector */
+        mask &= (mask >> 1) | 0x8000;
+        for( ; mask; mask &= mask - 1 )
+        {
+            const uint8_t *c = p + ctz( mask );
+            if( block_StartcodeMatches( c, end, p_startcode, i_startcode_length ) )
+                return c;
+        }
+    }
+#else
+    /* Skips words without any zero byte */
+    const size_t ones = ((size_t)-1) / 0xFF;
+    for( ; end - p >= (ptrdiff_t)sizeof(size_t); p += sizeof(size_t) )
+    {
+        size_t v;
+        memcpy( &v, p, sizeof(v) );
+        if( !((v - ones) & ~v & (ones << 7)) )
+            continue;
+        for( unsigned i = 0; i < sizeof(size_t); i++ )
+            if( p[i] == 0 &&
+                block_StartcodeMatches( &p[i], end, p_startcode, i_startcode_length ) )
+                return &p[i];
+    }
+#endif
+    for( ; p < end; p++ )
+        if( *p == 0 &&
+            block_StartcodeMatches( p, end, p_startcode, i_startcode_length ) )
+            return p;
+    return end;
+}
+
 static inline int block_FindStartcodeFromOffset(
     block_bytestream_t *p_bytestream, size_t *pi_offset,
     const uint8_t *p_startcode, int i_startcode_length )
@@ -472,6 +546,18 @@ static inline int block_FindStartcodeFromOffset(
     {
         for( i_offset = i_size; i_offset < p_block->i_buffer; i_offset++ )
         {
+            if( !i_match )
+            {
+                /* Skip to the next possible match in this block */
+                i_offset = block_FindStartcodeCandidate(
+                                &p_block->p_buffer[i_offset],
+                                &p_block->p_buffer[p_block->i_buffer],
+                                p_startcode, i_startcode_length )
+                           - p_block->p_buffer;
+                if( i_offset >= p_block->i_buffer )
+                    break;
+            }
+
             if( p_block->p_buffer[i_offset] == p_startcode[i_match] )
             {
                 if( !i_match )
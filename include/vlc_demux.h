@@ -99,6 +99,57 @@ typedef struct demux_meta_t
     input_attachment_t **attachments;    /**< array of attachments */
 } demux_meta_t;
 
+/**
+ * MPEG-TS analysis counters for one PID (after ETSI TR 101 290).
+ */
+typedef struct
+{
+    uint16_t i_pid;
+    uint64_t i_packets;
+    uint64_t i_cc_errors;       /**< continuity counter errors */
+    uint64_t i_scrambled;       /**< packets with scrambling control set */
+    uint64_t i_bitrate;         /**< average bitrate (bits/s) */
+
+    uint64_t i_pcr;             /**< PCRs received */
+    uint64_t i_pcr_errors;      /**< PCR intervals above 40ms or jumps */
+    mtime_t  i_pcr_interval_max;/**< longest PCR interval (us) */
+    mtime_t  i_pcr_accuracy_max;/**< worst PCR deviation from the
+                                     position in the multiplex (ns) */
+} demux_ts_pid_stats_t;
+
+/**
+ * MPEG-TS analysis counters for one program.
+ */
+typedef struct
+{
+    uint16_t i_number;
+    uint16_t i_pmt_pid;
+    uint16_t i_pcr_pid;
+    uint64_t i_pmt;             /**< PMT sections received */
+    uint64_t i_pmt_errors;      /**< PMT intervals above 500ms */
+    mtime_t  i_pmt_interval_max;/**< longest PMT interval (us) */
+} demux_ts_program_stats_t;
+
+/**
+ * MPEG-TS analysis counters, as returned by DEMUX_GET_TS_STATS.
+ * The arrays are allocated along with the structure: a single free()
+ * releases everything.
+ */
+typedef struct
+{
+    uint64_t i_packets;
+    uint64_t i_sync_losses;
+    uint64_t i_bitrate;         /**< multiplex bitrate (bits/s) */
+    uint64_t i_pat;             /**< PAT sections received */
+    uint64_t i_pat_errors;      /**< PAT intervals above 500ms */
+    mtime_t  i_pat_interval_max;/**< longest PAT interval (us) */
+
+    unsigned i_pids;
+    demux_ts_pid_stats_t *p_pids;
+    unsigned i_programs;
+    demux_ts_program_stats_t *p_programs;
+} demux_ts_stats_t;
+
 enum demux_query_e
 {
     /* I. Common queries to access_demux and demux */
@@ -150,6 +201,9 @@ enum demux_query_e
     DEMUX_GET_SIGNAL, /* arg1=double *pf_quality, arg2=double *pf_strength
                          res=can fail */
 
+    /* Transport stream analysis, the result must be released with free() */
+    DEMUX_GET_TS_STATS, /* arg1= demux_ts_stats_t ** res=can fail */
+
     /* II. Specific access_demux queries */
     /* PAUSE you are ensured that it is never called twice with the same state */
     DEMUX_CAN_PAUSE = 0x1000,   /* arg1= bool*    can fail (assume false)*/
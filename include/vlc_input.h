@@ -275,7 +275,7 @@ struct input_thread_t
  *  - state (\see input_state_e)
  *  - rate
  *  - position, position-offset
- *  - time, time-offset
+ *  - time, time-offset, time-exact
  *  - title, next-title, prev-title
  *  - chapter, next-chapter, next-chapter-prev
  *  - program, audio-es, video-es, spu-es
@@ -508,6 +508,38 @@ VLC_API void input_Stop( input_thread_t * );
 VLC_API int input_Read( vlc_object_t *, input_item_t * );
 #define input_Read(a,b) input_Read(VLC_OBJECT(a),b)
 
+/**
+ * Callback receiving the thumbnails of input_Thumbnails().
+ * \param i_index index of the requested time
+ * \param p_pic the thumbnail, only valid during the call
+ */
+typedef void (*input_thumbnail_cb)( void *p_opaque, size_t i_index,
+                                    picture_t *p_pic );
+
+/**
+ * Extract thumbnails from an item without playing it.
+ *
+ * For each time, the demuxer seeks to the nearest keyframe and only the first
+ * picture decoded from there is converted. There is no clock, audio or video
+ * output involved. This function is blocking and, as for preparsing, only
+ * accepts regular files and streams. Times that cannot be seeked to are
+ * skipped, except time 0 as long as nothing was decoded yet.
+ *
+ * \param pi_times times from the start of the item, in microseconds
+ * \param p_fmt chroma and size of the thumbnails, a null width or height
+ * is computed to keep the aspect ratio
+ * \param pf_thumbnail called for each extracted thumbnail, in order
+ * \return the number of thumbnails extracted, or -1 if the item cannot be
+ * opened
+ */
+VLC_API int input_Thumbnails( vlc_object_t *, input_item_t *,
+                              const mtime_t *pi_times, size_t i_count,
+                              const video_format_t *p_fmt,
+                              input_thumbnail_cb pf_thumbnail,
+                              void *p_opaque );
+#define input_Thumbnails(a,b,c,d,e,f,g) \
+        input_Thumbnails(VLC_OBJECT(a),b,c,d,e,f,g)
+
 VLC_API int input_vaControl( input_thread_t *, int i_query, va_list  );
 
 VLC_API int input_Control( input_thread_t *, int i_query, ...  );
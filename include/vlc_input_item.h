@@ -327,9 +327,31 @@ VLC_API int libvlc_MetaRequest(libvlc_int_t *, input_item_t *,
 VLC_API int libvlc_ArtRequest(libvlc_int_t *, input_item_t *,
                               input_item_meta_request_option_t );
 
+/** Progress of the meta data requests */
+typedef struct input_preparser_stats_t
+{
+    unsigned i_waiting;   /**< items not started yet */
+    unsigned i_running;   /**< items being preparsed */
+    uint64_t i_done;      /**< items preparsed, including the timed out ones */
+    uint64_t i_timeouts;  /**< items aborted after the deadline */
+    mtime_t  i_busy;      /**< total preparsing time, over all the threads */
+} input_preparser_stats_t;
+
+VLC_API void libvlc_MetaRequestStats(libvlc_int_t *, input_preparser_stats_t *);
+
 /******************
  * Input stats
  ******************/
+
+/** Summary of a distribution of samples */
+typedef struct input_stats_distribution_t
+{
+    int64_t i_count;    /**< number of samples */
+    int64_t i_median;
+    int64_t i_p99;      /**< 99th percentile */
+    int64_t i_max;
+} input_stats_distribution_t;
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -364,6 +386,25 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Latencies */
+    input_stats_distribution_t decode_time;     /**< per frame, in us */
+    input_stats_distribution_t display_latency; /**< demux to display, in us */
+    input_stats_distribution_t decoder_queue;   /**< queued blocks */
+
+    /* Live latency budget */
+    int64_t i_latency;          /**< worst demux to output delay, in us */
+    int64_t i_latency_catchups; /**< times played faster to catch up */
+    int64_t i_latency_drops;    /**< times late frames were dropped */
+
+    /* Transport stream analysis, see DEMUX_GET_TS_STATS */
+    int64_t i_ts_packets;
+    int64_t i_ts_sync_losses;
+    int64_t i_ts_cc_errors;     /**< continuity counter errors */
+    int64_t i_ts_pcr_errors;    /**< PCR intervals above 40ms or jumps */
+    int64_t i_ts_pcr_accuracy;  /**< worst PCR deviation, in ns */
+    int64_t i_ts_psi_errors;    /**< PAT/PMT intervals above 500ms */
+    int64_t i_ts_scrambled;     /**< scrambled packets */
 };
 
 #endif
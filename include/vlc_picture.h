@@ -74,6 +74,7 @@ struct picture_t
      * but should never be written directly */
     /**@{*/
     mtime_t         date;                                  /**< display date */
+    mtime_t         pts;             /**< stream timestamp of the display date */
     bool            b_force;
     /**@}*/
 
@@ -36,6 +36,7 @@
 #include <vlc_common.h>
 #include <vlc_input.h>
 #include <vlc_meta.h>
+#include <vlc_picture.h>
 #include <vlc_playlist.h> /* For the preparser */
 #include <vlc_url.h>
 
@@ -246,6 +247,16 @@ static void input_item_preparse_ended( const vlc_event_t * p_event,
     libvlc_media_t * p_md = user_data;
     libvlc_media_list_t *p_subitems = media_get_subitems( p_md, false );
 
+    /* An aborted parsing leaves the media unparsed: let libvlc_media_parse()
+     * return, and the media be parsed again */
+    vlc_mutex_lock( &p_md->parsed_lock );
+    if( !p_md->is_parsed )
+    {
+        p_md->has_asked_preparse = false;
+        vlc_cond_broadcast( &p_md->parsed_cond );
+    }
+    vlc_mutex_unlock( &p_md->parsed_lock );
+
     if( p_subitems != NULL )
     {
         /* notify the media list */
@@ -673,6 +684,14 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     p_stats->i_sent_packets = p_itm_stats->i_sent_packets;
     p_stats->i_sent_bytes = p_itm_stats->i_sent_bytes;
     p_stats->f_send_bitrate = p_itm_stats->f_send_bitrate;
+
+    p_stats->i_ts_packets = p_itm_stats->i_ts_packets;
+    p_stats->i_ts_sync_losses = p_itm_stats->i_ts_sync_losses;
+    p_stats->i_ts_cc_errors = p_itm_stats->i_ts_cc_errors;
+    p_stats->i_ts_pcr_errors = p_itm_stats->i_ts_pcr_errors;
+    p_stats->i_ts_pcr_accuracy = p_itm_stats->i_ts_pcr_accuracy;
+    p_stats->i_ts_psi_errors = p_itm_stats->i_ts_psi_errors;
+    p_stats->i_ts_scrambled = p_itm_stats->i_ts_scrambled;
     vlc_mutex_unlock( &p_itm_stats->lock );
     return true;
 }
@@ -748,7 +767,7 @@ static int media_parse(libvlc_media_t *media, bool b_async,
     if (!b_async)
     {
         vlc_mutex_lock(&media->parsed_lock);
-        while (!media->is_parsed)
+        while (!media->is_parsed && media->has_asked_preparse)
             vlc_cond_wait(&media->parsed_cond, &media->parsed_lock);
         vlc_mutex_unlock(&media->parsed_lock);
     }
@@ -783,6 +802,23 @@ libvlc_media_parse_with_options( libvlc_media_t *media,
     return media_parse( media, true, parse_flag ) == VLC_SUCCESS ? 0 : -1;
 }
 
+/**************************************************************************
+ * Get the progress of the media parsing.
+ **************************************************************************/
+void
+libvlc_media_parse_get_stats( libvlc_instance_t *p_instance,
+                              libvlc_media_parse_stats_t *p_stats )
+{
+    input_preparser_stats_t stats;
+
+    libvlc_MetaRequestStats( p_instance->p_libvlc_int, &stats );
+    p_stats->i_pending = stats.i_waiting;
+    p_stats->i_running = stats.i_running;
+    p_stats->i_parsed = stats.i_done;
+    p_stats->i_timed_out = stats.i_timeouts;
+    p_stats->i_parse_time = from_mtime( stats.i_busy );
+}
+
 /**************************************************************************
  * Get parsed status for media object.
  **************************************************************************/
@@ -797,6 +833,63 @@ libvlc_media_is_parsed(libvlc_media_t *media)
     return parsed;
 }
 
+/**************************************************************************
+ * Extract thumbnails.
+ **************************************************************************/
+struct media_thumbnails
+{
+    libvlc_media_thumbnail_cb cb;
+    void *opaque;
+};
+
+static void media_thumbnail( void *opaque, size_t i_index, picture_t *p_pic )
+{
+    struct media_thumbnails *p_thumbnails = opaque;
+
+    p_thumbnails->cb( p_thumbnails->opaque, i_index, p_pic->p[0].p_pixels,
+                      p_pic->format.i_visible_width,
+                      p_pic->format.i_visible_height, p_pic->p[0].i_pitch );
+}
+
+int
+libvlc_media_thumbnails( libvlc_media_t *p_md, const libvlc_time_t *times,
+                         unsigned count, const char *chroma,
+                         unsigned width, unsigned height,
+                         libvlc_media_thumbnail_cb cb, void *opaque )
+{
+    vlc_fourcc_t i_chroma = vlc_fourcc_GetCodecFromString( VIDEO_ES, chroma );
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( i_chroma );
+    if( p_dsc == NULL || p_dsc->plane_count != 1 )
+    {
+        libvlc_printerr( "Unsupported thumbnail chroma %s", chroma );
+        return -1;
+    }
+
+    mtime_t *pi_times = malloc( count * sizeof( *pi_times ) );
+    if( count > 0 && pi_times == NULL )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+    for( unsigned i = 0; i < count; i++ )
+        pi_times[i] = to_mtime( times[i] );
+
+    video_format_t fmt;
+    video_format_Init( &fmt, i_chroma );
+    fmt.i_width = fmt.i_visible_width = width;
+    fmt.i_height = fmt.i_visible_height = height;
+
+    struct media_thumbnails thumbnails = { cb, opaque };
+    int i_ret = input_Thumbnails( p_md->p_libvlc_instance->p_libvlc_int,
+                                  p_md->p_input_item, pi_times, count, &fmt,
+                                  media_thumbnail, &thumbnails );
+    free( pi_times );
+    if( i_ret < 0 )
+        libvlc_printerr( "Cannot open media" );
+    return i_ret;
+}
+
 /**************************************************************************
  * Sets media descriptor's user_data. user_data is specialized data
  * accessed by the host application, VLC.framework uses it as a pointer to
@@ -568,6 +568,8 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-buffer", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-frame", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-chroma", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
@@ -645,6 +647,9 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "amem-format", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "amem-rate", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "amem-channels", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
+    var_Create (mp, "amem-period", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
+    var_Create (mp, "amem-ring", VLC_VAR_ADDRESS);
+    var_Create (mp, "amem-ring-periods", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
 
     /* Video Title */
     var_Create (mp, "video-title-show", VLC_VAR_BOOL);
@@ -1016,6 +1021,8 @@ void libvlc_video_set_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-lock", lock_cb );
     var_SetAddress( mp, "vmem-unlock", unlock_cb );
     var_SetAddress( mp, "vmem-display", display_cb );
+    var_SetAddress( mp, "vmem-buffer", NULL );
+    var_SetAddress( mp, "vmem-frame", NULL );
     var_SetAddress( mp, "vmem-data", opaque );
     var_SetString( mp, "avcodec-hw", "none" );
     var_SetString( mp, "vout", "vmem" );
@@ -1030,6 +1037,31 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-cleanup", cleanup );
 }
 
+void libvlc_video_set_buffer_callbacks( libvlc_media_player_t *mp,
+                                        libvlc_video_format_cb setup,
+                                        libvlc_video_buffer_cb buffer,
+                                        libvlc_video_frame_cb frame,
+                                        libvlc_video_cleanup_cb cleanup,
+                                        void *opaque )
+{
+    var_SetAddress( mp, "vmem-lock", NULL );
+    var_SetAddress( mp, "vmem-unlock", NULL );
+    var_SetAddress( mp, "vmem-display", NULL );
+    var_SetAddress( mp, "vmem-setup", setup );
+    var_SetAddress( mp, "vmem-buffer", buffer );
+    var_SetAddress( mp, "vmem-frame", frame );
+    var_SetAddress( mp, "vmem-cleanup", cleanup );
+    var_SetAddress( mp, "vmem-data", opaque );
+    var_SetString( mp, "avcodec-hw", "none" );
+    var_SetString( mp, "vout", "vmem" );
+    var_SetString( mp, "window", "none" );
+}
+
+void libvlc_video_frame_release( libvlc_video_frame_t *frame )
+{
+    picture_Release( (picture_t *)frame );
+}
+
 void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
                               unsigned width, unsigned height, unsigned pitch )
 {
@@ -1203,6 +1235,22 @@ void libvlc_audio_set_format( libvlc_media_player_t *mp, const char *format,
     input_resource_ResetAout(mp->input.p_resource);
 }
 
+void libvlc_audio_set_period( libvlc_media_player_t *mp, unsigned samples )
+{
+    var_SetInteger( mp, "amem-period", samples );
+
+    input_resource_ResetAout(mp->input.p_resource);
+}
+
+void libvlc_audio_set_ring_buffer( libvlc_media_player_t *mp, void *buffer,
+                                   unsigned periods )
+{
+    var_SetAddress( mp, "amem-ring", buffer );
+    var_SetInteger( mp, "amem-ring-periods", buffer != NULL ? periods : 0 );
+
+    input_resource_ResetAout(mp->input.p_resource);
+}
+
 
 /**************************************************************************
  * Getters for stream information
@@ -1250,6 +1298,19 @@ void libvlc_media_player_set_time( libvlc_media_player_t *p_mi,
     vlc_object_release( p_input_thread );
 }
 
+void libvlc_media_player_set_time_exact( libvlc_media_player_t *p_mi,
+                                         libvlc_time_t i_time )
+{
+    input_thread_t *p_input_thread;
+
+    p_input_thread = libvlc_get_input_thread ( p_mi );
+    if( !p_input_thread )
+        return;
+
+    var_SetInteger( p_input_thread, "time-exact", to_mtime(i_time) );
+    vlc_object_release( p_input_thread );
+}
+
 void libvlc_media_player_set_position( libvlc_media_player_t *p_mi,
                                        float position )
 {
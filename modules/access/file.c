@@ -44,6 +44,10 @@
 #   include <linux/magic.h>
 #endif
 
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
+
 #if defined( _WIN32 )
 #   include <io.h>
 #   include <ctype.h>
@@ -64,6 +68,32 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 #include <vlc_interrupt.h>
+#include <vlc_atomic.h>
+
+#ifdef HAVE_MMAP
+/* Size of the file mappings, and of the blocks handed out from them */
+# if (SIZE_MAX > UINT32_MAX)
+#  define MMAP_WINDOW_SIZE (32 << 20)
+# else
+#  define MMAP_WINDOW_SIZE (8 << 20)
+# endif
+# define MMAP_BLOCK_SIZE (1 << 20)
+
+/* A file mapping, shared by the blocks pointing into it */
+typedef struct
+{
+    atomic_uint refs;
+    void       *addr;
+    size_t      length;
+    uint64_t    offset;
+} file_window_t;
+
+typedef struct
+{
+    block_t        self;
+    file_window_t *window;
+} file_block_t;
+#endif
 
 struct access_sys_t
 {
@@ -71,6 +101,11 @@ struct access_sys_t
 
     bool b_pace_control;
     uint64_t size;
+
+#ifdef HAVE_MMAP
+    file_window_t *window; /* current mapping, NULL if none */
+    size_t page_size;
+#endif
 };
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -128,12 +163,20 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t FileRead (access_t *, uint8_t *, size_t);
 static int FileSeek (access_t *, uint64_t);
 static ssize_t StreamRead (access_t *, uint8_t *, size_t);
 static int NoSeek (access_t *, uint64_t);
 static int FileControl (access_t *, int, va_list);
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (access_t *);
+static int MmapSeek (access_t *, uint64_t);
+static void WindowRelease (file_window_t *);
+#endif
 
 /*****************************************************************************
  * FileOpen: open the file
@@ -220,7 +263,23 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_MMAP
+    p_sys->window = NULL;
+    p_sys->page_size = sysconf (_SC_PAGESIZE);
 
+    if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap")
+     && !IsRemote(fd, p_access->psz_filepath))
+    {
+        p_access->pf_read = NULL;
+        p_access->pf_block = MmapBlock;
+        p_access->pf_seek = MmapSeek;
+        p_sys->b_pace_control = true;
+        p_sys->size = st.st_size;
+        posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        msg_Dbg (p_access, "mapping file in memory");
+    }
+    else
+#endif
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
         p_access->pf_read = FileRead;
@@ -264,7 +323,7 @@ void FileClose (vlc_object_t * p_this)
 {
     access_t     *p_access = (access_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -272,6 +331,10 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_MMAP
+    if (p_sys->window != NULL)
+        WindowRelease (p_sys->window);
+#endif
     close (p_sys->fd);
     free (p_sys);
 }
@@ -348,6 +411,138 @@ static int NoSeek (access_t *p_access, uint64_t i_pos)
     return VLC_EGENERIC;
 }
 
+#ifdef HAVE_MMAP
+/*****************************************************************************
+ * Memory mapped reading
+ *****************************************************************************
+ * Blocks point directly into large mappings of the file. Each mapping is
+ * reference counted, and unmapped once the access and all the blocks handed
+ * out from it are done with it. Blocks can be passed on to the demuxer and
+ * the decoders, and outlive the access: a mapping stays valid after the
+ * file descriptor is closed, and the release callback stays loaded as
+ * plugins are only unloaded with the module bank.
+ *****************************************************************************/
+static void WindowRelease (file_window_t *window)
+{
+    if (atomic_fetch_sub (&window->refs, 1) == 1)
+    {
+        munmap (window->addr, window->length);
+        free (window);
+    }
+}
+
+static void MmapBlockRelease (block_t *block)
+{
+    file_block_t *fb = (file_block_t *)block;
+
+    WindowRelease (fb->window);
+    free (fb);
+}
+
+/**
+ * Maps the window containing a given file offset.
+ */
+static file_window_t *WindowMap (access_t *p_access, uint64_t pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t offset = pos - (pos % p_sys->page_size);
+    size_t length = MMAP_WINDOW_SIZE;
+
+    if (offset + length > p_sys->size)
+        length = p_sys->size - offset;
+
+    file_window_t *window = malloc (sizeof (*window));
+    if (unlikely(window == NULL))
+        return NULL;
+
+    window->addr = mmap (NULL, length, PROT_READ, MAP_SHARED, p_sys->fd,
+                         offset);
+    if (window->addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        free (window);
+        return NULL;
+    }
+    atomic_init (&window->refs, 1);
+    window->length = length;
+    window->offset = offset;
+
+    posix_madvise (window->addr, length, POSIX_MADV_SEQUENTIAL);
+    /* Start reading the next window ahead */
+    if (offset + length < p_sys->size)
+        posix_fadvise (p_sys->fd, offset + length, MMAP_WINDOW_SIZE,
+                       POSIX_FADV_WILLNEED);
+    return window;
+}
+
+static block_t *MmapBlock (access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t pos = p_access->info.i_pos;
+
+    if (pos >= p_sys->size)
+    {   /* The file may still be growing */
+        struct stat st;
+
+        if (fstat (p_sys->fd, &st) == 0)
+            p_sys->size = st.st_size;
+        if (pos >= p_sys->size)
+        {
+            p_access->info.b_eof = true;
+            return NULL;
+        }
+    }
+
+    file_window_t *window = p_sys->window;
+    if (window == NULL || pos < window->offset
+     || pos >= window->offset + window->length)
+    {
+        if (window != NULL)
+            WindowRelease (window);
+        p_sys->window = window = WindowMap (p_access, pos);
+        if (window == NULL)
+        {
+            p_access->info.b_eof = true;
+            return NULL;
+        }
+    }
+
+    file_block_t *fb = malloc (sizeof (*fb));
+    if (unlikely(fb == NULL))
+        return NULL;
+
+    size_t skip = pos - window->offset;
+    size_t length = __MIN(window->length - skip, MMAP_BLOCK_SIZE);
+    uint8_t *buf = (uint8_t *)window->addr + skip;
+
+    block_Init (&fb->self, buf, length);
+    fb->self.pf_release = MmapBlockRelease;
+    fb->window = window;
+    atomic_fetch_add (&window->refs, 1);
+
+    /* Hint the following block so that page faults do not stall reading */
+    if (skip + length < window->length)
+    {
+        size_t next = skip + length;
+        size_t page = next - (next % p_sys->page_size);
+
+        posix_madvise ((uint8_t *)window->addr + page,
+                       __MIN(window->length - page, MMAP_BLOCK_SIZE),
+                       POSIX_MADV_WILLNEED);
+    }
+
+    p_access->info.i_pos += length;
+    return &fb->self;
+}
+
+static int MmapSeek (access_t *p_access, uint64_t i_pos)
+{
+    p_access->info.i_pos = i_pos;
+    p_access->info.b_eof = false;
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Control:
  *****************************************************************************/
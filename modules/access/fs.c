@@ -30,12 +30,21 @@
 #include "fs.h"
 #include <vlc_plugin.h>
 
+#define MMAP_TEXT N_("Map local files in memory")
+#define MMAP_LONGTEXT N_( \
+    "Read local files through memory mappings instead of copying them. " \
+    "This is faster for high bitrate files on fast storage, but the file " \
+    "must not be truncated while it is being read." )
+
 vlc_module_begin ()
     set_description( N_("File input") )
     set_shortname( N_("File") )
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_obsolete_string( "file-cat" )
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, MMAP_TEXT, MMAP_LONGTEXT, true )
+#endif
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
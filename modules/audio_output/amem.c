@@ -49,6 +49,14 @@ vlc_module_begin ()
                  N_("Channels count"), N_("Channels count"), false)
         change_integer_range (1, AOUT_CHAN_MAX)
         change_private()
+    add_integer ("amem-period", 0,
+                 N_("Period size"), N_("Period size"), false)
+        change_integer_range (0, 1 << 20)
+        change_private()
+    add_integer ("amem-ring-periods", 0,
+                 N_("Ring buffer periods"), N_("Ring buffer periods"), false)
+        change_integer_range (0, 1 << 16)
+        change_private()
 
 vlc_module_end ()
 
@@ -78,14 +86,140 @@ struct aout_sys_t
     float volume;
     bool mute;
     bool ready;
+
+    /* Output layout */
+    unsigned frame_rate;
+    unsigned frame_channels;
+    unsigned sample_size;
+    bool planar;
+
+    /* Batching: samples are coalesced into periods of a fixed size, within
+     * a ring of periods that is either provided by the application or
+     * reduced to a single internal period. */
+    unsigned period;
+    unsigned fill; /**< samples in the current period */
+    unsigned slot; /**< current period in the ring */
+    unsigned slots;
+    int64_t period_pts;
+    uint8_t *ring;
+    uint8_t *buffer; /**< internal buffer, if any */
+    size_t buffer_size;
 };
 
+/**
+ * Splits interleaved samples into planes, each plane_size samples apart.
+ */
+static void Deinterleave (uint8_t *dst, size_t plane_size, const uint8_t *src,
+                          unsigned count, unsigned channels, unsigned size)
+{
+    if (size == 4)
+    {
+        const uint32_t *in = (const uint32_t *)src;
+
+        for (unsigned c = 0; c < channels; c++)
+        {
+            uint32_t *out = (uint32_t *)dst + c * plane_size;
+
+            for (unsigned i = 0; i < count; i++)
+                out[i] = in[i * channels + c];
+        }
+    }
+    else
+    {
+        const uint16_t *in = (const uint16_t *)src;
+
+        assert (size == 2);
+        for (unsigned c = 0; c < channels; c++)
+        {
+            uint16_t *out = (uint16_t *)dst + c * plane_size;
+
+            for (unsigned i = 0; i < count; i++)
+                out[i] = in[i * channels + c];
+        }
+    }
+}
+
+/**
+ * Hands the current period over to the application and moves to the next
+ * one in the ring.
+ */
+static void Emit (aout_sys_t *sys)
+{
+    const size_t frame_size = sys->frame_channels * sys->sample_size;
+    uint8_t *data = sys->ring + sys->slot * sys->period * frame_size;
+    unsigned count = sys->fill;
+
+    if (sys->planar && count < sys->period)
+    {   /* Partial period on drain: keep the planes contiguous */
+        for (unsigned c = 1; c < sys->frame_channels; c++)
+            memmove (data + c * count * sys->sample_size,
+                     data + c * sys->period * sys->sample_size,
+                     count * sys->sample_size);
+    }
+
+    sys->play (sys->opaque, data, count, sys->period_pts);
+    sys->fill = 0;
+    if (++sys->slot >= sys->slots)
+        sys->slot = 0;
+}
+
 static void Play (audio_output_t *aout, block_t *block)
 {
     aout_sys_t *sys = aout->sys;
+    const size_t frame_size = sys->frame_channels * sys->sample_size;
+
+    if (sys->period == 0)
+    {
+        const void *data = block->p_buffer;
+
+        if (sys->planar)
+        {
+            if (block->i_buffer > sys->buffer_size)
+            {
+                void *buffer = realloc (sys->buffer, block->i_buffer);
+                if (unlikely(buffer == NULL))
+                {
+                    block_Release (block);
+                    return;
+                }
+                sys->buffer = buffer;
+                sys->buffer_size = block->i_buffer;
+            }
+            Deinterleave (sys->buffer, block->i_nb_samples, block->p_buffer,
+                          block->i_nb_samples, sys->frame_channels,
+                          sys->sample_size);
+            data = sys->buffer;
+        }
+        sys->play (sys->opaque, data, block->i_nb_samples, block->i_pts);
+        block_Release (block);
+        return;
+    }
+
+    const uint8_t *src = block->p_buffer;
+    unsigned offset = 0;
 
-    sys->play (sys->opaque, block->p_buffer, block->i_nb_samples,
-               block->i_pts);
+    while (offset < block->i_nb_samples)
+    {
+        uint8_t *dst = sys->ring + sys->slot * sys->period * frame_size;
+        unsigned count = __MIN(block->i_nb_samples - offset,
+                               sys->period - sys->fill);
+
+        if (sys->fill == 0)
+            sys->period_pts = block->i_pts
+                            + CLOCK_FREQ * (mtime_t)offset / sys->frame_rate;
+
+        if (sys->planar)
+            Deinterleave (dst + sys->fill * sys->sample_size, sys->period,
+                          src, count, sys->frame_channels, sys->sample_size);
+        else
+            memcpy (dst + sys->fill * frame_size, src, count * frame_size);
+
+        src += count * frame_size;
+        offset += count;
+        sys->fill += count;
+        if (sys->fill == sys->period)
+            Emit (sys);
+    }
     block_Release (block);
 }
 
@@ -103,6 +237,11 @@ static void Flush (audio_output_t *aout, bool wait)
     aout_sys_t *sys = aout->sys;
     void (*cb) (void *) = wait ? sys->drain : sys->flush;
 
+    /* Pending samples of an incomplete period are played on drain only */
+    if (wait && sys->fill > 0)
+        Emit (sys);
+    sys->fill = 0;
+
     if (cb != NULL)
         cb (sys->opaque);
 }
@@ -155,6 +294,10 @@ static void Stop (audio_output_t *aout)
     if (sys->cleanup != NULL)
         sys->cleanup (sys->opaque);
     sys->ready = false;
+
+    free (sys->buffer);
+    sys->buffer = NULL;
+    sys->buffer_size = 0;
 }
 
 static int Start (audio_output_t *aout, audio_sample_format_t *fmt)
@@ -173,6 +316,12 @@ static int Start (audio_output_t *aout, audio_sample_format_t *fmt)
     }
     else
     {
+        char *str = var_InheritString (aout, "amem-format");
+        if (str != NULL)
+        {
+            strncpy (format, str, 4);
+            free (str);
+        }
         fmt->i_rate = sys->rate;
         channels = sys->channels;
     }
@@ -183,9 +332,22 @@ static int Start (audio_output_t *aout, audio_sample_format_t *fmt)
         sys->set_volume(sys->opaque, sys->volume, sys->mute);
 
     /* Ensure that format is supported */
+    vlc_fourcc_t codec = 0;
+    bool planar = false;
+
+    if (!strcmp (format, "S16N"))
+        codec = VLC_CODEC_S16N;
+    else if (!strcmp (format, "FL32"))
+        codec = VLC_CODEC_FL32;
+    else if (!strcmp (format, "FLTP"))
+    {   /* Planar float, split from the interleaved mixer output */
+        codec = VLC_CODEC_FL32;
+        planar = true;
+    }
+
     if (fmt->i_rate == 0 || fmt->i_rate > 192000
      || channels == 0 || channels > AOUT_CHAN_MAX
-     || strcmp(format, "S16N") /* TODO: amem-format */)
+     || codec == 0)
     {
         msg_Err (aout, "format not supported: %s, %u channel(s), %u Hz",
                  format, channels, fmt->i_rate);
@@ -227,8 +389,35 @@ static int Start (audio_output_t *aout, audio_sample_format_t *fmt)
             vlc_assert_unreachable();
     }
 
-    fmt->i_format = VLC_CODEC_S16N;
+    fmt->i_format = codec;
     fmt->i_original_channels = fmt->i_physical_channels;
+
+    sys->frame_rate = fmt->i_rate;
+    sys->frame_channels = channels;
+    sys->sample_size = aout_BitsPerSample (codec) / 8;
+    sys->planar = planar;
+    sys->fill = 0;
+    sys->slot = 0;
+
+    if (sys->period > 0)
+    {
+        sys->ring = var_InheritAddress (aout, "amem-ring");
+        sys->slots = var_InheritInteger (aout, "amem-ring-periods");
+        if (sys->ring == NULL || sys->slots == 0)
+        {
+            sys->buffer_size = sys->period * channels * sys->sample_size;
+            sys->buffer = malloc (sys->buffer_size);
+            if (unlikely(sys->buffer == NULL))
+            {
+                Stop (aout);
+                return VLC_ENOMEM;
+            }
+            sys->ring = sys->buffer;
+            sys->slots = 1;
+        }
+        msg_Dbg (aout, "playing periods of %u samples in a ring of %u",
+                 sys->period, sys->slots);
+    }
     return VLC_SUCCESS;
 }
 
@@ -262,6 +451,9 @@ static int Open (vlc_object_t *obj)
     sys->volume = 1.;
     sys->mute = false;
     sys->ready = false;
+    sys->period = var_InheritInteger (obj, "amem-period");
+    sys->buffer = NULL;
+    sys->buffer_size = 0;
     if (sys->play == NULL)
     {
         free (sys);
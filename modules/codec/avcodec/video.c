@@ -551,11 +551,16 @@ static picture_t *DecodeVideo( decoder_t *p_dec, block_t **pp_block )
 
         if( p_block->i_flags & BLOCK_FLAG_PREROLL )
         {
-            /* Do not care about late frames when prerolling
-             * TODO avoid decoding of non reference frame
-             * (ie all B except for H264 where it depends only on nal_ref_idc) */
+            /* Do not care about late frames when prerolling */
             p_sys->i_late_frames = 0;
+            /* Nothing before the preroll end is displayed, so frames that
+             * are not referenced do not need to be decoded at all
+             * (ie all B except for H264 where it depends only on nal_ref_idc) */
+            p_context->skip_frame = __MAX( p_sys->i_skip_frame,
+                                           AVDISCARD_NONREF );
         }
+        else
+            p_context->skip_frame = p_sys->i_skip_frame;
     }
 
     if( p_dec->b_frame_drop_allowed && (p_sys->i_late_frames > 0) &&
@@ -1777,6 +1777,32 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
     msg_rc(_("| sending bitrate  :   %6.0f kb/s"),
             (float)(p_item->p_stats->f_send_bitrate*8)*1000 );
     msg_rc("|");
+    /* Latencies */
+    msg_rc("%s", _("+-[Latencies]  median / p99 / max"));
+    msg_rc(_("| decoding time    : %6"PRId64" / %6"PRId64" / %6"PRId64" us"),
+            p_item->p_stats->decode_time.i_median,
+            p_item->p_stats->decode_time.i_p99,
+            p_item->p_stats->decode_time.i_max );
+    msg_rc(_("| demux to display : %6"PRId64" / %6"PRId64" / %6"PRId64" ms"),
+            p_item->p_stats->display_latency.i_median / 1000,
+            p_item->p_stats->display_latency.i_p99 / 1000,
+            p_item->p_stats->display_latency.i_max / 1000 );
+    msg_rc(_("| decoder queue    : %6"PRId64" / %6"PRId64" / %6"PRId64" blocks"),
+            p_item->p_stats->decoder_queue.i_median,
+            p_item->p_stats->decoder_queue.i_p99,
+            p_item->p_stats->decoder_queue.i_max );
+    msg_rc("|");
+    if( p_item->p_stats->i_latency > 0 )
+    {
+        msg_rc("%s", _("+-[Live latency]"));
+        msg_rc(_("| demux to output  :    %5"PRId64" ms"),
+                p_item->p_stats->i_latency / 1000 );
+        msg_rc(_("| catch-ups        :    %5"PRIi64),
+                p_item->p_stats->i_latency_catchups );
+        msg_rc(_("| drops            :    %5"PRIi64),
+                p_item->p_stats->i_latency_drops );
+        msg_rc("|");
+    }
     msg_rc( "+----[ end of statistical info ]" );
     vlc_mutex_unlock( &p_item->p_stats->lock );
     vlc_mutex_unlock( &p_item->lock );
@@ -45,6 +45,7 @@
 
 #include "libavi.h"
 #include "../rawdv.h"
+#include "../index_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -2540,6 +2541,113 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
+/* Created indexes are cached as the last chunk position, then for each
+ * track the entry count followed by the entries */
+#define AVI_INDEX_CACHE         "avi-1"
+#define AVI_INDEX_ENTRY_SIZE    (4 + 4 + 8 + 4)
+
+static bool AVI_IndexCacheLoad( demux_t *p_demux, const char *psz_file )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint64_t i_stream_size = stream_Size( p_demux->s );
+    size_t i_size;
+
+    uint8_t *p_data = index_cache_Load( VLC_OBJECT(p_demux), psz_file,
+                                        AVI_INDEX_CACHE, &i_size );
+    if( !p_data )
+        return false;
+
+    const uint8_t *p = p_data;
+    if( i_size < 12 || GetDWBE( &p[8] ) != p_sys->i_track )
+        goto error;
+    off_t i_last_pos = GetQWBE( &p[0] );
+    p += 12;
+    i_size -= 12;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_index = &p_sys->track[i]->idx;
+        off_t i_dummy = 0;
+
+        if( i_size < 4 )
+            goto error;
+        uint32_t i_count = GetDWBE( p );
+        p += 4;
+        i_size -= 4;
+        if( i_size / AVI_INDEX_ENTRY_SIZE < i_count )
+            goto error;
+
+        for( uint32_t j = 0; j < i_count; j++ )
+        {
+            avi_entry_t index;
+            index.i_id      = GetDWLE( &p[0] );
+            index.i_flags   = GetDWBE( &p[4] );
+            index.i_pos     = GetQWBE( &p[8] );
+            index.i_length  = GetDWBE( &p[16] );
+            if( (uint64_t)index.i_pos >= i_stream_size )
+                goto error;
+            avi_index_Append( p_index, &i_dummy, &index );
+            if( p_index->i_size != j + 1 )
+                goto error;
+            p += AVI_INDEX_ENTRY_SIZE;
+            i_size -= AVI_INDEX_ENTRY_SIZE;
+        }
+    }
+    free( p_data );
+
+    if( p_sys->i_movi_lastchunk_pos < i_last_pos )
+        p_sys->i_movi_lastchunk_pos = i_last_pos;
+    return true;
+
+error:
+    msg_Warn( p_demux, "invalid cached index" );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        avi_index_Init( &p_sys->track[i]->idx );
+    }
+    free( p_data );
+    return false;
+}
+
+static void AVI_IndexCacheSave( demux_t *p_demux, const char *psz_file )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    size_t i_size = 12;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        i_size += 4 + (size_t)p_sys->track[i]->idx.i_size * AVI_INDEX_ENTRY_SIZE;
+
+    uint8_t *p_data = malloc( i_size );
+    if( !p_data )
+        return;
+
+    uint8_t *p = p_data;
+    SetQWBE( &p[0], p_sys->i_movi_lastchunk_pos );
+    SetDWBE( &p[8], p_sys->i_track );
+    p += 12;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i]->idx;
+
+        SetDWBE( p, p_index->i_size );
+        p += 4;
+        for( unsigned j = 0; j < p_index->i_size; j++ )
+        {
+            const avi_entry_t *p_entry = &p_index->p_entry[j];
+            SetDWLE( &p[0], p_entry->i_id );
+            SetDWBE( &p[4], p_entry->i_flags );
+            SetQWBE( &p[8], p_entry->i_pos );
+            SetDWBE( &p[16], p_entry->i_length );
+            p += AVI_INDEX_ENTRY_SIZE;
+        }
+    }
+
+    index_cache_Save( VLC_OBJECT(p_demux), psz_file, AVI_INDEX_CACHE,
+                      p_data, i_size );
+    free( p_data );
+}
+
 static void AVI_IndexCreate( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2552,6 +2660,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
     mtime_t i_dialog_update;
     dialog_progress_bar_t *p_dialog = NULL;
+    bool b_cancelled = false;
 
     p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
     p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
@@ -2565,6 +2674,14 @@ static void AVI_IndexCreate( demux_t *p_demux )
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
         avi_index_Init( &p_sys->track[i_stream]->idx );
 
+    /* Reuse the index created the last time this file was opened */
+    char *psz_file = index_cache_GetPath( p_demux );
+    if( psz_file && AVI_IndexCacheLoad( p_demux, psz_file ) )
+    {
+        free( psz_file );
+        goto print_stat;
+    }
+
     i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
                         stream_Size( p_demux->s ) );
 
@@ -2586,7 +2703,10 @@ static void AVI_IndexCreate( demux_t *p_demux )
         if( p_dialog && mdate() - i_dialog_update > 100000 )
         {
             if( dialog_ProgressCancelled( p_dialog ) )
+            {
+                b_cancelled = true;
                 break;
+            }
 
             double f_current = stream_Tell( p_demux->s );
             double f_size    = stream_Size( p_demux->s );
@@ -2625,10 +2745,10 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
                     if( stream_Seek( p_demux->s, p_sysx->i_chunk_pos + 24 ) )
-                        goto print_stat;
+                        goto end;
                     break;
                 }
-                goto print_stat;
+                goto end;
 
             case AVIFOURCC_RIFF:
                     msg_Dbg( p_demux, "new RIFF chunk found" );
@@ -2643,7 +2763,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
                 if( AVI_PacketSearch( p_demux ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
-                    goto print_stat;
+                    goto end;
                 }
             }
         }
@@ -2655,6 +2775,11 @@ static void AVI_IndexCreate( demux_t *p_demux )
         }
     }
 
+end:
+    if( psz_file && !b_cancelled )
+        AVI_IndexCacheSave( p_demux, psz_file );
+    free( psz_file );
+
 print_stat:
     if( p_dialog != NULL )
         dialog_ProgressDestroy( p_dialog );
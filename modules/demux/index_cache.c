@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * index_cache.c: on-disk cache of demuxer seek indexes
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "index_cache.h"
+
+#define CACHE_MAGIC         "VLCINDEX"
+#define CACHE_VERSION       1
+#define CACHE_HEADER_SIZE   (8 + 4 + 8 + 8 + 16 + 8 + 16)
+#define CACHE_HEAD_SIZE     65536
+#define CACHE_MAX_SIZE      (256 << 20)
+
+/* Identity of the indexed file */
+typedef struct
+{
+    uint64_t i_size;
+    int64_t  i_mtime;
+    uint8_t  head[16];  /* MD5 of the first bytes */
+} file_identity_t;
+
+static int GetIdentity( const char *psz_file, file_identity_t *p_id )
+{
+    int fd = vlc_open( psz_file, O_RDONLY );
+    if( fd == -1 )
+        return VLC_EGENERIC;
+
+    struct stat st;
+    if( fstat( fd, &st ) )
+    {
+        close( fd );
+        return VLC_EGENERIC;
+    }
+    p_id->i_size = st.st_size;
+    p_id->i_mtime = st.st_mtime;
+
+    uint8_t *p_head = malloc( CACHE_HEAD_SIZE );
+    if( !p_head )
+    {
+        close( fd );
+        return VLC_ENOMEM;
+    }
+    ssize_t i_read = read( fd, p_head, CACHE_HEAD_SIZE );
+    close( fd );
+    if( i_read < 0 )
+    {
+        free( p_head );
+        return VLC_EGENERIC;
+    }
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_head, i_read );
+    EndMD5( &md5 );
+    memcpy( p_id->head, md5.buf, 16 );
+
+    free( p_head );
+    return VLC_SUCCESS;
+}
+
+static int CreateDir( const char *psz_dirname )
+{
+    if( vlc_mkdir( psz_dirname, 0700 ) == 0 || errno == EEXIST )
+        return 0;
+    if( errno != ENOENT )
+        return -1;
+
+    /* Create the parent directory first */
+    char psz_parent[strlen( psz_dirname ) + 1], *psz_end;
+    strcpy( psz_parent, psz_dirname );
+    psz_end = strrchr( psz_parent, DIR_SEP_CHAR );
+    if( !psz_end || psz_end == psz_parent )
+        return -1;
+    *psz_end = '\0';
+    if( CreateDir( psz_parent ) )
+        return -1;
+    return vlc_mkdir( psz_dirname, 0700 ) == 0 || errno == EEXIST ? 0 : -1;
+}
+
+/* Cache entries are named after the file path and the index name */
+static char *GetCachePath( const char *psz_file, const char *psz_name,
+                           bool b_create )
+{
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_cachedir )
+        return NULL;
+
+    char *psz_dir;
+    if( asprintf( &psz_dir, "%s"DIR_SEP"index", psz_cachedir ) == -1 )
+        psz_dir = NULL;
+    free( psz_cachedir );
+    if( !psz_dir || ( b_create && CreateDir( psz_dir ) ) )
+    {
+        free( psz_dir );
+        return NULL;
+    }
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_file, strlen( psz_file ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_path;
+    if( !psz_hash ||
+        asprintf( &psz_path, "%s"DIR_SEP"%s-%s.idx", psz_dir, psz_hash,
+                  psz_name ) == -1 )
+        psz_path = NULL;
+    free( psz_hash );
+    free( psz_dir );
+    return psz_path;
+}
+
+char *index_cache_GetPath( demux_t *p_demux )
+{
+    if( !p_demux->psz_file || !p_demux->psz_access ||
+        strcmp( p_demux->psz_access, "file" ) )
+        return NULL;
+    return strdup( p_demux->psz_file );
+}
+
+void *index_cache_Load( vlc_object_t *p_obj, const char *psz_file,
+                        const char *psz_name, size_t *pi_size )
+{
+    if( !var_InheritBool( p_obj, "input-index-cache" ) )
+        return NULL;
+
+    file_identity_t id;
+    if( GetIdentity( psz_file, &id ) )
+        return NULL;
+
+    char *psz_path = GetCachePath( psz_file, psz_name, false );
+    if( !psz_path )
+        return NULL;
+
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    if( !p_file )
+    {
+        free( psz_path );
+        return NULL;
+    }
+
+    uint8_t *p_data = NULL;
+    uint8_t header[CACHE_HEADER_SIZE];
+    if( fread( header, CACHE_HEADER_SIZE, 1, p_file ) != 1 ||
+        memcmp( header, CACHE_MAGIC, 8 ) ||
+        GetDWBE( &header[8] ) != CACHE_VERSION ||
+        GetQWBE( &header[12] ) != id.i_size ||
+        (int64_t) GetQWBE( &header[20] ) != id.i_mtime ||
+        memcmp( &header[28], id.head, 16 ) )
+        goto error;
+
+    const uint64_t i_size = GetQWBE( &header[44] );
+    if( i_size == 0 || i_size > CACHE_MAX_SIZE )
+        goto error;
+
+    p_data = malloc( i_size );
+    if( !p_data || fread( p_data, i_size, 1, p_file ) != 1 )
+        goto error;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_data, i_size );
+    EndMD5( &md5 );
+    if( memcmp( &header[52], md5.buf, 16 ) )
+        goto error;
+
+    fclose( p_file );
+    msg_Dbg( p_obj, "loaded %s index from %s", psz_name, psz_path );
+    free( psz_path );
+    *pi_size = i_size;
+    return p_data;
+
+error:
+    msg_Dbg( p_obj, "ignoring stale or invalid index %s", psz_path );
+    fclose( p_file );
+    free( p_data );
+    free( psz_path );
+    return NULL;
+}
+
+int index_cache_Save( vlc_object_t *p_obj, const char *psz_file,
+                      const char *psz_name, const void *p_data, size_t i_size )
+{
+    if( !var_InheritBool( p_obj, "input-index-cache" ) ||
+        i_size == 0 || i_size > CACHE_MAX_SIZE )
+        return VLC_EGENERIC;
+
+    file_identity_t id;
+    if( GetIdentity( psz_file, &id ) )
+        return VLC_EGENERIC;
+
+    char *psz_path = GetCachePath( psz_file, psz_name, true );
+    char *psz_tmp;
+    if( !psz_path || asprintf( &psz_tmp, "%s.part", psz_path ) == -1 )
+    {
+        free( psz_path );
+        return VLC_ENOMEM;
+    }
+
+    FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+    if( !p_file )
+    {
+        free( psz_tmp );
+        free( psz_path );
+        return VLC_EGENERIC;
+    }
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_data, i_size );
+    EndMD5( &md5 );
+
+    uint8_t header[CACHE_HEADER_SIZE];
+    memcpy( header, CACHE_MAGIC, 8 );
+    SetDWBE( &header[8], CACHE_VERSION );
+    SetQWBE( &header[12], id.i_size );
+    SetQWBE( &header[20], id.i_mtime );
+    memcpy( &header[28], id.head, 16 );
+    SetQWBE( &header[44], i_size );
+    memcpy( &header[52], md5.buf, 16 );
+
+    bool b_error = fwrite( header, CACHE_HEADER_SIZE, 1, p_file ) != 1;
+    b_error |= fwrite( p_data, i_size, 1, p_file ) != 1;
+    b_error |= fclose( p_file ) != 0;
+
+    if( b_error || vlc_rename( psz_tmp, psz_path ) )
+    {
+        vlc_unlink( psz_tmp );
+        b_error = true;
+    }
+    else
+        msg_Dbg( p_obj, "saved %s index to %s", psz_name, psz_path );
+
+    free( psz_tmp );
+    free( psz_path );
+    return b_error ? VLC_EGENERIC : VLC_SUCCESS;
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * index_cache.h: on-disk cache of demuxer seek indexes
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_INDEX_CACHE_H
+#define VLC_INDEX_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Indexes are opaque to the cache, each demuxer serializes its own. They
+ * are stored in the user cache directory and only returned for the same
+ * local file: same path, size, modification time and first bytes.
+ * Nothing is cached when "input-index-cache" is disabled.
+ */
+
+/**
+ * Returns the local path of the demuxed input, or NULL if it is not a local
+ * file.
+ */
+char *index_cache_GetPath( demux_t * );
+
+/**
+ * Loads an index.
+ * \param psz_file local path of the indexed file
+ * \param psz_name name and format version of the index, such as "avi-1"
+ * \return the index, to be freed, or NULL if there is no matching one
+ */
+void *index_cache_Load( vlc_object_t *, const char *psz_file,
+                        const char *psz_name, size_t *pi_size );
+
+/**
+ * Stores an index, replacing any previous one of the same name.
+ */
+int index_cache_Save( vlc_object_t *, const char *psz_file,
+                      const char *psz_name, const void *p_data, size_t i_size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -27,6 +27,8 @@
 #include "demux.hpp"
 #include "util.hpp"
 #include "Ebml_parser.hpp"
+#include "stream_io_callback.hpp"
+#include "../index_cache.h"
 
 matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estream )
     :segment(NULL)
@@ -52,6 +54,7 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,b_cues(false)
     ,i_index(0)
     ,i_index_max(1024)
+    ,i_index_cached(0)
     ,psz_muxing_application(NULL)
     ,psz_writing_application(NULL)
     ,psz_segment_filename(NULL)
@@ -611,6 +614,98 @@ void matroska_segment_c::IndexAppendCluster( KaxCluster *cluster )
 #undef idx
 }
 
+/* Without Cues, the cluster index is built while seeking. It is cached as the
+ * cluster position and timecode of each entry, per segment of the file. */
+#define MKV_INDEX_ENTRY_SIZE 16
+
+static char *IndexCacheName( int64_t i_start_pos )
+{
+    char *psz_name;
+    if( asprintf( &psz_name, "mkv-1-%" PRId64, i_start_pos ) == -1 )
+        return NULL;
+    return psz_name;
+}
+
+void matroska_segment_c::IndexCacheLoad( const char *psz_file )
+{
+    if( b_cues || i_index > 0 )
+        return;
+
+    char *psz_name = IndexCacheName( i_start_pos );
+    if( !psz_name )
+        return;
+
+    size_t i_size;
+    uint8_t *p_data = (uint8_t *)index_cache_Load( VLC_OBJECT(&sys.demuxer),
+                                                   psz_file, psz_name, &i_size );
+    free( psz_name );
+    if( !p_data )
+        return;
+
+    const size_t i_count = i_size / MKV_INDEX_ENTRY_SIZE;
+    const int64_t i_stream_size = stream_Size( sys.demuxer.s );
+    mkv_index_t *p_loaded = NULL;
+    if( i_size % MKV_INDEX_ENTRY_SIZE == 0 && i_count < INT_MAX - 1024 )
+        p_loaded = (mkv_index_t *)malloc( sizeof( mkv_index_t ) * ( i_count + 1024 ) );
+    if( !p_loaded )
+    {
+        free( p_data );
+        return;
+    }
+
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        mkv_index_t *p_idx = &p_loaded[i];
+        p_idx->i_track        = -1;
+        p_idx->i_block_number = -1;
+        p_idx->i_position     = GetQWBE( &p_data[i * MKV_INDEX_ENTRY_SIZE] );
+        p_idx->i_mk_time      = GetQWBE( &p_data[i * MKV_INDEX_ENTRY_SIZE + 8] );
+        p_idx->b_key          = true;
+
+        if( p_idx->i_position < i_start_pos ||
+            ( i_stream_size > 0 && p_idx->i_position >= i_stream_size ) ||
+            ( i > 0 && p_idx->i_position <= p_loaded[i - 1].i_position ) )
+        {
+            msg_Warn( &sys.demuxer, "invalid cached index" );
+            free( p_loaded );
+            free( p_data );
+            return;
+        }
+    }
+    free( p_data );
+
+    free( p_indexes );
+    p_indexes = p_loaded;
+    i_index = i_index_cached = (int)i_count;
+    i_index_max = (int)i_count + 1024;
+}
+
+void matroska_segment_c::IndexCacheSave( const char *psz_file ) const
+{
+    /* Only save when seeking found new clusters */
+    if( b_cues || i_index <= i_index_cached )
+        return;
+
+    char *psz_name = IndexCacheName( i_start_pos );
+    if( !psz_name )
+        return;
+
+    const size_t i_size = (size_t)i_index * MKV_INDEX_ENTRY_SIZE;
+    uint8_t *p_data = (uint8_t *)malloc( i_size );
+    if( p_data )
+    {
+        for( int i = 0; i < i_index; i++ )
+        {
+            SetQWBE( &p_data[i * MKV_INDEX_ENTRY_SIZE], p_indexes[i].i_position );
+            SetQWBE( &p_data[i * MKV_INDEX_ENTRY_SIZE + 8], p_indexes[i].i_mk_time );
+        }
+        index_cache_Save( VLC_OBJECT(&sys.demuxer), psz_file, psz_name,
+                          p_data, i_size );
+        free( p_data );
+    }
+    free( psz_name );
+}
+
 bool matroska_segment_c::PreloadFamily( const matroska_segment_c & of_segment )
 {
     if ( b_preloaded )
@@ -1365,6 +1460,16 @@ void matroska_segment_c::UnSelect( )
     ep = NULL;
 }
 
+/* Leaves the frames of the blocks in the read-ahead data, BlockDecode()
+ * hands them out from there */
+ScopeMode matroska_segment_c::BlockScope( EbmlElement *el )
+{
+    vlc_stream_io_callback &io = static_cast<vlc_stream_io_callback &>( es.I_O() );
+
+    return io.isBuffered( el->GetEndPosition() ) ? SCOPE_PARTIAL_DATA
+                                                 : SCOPE_ALL_DATA;
+}
+
 int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_simpleblock, bool *pb_key_picture, bool *pb_discardable_picture, int64_t *pi_duration )
 {
     pp_simpleblock = NULL;
@@ -1405,9 +1510,27 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                 {
                     case VLC_CODEC_THEORA:
                         {
-                            DataBuffer *p_data = &pp_block->GetBuffer(0);
-                            size_t sz = p_data->Size();
-                            const uint8_t * p_buff = p_data->Buffer();
+                            block_t *p_frame = NULL;
+                            uint64_t i_frame_pos = 0;
+                            size_t sz;
+                            const uint8_t * p_buff;
+                            if( pp_block->EbmlBinary::GetBuffer() == NULL )
+                            {
+                                /* partially read, peek at the frame */
+                                sz = pp_block->NumberFrames() &&
+                                     BlockFramesPosition( *pp_block, &i_frame_pos ) ?
+                                     __MIN( pp_block->GetFrameSize(0), 1 ) : 0;
+                                if( sz )
+                                    p_frame = static_cast<vlc_stream_io_callback &>( es.I_O() )
+                                                  .readBlock( i_frame_pos, sz );
+                                p_buff = p_frame ? p_frame->p_buffer : NULL;
+                            }
+                            else
+                            {
+                                DataBuffer *p_data = &pp_block->GetBuffer(0);
+                                sz = p_data->Size();
+                                p_buff = p_data->Buffer();
+                            }
                             /* if the second bit of a Theora frame is 1
                                it's not a keyframe */
                             if( sz && p_buff )
@@ -1417,6 +1540,8 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                             }
                             else
                                 *pb_key_picture = false;
+                            if( p_frame )
+                                block_Release( p_frame );
                             break;
                         }
                 }
@@ -1474,6 +1599,11 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                         cluster = (KaxCluster*)el;
                         i_cluster_pos = cluster->GetElementPosition();
 
+                        /* read the whole cluster at once */
+                        if( cluster->IsFiniteSize() )
+                            static_cast<vlc_stream_io_callback &>( es.I_O() )
+                                .prefetch( cluster->GetEndPosition() );
+
                         // reset silent tracks
                         for (size_t i=0; i<tracks.size(); i++)
                         {
@@ -1526,7 +1656,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                     {
                         pp_simpleblock = (KaxSimpleBlock*)el;
 
-                        pp_simpleblock->ReadData( es.I_O() );
+                        pp_simpleblock->ReadData( es.I_O(), BlockScope( el ) );
                         pp_simpleblock->SetParent( *cluster );
                     }
                     break;
@@ -1545,7 +1675,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                     {
                         pp_block = (KaxBlock*)el;
 
-                        pp_block->ReadData( es.I_O() );
+                        pp_block->ReadData( es.I_O(), BlockScope( el ) );
                         pp_block->SetParent( *cluster );
 
                         ep->Keep();
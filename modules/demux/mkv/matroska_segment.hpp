@@ -110,6 +110,7 @@ public:
     int                     i_index;
     int                     i_index_max;
     mkv_index_t             *p_indexes;
+    int                     i_index_cached;
 
     /* info */
     char                    *psz_muxing_application;
@@ -145,6 +146,9 @@ public:
     bool Select( mtime_t i_mk_start_time );
     void UnSelect();
 
+    void IndexCacheLoad( const char *psz_file );
+    void IndexCacheSave( const char *psz_file ) const;
+
     static bool CompareSegmentUIDs( const matroska_segment_c * item_a, const matroska_segment_c * item_b );
 
 private:
@@ -159,6 +163,7 @@ private:
     void ParseChapterAtom( int i_level, KaxChapterAtom *ca, chapter_item_c & chapters );
     void ParseTrackEntry( KaxTrackEntry *m );
     void ParseCluster( KaxCluster *cluster, bool b_update_start_time = true, ScopeMode read_fully = SCOPE_ALL_DATA );
+    ScopeMode BlockScope( EbmlElement *el );
     SimpleTag * ParseSimpleTags( KaxTagSimple *tag, int level = 50 );
     void IndexAppendCluster( KaxCluster *cluster );
     int32_t TrackInit( mkv_track_t * p_tk );
@@ -35,6 +35,7 @@
 
 extern "C" {
 #include "../../modules/codec/dts_header.h"
+#include "../index_cache.h"
 }
 
 #include <vlc_fs.h>
@@ -138,6 +139,14 @@ static int Open( vlc_object_t * p_this )
         b_need_preload |= p_stream->segments[i]->b_ref_external_segments;
     }
 
+    /* Reuse the cluster index built by previous seeks in cue-less segments */
+    if( char *psz_file = index_cache_GetPath( p_demux ) )
+    {
+        for (size_t i=0; i<p_stream->segments.size(); i++)
+            p_stream->segments[i]->IndexCacheLoad( psz_file );
+        free( psz_file );
+    }
+
     p_segment = p_stream->segments[0];
     if( p_segment->cluster == NULL )
     {
@@ -275,6 +284,20 @@ static void Close( vlc_object_t *p_this )
             p_segment->UnSelect();
     }
 
+    /* Only segments of the opened file, which is always the first stream */
+    char *psz_file = index_cache_GetPath( p_demux );
+    if( psz_file && !p_sys->streams.empty() && p_sys->streams[0] )
+    {
+        const EbmlStream *p_estream = p_sys->streams[0]->p_estream;
+        for( size_t i = 0; i < p_sys->opened_segments.size(); i++ )
+        {
+            matroska_segment_c *p_segment = p_sys->opened_segments[i];
+            if( p_segment && &p_segment->es == p_estream )
+                p_segment->IndexCacheSave( psz_file );
+        }
+    }
+    free( psz_file );
+
     delete p_sys;
 }
 
@@ -543,43 +566,69 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
 
 
     size_t frame_size = 0;
-    size_t block_size = 0;
-
-    if( simpleblock != NULL )
-        block_size = simpleblock->GetSize();
-    else
-        block_size = block->GetSize();
- 
-    const unsigned int i_number_frames = block != NULL ? block->NumberFrames() :
-            ( simpleblock != NULL ? simpleblock->NumberFrames() : 0 );
+    KaxInternalBlock & internal = simpleblock != NULL ?
+            static_cast<KaxInternalBlock &>( *simpleblock ) :
+            static_cast<KaxInternalBlock &>( *block );
+    const size_t block_size = internal.GetSize();
+
+    /* Blocks read partially have their frames in the read-ahead data */
+    vlc_stream_io_callback & io =
+            static_cast<vlc_stream_io_callback &>( p_segment->es.I_O() );
+    const bool b_partial = internal.EbmlBinary::GetBuffer() == NULL;
+    uint64_t i_frame_pos = 0;
+    if( b_partial && !BlockFramesPosition( internal, &i_frame_pos ) )
+    {
+        msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+        return;
+    }
+
+    const unsigned int i_number_frames = internal.NumberFrames();
     for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
     {
         block_t *p_block;
-        DataBuffer *data;
-        if( simpleblock != NULL )
+        block_t *p_frame = NULL;
+        uint8_t *p_data;
+        size_t i_data;
+        if( b_partial )
         {
-            data = &simpleblock->GetBuffer(i_frame);
+            i_data = internal.GetFrameSize(i_frame);
+            frame_size += i_data;
+            p_frame = io.readBlock( i_frame_pos, i_data );
+            i_frame_pos += i_data;
+            p_data = p_frame != NULL ? p_frame->p_buffer : NULL;
         }
         else
         {
-            data = &block->GetBuffer(i_frame);
+            DataBuffer & data = internal.GetBuffer(i_frame);
+            i_data = data.Size();
+            frame_size += i_data;
+            p_data = data.Buffer();
         }
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+        if( !p_data || i_data > frame_size || frame_size > block_size  )
         {
             msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+            if( p_frame != NULL )
+                block_Release( p_frame );
             break;
         }
 
         if( tk->i_compression_type == MATROSKA_COMPRESSION_HEADER &&
             tk->p_compression_data != NULL &&
             tk->i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), tk->p_compression_data->GetSize() );
+            p_block = MemToBlock( p_data, i_data, tk->p_compression_data->GetSize() );
         else if( unlikely( tk->fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack(tk, data->Buffer(), data->Size());
+            p_block = packetize_wavpack(tk, p_data, i_data);
+        else if( p_frame != NULL )
+        {
+            /* handed out of the read-ahead data without copy */
+            p_block = p_frame;
+            p_frame = NULL;
+        }
         else
-            p_block = MemToBlock( data->Buffer(), data->Size(), 0 );
+            p_block = MemToBlock( p_data, i_data, 0 );
 
+        if( p_frame != NULL )
+            block_Release( p_frame );
         if( p_block == NULL )
         {
             break;
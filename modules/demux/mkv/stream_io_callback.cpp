@@ -27,6 +27,124 @@
 #include "matroska_segment.hpp"
 #include "demux.hpp"
 
+/*****************************************************************************
+ * Read-ahead buffers
+ *****************************************************************************/
+
+/* Clusters are read ahead by chunks of at most this size */
+#define MKV_READAHEAD_MAX (8 << 20)
+
+struct mkv_readahead_pool_t
+{
+    vlc_mutex_t      lock;
+    unsigned         i_refs; /* io callback and buffers in use */
+    mkv_readahead_t  *p_free;
+};
+
+struct mkv_readahead_t
+{
+    mkv_readahead_pool_t *p_pool;
+    unsigned         i_refs; /* protected by the pool lock */
+    uint8_t          *p_buffer;
+    size_t           i_size;
+    size_t           i_buffer;
+    uint64_t         i_pos;
+};
+
+/* Frame handed out of a read-ahead buffer without copy */
+struct mkv_frame_t
+{
+    block_t          self;
+    mkv_readahead_t  *p_readahead;
+};
+
+static void ReadaheadFree( mkv_readahead_t *p_readahead )
+{
+    free( p_readahead->p_buffer );
+    free( p_readahead );
+}
+
+static void PoolRelease( mkv_readahead_pool_t *p_pool, bool b_last )
+{
+    if( b_last )
+    {
+        if( p_pool->p_free != NULL )
+            ReadaheadFree( p_pool->p_free );
+        vlc_mutex_destroy( &p_pool->lock );
+        free( p_pool );
+    }
+}
+
+static mkv_readahead_t *ReadaheadGet( mkv_readahead_pool_t *p_pool,
+                                      size_t i_size )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    mkv_readahead_t *p_readahead = p_pool->p_free;
+    p_pool->p_free = NULL;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( p_readahead == NULL )
+    {
+        p_readahead = (mkv_readahead_t *)malloc( sizeof(*p_readahead) );
+        if( unlikely(p_readahead == NULL) )
+            return NULL;
+        p_readahead->p_buffer = NULL;
+        p_readahead->i_size = 0;
+    }
+
+    if( p_readahead->i_size < i_size )
+    {
+        uint8_t *p_buffer = (uint8_t *)realloc( p_readahead->p_buffer, i_size );
+        if( unlikely(p_buffer == NULL) )
+        {
+            ReadaheadFree( p_readahead );
+            return NULL;
+        }
+        p_readahead->p_buffer = p_buffer;
+        p_readahead->i_size = i_size;
+    }
+
+    p_readahead->p_pool = p_pool;
+    p_readahead->i_refs = 1;
+    p_readahead->i_buffer = 0;
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->i_refs++;
+    vlc_mutex_unlock( &p_pool->lock );
+    return p_readahead;
+}
+
+static void ReadaheadRelease( mkv_readahead_t *p_readahead )
+{
+    mkv_readahead_pool_t *p_pool = p_readahead->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( --p_readahead->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &p_pool->lock );
+        return;
+    }
+    /* Keep it for the next read-ahead */
+    if( p_pool->p_free == NULL )
+    {
+        p_pool->p_free = p_readahead;
+        p_readahead = NULL;
+    }
+    const bool b_last = --p_pool->i_refs == 0;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( p_readahead != NULL )
+        ReadaheadFree( p_readahead );
+    PoolRelease( p_pool, b_last );
+}
+
+static void FrameRelease( block_t *p_block )
+{
+    mkv_frame_t *p_frame = (mkv_frame_t *)p_block;
+
+    ReadaheadRelease( p_frame->p_readahead );
+    free( p_frame );
+}
+
 /*****************************************************************************
  * Stream managment
  *****************************************************************************/
@@ -34,6 +152,138 @@ vlc_stream_io_callback::vlc_stream_io_callback( stream_t *s_, bool b_owner_ )
                        : s( s_), b_owner( b_owner_ )
 {
     mb_eof = false;
+    p_readahead = NULL;
+    i_prefetch_end = 0;
+    i_pos = 0;
+
+    /* Only read ahead when it does not wait for data past the current
+     * needs, as it would on network streams */
+    if( stream_Control( s, STREAM_CAN_FASTSEEK, &b_can_prefetch ) )
+        b_can_prefetch = false;
+
+    p_pool = (mkv_readahead_pool_t *)malloc( sizeof(*p_pool) );
+    if( likely(p_pool != NULL) )
+    {
+        vlc_mutex_init( &p_pool->lock );
+        p_pool->i_refs = 1;
+        p_pool->p_free = NULL;
+    }
+    else
+        b_can_prefetch = false;
+}
+
+vlc_stream_io_callback::~vlc_stream_io_callback()
+{
+    if( p_readahead != NULL )
+        ReadaheadRelease( p_readahead );
+
+    if( p_pool != NULL )
+    {
+        /* Frames still in use keep the pool until they are released */
+        vlc_mutex_lock( &p_pool->lock );
+        const bool b_last = --p_pool->i_refs == 0;
+        vlc_mutex_unlock( &p_pool->lock );
+        PoolRelease( p_pool, b_last );
+    }
+
+    if( b_owner )
+        stream_Delete( s );
+}
+
+void vlc_stream_io_callback::dropReadahead( void )
+{
+    if( p_readahead == NULL )
+        return;
+
+    const uint64_t i_end = p_readahead->i_pos + p_readahead->i_buffer;
+    ReadaheadRelease( p_readahead );
+    p_readahead = NULL;
+    if( i_pos != i_end )
+        stream_Seek( s, i_pos );
+}
+
+bool vlc_stream_io_callback::fillReadahead( void )
+{
+    const uint64_t i_start = stream_Tell( s );
+    if( i_start >= i_prefetch_end )
+        return false;
+
+    const size_t i_size = __MIN( i_prefetch_end - i_start, MKV_READAHEAD_MAX );
+    p_readahead = ReadaheadGet( p_pool, i_size );
+    if( p_readahead != NULL )
+    {
+        ssize_t i_read = stream_Read( s, p_readahead->p_buffer, i_size );
+        if( i_read > 0 )
+            p_readahead->i_buffer = i_read;
+        else
+        {
+            ReadaheadRelease( p_readahead );
+            p_readahead = NULL;
+        }
+    }
+    if( p_readahead == NULL )
+    {
+        i_prefetch_end = 0;
+        return false;
+    }
+    p_readahead->i_pos = i_pos = i_start;
+    return true;
+}
+
+/* Reads the data up to i_end with large reads, instead of the many small
+ * ones of the EBML parsing */
+void vlc_stream_io_callback::prefetch( uint64_t i_end )
+{
+    if( b_can_prefetch )
+        i_prefetch_end = i_end;
+}
+
+/* Whether the data from the current position up to i_end is read ahead */
+bool vlc_stream_io_callback::isBuffered( uint64_t i_end )
+{
+    if( p_readahead == NULL && !fillReadahead() )
+        return false;
+    return i_end <= p_readahead->i_pos + p_readahead->i_buffer;
+}
+
+/* Returns the data at i_start, shared with the read-ahead buffer when it
+ * holds it, without moving the read position */
+block_t *vlc_stream_io_callback::readBlock( uint64_t i_start, size_t i_size )
+{
+    if( p_readahead != NULL && i_start >= p_readahead->i_pos &&
+        i_start - p_readahead->i_pos <= p_readahead->i_buffer &&
+        i_size <= p_readahead->i_buffer - ( i_start - p_readahead->i_pos ) )
+    {
+        mkv_frame_t *p_frame = (mkv_frame_t *)malloc( sizeof(*p_frame) );
+        if( unlikely(p_frame == NULL) )
+            return NULL;
+
+        block_Init( &p_frame->self,
+                    &p_readahead->p_buffer[i_start - p_readahead->i_pos],
+                    i_size );
+        p_frame->self.pf_release = FrameRelease;
+        p_frame->p_readahead = p_readahead;
+
+        vlc_mutex_lock( &p_pool->lock );
+        p_readahead->i_refs++;
+        vlc_mutex_unlock( &p_pool->lock );
+        return &p_frame->self;
+    }
+
+    /* The stream is positioned at the end of the read-ahead data, if any */
+    const uint64_t i_current = stream_Tell( s );
+    block_t *p_block = block_Alloc( i_size );
+    if( unlikely(p_block == NULL) )
+        return NULL;
+
+    if( stream_Seek( s, i_start ) ||
+        stream_Read( s, p_block->p_buffer, i_size ) != (ssize_t)i_size )
+    {
+        block_Release( p_block );
+        p_block = NULL;
+    }
+    stream_Seek( s, i_current );
+    return p_block;
 }
 
 uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
@@ -41,38 +291,80 @@ uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
     if( i_size <= 0 || mb_eof )
         return 0;
 
-    return stream_Read( s, p_buffer, i_size );
+    uint8_t *p_dst = (uint8_t *)p_buffer;
+    size_t i_done = 0;
+
+    while( i_done < i_size && ( p_readahead != NULL || fillReadahead() ) )
+    {
+        const size_t i_offset = i_pos - p_readahead->i_pos;
+        const size_t i_copy = __MIN( i_size - i_done,
+                                     p_readahead->i_buffer - i_offset );
+        if( p_dst != NULL )
+            memcpy( &p_dst[i_done], &p_readahead->p_buffer[i_offset], i_copy );
+        i_done += i_copy;
+        i_pos += i_copy;
+        if( i_offset + i_copy == p_readahead->i_buffer )
+            dropReadahead();
+    }
+
+    if( i_done < i_size )
+    {
+        ssize_t i_read = stream_Read( s, p_dst ? &p_dst[i_done] : NULL,
+                                      i_size - i_done );
+        if( i_read > 0 )
+            i_done += i_read;
+    }
+    return i_done;
 }
 
 void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
 {
-    int64_t i_pos, i_size;
-    int64_t i_current = stream_Tell( s );
+    int64_t i_target, i_size;
+    int64_t i_current = getFilePointer();
 
     switch( mode )
     {
         case seek_beginning:
-            i_pos = i_offset;
+            i_target = i_offset;
             break;
         case seek_end:
-            i_pos = stream_Size( s ) - i_offset;
+            i_target = stream_Size( s ) - i_offset;
             break;
         default:
-            i_pos= i_current + i_offset;
+            i_target = i_current + i_offset;
             break;
     }
 
-    if(i_pos == i_current)
+    if(i_target == i_current)
+        return;
+
+    /* Seeking inside the read-ahead data, or to its end where the stream
+     * already is, as when skipping the data of a partially read block */
+    if( p_readahead != NULL && i_target >= (int64_t)p_readahead->i_pos &&
+        i_target <= (int64_t)( p_readahead->i_pos + p_readahead->i_buffer ) )
+    {
+        mb_eof = false;
+        i_pos = i_target;
+        if( i_pos == p_readahead->i_pos + p_readahead->i_buffer )
+            dropReadahead();
         return;
+    }
+
+    if( p_readahead != NULL )
+    {
+        ReadaheadRelease( p_readahead );
+        p_readahead = NULL;
+    }
+    i_prefetch_end = 0;
 
-    if( i_pos < 0 || ( ( i_size = stream_Size( s ) ) != 0 && i_pos >= i_size ) )
+    if( i_target < 0 || ( ( i_size = stream_Size( s ) ) != 0 && i_target >= i_size ) )
     {
         mb_eof = true;
         return;
     }
 
     mb_eof = false;
-    if( stream_Seek( s, i_pos ) )
+    if( stream_Seek( s, i_target ) )
     {
         mb_eof = true;
     }
@@ -83,6 +375,8 @@ uint64 vlc_stream_io_callback::getFilePointer( void )
 {
     if ( s == NULL )
         return 0;
+    if( p_readahead != NULL )
+        return i_pos;
     return stream_Tell( s );
 }
 
@@ -103,6 +397,5 @@ uint64 vlc_stream_io_callback::toRead( void )
     if( i_size == 0 )
         return UINT64_MAX;
 
-    return (uint64) i_size - stream_Tell( s );
+    return (uint64) i_size - getFilePointer();
 }
-
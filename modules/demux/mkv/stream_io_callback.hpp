@@ -26,21 +26,31 @@
 /*****************************************************************************
  * Stream managment
  *****************************************************************************/
+struct mkv_readahead_t;
+struct mkv_readahead_pool_t;
+
 class vlc_stream_io_callback: public IOCallback
 {
   private:
     stream_t       *s;
     bool           mb_eof;
     bool           b_owner;
+    bool           b_can_prefetch;
+
+    /* Read-ahead buffer, the stream is positioned at its end */
+    mkv_readahead_t *p_readahead;
+    /* Recycles the read-ahead buffers once their frames are released */
+    mkv_readahead_pool_t *p_pool;
+    uint64_t       i_prefetch_end;
+    uint64_t       i_pos;
+
+    void           dropReadahead   ( void );
+    bool           fillReadahead   ( void );
 
   public:
     vlc_stream_io_callback( stream_t *, bool );
 
-    virtual ~vlc_stream_io_callback()
-    {
-        if( b_owner )
-            stream_Delete( s );
-    }
+    virtual ~vlc_stream_io_callback();
 
     virtual uint32   read            ( void *p_buffer, size_t i_size);
     virtual void     setFilePointer  ( int64_t i_offset, seek_mode mode = seek_beginning );
@@ -48,5 +58,8 @@ class vlc_stream_io_callback: public IOCallback
     virtual uint64   getFilePointer  ( void );
     virtual void     close           ( void ) { return; }
     uint64           toRead          ( void );
+    void             prefetch        ( uint64_t i_end );
+    bool             isBuffered      ( uint64_t i_end );
+    block_t *        readBlock       ( uint64_t i_pos, size_t i_size );
 };
 
@@ -167,6 +167,21 @@ block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset)
     return p_block;
 }
 
+/* Blocks read with SCOPE_PARTIAL_DATA leave their frames in the stream,
+ * back to back up to the end of the block */
+bool BlockFramesPosition( KaxInternalBlock & block, uint64_t *pi_pos )
+{
+    uint64_t i_total = 0;
+    for( unsigned int i = 0; i < block.NumberFrames(); i++ )
+    {
+        const uint64_t i_size = block.GetFrameSize( i );
+        if( i_size > block.GetSize() - i_total )
+            return false;
+        i_total += i_size;
+    }
+    *pi_pos = block.GetEndPosition() - i_total;
+    return true;
+}
 
 void handle_real_audio(demux_t * p_demux, mkv_track_t * p_tk, block_t * p_blk, mtime_t i_pts)
 {
@@ -68,6 +68,10 @@ static int   Control ( demux_t *, int, va_list );
 struct demux_sys_t
 {
     MP4_Box_t    *p_root;      /* container for the whole file */
+    /* Replaced roots that tracks were created from: their chunks still
+     * point into the sample tables */
+    int          i_old_roots;
+    MP4_Box_t    **pp_old_roots;
 
     mtime_t      i_pcr;
 
@@ -231,35 +235,48 @@ static MP4_Box_t * MP4_GetTrakByTrackID( MP4_Box_t *p_moov, const uint32_t i_id
     return p_trak;
 }
 
-/* Return time in microsecond of a track */
-static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+/* Return the dts of the i_sample-th sample of a chunk, relative to its
+ * first sample, in track timescale */
+static inline int64_t MP4_ChunkGetDTSOffset( const mp4_chunk_t *p_chunk,
+                                             uint32_t i_sample )
 {
-    demux_sys_t *p_sys = p_demux->p_sys;
-    const mp4_chunk_t *p_chunk;
-    if( p_sys->b_fragmented )
-        p_chunk = p_track->cchunk;
-    else
-        p_chunk = &p_track->chunk[p_track->i_chunk];
+    uint64_t i_left = (uint64_t)i_sample + p_chunk->i_skip_dts;
+    int64_t i_dts = 0;
 
-    unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - p_chunk->i_sample_first;
-    int64_t i_dts = p_chunk->i_first_dts;
+    if( p_chunk->i_skip_dts )
+        i_dts -= (int64_t)p_chunk->i_skip_dts * p_chunk->p_sample_delta_dts[0];
 
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    for( uint32_t i_index = 0;
+         i_left > 0 && i_index < p_chunk->i_entries_dts; i_index++ )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        if( i_left > p_chunk->p_sample_count_dts[i_index] )
         {
-            i_dts += p_chunk->p_sample_count_dts[i_index] *
+            i_dts += (int64_t)p_chunk->p_sample_count_dts[i_index] *
                 p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index];
-            i_index++;
+            i_left -= p_chunk->p_sample_count_dts[i_index];
         }
         else
         {
-            i_dts += i_sample * p_chunk->p_sample_delta_dts[i_index];
+            i_dts += i_left * p_chunk->p_sample_delta_dts[i_index];
             break;
         }
     }
+    return i_dts;
+}
+
+/* Return time in microsecond of a track */
+static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const mp4_chunk_t *p_chunk;
+    if( p_sys->b_fragmented )
+        p_chunk = p_track->cchunk;
+    else
+        p_chunk = &p_track->chunk[p_track->i_chunk];
+
+    int64_t i_dts = p_chunk->i_first_dts +
+        MP4_ChunkGetDTSOffset( p_chunk,
+                               p_track->i_sample - p_chunk->i_sample_first );
 
     /* now handle elst */
     if( p_track->p_elst )
@@ -296,7 +313,8 @@ static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
         ck = &p_track->chunk[p_track->i_chunk];
 
     unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - ck->i_sample_first;
+    uint64_t i_sample = (uint64_t)p_track->i_sample - ck->i_sample_first +
+                        ck->i_skip_pts;
 
     if( ck->p_sample_count_pts == NULL || ck->p_sample_offset_pts == NULL )
         return false;
@@ -487,12 +505,8 @@ static block_t * MP4_EIA608_Convert( block_t * p_block )
     return p_newblock;
 }
 
-static block_t * MP4_Block_Read( demux_t *p_demux, const mp4_track_t *p_track, int i_size )
+static block_t * MP4_Block_Encap( const mp4_track_t *p_track, block_t *p_block )
 {
-    block_t *p_block = stream_Block( p_demux->s, i_size );
-    if ( !p_block )
-        return NULL;
-
     /* might have some encap */
     if( p_track->fmt.i_cat == SPU_ES )
     {
@@ -514,6 +528,90 @@ static block_t * MP4_Block_Read( demux_t *p_demux, const mp4_track_t *p_track, i
     return p_block;
 }
 
+static block_t * MP4_Block_Read( demux_t *p_demux, const mp4_track_t *p_track, int i_size )
+{
+    block_t *p_block = stream_Block( p_demux->s, i_size );
+    if ( !p_block )
+        return NULL;
+
+    return MP4_Block_Encap( p_track, p_block );
+}
+
+/* Non interleaved files are read by large reads per track, each covering
+ * the data of the track up to the next chunk of another track */
+#define MP4_READAHEAD_MAX (4 << 20)
+
+static uint64_t MP4_GetNextChunkOffset( demux_sys_t *p_sys,
+                                        const mp4_track_t *p_track,
+                                        uint64_t i_pos )
+{
+    uint64_t i_next = UINT64_MAX;
+
+    for( unsigned i = 0; i < p_sys->i_tracks; i++ )
+    {
+        const mp4_track_t *tk = &p_sys->track[i];
+        if( tk == p_track || !tk->b_ok || !tk->chunk )
+            continue;
+
+        /* first chunk after i_pos */
+        uint32_t i_low = 0, i_high = tk->i_chunk_count;
+        while( i_low < i_high )
+        {
+            uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+            if( tk->chunk[i_mid].i_offset <= i_pos )
+                i_low = i_mid + 1;
+            else
+                i_high = i_mid;
+        }
+        if( i_low < tk->i_chunk_count && tk->chunk[i_low].i_offset < i_next )
+            i_next = tk->chunk[i_low].i_offset;
+    }
+
+    return i_next;
+}
+
+static block_t * MP4_Block_ReadAhead( demux_t *p_demux, mp4_track_t *p_track,
+                                      uint64_t i_pos, uint32_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    block_t *p_data = p_track->p_readahead;
+
+    if( !p_data || i_pos < p_track->i_readahead_pos ||
+        i_pos - p_track->i_readahead_pos + i_size > p_data->i_buffer )
+    {
+        if( p_data )
+            block_Release( p_data );
+        p_track->p_readahead = p_data = NULL;
+
+        if( stream_Seek( p_demux->s, i_pos ) )
+            return NULL;
+        if( i_size >= MP4_READAHEAD_MAX )
+            return MP4_Block_Read( p_demux, p_track, i_size );
+
+        uint64_t i_end = MP4_GetNextChunkOffset( p_sys, p_track, i_pos );
+        i_end = __MIN( i_end, i_pos + MP4_READAHEAD_MAX );
+        i_end = __MAX( i_end, i_pos + i_size );
+
+        p_data = stream_Block( p_demux->s, i_end - i_pos );
+        if( !p_data || p_data->i_buffer < i_size )
+        {
+            if( p_data )
+                block_Release( p_data );
+            return NULL;
+        }
+        p_track->p_readahead = p_data;
+        p_track->i_readahead_pos = i_pos;
+    }
+
+    block_t *p_block = block_Alloc( i_size );
+    if( !p_block )
+        return NULL;
+    memcpy( p_block->p_buffer,
+            &p_data->p_buffer[i_pos - p_track->i_readahead_pos], i_size );
+
+    return MP4_Block_Encap( p_track, p_block );
+}
+
 static void MP4_Block_Send( demux_t *p_demux, mp4_track_t *p_track, block_t *p_block )
 {
     if ( p_track->b_chans_reorder && aout_BitsPerSample( p_track->fmt.i_codec ) )
@@ -1089,16 +1187,6 @@ static int Demux( demux_t *p_demux )
         msg_Dbg( p_demux, "Could not select track by data position" );
         goto end;
     }
-    else if ( p_sys->b_seekmode )
-    {
-        if( stream_Seek( p_demux->s, i_candidate_pos ) )
-        {
-            msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)",
-                      tk->i_track_ID );
-            MP4_TrackUnselect( p_demux, tk );
-            goto end;
-        }
-    }
 
 #if 0
     msg_Dbg( p_demux, "tk(%i)=%"PRId64" mv=%"PRId64" pos=%"PRIu64, tk->i_track_ID,
@@ -1115,24 +1203,35 @@ static int Demux( demux_t *p_demux )
         uint64_t i_current_pos;
 
         /* go,go go ! */
-        if ( !MP4_stream_Tell( p_demux->s, &i_current_pos ) )
-            goto end;
-
-        if( i_current_pos != i_candidate_pos )
+        if ( p_sys->b_seekmode )
         {
-            if( stream_Seek( p_demux->s, i_candidate_pos ) )
-            {
-                msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)"
-                          ": Failed to seek to %"PRIu64,
-                          tk->i_track_ID, i_candidate_pos );
-                MP4_TrackUnselect( p_demux, tk );
+            i_current_pos = i_candidate_pos;
+            p_block = MP4_Block_ReadAhead( p_demux, tk, i_candidate_pos,
+                                           i_samplessize );
+        }
+        else
+        {
+            if ( !MP4_stream_Tell( p_demux->s, &i_current_pos ) )
                 goto end;
+
+            if( i_current_pos != i_candidate_pos )
+            {
+                if( stream_Seek( p_demux->s, i_candidate_pos ) )
+                {
+                    msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)"
+                              ": Failed to seek to %"PRIu64,
+                              tk->i_track_ID, i_candidate_pos );
+                    MP4_TrackUnselect( p_demux, tk );
+                    goto end;
+                }
+                i_current_pos = i_candidate_pos;
             }
-            i_current_pos = i_candidate_pos;
+
+            /* now read pes */
+            p_block = MP4_Block_Read( p_demux, tk, i_samplessize );
         }
 
-        /* now read pes */
-        if( !(p_block = MP4_Block_Read( p_demux, tk, i_samplessize )) )
+        if( !p_block )
         {
             msg_Warn( p_demux, "track[0x%x] will be disabled (eof?)"
                       ": Failed to read %d bytes sample at %"PRIu64,
@@ -1731,6 +1830,9 @@ static void Close ( vlc_object_t * p_this )
     msg_Dbg( p_demux, "freeing all memory" );
 
     MP4_BoxFree( p_demux->s, p_sys->p_root );
+    for( int i = 0; i < p_sys->i_old_roots; i++ )
+        MP4_BoxFree( p_demux->s, p_sys->pp_old_roots[i] );
+    TAB_CLEAN( p_sys->i_old_roots, p_sys->pp_old_roots );
     for( i_track = 0; i_track < p_sys->i_tracks; i_track++ )
     {
         MP4_TrackDestroy( p_demux, &p_sys->track[i_track] );
@@ -1964,52 +2066,38 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
+/* Points a chunk at the runs of a stts/ctts table covering its samples,
+ * without copying them. *pi_index and *pi_used are the position in the
+ * table, advanced past the chunk. Returns false if the table is too short */
+static bool TrackChunkRuns( uint32_t i_sample_count,
+                            const uint32_t *pi_run_count, uint32_t i_run_count,
+                            uint32_t *pi_index, uint32_t *pi_used,
+                            uint32_t *pi_first, uint32_t *pi_entries,
+                            uint32_t *pi_skip )
 {
-    uint32_t i_array_offset;
+    *pi_first = *pi_index;
+    *pi_entries = 0;
+    *pi_skip = *pi_used;
+
     while( i_sample_count > 0 )
     {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
+        if( *pi_index >= i_run_count )
+            return false;
 
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_ENOVAR;
-        }
+        uint32_t i_run = pi_run_count[*pi_index] - *pi_used;
+        uint32_t i_count = __MIN( i_run, i_sample_count );
 
-        if ( i_index_samples_left )
+        i_sample_count -= i_count;
+        *pi_entries += 1;
+        if( i_count == i_run )
         {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
+            *pi_index += 1;
+            *pi_used = 0;
         }
         else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
+            *pi_used += i_count;
     }
-
-    return VLC_SUCCESS;
+    return true;
 }
 
 static int TrackCreateSamplesIndex( demux_t *p_demux,
@@ -2044,18 +2132,9 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 2: each sample can have a different size, use the box table */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count )
@@ -2088,12 +2167,8 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only points to the runs covering it, and
+     *  timestamps are decoded on demand */
 
     mtime_t i_next_dts = 0;
     /* Find stts
@@ -2111,96 +2186,46 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_used = 0;
+        bool b_short = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* save first dts */
-            ck->i_first_dts = i_next_dts;
-            ck->i_last_dts  = i_next_dts;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            uint32_t i_first;
+
+            /* A short table only covers the first samples: the chunks keep
+             * the runs there are */
+            if( !TrackChunkRuns( ck->i_sample_count, stts->pi_sample_count,
+                                 stts->i_entry_count, &i_index, &i_used,
+                                 &i_first, &ck->i_entries_dts, &ck->i_skip_dts )
+                && !b_short )
             {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
+                msg_Warn( p_demux, "invalid index counting total samples %u %u",
+                          i_index, stts->i_entry_count );
+                b_short = true;
             }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->p_sample_count_dts = &stts->pi_sample_count[i_first];
+            ck->p_sample_delta_dts = (uint32_t *)&stts->pi_sample_delta[i_first];
+
+            /* save first dts, and the one of the last run */
+            ck->i_first_dts = i_next_dts;
+            ck->i_last_dts  = i_next_dts;
 
+            uint32_t i_sample_count = ck->i_sample_count;
             for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
             {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        if ( i_sample_count ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        if ( i_current_index_samples_left ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        if ( i_sample_count ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        if ( stts->pi_sample_count[i_index] ) ck->i_last_dts = i_next_dts;
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
+                uint32_t i_count = ck->p_sample_count_dts[i];
+                if( i == 0 )
+                    i_count -= ck->i_skip_dts;
+                i_count = __MIN( i_count, i_sample_count );
+
+                if( i_count )
+                    ck->i_last_dts = i_next_dts;
+                i_next_dts += (uint64_t)i_count * ck->p_sample_delta_dts[i];
+                i_sample_count -= i_count;
             }
         }
     }
@@ -2216,85 +2241,29 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        /* Create pts-dts table per chunk */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_used = 0;
+        bool b_short = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            uint32_t i_first;
+
+            /* A short table only covers the first samples: the chunks keep
+             * the runs there are */
+            if( !TrackChunkRuns( ck->i_sample_count, ctts->pi_sample_count,
+                                 ctts->i_entry_count, &i_index, &i_used,
+                                 &i_first, &ck->i_entries_pts, &ck->i_skip_pts )
+                && !b_short )
             {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
+                msg_Warn( p_demux, "invalid index counting total samples %u %u",
+                          i_index, ctts->i_entry_count );
+                b_short = true;
             }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
-            }
+            ck->p_sample_count_pts = &ctts->pi_sample_count[i_first];
+            ck->p_sample_offset_pts = &ctts->pi_sample_offset[i_first];
         }
     }
 
@@ -2453,6 +2422,21 @@ static int TrackCreateES( demux_t *p_demux, mp4_track_t *p_track,
     return VLC_SUCCESS;
 }
 
+/* return the chunk containing a sample, using a binary search */
+static uint32_t TrackSampleToChunk( const mp4_track_t *p_track, uint32_t i_sample )
+{
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count - 1;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + ( i_high - i_low + 1 ) / 2;
+        if( p_track->chunk[i_mid].i_sample_first <= i_sample )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
+    }
+    return i_low;
+}
+
 /* given a time it return sample/chunk
  * it also update elst field of the track
  */
@@ -2462,10 +2446,8 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
 {
     demux_sys_t *p_sys = p_demux->p_sys;
     MP4_Box_t   *p_box_stss;
-    uint64_t     i_dts;
     unsigned int i_sample;
     unsigned int i_chunk;
-    int          i_index;
 
     /* FIXME see if it's needed to check p_track->i_chunk_count */
     if( p_track->i_chunk_count == 0 )
@@ -2509,53 +2491,49 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = i_start * p_track->i_timescale / CLOCK_FREQ;
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
-    {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
+    /* binary search of the last chunk starting at or before i_start, the
+       last chunk can't be checked, it will be while searching i_sample */
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count - 1;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + ( i_high - i_low + 1 ) / 2;
+        if( p_track->chunk[i_mid].i_first_dts <= (uint64_t)i_start )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
     }
+    i_chunk = i_low;
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-    for( i_index = 0; i_sample < p_track->chunk[i_chunk].i_sample_count; )
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    uint64_t i_time = (uint64_t)i_start - ck->i_first_dts;
+    uint32_t i_left = ck->i_sample_count;
+
+    i_sample = ck->i_sample_first;
+    for( uint32_t i_index = 0; i_index < ck->i_entries_dts && i_left > 0; i_index++ )
     {
-        if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
-        {
-            i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+        uint32_t i_count = ck->p_sample_count_dts[i_index];
+        if( i_index == 0 )
+            i_count -= ck->i_skip_dts;
+        i_count = __MIN( i_count, i_left );
 
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
-            i_index++;
-        }
-        else
+        uint64_t i_duration = (uint64_t)i_count * ck->p_sample_delta_dts[i_index];
+        if( i_time < i_duration )
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
-            {
-                break;
-            }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+            i_sample += i_time / ck->p_sample_delta_dts[i_index];
             break;
         }
+        i_time -= i_duration;
+        i_sample += i_count;
+        i_left -= i_count;
     }
 
+    /* past the end of the chunk, that's the first sample of the next one */
+    if( i_sample >= ck->i_sample_first + ck->i_sample_count &&
+        i_chunk + 1 < p_track->i_chunk_count )
+        i_chunk++;
+
     if( i_sample >= p_track->i_sample_count )
     {
         msg_Warn( p_demux, "track[Id 0x%x] will be disabled "
@@ -2580,19 +2558,7 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
                 msg_Dbg( p_demux, "stss gives %d --> %d (sample number)",
                          i_sample, i_sync_sample );
 
-                if( i_sync_sample <= i_sample )
-                {
-                    while( i_chunk > 0 &&
-                           i_sync_sample < p_track->chunk[i_chunk].i_sample_first )
-                        i_chunk--;
-                }
-                else
-                {
-                    while( i_chunk < p_track->i_chunk_count - 1 &&
-                           i_sync_sample >= p_track->chunk[i_chunk].i_sample_first +
-                                            p_track->chunk[i_chunk].i_sample_count )
-                        i_chunk++;
-                }
+                i_chunk = TrackSampleToChunk( p_track, i_sync_sample );
                 i_sample = i_sync_sample;
                 break;
             }
@@ -2968,6 +2934,7 @@ static void MP4_TrackCreate( demux_t *p_demux, mp4_track_t *p_track,
     p_track->b_ok = true;
 }
 
+/* Releases the tables of a fragmented chunk */
 static void DestroyChunk( mp4_chunk_t *ck )
 {
     free( ck->p_sample_count_dts );
@@ -2996,11 +2963,7 @@ static void MP4_TrackDestroy( demux_t *p_demux, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( p_demux->out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            DestroyChunk( &p_track->chunk[i_chunk] );
-    }
+    /* moov chunks only reference the sample tables of the boxes */
     free( p_track->chunk );
 
     if( p_track->cchunk )
@@ -3010,11 +2973,11 @@ static void MP4_TrackDestroy( demux_t *p_demux, mp4_track_t *p_track )
         free( p_track->cchunk );
     }
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
+
+    if ( p_track->p_readahead )
+        block_Release( p_track->p_readahead );
 }
 
 static int MP4_TrackSelect( demux_t *p_demux, mp4_track_t *p_track,
@@ -3054,6 +3017,13 @@ static void MP4_TrackUnselect( demux_t *p_demux, mp4_track_t *p_track )
                         p_track->p_es, false );
     }
 
+    /* Up to MP4_READAHEAD_MAX of data that will not be read */
+    if( p_track->p_readahead )
+    {
+        block_Release( p_track->p_readahead );
+        p_track->p_readahead = NULL;
+    }
+
     p_track->b_selected = false;
 }
 
@@ -3719,6 +3689,34 @@ static int ReInitDecoder( demux_t *p_demux, const MP4_Box_t *p_root,
     return VLC_SUCCESS;
 }
 
+/**
+ * Frees the replaced roots that no track was created from any more.
+ */
+static void MP4_FreeOldRoots( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( int i = p_sys->i_old_roots - 1; i >= 0; i-- )
+    {
+        MP4_Box_t *p_old = p_sys->pp_old_roots[i];
+        bool b_used = false;
+
+        for( unsigned j = 0; j < p_sys->i_tracks && !b_used; j++ )
+        {
+            const MP4_Box_t *p_box = p_sys->track[j].p_track;
+            while( p_box != NULL && p_box->p_father != NULL )
+                p_box = p_box->p_father;
+            b_used = p_box == p_old;
+        }
+
+        if( !b_used )
+        {
+            TAB_REMOVE( p_sys->i_old_roots, p_sys->pp_old_roots, p_old );
+            MP4_BoxFree( p_demux->s, p_old );
+        }
+    }
+}
+
 /**
  * This function fills a mp4_chunk_t structure from a MP4_Box_t (p_chunk).
  * The 'i_tk_id' argument returns the ID of the track the chunk belongs to.
@@ -3882,6 +3880,7 @@ static int MP4_frg_GetChunk( demux_t *p_demux, MP4_Box_t *p_chunk, unsigned *i_t
     {
         ReInitDecoder( p_demux, p_demux->p_sys->p_root, p_track );
         p_track->b_codec_need_restart = false;
+        MP4_FreeOldRoots( p_demux );
     }
 
     /* Skip if we didn't reach the end of mdat box */
@@ -3918,8 +3917,10 @@ static int MP4_frg_GetChunks( demux_t *p_demux, const unsigned i_tk_id )
         uint32_t tid = 0;
         if( i_type == ATOM_uuid || i_type == ATOM_ftyp )
         {
-            MP4_BoxFree( p_demux->s, p_sys->p_root );
+            TAB_APPEND( p_sys->i_old_roots, p_sys->pp_old_roots,
+                        p_sys->p_root );
             p_sys->p_root = p_chunk;
+            MP4_FreeOldRoots( p_demux );
 
             if( i_type == ATOM_ftyp ) /* DASH */
             {
@@ -4766,26 +4767,7 @@ static int LeafMOOVGetSamplesSize( const mp4_track_t *p_track, const uint32_t i_
 
 static inline mtime_t LeafGetMOOVTimeInChunk( const mp4_chunk_t *p_chunk, uint32_t i_sample )
 {
-    mtime_t i_time = 0;
-    uint32_t i_index = 0;
-
-    while( i_sample > 0 )
-    {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
-        {
-            i_time += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index];
-            i_index++;
-        }
-        else
-        {
-            i_time += i_sample * p_chunk->p_sample_delta_dts[i_index];
-            break;
-        }
-    }
-
-    return i_time;
+    return MP4_ChunkGetDTSOffset( p_chunk, i_sample );
 }
 
 static int LeafParseMDATwithMOOV( demux_t *p_demux )
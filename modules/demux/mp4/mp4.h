@@ -49,11 +49,18 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_last_dts;    /* DTS of the last sample */
 
+    /* Runs of the stts and ctts tables covering this chunk. For chunks
+     * of the moov, they point into the boxes and are not owned: the first
+     * run may have been partly used by the previous chunk (i_skip_*) and
+     * the last one may extend past this chunk. Fragmented chunks own
+     * tables of one entry per sample. */
     uint32_t     i_entries_dts;
+    uint32_t     i_skip_dts;
     uint32_t     *p_sample_count_dts;
     uint32_t     *p_sample_delta_dts;   /* dts delta */
 
     uint32_t     i_entries_pts;
+    uint32_t     i_skip_pts;
     uint32_t     *p_sample_count_pts;
     int32_t      *p_sample_offset_pts;  /* pts-dts */
 
@@ -110,14 +117,17 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* points into the stsz box */
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
     uint64_t     i_first_dts;    /* i_first_dts value
                                                    of the next chunk */
 
+    /* data read ahead at i_readahead_pos, when the file is not interleaved */
+    block_t         *p_readahead;
+    uint64_t        i_readahead_pos;
+
     const MP4_Box_t *p_track;
     const MP4_Box_t *p_stbl;  /* will contain all timing information */
     const MP4_Box_t *p_stsd;  /* will contain all data to initialize decoder */
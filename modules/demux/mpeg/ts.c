@@ -42,6 +42,7 @@
 #include <vlc_epg.h>
 #include <vlc_charset.h>   /* FromCharset, for EIT */
 #include <vlc_bits.h>
+#include <vlc_interrupt.h>
 
 #include "../../mux/mpeg/csa.h"
 
@@ -72,6 +73,7 @@
 
 #include "pes.h"
 #include "mpeg4_iod.h"
+#include "../index_cache.h"
 
 #ifdef HAVE_ARIBB24
  #include <aribb24/aribb24.h>
@@ -134,6 +136,17 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define SEEK_INDEX_TEXT N_("Seek using a PCR index")
+#define SEEK_INDEX_LONGTEXT N_( \
+    "Remember the file position of PCRs while playing, and use them to seek " \
+    "without searching through the whole file." )
+
+#define SEEK_INDEX_BUILD_TEXT N_("Build a complete seek index")
+#define SEEK_INDEX_BUILD_LONGTEXT N_( \
+    "Scan the whole file when opening it to build a complete seek index. " \
+    "As the index of local files is cached, this allows indexing archives " \
+    "ahead of playback." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -169,6 +182,8 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-seek-index", true, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT, true )
+    add_bool( "ts-seek-index-build", false, SEEK_INDEX_BUILD_TEXT, SEEK_INDEX_BUILD_LONGTEXT, true )
 
     add_integer( "ts-arib", ARIBMODE_AUTO, SUPPORT_ARIB_TEXT, SUPPORT_ARIB_LONGTEXT, false )
         change_integer_list( arib_mode_list, arib_mode_list_text )
@@ -304,6 +319,38 @@ enum
 #define SEEN(x) ((x)->i_flags & FLAG_SEEN)
 #define SCRAMBLED(x) ((x).i_flags & FLAG_SCRAMBLED)
 
+/* TR 101 290 thresholds */
+#define STATS_PCR_INTERVAL_MAX      (CLOCK_FREQ / 25)   /* 40ms */
+#define STATS_PCR_DISCONTINUITY_MAX (CLOCK_FREQ / 10)   /* 100ms */
+#define STATS_PSI_INTERVAL_MAX      (CLOCK_FREQ / 2)    /* 500ms */
+#define STATS_PCR_WINDOW            (INT64_C(27000000) * 10)
+
+typedef struct
+{
+    uint64_t    i_packets;
+    uint64_t    i_cc_errors;
+    uint64_t    i_scrambled;
+    uint8_t     i_cc;       /* 0xff if unknown */
+
+    /* PCR, in 27MHz units. The reference is the start of a ~10s window
+     * used to estimate the multiplex rate */
+    bool        b_pcr;
+    uint64_t    i_pcr;
+    uint64_t    i_pcr_errors;
+    mtime_t     i_pcr_interval_max;
+    mtime_t     i_pcr_accuracy_max;
+    int64_t     i_pcr_ref;
+    uint64_t    i_pcr_ref_pkt;
+    int64_t     i_pcr_prev;
+    uint64_t    i_pcr_prev_pkt;
+
+    /* PSI sections (PAT/PMT), on the stats clock */
+    uint64_t    i_sections;
+    uint64_t    i_section_errors;
+    mtime_t     i_section_interval_max;
+    mtime_t     i_section_last; /* -1 if none */
+} ts_pid_stats_t;
+
 struct ts_pid_t
 {
     uint16_t    i_pid;
@@ -332,6 +379,7 @@ struct ts_pid_t
         int i_pcr_count;
     } probed;
 
+    ts_pid_stats_t stats;
 };
 
 typedef struct
@@ -339,6 +387,30 @@ typedef struct
     int i_service;
 } vdr_info_t;
 
+/* PCR positions of one PCR pid, sorted by offset. PCRs are in 90kHz units */
+typedef struct
+{
+    int64_t  i_pcr;
+    uint64_t i_offset;
+} ts_index_point_t;
+
+typedef struct
+{
+    uint16_t i_pid;
+    int64_t  i_last_pcr;    /* last PCR seen, valid if the index is complete */
+    size_t   i_count;
+    size_t   i_alloc;
+    ts_index_point_t *p_points;
+} ts_index_track_t;
+
+typedef struct
+{
+    unsigned i_tracks;
+    ts_index_track_t *p_tracks;
+    bool     b_complete;    /* built from a full scan of the file */
+    bool     b_dirty;       /* changed since loaded */
+} ts_index_t;
+
 #define MIN_ES_PID 4    /* Should be 32.. broken muxers */
 #define MAX_ES_PID 8190
 #define MIN_PAT_INTERVAL CLOCK_FREQ // DVB is 500ms
@@ -432,6 +504,23 @@ struct demux_sys_t
 
     vdr_info_t  vdr;
 
+    /* Analysis */
+    struct
+    {
+        uint64_t i_packets;
+        uint64_t i_sync_losses;
+        uint16_t i_clock_pid; /* PCR pid driving the clock, 0 if none yet */
+        mtime_t  i_clock;     /* monotonic, built from PCR deltas */
+    } stats;
+
+    /* PCR positions for seeking */
+    struct
+    {
+        bool       b_enabled;
+        ts_index_t index;
+        char      *psz_file;  /* local path for the index cache, or NULL */
+    } seekindex;
+
     /* */
     bool        b_start_record;
 };
@@ -452,6 +541,12 @@ static void PSINewTableCallBack( dvbpsi_t *handle, uint8_t  i_table_id,
 static int ChangeKeyCallback( vlc_object_t *, char const *, vlc_value_t, vlc_value_t, void * );
 
 /* Structs */
+static inline void PIDStatsInit( ts_pid_stats_t *p_stats )
+{
+    p_stats->i_cc = 0xff;
+    p_stats->i_section_last = -1;
+}
+
 static ts_pat_t *ts_pat_New( demux_t * );
 static void ts_pat_Del( demux_t *, ts_pat_t * );
 static ts_pmt_t *ts_pmt_New( demux_t * );
@@ -484,6 +579,15 @@ static int SeekToTime( demux_t *p_demux, ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, block_t * );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
+static void PIDStatsPacket( demux_sys_t *, ts_pid_t *, const uint8_t * );
+
+static void IndexOpen( demux_t * );
+static void IndexBuild( demux_t * );
+static void IndexClose( demux_t * );
+static void IndexPacket( demux_t *, block_t * );
+static const ts_index_point_t *IndexFind( const ts_index_t *, uint16_t, int64_t,
+                                          int64_t, const ts_index_point_t ** );
+static demux_ts_stats_t *StatsGet( demux_sys_t * );
 static int64_t TimeStampWrapAround( ts_pmt_t *, int64_t );
 
 /* MPEG4 related */
@@ -999,6 +1103,8 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->pids.dummy.i_pid = 8191;
     p_sys->pids.dummy.i_flags = FLAG_SEEN;
+    PIDStatsInit( &p_sys->pids.dummy.stats );
+    PIDStatsInit( &p_sys->pids.pat.stats );
 
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
@@ -1131,6 +1237,8 @@ static int Open( vlc_object_t *p_this )
     stream_Control( p_sys->stream, STREAM_CAN_SEEK, &p_sys->b_canseek );
     stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK, &p_sys->b_canfastseek );
 
+    IndexOpen( p_demux );
+
     /* Preparse time */
     if( p_sys->b_canseek )
     {
@@ -1154,6 +1262,8 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    IndexClose( p_demux );
+
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
     if( p_sys->b_dvb_meta )
@@ -1255,6 +1365,8 @@ static int Demux( demux_t *p_demux )
 
         /* Parse the TS packet */
         ts_pid_t *p_pid = GetPID( p_sys, PIDGet( p_pkt ) );
+        PIDStatsPacket( p_sys, p_pid, p_pkt->p_buffer );
+        IndexPacket( p_demux, p_pkt );
 
         if( (p_pkt->p_buffer[1] & 0x40) && (p_pkt->p_buffer[3] & 0x10) &&
             !SCRAMBLED(*p_pid) != !(p_pkt->p_buffer[3] & 0x80) )
@@ -1680,6 +1792,14 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     case DEMUX_GET_SIGNAL:
         return stream_vaControl( p_sys->stream, STREAM_GET_SIGNAL, args );
 
+    case DEMUX_GET_TS_STATS:
+    {
+        demux_ts_stats_t **pp_stats = va_arg( args, demux_ts_stats_t ** );
+
+        *pp_stats = StatsGet( p_sys );
+        return *pp_stats ? VLC_SUCCESS : VLC_ENOMEM;
+    }
+
     default:
         break;
     }
@@ -1835,6 +1955,7 @@ static void PIDReset( ts_pid_t *pid )
 {
     assert(pid->i_refcount == 0);
     pid->i_cc       = 0xff;
+    pid->stats.i_cc = 0xff;
     pid->i_flags    &= ~FLAG_SCRAMBLED;
     pid->p_parent    = NULL;
     pid->type = TYPE_FREE;
@@ -2523,6 +2644,7 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     if( p_pkt->p_buffer[0] != 0x47 )
     {
         msg_Warn( p_demux, "lost synchro" );
+        p_sys->stats.i_sync_losses++;
         block_Release( p_pkt );
         for( ;; )
         {
@@ -2641,6 +2763,15 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    /* Analysis counters must not see the seek as stream errors */
+    for( int i = -1; i < p_sys->pids.i_all; i++ )
+    {
+        ts_pid_t *pid = ( i < 0 ) ? &p_sys->pids.pat : p_sys->pids.pp_all[i];
+        pid->stats.i_cc = 0xff;
+        pid->stats.b_pcr = false;
+        pid->stats.i_section_last = -1;
+    }
+
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
     for( int i=0; i< p_pat->programs.i_size; i++ )
     {
@@ -2693,6 +2824,23 @@ static int SeekToTime( demux_t *p_demux, ts_pmt_t *p_pmt, int64_t i_scaledtime )
     /* Find the time position by using binary search algorithm. */
     int64_t i_head_pos = 0;
     int64_t i_tail_pos = stream_Size( p_sys->stream ) - p_sys->i_packet_size;
+
+    /* Narrow the search to the indexed points around the target */
+    const ts_index_point_t *p_point = NULL, *p_next = NULL;
+    if( p_sys->seekindex.b_enabled )
+        p_point = IndexFind( &p_sys->seekindex.index, p_pmt->i_pid_pcr,
+                             i_scaledtime, p_pmt->pcr.i_first, &p_next );
+    if( p_point )
+    {
+        if( i_scaledtime - TimeStampWrapAround( p_pmt, p_point->i_pcr )
+                < TO_SCALE(VLC_TS_0 + CLOCK_FREQ / 2) )
+            return stream_Seek( p_sys->stream, p_point->i_offset );
+
+        i_head_pos = p_point->i_offset;
+        if( p_next && (int64_t) p_next->i_offset < i_tail_pos )
+            i_tail_pos = p_next->i_offset;
+    }
+
     if( i_head_pos >= i_tail_pos )
         return VLC_EGENERIC;
 
@@ -2769,6 +2917,9 @@ static int SeekToTime( demux_t *p_demux, ts_pmt_t *p_pmt, int64_t i_scaledtime )
             i_tail_pos = i_splitpos - p_sys->i_packet_size;
     }
 
+    if( !b_found && p_point )
+        return stream_Seek( p_sys->stream, p_point->i_offset );
+
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
@@ -2820,6 +2971,7 @@ static ts_pid_t *GetPID( demux_sys_t *p_sys, uint16_t i_pid )
     }
 
     p_pid->i_pid = i_pid;
+    PIDStatsInit( &p_pid->stats );
     p_sys->pids.pp_all[p_sys->pids.i_all++] = p_pid;
 
     p_sys->pids.p_last = p_pid;
@@ -3155,6 +3307,608 @@ static void PCRFixHandle( demux_t *p_demux, ts_pmt_t *p_pmt, block_t *p_block )
     }
 }
 
+/*****************************************************************************
+ * Analysis counters
+ *****************************************************************************/
+static int64_t PCRDelta( int64_t i_from, int64_t i_to )
+{
+    int64_t i_delta = i_to - i_from;
+    if( i_delta < 0 ) /* 33 bits base wrap */
+        i_delta += INT64_C(300) << 33;
+    return i_delta;
+}
+
+static void PIDStatsPCR( demux_sys_t *p_sys, ts_pid_t *pid, const uint8_t *p )
+{
+    ts_pid_stats_t *p_stats = &pid->stats;
+    const uint64_t i_pkt = p_sys->stats.i_packets;
+    const int64_t i_pcr = 300 * (( (int64_t)p[6] << 25 ) |
+                                 ( (int64_t)p[7] << 17 ) |
+                                 ( (int64_t)p[8] << 9 ) |
+                                 ( (int64_t)p[9] << 1 ) |
+                                 ( (int64_t)p[10] >> 7 ))
+                          + (((p[10] & 0x01) << 8) | p[11]);
+
+    p_stats->i_pcr++;
+    if( p_sys->stats.i_clock_pid == 0 )
+        p_sys->stats.i_clock_pid = pid->i_pid;
+
+    if( p_stats->b_pcr && !(p[5] & 0x80) /* discontinuity_indicator */ )
+    {
+        const int64_t i_delta = PCRDelta( p_stats->i_pcr_prev, i_pcr );
+        const mtime_t i_interval = i_delta / 27;
+
+        if( i_interval > STATS_PCR_DISCONTINUITY_MAX )
+        {
+            /* unsignaled jump, restart the rate estimation */
+            p_stats->i_pcr_errors++;
+            p_stats->i_pcr_ref = i_pcr;
+            p_stats->i_pcr_ref_pkt = i_pkt;
+        }
+        else
+        {
+            if( i_interval > p_stats->i_pcr_interval_max )
+                p_stats->i_pcr_interval_max = i_interval;
+            if( i_interval > STATS_PCR_INTERVAL_MAX )
+                p_stats->i_pcr_errors++;
+
+            /* Compare against the position predicted by the rate of the
+             * current window (constant bitrate assumption) */
+            const int64_t i_window = PCRDelta( p_stats->i_pcr_ref,
+                                               p_stats->i_pcr_prev );
+            if( p_stats->i_pcr_prev_pkt > p_stats->i_pcr_ref_pkt && i_window > 0 )
+            {
+                int64_t i_expected = (int64_t)(i_pkt - p_stats->i_pcr_prev_pkt) * i_window
+                                   / (int64_t)(p_stats->i_pcr_prev_pkt - p_stats->i_pcr_ref_pkt);
+                mtime_t i_accuracy = llabs( i_delta - i_expected ) * 1000 / 27;
+                if( i_accuracy > p_stats->i_pcr_accuracy_max )
+                    p_stats->i_pcr_accuracy_max = i_accuracy;
+            }
+            if( i_window > STATS_PCR_WINDOW )
+            {
+                p_stats->i_pcr_ref = p_stats->i_pcr_prev;
+                p_stats->i_pcr_ref_pkt = p_stats->i_pcr_prev_pkt;
+            }
+
+            if( p_sys->stats.i_clock_pid == pid->i_pid )
+                p_sys->stats.i_clock += i_interval;
+        }
+    }
+    else
+    {
+        p_stats->i_pcr_ref = i_pcr;
+        p_stats->i_pcr_ref_pkt = i_pkt;
+        p_stats->b_pcr = true;
+    }
+    p_stats->i_pcr_prev = i_pcr;
+    p_stats->i_pcr_prev_pkt = i_pkt;
+}
+
+static void PIDStatsSection( demux_sys_t *p_sys, ts_pid_stats_t *p_stats )
+{
+    p_stats->i_sections++;
+    if( p_sys->stats.i_clock_pid == 0 )
+        return; /* no timebase yet */
+
+    if( p_stats->i_section_last >= 0 )
+    {
+        mtime_t i_interval = p_sys->stats.i_clock - p_stats->i_section_last;
+        if( i_interval > p_stats->i_section_interval_max )
+            p_stats->i_section_interval_max = i_interval;
+        if( i_interval > STATS_PSI_INTERVAL_MAX )
+            p_stats->i_section_errors++;
+    }
+    p_stats->i_section_last = p_sys->stats.i_clock;
+}
+
+static void PIDStatsPacket( demux_sys_t *p_sys, ts_pid_t *pid, const uint8_t *p )
+{
+    ts_pid_stats_t *p_stats = &pid->stats;
+    const bool b_adaptation = p[3] & 0x20;
+    const bool b_payload = p[3] & 0x10;
+    const uint8_t i_cc = p[3] & 0x0f;
+
+    p_sys->stats.i_packets++;
+    p_stats->i_packets++;
+    if( p[3] & 0xc0 )
+        p_stats->i_scrambled++;
+
+    if( pid->i_pid == 0x1FFF )
+        return;
+
+    /* Continuity: +1 with payload, unchanged without payload,
+     * or a single duplicate packet */
+    if( b_adaptation && p[4] > 0 && (p[5] & 0x80) )
+        p_stats->i_cc = 0xff; /* discontinuity_indicator */
+    if( p_stats->i_cc != 0xff && i_cc != p_stats->i_cc &&
+        ( !b_payload || i_cc != ((p_stats->i_cc + 1) & 0x0f) ) )
+        p_stats->i_cc_errors++;
+    p_stats->i_cc = i_cc;
+
+    if( b_adaptation && p[4] >= 7 && (p[5] & 0x10) )
+        PIDStatsPCR( p_sys, pid, p );
+
+    if( (p[1] & 0x40) && b_payload &&
+        ( pid->type == TYPE_PAT || pid->type == TYPE_PMT ) )
+        PIDStatsSection( p_sys, p_stats );
+}
+
+/*****************************************************************************
+ * Seek index
+ *****************************************************************************/
+/* Spacing between points, in 90kHz units */
+#define INDEX_RAP_SPACING   (1 * 90000)
+#define INDEX_PCR_SPACING   (5 * 90000)
+/* Maximum distance a point may be from the seek target */
+#define INDEX_MAX_GAP       (10 * 90000)
+#define INDEX_MAX_POINTS    (1 << 24)
+
+static void IndexInit( ts_index_t *p_index )
+{
+    p_index->i_tracks = 0;
+    p_index->p_tracks = NULL;
+    p_index->b_complete = false;
+    p_index->b_dirty = false;
+}
+
+static void IndexClean( ts_index_t *p_index )
+{
+    for( unsigned i = 0; i < p_index->i_tracks; i++ )
+        free( p_index->p_tracks[i].p_points );
+    free( p_index->p_tracks );
+    IndexInit( p_index );
+}
+
+static ts_index_track_t * IndexGetTrack( const ts_index_t *p_index, uint16_t i_pid )
+{
+    for( unsigned i = 0; i < p_index->i_tracks; i++ )
+        if( p_index->p_tracks[i].i_pid == i_pid )
+            return &p_index->p_tracks[i];
+    return NULL;
+}
+
+static ts_index_track_t * IndexAddTrack( ts_index_t *p_index, uint16_t i_pid )
+{
+    ts_index_track_t *p_track = IndexGetTrack( p_index, i_pid );
+    if( p_track )
+        return p_track;
+
+    p_track = realloc( p_index->p_tracks,
+                       (p_index->i_tracks + 1) * sizeof(*p_track) );
+    if( !p_track )
+        return NULL;
+    p_index->p_tracks = p_track;
+
+    p_track = &p_index->p_tracks[p_index->i_tracks++];
+    p_track->i_pid = i_pid;
+    p_track->i_last_pcr = -1;
+    p_track->i_count = 0;
+    p_track->i_alloc = 0;
+    p_track->p_points = NULL;
+    return p_track;
+}
+
+/* Returns the index of the first point with an offset greater than i_offset */
+static size_t IndexUpperBound( const ts_index_track_t *p_track, uint64_t i_offset )
+{
+    size_t lo = 0, hi = p_track->i_count;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_track->p_points[mid].i_offset <= i_offset )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int64_t IndexPCRDistance( int64_t a, int64_t b )
+{
+    int64_t i_diff = llabs( a - b );
+    /* 33 bits wrap */
+    if( i_diff > 0x100000000LL )
+        i_diff = 0x200000000LL - i_diff;
+    return i_diff;
+}
+
+/* Records a PCR position. Points closer than 1s (random access points) or
+ * 5s (other PCRs) to an existing neighbour are dropped. */
+static void IndexAdd( ts_index_t *p_index, uint16_t i_pid, int64_t i_pcr,
+                      uint64_t i_offset, bool b_random_access )
+{
+    ts_index_track_t *p_track = IndexAddTrack( p_index, i_pid );
+    if( !p_track )
+        return;
+
+    if( !p_index->b_complete )
+        p_track->i_last_pcr = i_pcr;
+
+    const int64_t i_spacing = b_random_access ? INDEX_RAP_SPACING
+                                              : INDEX_PCR_SPACING;
+    size_t i_pos = IndexUpperBound( p_track, i_offset );
+    if( i_pos > 0 )
+    {
+        const ts_index_point_t *p_prev = &p_track->p_points[i_pos - 1];
+        if( p_prev->i_offset == i_offset ||
+            IndexPCRDistance( p_prev->i_pcr, i_pcr ) < i_spacing )
+            return;
+    }
+    if( i_pos < p_track->i_count &&
+        IndexPCRDistance( p_track->p_points[i_pos].i_pcr, i_pcr ) < i_spacing )
+        return;
+
+    if( p_track->i_count == p_track->i_alloc )
+    {
+        if( p_track->i_alloc >= INDEX_MAX_POINTS )
+            return;
+        size_t i_alloc = p_track->i_alloc ? p_track->i_alloc * 2 : 64;
+        ts_index_point_t *p_realloc = realloc( p_track->p_points,
+                                               i_alloc * sizeof(*p_realloc) );
+        if( !p_realloc )
+            return;
+        p_track->p_points = p_realloc;
+        p_track->i_alloc = i_alloc;
+    }
+
+    memmove( &p_track->p_points[i_pos + 1], &p_track->p_points[i_pos],
+             (p_track->i_count - i_pos) * sizeof(*p_track->p_points) );
+    p_track->p_points[i_pos].i_pcr = i_pcr;
+    p_track->p_points[i_pos].i_offset = i_offset;
+    p_track->i_count++;
+    p_index->b_dirty = true;
+}
+
+static int64_t IndexUnwrap( int64_t i_pcr, int64_t i_first_pcr )
+{
+    if( i_first_pcr > 0x0FFFFFFFF && i_pcr < 0x0FFFFFFFF )
+        i_pcr += 0x1FFFFFFFF;
+    return i_pcr;
+}
+
+/* Returns the last point at or before i_pcr, or NULL if that part of the
+ * file is not indexed. *pp_next is set to the following point when the
+ * target lies between both, NULL otherwise. Points below 2^32 are unwrapped
+ * when i_first_pcr is above, as TimeStampWrapAround() does. */
+static const ts_index_point_t *IndexFind( const ts_index_t *p_index,
+                                          uint16_t i_pid, int64_t i_pcr,
+                                          int64_t i_first_pcr,
+                                          const ts_index_point_t **pp_next )
+{
+    const ts_index_track_t *p_track = IndexGetTrack( p_index, i_pid );
+    if( !p_track || p_track->i_count == 0 )
+        return NULL;
+
+    /* Points are sorted by offset, and therefore by unwrapped PCR */
+    size_t lo = 0, hi = p_track->i_count;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( IndexUnwrap( p_track->p_points[mid].i_pcr, i_first_pcr ) <= i_pcr )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if( lo == 0 )
+        return NULL;
+
+    const ts_index_point_t *p_point = &p_track->p_points[lo - 1];
+    const ts_index_point_t *p_next = NULL;
+    int64_t i_gap = i_pcr - IndexUnwrap( p_point->i_pcr, i_first_pcr );
+
+    if( lo < p_track->i_count )
+    {
+        p_next = &p_track->p_points[lo];
+        if( IndexUnwrap( p_next->i_pcr, i_first_pcr ) -
+            IndexUnwrap( p_point->i_pcr, i_first_pcr ) > INDEX_MAX_GAP )
+            p_next = NULL;
+    }
+
+    /* Only trust the point if the index covers the target. Otherwise,
+     * the file part after the point was never indexed */
+    if( !p_next && i_gap > INDEX_PCR_SPACING &&
+        ( !p_index->b_complete || i_gap > INDEX_MAX_GAP ) )
+        return NULL;
+
+    *pp_next = p_next;
+    return p_point;
+}
+
+/* Indexes are cached as the packet size, flags and track count, then for
+ * each track its pid, last PCR and point count followed by the points */
+#define TS_INDEX_CACHE          "ts-1"
+#define TS_INDEX_HEADER_SIZE    (4 + 4 + 4)
+#define TS_INDEX_TRACK_SIZE     (2 + 2 + 8 + 4)
+#define TS_INDEX_POINT_SIZE     (8 + 8)
+#define TS_INDEX_MAX_TRACKS     0x2000
+#define TS_INDEX_FLAG_COMPLETE  0x01
+
+static bool IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint64_t i_stream_size = stream_Size( p_sys->stream );
+    size_t i_size;
+
+    uint8_t *p_data = index_cache_Load( VLC_OBJECT(p_demux),
+                                        p_sys->seekindex.psz_file,
+                                        TS_INDEX_CACHE, &i_size );
+    if( !p_data )
+        return false;
+
+    ts_index_t index;
+    IndexInit( &index );
+
+    const uint8_t *p = p_data;
+    if( i_size < TS_INDEX_HEADER_SIZE ||
+        GetDWBE( &p[0] ) != p_sys->i_packet_size ||
+        GetDWBE( &p[8] ) > TS_INDEX_MAX_TRACKS )
+        goto error;
+    const uint32_t i_flags = GetDWBE( &p[4] );
+    const uint32_t i_tracks = GetDWBE( &p[8] );
+    p += TS_INDEX_HEADER_SIZE;
+    i_size -= TS_INDEX_HEADER_SIZE;
+
+    for( uint32_t i = 0; i < i_tracks; i++ )
+    {
+        if( i_size < TS_INDEX_TRACK_SIZE )
+            goto error;
+        const uint32_t i_count = GetDWBE( &p[12] );
+        if( i_count > INDEX_MAX_POINTS ||
+            (i_size - TS_INDEX_TRACK_SIZE) / TS_INDEX_POINT_SIZE < i_count )
+            goto error;
+
+        ts_index_track_t *p_track = IndexAddTrack( &index, GetWBE( &p[0] ) );
+        if( !p_track || p_track->i_count )
+            goto error;
+        p_track->i_last_pcr = GetQWBE( &p[4] );
+        p += TS_INDEX_TRACK_SIZE;
+        i_size -= TS_INDEX_TRACK_SIZE;
+        if( i_count == 0 )
+            continue;
+
+        p_track->p_points = malloc( i_count * sizeof(*p_track->p_points) );
+        if( !p_track->p_points )
+            goto error;
+        p_track->i_alloc = i_count;
+
+        for( uint32_t j = 0; j < i_count; j++ )
+        {
+            ts_index_point_t *p_point = &p_track->p_points[j];
+            p_point->i_pcr = GetQWBE( &p[0] );
+            p_point->i_offset = GetQWBE( &p[8] );
+            if( p_point->i_offset >= i_stream_size ||
+                (j > 0 && p_point->i_offset <= p_point[-1].i_offset) )
+                goto error;
+            p_track->i_count++;
+            p += TS_INDEX_POINT_SIZE;
+            i_size -= TS_INDEX_POINT_SIZE;
+        }
+    }
+    free( p_data );
+
+    index.b_complete = i_flags & TS_INDEX_FLAG_COMPLETE;
+    IndexClean( &p_sys->seekindex.index );
+    p_sys->seekindex.index = index;
+    return true;
+
+error:
+    msg_Warn( p_demux, "invalid cached index" );
+    IndexClean( &index );
+    free( p_data );
+    return false;
+}
+
+static void IndexCacheSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const ts_index_t *p_index = &p_sys->seekindex.index;
+
+    size_t i_size = TS_INDEX_HEADER_SIZE;
+    for( unsigned i = 0; i < p_index->i_tracks; i++ )
+        i_size += TS_INDEX_TRACK_SIZE +
+                  p_index->p_tracks[i].i_count * TS_INDEX_POINT_SIZE;
+
+    uint8_t *p_data = malloc( i_size );
+    if( !p_data )
+        return;
+
+    uint8_t *p = p_data;
+    SetDWBE( &p[0], p_sys->i_packet_size );
+    SetDWBE( &p[4], p_index->b_complete ? TS_INDEX_FLAG_COMPLETE : 0 );
+    SetDWBE( &p[8], p_index->i_tracks );
+    p += TS_INDEX_HEADER_SIZE;
+    for( unsigned i = 0; i < p_index->i_tracks; i++ )
+    {
+        const ts_index_track_t *p_track = &p_index->p_tracks[i];
+
+        SetWBE( &p[0], p_track->i_pid );
+        SetWBE( &p[2], 0 );
+        SetQWBE( &p[4], p_track->i_last_pcr );
+        SetDWBE( &p[12], p_track->i_count );
+        p += TS_INDEX_TRACK_SIZE;
+        for( size_t j = 0; j < p_track->i_count; j++ )
+        {
+            SetQWBE( &p[0], p_track->p_points[j].i_pcr );
+            SetQWBE( &p[8], p_track->p_points[j].i_offset );
+            p += TS_INDEX_POINT_SIZE;
+        }
+    }
+
+    index_cache_Save( VLC_OBJECT(p_demux), p_sys->seekindex.psz_file,
+                      TS_INDEX_CACHE, p_data, i_size );
+    free( p_data );
+}
+
+static void IndexOpen( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    IndexInit( &p_sys->seekindex.index );
+    p_sys->seekindex.psz_file = NULL;
+    p_sys->seekindex.b_enabled = p_sys->b_canseek &&
+                                 var_InheritBool( p_demux, "ts-seek-index" );
+    if( !p_sys->seekindex.b_enabled )
+        return;
+
+    p_sys->seekindex.psz_file = index_cache_GetPath( p_demux );
+    if( p_sys->seekindex.psz_file && IndexCacheLoad( p_demux ) )
+        msg_Dbg( p_demux, "using cached seek index" );
+
+    if( !p_sys->seekindex.index.b_complete &&
+        var_InheritBool( p_demux, "ts-seek-index-build" ) )
+        IndexBuild( p_demux );
+}
+
+/* Scans the whole file for PCRs */
+static void IndexBuild( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const int64_t i_initial_pos = stream_Tell( p_sys->stream );
+    block_t *p_pkt;
+
+    msg_Dbg( p_demux, "building seek index" );
+
+    while( !vlc_killed() && (p_pkt = ReadTSPacket( p_demux )) )
+    {
+        IndexPacket( p_demux, p_pkt );
+        block_Release( p_pkt );
+    }
+
+    if( stream_Tell( p_sys->stream ) == stream_Size( p_sys->stream ) )
+    {
+        p_sys->seekindex.index.b_complete = true;
+        p_sys->seekindex.index.b_dirty = true;
+    }
+
+    stream_Seek( p_sys->stream, i_initial_pos );
+}
+
+static void IndexClose( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->seekindex.psz_file && p_sys->seekindex.index.b_dirty )
+        IndexCacheSave( p_demux );
+
+    free( p_sys->seekindex.psz_file );
+    IndexClean( &p_sys->seekindex.index );
+}
+
+static void IndexPacket( demux_t *p_demux, block_t *p_pkt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->seekindex.b_enabled )
+        return;
+
+    const mtime_t i_pcr = GetPCR( p_pkt );
+    if( i_pcr < 0 )
+        return;
+
+    const int64_t i_pos = stream_Tell( p_sys->stream ) - p_sys->i_packet_size;
+    if( i_pos < 0 )
+        return;
+
+    /* random_access_indicator */
+    const bool b_rap = p_pkt->p_buffer[5] & 0x40;
+    IndexAdd( &p_sys->seekindex.index, PIDGet( p_pkt ), i_pcr, i_pos, b_rap );
+}
+
+/* Multiplex rate from the window of the clock PCR pid */
+static uint64_t StatsBitrate( demux_sys_t *p_sys )
+{
+    if( p_sys->stats.i_clock_pid == 0 )
+        return 0;
+
+    const ts_pid_stats_t *p_stats = &GetPID( p_sys, p_sys->stats.i_clock_pid )->stats;
+    const int64_t i_window = PCRDelta( p_stats->i_pcr_ref, p_stats->i_pcr_prev );
+    if( !p_stats->b_pcr || i_window <= 0 )
+        return 0;
+
+    return (p_stats->i_pcr_prev_pkt - p_stats->i_pcr_ref_pkt) *
+           TS_PACKET_SIZE_188 * 8 * INT64_C(27000000) / i_window;
+}
+
+/* PIDs in report order: PAT (-1), then all the others, then null (i_all) */
+static ts_pid_t *StatsPID( demux_sys_t *p_sys, int i )
+{
+    if( i < 0 )
+        return &p_sys->pids.pat;
+    if( i < p_sys->pids.i_all )
+        return p_sys->pids.pp_all[i];
+    return &p_sys->pids.dummy;
+}
+
+static demux_ts_stats_t *StatsGet( demux_sys_t *p_sys )
+{
+    unsigned i_pids = 0;
+    ts_pat_t *p_pat = NULL;
+
+    /* Only the PIDs seen in the stream are reported */
+    for( int i = -1; i <= p_sys->pids.i_all; i++ )
+        if( StatsPID( p_sys, i )->stats.i_packets )
+            i_pids++;
+
+    if( GetPID( p_sys, 0 )->type == TYPE_PAT )
+        p_pat = GetPID( p_sys, 0 )->u.p_pat;
+    const unsigned i_programs = p_pat ? p_pat->programs.i_size : 0;
+
+    demux_ts_stats_t *p_ts_stats = malloc( sizeof(*p_ts_stats)
+                                 + i_pids * sizeof(demux_ts_pid_stats_t)
+                                 + i_programs * sizeof(demux_ts_program_stats_t) );
+    if( !p_ts_stats )
+        return NULL;
+
+    const ts_pid_stats_t *p_pat_stats = &p_sys->pids.pat.stats;
+    p_ts_stats->i_packets = p_sys->stats.i_packets;
+    p_ts_stats->i_sync_losses = p_sys->stats.i_sync_losses;
+    p_ts_stats->i_bitrate = StatsBitrate( p_sys );
+    p_ts_stats->i_pat = p_pat_stats->i_sections;
+    p_ts_stats->i_pat_errors = p_pat_stats->i_section_errors;
+    p_ts_stats->i_pat_interval_max = p_pat_stats->i_section_interval_max;
+
+    p_ts_stats->i_pids = i_pids;
+    p_ts_stats->p_pids = (demux_ts_pid_stats_t *)&p_ts_stats[1];
+    demux_ts_pid_stats_t *p_dst = p_ts_stats->p_pids;
+    for( int i = -1; i <= p_sys->pids.i_all; i++ )
+    {
+        const ts_pid_t *pid = StatsPID( p_sys, i );
+        const ts_pid_stats_t *p_stats = &pid->stats;
+
+        if( !p_stats->i_packets )
+            continue;
+
+        p_dst->i_pid = pid->i_pid;
+        p_dst->i_packets = p_stats->i_packets;
+        p_dst->i_cc_errors = p_stats->i_cc_errors;
+        p_dst->i_scrambled = p_stats->i_scrambled;
+        p_dst->i_bitrate = p_ts_stats->i_packets ?
+            p_ts_stats->i_bitrate * p_stats->i_packets / p_ts_stats->i_packets : 0;
+        p_dst->i_pcr = p_stats->i_pcr;
+        p_dst->i_pcr_errors = p_stats->i_pcr_errors;
+        p_dst->i_pcr_interval_max = p_stats->i_pcr_interval_max;
+        p_dst->i_pcr_accuracy_max = p_stats->i_pcr_accuracy_max;
+        p_dst++;
+    }
+
+    p_ts_stats->i_programs = i_programs;
+    p_ts_stats->p_programs = (demux_ts_program_stats_t *)&p_ts_stats->p_pids[i_pids];
+    for( unsigned i = 0; i < i_programs; i++ )
+    {
+        const ts_pid_t *pmtpid = p_pat->programs.p_elems[i];
+        demux_ts_program_stats_t *p_dst = &p_ts_stats->p_programs[i];
+
+        p_dst->i_number = pmtpid->u.p_pmt->i_number;
+        p_dst->i_pmt_pid = pmtpid->i_pid;
+        p_dst->i_pcr_pid = pmtpid->u.p_pmt->i_pid_pcr;
+        p_dst->i_pmt = pmtpid->stats.i_sections;
+        p_dst->i_pmt_errors = pmtpid->stats.i_section_errors;
+        p_dst->i_pmt_interval_max = pmtpid->stats.i_section_interval_max;
+    }
+
+    return p_ts_stats;
+}
+
 static bool GatherData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
 {
     const uint8_t *p = p_bk->p_buffer;
@@ -2124,8 +2124,10 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
 
         p_stream->p_es = NULL;
 
-        /* initialise kframe index */
+        /* initialise kframe index, from previous seeks in this file */
         p_stream->idx=NULL;
+        p_stream->i_idx_cached = 0;
+        Oggseek_IndexCacheLoad( p_demux, p_stream );
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2214,6 +2216,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
 
     if ( p_stream->idx != NULL)
     {
+        Oggseek_IndexCacheSave( p_demux, p_stream );
         oggseek_index_entries_free( p_stream->idx );
     }
 
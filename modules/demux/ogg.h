@@ -101,6 +101,7 @@ typedef struct logical_stream_s
 
     /* keyframe index for seeking, created as we discover keyframes */
     demux_index_entry_t *idx;
+    int i_idx_cached; /* entries loaded from the index cache */
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -40,6 +40,7 @@
 
 #include "ogg.h"
 #include "oggseek.h"
+#include "index_cache.h"
 
 /* Theora spec 7.1 */
 #define THEORA_FTYPE_NOTDATA       0x80
@@ -152,6 +153,104 @@ const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
     return idx;
 }
 
+/* The keyframe index of each logical stream is cached as its timestamp and
+ * page position pairs, by serial number */
+#define OGG_INDEX_ENTRY_SIZE 16
+
+static char *OggSeek_IndexCacheName( logical_stream_t *p_stream )
+{
+    char *psz_name;
+    if ( asprintf( &psz_name, "ogg-1-%08x",
+                   (unsigned) p_stream->i_serial_no ) == -1 )
+        return NULL;
+    return psz_name;
+}
+
+void Oggseek_IndexCacheLoad ( demux_t *p_demux, logical_stream_t *p_stream )
+{
+    char *psz_file = index_cache_GetPath( p_demux );
+    char *psz_name = OggSeek_IndexCacheName( p_stream );
+    uint8_t *p_data = NULL;
+    size_t i_size = 0;
+
+    if ( psz_file && psz_name && p_stream->idx == NULL )
+        p_data = index_cache_Load( VLC_OBJECT(p_demux), psz_file, psz_name,
+                                   &i_size );
+    free( psz_name );
+    free( psz_file );
+    if ( !p_data )
+        return;
+
+    const int64_t i_stream_size = stream_Size( p_demux->s );
+    demux_index_entry_t *p_last = NULL;
+    int i_count = 0;
+
+    if ( i_size % OGG_INDEX_ENTRY_SIZE )
+        goto error;
+
+    for ( size_t i = 0; i < i_size; i += OGG_INDEX_ENTRY_SIZE )
+    {
+        int64_t i_value = GetQWBE( &p_data[i] );
+        int64_t i_pagepos = GetQWBE( &p_data[i + 8] );
+        if ( i_value < 1 || i_pagepos < 1 || i_pagepos >= i_stream_size ||
+             ( p_last && i_pagepos < p_last->i_pagepos ) )
+            goto error;
+
+        /* Entries are sorted by page position, append them directly */
+        demux_index_entry_t *idx = index_entry_new();
+        if ( !idx )
+            goto error;
+        idx->i_value = i_value;
+        idx->i_pagepos = i_pagepos;
+        idx->p_prev = p_last;
+        if ( p_last )
+            p_last->p_next = idx;
+        else
+            p_stream->idx = idx;
+        p_last = idx;
+        i_count++;
+    }
+    free( p_data );
+    p_stream->i_idx_cached = i_count;
+    return;
+
+error:
+    msg_Warn( p_demux, "invalid cached index" );
+    oggseek_index_entries_free( p_stream->idx );
+    p_stream->idx = NULL;
+    free( p_data );
+}
+
+void Oggseek_IndexCacheSave ( demux_t *p_demux, logical_stream_t *p_stream )
+{
+    int i_count = 0;
+    for ( demux_index_entry_t *idx = p_stream->idx; idx; idx = idx->p_next )
+        i_count++;
+
+    /* Only save when seeking found new keyframes */
+    if ( i_count <= p_stream->i_idx_cached )
+        return;
+
+    char *psz_file = index_cache_GetPath( p_demux );
+    char *psz_name = OggSeek_IndexCacheName( p_stream );
+    uint8_t *p_data = malloc( (size_t) i_count * OGG_INDEX_ENTRY_SIZE );
+    if ( psz_file && psz_name && p_data )
+    {
+        uint8_t *p = p_data;
+        for ( demux_index_entry_t *idx = p_stream->idx; idx; idx = idx->p_next )
+        {
+            SetQWBE( &p[0], idx->i_value );
+            SetQWBE( &p[8], idx->i_pagepos );
+            p += OGG_INDEX_ENTRY_SIZE;
+        }
+        index_cache_Save( VLC_OBJECT(p_demux), psz_file, psz_name, p_data,
+                          (size_t) i_count * OGG_INDEX_ENTRY_SIZE );
+    }
+    free( p_data );
+    free( psz_name );
+    free( psz_file );
+}
+
 static bool OggSeekIndexFind ( logical_stream_t *p_stream, int64_t i_timestamp,
                                int64_t *pi_pos_lower, int64_t *pi_pos_upper )
 {
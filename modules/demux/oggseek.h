@@ -62,4 +62,7 @@ void    Oggseek_ProbeEnd( demux_t * );
 
 void oggseek_index_entries_free ( demux_index_entry_t * );
 
+void Oggseek_IndexCacheLoad ( demux_t *, logical_stream_t * );
+void Oggseek_IndexCacheSave ( demux_t *, logical_stream_t * );
+
 int64_t oggseek_read_page ( demux_t * );
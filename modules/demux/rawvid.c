@@ -430,8 +430,36 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     const int64_t i_bps = 8LL * p_sys->frame_size * p_sys->pcr.i_divider_num /
                                                     p_sys->pcr.i_divider_den;
 
+    int64_t i_time = -1;
+    bool b_precise = false;
+
+    if( i_query == DEMUX_SET_TIME )
+    {
+        va_list ap;
+
+        va_copy( ap, args );
+        i_time = va_arg( ap, int64_t );
+        b_precise = va_arg( ap, int );
+        va_end( ap );
+    }
+
     /* XXX: DEMUX_SET_TIME is precise here */
-    return demux_vaControlHelper( p_demux->s, 0, -1, i_bps,
-                                   p_sys->frame_size, i_query, args );
+    int i_ret = demux_vaControlHelper( p_demux->s, 0, -1, i_bps,
+                                       p_sys->frame_size, i_query, args );
+
+    /* Date the frames from where the seek landed, and show the requested
+     * one first. Y4M frames have headers: they are not aligned. */
+    if( i_ret == VLC_SUCCESS && !p_sys->b_y4m &&
+        ( i_query == DEMUX_SET_TIME || i_query == DEMUX_SET_POSITION ) )
+    {
+        date_Set( &p_sys->pcr, 0 );
+        date_Increment( &p_sys->pcr,
+                        stream_Tell( p_demux->s ) / p_sys->frame_size );
+
+        if( b_precise && i_time > date_Get( &p_sys->pcr ) )
+            es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
+                            VLC_TS_0 + i_time );
+    }
+    return i_ret;
 }
 
@@ -76,6 +76,7 @@ static vlc_log_cb Open(vlc_object_t *obj, void **sysp)
         return NULL;
 
     *sysp = (void *)(uintptr_t)verbosity;
+    var_SetInteger(obj, "verbosity", verbosity);
 
     return AndroidPrintMsg;
 }
@@ -176,6 +176,7 @@ static vlc_log_cb Open(vlc_object_t *obj, void **restrict sysp)
     setvbuf(sys->stream, NULL, _IONBF, 0);
     fputs(header, sys->stream);
 
+    var_SetInteger(obj, "verbosity", verbosity);
     *sysp = sys;
     return cb;
 }
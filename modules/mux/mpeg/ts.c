@@ -143,6 +143,12 @@ static void    Close  ( vlc_object_t * );
   "PCRs (Program Clock Reference) will be sent (in milliseconds). " \
   "This value should be below 100ms. (default is 70ms).")
 
+#define MUXRATE_TEXT N_("Mux rate (bits/s)")
+#define MUXRATE_LONGTEXT N_("Produce a constant bitrate multiplex at the " \
+  "given rate, padded with null packets. PCRs are stamped according to " \
+  "their actual position in the multiplex. 0 disables constant bitrate " \
+  "muxing.")
+
 #define BMIN_TEXT N_( "Minimum B (deprecated)")
 #define BMIN_LONGTEXT N_( "This setting is deprecated and not used anymore" )
 
@@ -180,6 +186,7 @@ static void    Close  ( vlc_object_t * );
 #define SOUT_CFG_PREFIX "sout-ts-"
 #define MAX_PMT 64       /* Maximum number of programs. FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
 #define MAX_PMT_PID 64       /* Maximum pids in each pmt.  FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
+#define TS_MAX_MUXRATE 200000000 /* keeps the 27 MHz clock arithmetic in 64 bits */
 #if MAX_SDT_DESC < MAX_PMT
   #error "MAX_SDT_DESC < MAX_PMT"
 #endif
@@ -212,6 +219,8 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "use-key-frames", false, KEYF_TEXT, KEYF_LONGTEXT, true)
 
     add_integer( SOUT_CFG_PREFIX "pcr", 70, PCR_TEXT, PCR_LONGTEXT, true)
+    add_integer( SOUT_CFG_PREFIX "muxrate", 0, MUXRATE_TEXT, MUXRATE_LONGTEXT, true)
+        change_integer_range( 0, TS_MAX_MUXRATE )
     add_integer( SOUT_CFG_PREFIX "bmin", 0, BMIN_TEXT, BMIN_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmax", 0, BMAX_TEXT, BMAX_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT, DTS_LONGTEXT, true)
@@ -232,7 +241,7 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "pid-video", "pid-audio", "pid-spu", "pid-pmt", "tsid",
     "netid", "sdtdesc",
-    "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
+    "es-id-pid", "shaping", "pcr", "muxrate", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
     "muxpmt", "program-pmt", "alignment",
     NULL
@@ -325,6 +334,19 @@ typedef struct
     pes_state_t  state;
 } sout_input_sys_t;
 
+typedef struct
+{
+    unsigned    i_count;            /* PCRs emitted */
+    mtime_t     i_interval_min;
+    mtime_t     i_interval_max;
+    mtime_t     i_interval_total;
+    mtime_t     i_drift_max;        /* CBR date vs. shaped date */
+    unsigned    i_accuracy_max;     /* PCR rounding error (ns) */
+    uint64_t    i_null_packets;
+    uint64_t    i_overflow_packets; /* packets sent over the mux rate */
+    mtime_t     i_last_report;
+} pcr_stats_t;
+
 struct sout_mux_sys_t
 {
     int             i_pcr_pid;
@@ -367,6 +389,14 @@ struct sout_mux_sys_t
 
     mtime_t         i_pcr;  /* last PCR emited */
 
+    /* constant bitrate */
+    int64_t         i_muxrate;      /* bits/s, 0 if disabled */
+    mtime_t         i_cbr_origin;   /* date of the first CBR packet */
+    uint64_t        i_cbr_packets;  /* packets sent since i_cbr_origin */
+    mtime_t         i_cbr_last_pcr;
+    bool            b_cbr_discontinuity;
+    pcr_stats_t     pcr_stats;
+
     csa_t           *csa;
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
@@ -463,11 +493,16 @@ static void TSSchedule  ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                           mtime_t i_pcr_length, mtime_t i_pcr_dts );
 static void TSDate      ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                           mtime_t i_pcr_length, mtime_t i_pcr_dts );
+static void TSDateCBR   ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                          mtime_t i_pcr_length, mtime_t i_pcr_dts );
 static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
+static block_t *TSNewStuffing( sout_mux_t *p_mux, bool b_pcr );
 static void TSSetPCR( block_t *p_ts, mtime_t i_dts );
+static void TSSetPCR27M( block_t *p_ts, int64_t i_pcr );
+static void PCRStatsReport( sout_mux_t *p_mux );
 
 static csa_t *csaSetup( vlc_object_t *p_this )
 {
@@ -715,8 +750,28 @@ static int Open( vlc_object_t *p_this )
     var_Get( p_mux, SOUT_CFG_PREFIX "dts-delay", &val );
     p_sys->i_dts_delay = val.i_int * 1000;
 
-    msg_Dbg( p_mux, "shaping=%"PRId64" pcr=%"PRId64" dts_delay=%"PRId64,
-             p_sys->i_shaping_delay, p_sys->i_pcr_delay, p_sys->i_dts_delay );
+    p_sys->i_muxrate = var_GetInteger( p_mux, SOUT_CFG_PREFIX "muxrate" );
+    if( p_sys->i_muxrate < 0 || p_sys->i_muxrate > TS_MAX_MUXRATE )
+    {
+        msg_Err( p_mux, "invalid mux rate (%"PRId64" bits/s), "
+                 "disabling constant bitrate", p_sys->i_muxrate );
+        p_sys->i_muxrate = 0;
+    }
+    p_sys->pcr_stats.i_interval_min = INT64_MAX;
+    if( p_sys->i_muxrate > 0 )
+    {
+        /* Constant bitrate statistics, updated along with the reports:
+         * PCR interval and drift in us, accuracy in ns */
+        var_Create( p_mux, "pcr-interval-max", VLC_VAR_INTEGER );
+        var_Create( p_mux, "pcr-accuracy", VLC_VAR_INTEGER );
+        var_Create( p_mux, "pcr-drift", VLC_VAR_INTEGER );
+        var_Create( p_mux, "null-packets", VLC_VAR_INTEGER );
+        var_Create( p_mux, "overflow-packets", VLC_VAR_INTEGER );
+    }
+
+    msg_Dbg( p_mux, "shaping=%"PRId64" pcr=%"PRId64" dts_delay=%"PRId64
+             " muxrate=%"PRId64, p_sys->i_shaping_delay, p_sys->i_pcr_delay,
+             p_sys->i_dts_delay, p_sys->i_muxrate );
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
@@ -740,6 +795,16 @@ static void Close( vlc_object_t * p_this )
     sout_mux_t          *p_mux = (sout_mux_t*)p_this;
     sout_mux_sys_t      *p_sys = p_mux->p_sys;
 
+    if( p_sys->i_muxrate > 0 )
+    {
+        PCRStatsReport( p_mux );
+        var_Destroy( p_mux, "pcr-interval-max" );
+        var_Destroy( p_mux, "pcr-accuracy" );
+        var_Destroy( p_mux, "pcr-drift" );
+        var_Destroy( p_mux, "null-packets" );
+        var_Destroy( p_mux, "overflow-packets" );
+    }
+
     if( p_sys->p_dvbpsi )
         dvbpsi_delete( p_sys->p_dvbpsi );
 
@@ -1341,6 +1406,8 @@ static bool MuxStreams(sout_mux_t *p_mux )
                       p_data->i_dts, p_stream->state.i_pes_dts,
                       p_pcr_stream->state.i_pes_dts );
             block_Release( p_data );
+            /* The PCRs follow the new time base */
+            p_sys->b_cbr_discontinuity = true;
 
             BufferChainClean( &p_stream->state.chain_pes );
             p_stream->state.i_pes_dts = 0;
@@ -1358,6 +1425,10 @@ static bool MuxStreams(sout_mux_t *p_mux )
             continue;
         }
 
+        if( p_stream == p_pcr_stream &&
+            ( p_data->i_flags & BLOCK_FLAG_DISCONTINUITY ) )
+            p_sys->b_cbr_discontinuity = true;
+
         int i_header_size = 0;
         int i_max_pes_size = 0;
         int b_data_alignment = 0;
@@ -1761,6 +1832,12 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
     int i_packet_count = p_chain_ts->i_depth;
 
+    if( p_sys->i_muxrate > 0 )
+    {
+        TSDateCBR( p_mux, p_chain_ts, i_pcr_length, i_pcr_dts );
+        return;
+    }
+
     if ( i_pcr_length / 1000 > 0 )
     {
         int i_bitrate = ((uint64_t)i_packet_count * 188 * 8000)
@@ -1808,6 +1885,184 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     }
 }
 
+/* Offset of the i-th packet of the CBR multiplex, in 27 MHz ticks. Returns
+ * the sub-tick remainder (in 1/i_muxrate tick) through pi_rem. */
+static uint64_t CBRPacketTime( int64_t i_muxrate, uint64_t i_packet,
+                               uint64_t *pi_rem )
+{
+    const uint64_t i_bits = 188 * 8 * UINT64_C(27000000);
+    uint64_t i_part = (i_packet % i_muxrate) * i_bits;
+
+    if( pi_rem )
+        *pi_rem = i_part % i_muxrate;
+    return (i_packet / i_muxrate) * i_bits + i_part / i_muxrate;
+}
+
+static mtime_t CBRPacketDate( sout_mux_sys_t *p_sys, uint64_t i_packet )
+{
+    return p_sys->i_cbr_origin +
+           CBRPacketTime( p_sys->i_muxrate, i_packet, NULL ) / 27;
+}
+
+static void PCRStatsReport( sout_mux_t *p_mux )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    pcr_stats_t *p_stats = &p_sys->pcr_stats;
+
+    if( p_stats->i_count < 2 )
+        return;
+
+    var_SetInteger( p_mux, "pcr-interval-max", p_stats->i_interval_max );
+    var_SetInteger( p_mux, "pcr-accuracy", p_stats->i_accuracy_max );
+    var_SetInteger( p_mux, "pcr-drift", p_stats->i_drift_max );
+    var_SetInteger( p_mux, "null-packets", p_stats->i_null_packets );
+    var_SetInteger( p_mux, "overflow-packets", p_stats->i_overflow_packets );
+
+    msg_Dbg( p_mux, "CBR %"PRId64" bits/s: %u PCRs, interval min=%"PRId64
+             " max=%"PRId64" avg=%"PRId64" us, accuracy %u ns, drift %"PRId64
+             " us, %"PRIu64" null packets, %"PRIu64" packets over rate",
+             p_sys->i_muxrate, p_stats->i_count, p_stats->i_interval_min,
+             p_stats->i_interval_max,
+             p_stats->i_interval_total / (p_stats->i_count - 1),
+             p_stats->i_accuracy_max, p_stats->i_drift_max,
+             p_stats->i_null_packets, p_stats->i_overflow_packets );
+}
+
+static void CBRStampPCR( sout_mux_t *p_mux, block_t *p_ts, mtime_t i_date )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    pcr_stats_t *p_stats = &p_sys->pcr_stats;
+    uint64_t i_rem;
+    int64_t i_pcr = CBRPacketTime( p_sys->i_muxrate, p_sys->i_cbr_packets,
+                                   &i_rem );
+
+    i_pcr += 27 * (p_sys->i_cbr_origin - p_sys->i_dts_delay - p_sys->first_dts);
+    TSSetPCR27M( p_ts, i_pcr );
+    if( p_sys->b_cbr_discontinuity )
+    {
+        p_ts->p_buffer[5] |= 0x80; /* discontinuity_indicator */
+        p_sys->b_cbr_discontinuity = false;
+    }
+
+    /* The PCR is truncated to the 27 MHz tick below its byte position */
+    unsigned i_accuracy = i_rem * 1000 / (27 * p_sys->i_muxrate);
+    if( i_accuracy > p_stats->i_accuracy_max )
+        p_stats->i_accuracy_max = i_accuracy;
+
+    if( p_stats->i_count > 0 )
+    {
+        mtime_t i_interval = i_date - p_sys->i_cbr_last_pcr;
+
+        if( i_interval < p_stats->i_interval_min )
+            p_stats->i_interval_min = i_interval;
+        if( i_interval > p_stats->i_interval_max )
+            p_stats->i_interval_max = i_interval;
+        p_stats->i_interval_total += i_interval;
+    }
+    p_stats->i_count++;
+    p_sys->i_cbr_last_pcr = i_date;
+
+    if( i_date - p_stats->i_last_report >= 10 * CLOCK_FREQ )
+    {
+        PCRStatsReport( p_mux );
+        p_stats->i_last_report = i_date;
+    }
+}
+
+/* Sends the packets of one shaping period at exactly i_muxrate bits/s,
+ * filling the gaps with PCR-only and null packets. */
+static void TSDateCBR( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                       mtime_t i_pcr_length, mtime_t i_pcr_dts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    pcr_stats_t *p_stats = &p_sys->pcr_stats;
+    const int i_packet_count = p_chain_ts->i_depth;
+    const mtime_t i_slot_length = 188 * 8 * CLOCK_FREQ / p_sys->i_muxrate;
+
+    if( p_sys->i_cbr_origin == 0 )
+    {
+        p_sys->i_cbr_origin = i_pcr_dts;
+        p_stats->i_last_report = i_pcr_dts;
+    }
+    else if( CBRPacketDate( p_sys, p_sys->i_cbr_packets )
+             + p_sys->i_shaping_delay < i_pcr_dts )
+    {
+        /* Input gap (or clock jump): do not fill seconds of stuffing */
+        msg_Warn( p_mux, "CBR timeline late by %"PRId64" us, resetting",
+                  i_pcr_dts - CBRPacketDate( p_sys, p_sys->i_cbr_packets ) );
+        /* The PCRs keep following the input time base: this is no
+         * discontinuity, unless the input says so */
+        p_sys->i_cbr_origin = i_pcr_dts;
+        p_sys->i_cbr_packets = 0;
+    }
+
+    /* Number of packets the multiplex can carry until the end of the period */
+    mtime_t i_first = CBRPacketDate( p_sys, p_sys->i_cbr_packets );
+    int64_t i_slots = 0;
+    if( i_pcr_dts + i_pcr_length > i_first )
+        i_slots = (i_pcr_dts + i_pcr_length - i_first) * p_sys->i_muxrate
+                  / (188 * 8 * CLOCK_FREQ);
+
+    if( i_slots < i_packet_count )
+    {
+        msg_Warn( p_mux, "mux rate exceeded (%d packets for %"PRId64
+                  " slots in %"PRId64" us)", i_packet_count, i_slots,
+                  i_pcr_length );
+        p_stats->i_overflow_packets += i_packet_count - i_slots;
+        i_slots = i_packet_count;
+    }
+
+    int i_sent = 0;
+    for( int64_t i = 0; i < i_slots; i++ )
+    {
+        mtime_t i_date = CBRPacketDate( p_sys, p_sys->i_cbr_packets );
+        block_t *p_ts;
+
+        /* Spread the payload packets evenly among the stuffing */
+        if( i_sent < i_packet_count &&
+            ( i_sent * i_slots <= i * i_packet_count ||
+              i_slots - i <= i_packet_count - i_sent ) )
+        {
+            mtime_t i_shaped = i_pcr_dts + i_pcr_length * i_sent / i_packet_count;
+            mtime_t i_drift = i_date > i_shaped ? i_date - i_shaped
+                                                : i_shaped - i_date;
+            if( i_drift > p_stats->i_drift_max )
+                p_stats->i_drift_max = i_drift;
+
+            p_ts = BufferChainGet( p_chain_ts );
+            i_sent++;
+        }
+        else
+        {
+            bool b_pcr = p_sys->i_pcr_pid != 0x1fff &&
+                         i_date - p_sys->i_cbr_last_pcr >= p_sys->i_pcr_delay;
+            p_ts = TSNewStuffing( p_mux, b_pcr );
+            if( unlikely(p_ts == NULL) )
+            {
+                p_sys->i_cbr_packets++;
+                continue;
+            }
+            if( !b_pcr )
+                p_stats->i_null_packets++;
+        }
+
+        if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
+            CBRStampPCR( p_mux, p_ts, i_date );
+        if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+        {
+            vlc_mutex_lock( &p_sys->csa_lock );
+            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
+            vlc_mutex_unlock( &p_sys->csa_lock );
+        }
+
+        p_ts->i_dts    = i_date + p_sys->i_shaping_delay * 3 / 2;
+        p_ts->i_length = i_slot_length;
+        p_sys->i_cbr_packets++;
+
+        sout_AccessOutWrite( p_mux->p_access, p_ts );
+    }
+}
+
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
@@ -1911,17 +2166,64 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
     return p_ts;
 }
 
+/* Null packet, or adaptation-field-only packet carrying a PCR on the PCR PID */
+static block_t *TSNewStuffing( sout_mux_t *p_mux, bool b_pcr )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    block_t *p_ts = block_Alloc( 188 );
+
+    if( unlikely(p_ts == NULL) )
+        return NULL;
+
+    p_ts->p_buffer[0] = 0x47;
+    if( b_pcr )
+    {
+        sout_input_sys_t *p_pcr_stream =
+            (sout_input_sys_t*)p_sys->p_pcr_input->p_sys;
+
+        p_ts->p_buffer[1] = ( p_sys->i_pcr_pid >> 8 )&0x1f;
+        p_ts->p_buffer[2] = p_sys->i_pcr_pid & 0xff;
+        /* no payload: the continuity counter must not be incremented */
+        p_ts->p_buffer[3] = 0x20 |
+            ( ( p_pcr_stream->ts.i_continuity_counter + 15 ) % 16 );
+        p_ts->p_buffer[4] = 183;
+        p_ts->p_buffer[5] = 1 << 4; /* PCR_flag */
+        memset( &p_ts->p_buffer[12], 0xff, 188 - 12 );
+        p_ts->i_flags |= BLOCK_FLAG_CLOCK;
+    }
+    else
+    {
+        p_ts->p_buffer[1] = 0x1f;
+        p_ts->p_buffer[2] = 0xff;
+        p_ts->p_buffer[3] = 0x10;
+        memset( &p_ts->p_buffer[4], 0xff, 188 - 4 );
+    }
+    return p_ts;
+}
+
 static void TSSetPCR( block_t *p_ts, mtime_t i_dts )
 {
-    mtime_t i_pcr = 9 * i_dts / 100;
-
-    p_ts->p_buffer[6]  = ( i_pcr >> 25 )&0xff;
-    p_ts->p_buffer[7]  = ( i_pcr >> 17 )&0xff;
-    p_ts->p_buffer[8]  = ( i_pcr >> 9  )&0xff;
-    p_ts->p_buffer[9]  = ( i_pcr >> 1  )&0xff;
-    p_ts->p_buffer[10] = ( i_pcr << 7  )&0x80;
-    p_ts->p_buffer[10] |= 0x7e;
-    p_ts->p_buffer[11] = 0; /* we don't set PCR extension */
+    /* we don't set PCR extension */
+    TSSetPCR27M( p_ts, 9 * i_dts / 100 * 300 );
+}
+
+static void TSSetPCR27M( block_t *p_ts, int64_t i_pcr )
+{
+    const int64_t i_wrap = INT64_C(300) << 33;
+
+    i_pcr %= i_wrap;
+    if( i_pcr < 0 )
+        i_pcr += i_wrap;
+
+    uint64_t i_base = i_pcr / 300;
+    unsigned i_ext = i_pcr % 300;
+
+    p_ts->p_buffer[6]  = ( i_base >> 25 )&0xff;
+    p_ts->p_buffer[7]  = ( i_base >> 17 )&0xff;
+    p_ts->p_buffer[8]  = ( i_base >> 9  )&0xff;
+    p_ts->p_buffer[9]  = ( i_base >> 1  )&0xff;
+    p_ts->p_buffer[10] = ( ( i_base << 7 )&0x80 ) | 0x7e | ( i_ext >> 8 );
+    p_ts->p_buffer[11] = i_ext & 0xff;
 }
 
 void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
@@ -109,6 +109,12 @@ static int Open( vlc_object_t *p_this )
 
             if( s )
             {
+                /* All branches get the same blocks: let the transcoders
+                 * at their head share their decoders */
+                if( var_Create( s, "sout-decoder-group",
+                                VLC_VAR_ADDRESS ) == VLC_SUCCESS )
+                    var_SetAddress( s, "sout-decoder-group", p_stream );
+
                 TAB_APPEND( p_sys->i_nb_streams, p_sys->pp_streams, s );
                 TAB_APPEND( p_sys->i_nb_last_streams, p_sys->pp_last_streams,
                     p_last );
@@ -79,8 +79,12 @@ static int transcode_audio_initialize_filters( sout_stream_t *p_stream, sout_str
         msg_Err( p_stream, "Unable to initialize audio filters" );
         module_unneed( id->p_encoder, id->p_encoder->p_module );
         id->p_encoder->p_module = NULL;
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
+        /* A shared decoder is released along with the branch */
+        if( !id->shared.p_group )
+        {
+            module_unneed( id->p_decoder, id->p_decoder->p_module );
+            id->p_decoder->p_module = NULL;
+        }
         return VLC_EGENERIC;
     }
     id->fmt_audio.i_rate = fmt_last->i_rate;
@@ -110,8 +114,11 @@ static int transcode_audio_initialize_encoder( sout_stream_id_sys_t *id, sout_st
                            "Take a look few lines earlier to see possible reason.",
                  p_sys->psz_aenc ? p_sys->psz_aenc : "any",
                  (char *)&p_sys->i_acodec );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
+        if( !id->shared.p_group )
+        {
+            module_unneed( id->p_decoder, id->p_decoder->p_module );
+            id->p_decoder->p_module = NULL;
+        }
         return VLC_EGENERIC;
     }
 
@@ -140,22 +147,24 @@ int transcode_audio_new( sout_stream_t *p_stream,
     audio_sample_format_t fmt_last;
 
     /*
-     * Open decoder
+     * Open decoder, unless another branch of a duplicate already did
      */
-
-    /* Initialization of decoder structures */
-    id->p_decoder->fmt_out = id->p_decoder->fmt_in;
-    id->p_decoder->fmt_out.i_extra = 0;
-    id->p_decoder->fmt_out.p_extra = 0;
-    id->p_decoder->pf_decode_audio = NULL;
-    id->p_decoder->pf_aout_format_update = audio_update_format;
-    /* id->p_decoder->p_cfg = p_sys->p_audio_cfg; */
-    id->p_decoder->p_module =
-        module_need( id->p_decoder, "decoder", "$codec", false );
-    if( !id->p_decoder->p_module )
+    if( !transcode_shared_Join( p_stream, id ) )
     {
-        msg_Err( p_stream, "cannot find audio decoder" );
-        return VLC_EGENERIC;
+        /* Initialization of decoder structures */
+        id->p_decoder->fmt_out = id->p_decoder->fmt_in;
+        id->p_decoder->fmt_out.i_extra = 0;
+        id->p_decoder->fmt_out.p_extra = 0;
+        id->p_decoder->pf_decode_audio = NULL;
+        id->p_decoder->pf_aout_format_update = audio_update_format;
+        /* id->p_decoder->p_cfg = p_sys->p_audio_cfg; */
+        id->p_decoder->p_module =
+            module_need( id->p_decoder, "decoder", "$codec", false );
+        if( !id->p_decoder->p_module )
+        {
+            msg_Err( p_stream, "cannot find audio decoder" );
+            return VLC_EGENERIC;
+        }
     }
     /* decoders don't set audio.i_format, but audio filters use it */
     id->p_decoder->fmt_out.audio.i_format = id->p_decoder->fmt_out.i_codec;
@@ -183,6 +192,9 @@ int transcode_audio_new( sout_stream_t *p_stream,
 void transcode_audio_close( sout_stream_id_sys_t *id )
 {
     /* Close decoder */
+    if( id->shared.p_group )
+        transcode_shared_Leave( id );
+
     if( id->p_decoder->p_module )
         module_unneed( id->p_decoder, id->p_decoder->p_module );
     id->p_decoder->p_module = NULL;
@@ -219,8 +231,9 @@ int transcode_audio_process( sout_stream_t *p_stream,
         return VLC_SUCCESS;
     }
 
-    while( (p_audio_buf = id->p_decoder->pf_decode_audio( id->p_decoder,
-                                                          &in )) )
+    while( (p_audio_buf = id->shared.p_group
+                        ? transcode_shared_DecodeAudio( id, &in )
+                        : id->p_decoder->pf_decode_audio( id->p_decoder, &in )) )
     {
         if( unlikely( !id->p_encoder->p_module ) )
         {
@@ -0,0 +1,311 @@
+/*****************************************************************************
+ * shared.c: transcoding stream output module (decoders shared by branches)
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#include "transcode.h"
+
+#include <vlc_meta.h>
+#include <vlc_modules.h>
+
+/* When the duplicate stream output fans one ES out to several transcode
+ * branches, every branch receives a copy of each block, one after the
+ * other, before the next block is sent. The branches then share a single
+ * decoder: the first branch to get a block decodes it, and the following
+ * ones take the decoded pictures (or a copy of the decoded audio) instead
+ * of decoding the same data again. Each branch keeps its own filters and
+ * encoder. Blocks are matched by their rank in the ES, which is the same
+ * in every branch. */
+
+struct transcode_shared_t
+{
+    transcode_shared_t *p_next;
+
+    const void      *p_group;   /**< stream fanning out the blocks */
+    decoder_t       *p_decoder;
+    unsigned        i_refs;     /**< branches using the decoder */
+
+    vlc_mutex_t     lock;
+
+    /* Last decoded block */
+    uint64_t        i_seq;      /**< number of blocks decoded so far */
+    unsigned        i_takers;   /**< branches that took its output */
+
+    /* Pictures or audio blocks decoded from it */
+    int             i_out;
+    void            **pp_out;
+};
+
+static vlc_mutex_t shared_lock = VLC_STATIC_MUTEX;
+static transcode_shared_t *shared_list = NULL;
+
+static void OutputRelease( transcode_shared_t *p_sh, void *p_out )
+{
+    if( p_sh->p_decoder->fmt_in.i_cat == VIDEO_ES )
+        picture_Release( p_out );
+    else
+        block_Release( p_out );
+}
+
+static void OutputFlush( transcode_shared_t *p_sh )
+{
+    for( int i = 0; i < p_sh->i_out; i++ )
+        if( p_sh->pp_out[i] )
+            OutputRelease( p_sh, p_sh->pp_out[i] );
+    TAB_CLEAN( p_sh->i_out, p_sh->pp_out );
+}
+
+static void SharedPictureDestroy( picture_t *p_pic )
+{
+    picture_Release( (picture_t *)p_pic->p_sys );
+    free( p_pic );
+}
+
+/* Wraps the planes of a decoded picture in a picture of its own, so that
+ * each branch can date, chain and queue it independently. */
+static picture_t *SharedPictureNew( picture_t *p_pic )
+{
+    picture_resource_t rsc = {
+        .p_sys = (picture_sys_t *)p_pic,
+        .pf_destroy = SharedPictureDestroy,
+    };
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        rsc.p[i].p_pixels = p_pic->p[i].p_pixels;
+        rsc.p[i].i_lines = p_pic->p[i].i_lines;
+        rsc.p[i].i_pitch = p_pic->p[i].i_pitch;
+    }
+
+    picture_t *p_wrap = picture_NewFromResource( &p_pic->format, &rsc );
+    if( unlikely( p_wrap == NULL ) )
+        return NULL;
+
+    picture_CopyProperties( p_wrap, p_pic );
+    picture_Hold( p_pic );
+    return p_wrap;
+}
+
+static void DecodeBlock( transcode_shared_t *p_sh, block_t *p_block )
+{
+    decoder_t *p_dec = p_sh->p_decoder;
+    void *p_out;
+
+    OutputFlush( p_sh );
+    p_sh->i_seq++;
+    p_sh->i_takers = 0;
+
+    if( p_dec->fmt_in.i_cat == VIDEO_ES )
+    {
+        while( (p_out = p_dec->pf_decode_video( p_dec, &p_block )) )
+            TAB_APPEND( p_sh->i_out, p_sh->pp_out, p_out );
+    }
+    else
+    {
+        while( (p_out = p_dec->pf_decode_audio( p_dec, &p_block )) )
+            TAB_APPEND( p_sh->i_out, p_sh->pp_out, p_out );
+    }
+}
+
+/**
+ * Makes a branch use the decoder of the other transcode branches fed by the
+ * same stream, if any.
+ *
+ * On return, id->p_decoder is the shared decoder when sharing is possible,
+ * and the branch own decoder otherwise.
+ * \return true if the decoder is already opened, false if the caller must
+ * open it
+ */
+bool transcode_shared_Join( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    const void *p_group = var_GetAddress( p_stream, "sout-decoder-group" );
+    const es_format_t *p_fmt = &id->p_decoder->fmt_in;
+    transcode_shared_t *p_sh;
+
+    if( p_group == NULL )
+        return false;
+
+    vlc_mutex_lock( &shared_lock );
+    for( p_sh = shared_list; p_sh != NULL; p_sh = p_sh->p_next )
+    {
+        const es_format_t *p_cur = &p_sh->p_decoder->fmt_in;
+
+        if( p_sh->p_group == p_group && p_cur->i_cat == p_fmt->i_cat &&
+            p_cur->i_id == p_fmt->i_id && p_cur->i_codec == p_fmt->i_codec &&
+            p_cur->i_extra == p_fmt->i_extra )
+            break;
+    }
+
+    if( p_sh == NULL )
+    {
+        p_sh = calloc( 1, sizeof( *p_sh ) );
+        if( !p_sh )
+            goto error;
+
+        p_sh->p_decoder = vlc_object_create( p_stream->p_sout,
+                                             sizeof( decoder_t ) );
+        if( !p_sh->p_decoder )
+        {
+            free( p_sh );
+            goto error;
+        }
+        p_sh->p_decoder->p_module = NULL;
+        p_sh->p_decoder->fmt_in = *p_fmt;
+        p_sh->p_decoder->b_frame_drop_allowed = false;
+        p_sh->p_group = p_group;
+        vlc_mutex_init( &p_sh->lock );
+        TAB_INIT( p_sh->i_out, p_sh->pp_out );
+
+        p_sh->p_next = shared_list;
+        shared_list = p_sh;
+    }
+    p_sh->i_refs++;
+
+    bool b_opened = p_sh->p_decoder->p_module != NULL;
+    vlc_mutex_unlock( &shared_lock );
+
+    if( b_opened )
+        msg_Dbg( p_stream, "sharing decoder for es %d with %u other branch(es)",
+                 p_fmt->i_id, p_sh->i_refs - 1 );
+
+    id->shared.p_group = p_sh;
+    id->shared.p_decoder = id->p_decoder;
+    id->shared.i_seq = p_sh->i_seq;
+    id->shared.i_next = 0;
+    id->p_decoder = vlc_object_hold( p_sh->p_decoder );
+    return b_opened;
+
+error:
+    vlc_mutex_unlock( &shared_lock );
+    return false;
+}
+
+/**
+ * Stops sharing the decoder, closing it if no other branch is using it.
+ * id->p_decoder is the (unopened) branch own decoder again on return.
+ */
+void transcode_shared_Leave( sout_stream_id_sys_t *id )
+{
+    transcode_shared_t *p_sh = id->shared.p_group;
+    bool b_last;
+
+    vlc_mutex_lock( &shared_lock );
+    b_last = --p_sh->i_refs == 0;
+    if( b_last )
+    {
+        transcode_shared_t **pp = &shared_list;
+        while( *pp != p_sh )
+            pp = &(*pp)->p_next;
+        *pp = p_sh->p_next;
+    }
+    vlc_mutex_unlock( &shared_lock );
+
+    if( b_last )
+    {
+        decoder_t *p_dec = p_sh->p_decoder;
+
+        OutputFlush( p_sh );
+        if( p_dec->p_module )
+            module_unneed( p_dec, p_dec->p_module );
+        if( p_dec->p_description )
+            vlc_meta_Delete( p_dec->p_description );
+        free( p_dec->p_owner );
+        vlc_object_release( p_dec );
+
+        vlc_mutex_destroy( &p_sh->lock );
+        free( p_sh );
+    }
+
+    vlc_object_release( id->p_decoder );
+    id->p_decoder = id->shared.p_decoder;
+    id->shared.p_group = NULL;
+    id->shared.p_decoder = NULL;
+}
+
+/* Same calling convention as decoder_t.pf_decode_*: the first call takes
+ * the block, the following ones (with *pp_block == NULL) return the
+ * remaining output until NULL. */
+static void *Decode( sout_stream_id_sys_t *id, block_t **pp_block )
+{
+    transcode_shared_t *p_sh = id->shared.p_group;
+    block_t *p_block = *pp_block;
+    void *p_out = NULL;
+
+    vlc_mutex_lock( &p_sh->lock );
+    if( p_block != NULL )
+    {
+        *pp_block = NULL;
+
+        if( id->shared.i_seq == p_sh->i_seq )
+            DecodeBlock( p_sh, p_block );
+        else if( id->shared.i_seq + 1 == p_sh->i_seq )
+            block_Release( p_block ); /* Already decoded by another branch */
+        else
+        {
+            /* This branch missed blocks: its output is lost rather than
+             * mixed with the output of another block */
+            msg_Err( p_sh->p_decoder, "branch out of sync, dropping block" );
+            block_Release( p_block );
+            id->shared.i_seq = p_sh->i_seq;
+            vlc_mutex_unlock( &p_sh->lock );
+            return NULL;
+        }
+
+        id->shared.i_seq = p_sh->i_seq;
+        id->shared.i_next = 0;
+        p_sh->i_takers++;
+    }
+
+    if( id->shared.i_seq == p_sh->i_seq && id->shared.i_next < p_sh->i_out )
+    {
+        void **pp_out = &p_sh->pp_out[id->shared.i_next++];
+
+        if( *pp_out != NULL && p_sh->i_takers >= p_sh->i_refs )
+        {
+            /* No other branch will need it */
+            p_out = *pp_out;
+            *pp_out = NULL;
+        }
+        else if( *pp_out != NULL )
+        {
+            if( p_sh->p_decoder->fmt_in.i_cat == VIDEO_ES )
+                p_out = SharedPictureNew( *pp_out );
+            else /* audio filters work in place */
+                p_out = block_Duplicate( *pp_out );
+        }
+    }
+    vlc_mutex_unlock( &p_sh->lock );
+
+    return p_out;
+}
+
+picture_t *transcode_shared_DecodeVideo( sout_stream_id_sys_t *id,
+                                         block_t **pp_block )
+{
+    return Decode( id, pp_block );
+}
+
+block_t *transcode_shared_DecodeAudio( sout_stream_id_sys_t *id,
+                                       block_t **pp_block )
+{
+    return Decode( id, pp_block );
+}
@@ -565,6 +565,9 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
 error:
     if( id )
     {
+        if( id->shared.p_group )
+            transcode_shared_Leave( id );
+
         if( id->p_decoder )
         {
             vlc_object_release( id->p_decoder );
@@ -610,6 +613,9 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
 
     if( id->id ) sout_StreamIdDel( p_stream->p_next, id->id );
 
+    if( id->shared.p_group )
+        transcode_shared_Leave( id );
+
     if( id->p_decoder )
     {
         vlc_object_release( id->p_decoder );
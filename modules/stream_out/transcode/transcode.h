@@ -74,6 +74,7 @@ struct sout_stream_sys_t
 };
 
 struct aout_filters;
+typedef struct transcode_shared_t transcode_shared_t;
 
 struct sout_stream_id_sys_t
 {
@@ -85,6 +86,15 @@ struct sout_stream_id_sys_t
     /* Decoder */
     decoder_t       *p_decoder;
 
+    /* Decoder shared with the other branches of a duplicate */
+    struct
+    {
+        transcode_shared_t *p_group;
+        decoder_t       *p_decoder; /**< own decoder, unused while shared */
+        uint64_t        i_seq;      /**< blocks received from the group */
+        int             i_next;     /**< next output to take */
+    } shared;
+
     union
     {
          struct
@@ -110,6 +120,13 @@ struct sout_stream_id_sys_t
 
 };
 
+/* Shared decoders */
+
+bool transcode_shared_Join ( sout_stream_t *, sout_stream_id_sys_t * );
+void transcode_shared_Leave( sout_stream_id_sys_t * );
+picture_t *transcode_shared_DecodeVideo( sout_stream_id_sys_t *, block_t ** );
+block_t   *transcode_shared_DecodeAudio( sout_stream_id_sys_t *, block_t ** );
+
 /* OSD */
 
 int transcode_osd_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id );
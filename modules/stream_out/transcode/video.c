@@ -118,13 +118,32 @@ static void* EncoderThread( void *obj )
     return NULL;
 }
 
-int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+static void transcode_video_decoder_close( sout_stream_id_sys_t *id )
+{
+    if( id->shared.p_group )
+    {
+        /* Other branches may still be using it */
+        transcode_shared_Leave( id );
+        return;
+    }
+
+    if( id->p_decoder->p_module )
+        module_unneed( id->p_decoder, id->p_decoder->p_module );
+    id->p_decoder->p_module = NULL;
+    if( id->p_decoder->p_description )
+        vlc_meta_Delete( id->p_decoder->p_description );
+    id->p_decoder->p_description = NULL;
+
+    free( id->p_decoder->p_owner );
+    id->p_decoder->p_owner = NULL;
+}
+
+static int transcode_video_decoder_open( sout_stream_t *p_stream,
+                                         sout_stream_id_sys_t *id )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
 
-    /* Open decoder
-     * Initialization of decoder structures
-     */
+    /* Initialization of decoder structures */
     id->p_decoder->fmt_out = id->p_decoder->fmt_in;
     id->p_decoder->fmt_out.i_extra = 0;
     id->p_decoder->fmt_out.p_extra = NULL;
@@ -134,7 +153,10 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     id->p_decoder->pf_vout_buffer_new = video_new_buffer_decoder;
     id->p_decoder->p_owner = malloc( sizeof(decoder_owner_sys_t) );
     if( !id->p_decoder->p_owner )
+    {
+        transcode_video_decoder_close( id );
         return VLC_EGENERIC;
+    }
 
     id->p_decoder->p_owner->p_sys = p_sys;
     /* id->p_decoder->p_cfg = p_sys->p_video_cfg; */
@@ -145,9 +167,20 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     if( !id->p_decoder->p_module )
     {
         msg_Err( p_stream, "cannot find video decoder" );
-        free( id->p_decoder->p_owner );
+        transcode_video_decoder_close( id );
         return VLC_EGENERIC;
     }
+    return VLC_SUCCESS;
+}
+
+int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    /* Open decoder, unless another branch of a duplicate already did */
+    if( !transcode_shared_Join( p_stream, id ) &&
+        transcode_video_decoder_open( p_stream, id ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
 
     /*
      * Open encoder.
@@ -194,9 +227,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s). Take a look few lines earlier to see possible reason.",
                  p_sys->psz_venc ? p_sys->psz_venc : "any",
                  (char *)&p_sys->i_vcodec );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = 0;
-        free( id->p_decoder->p_owner );
+        transcode_video_decoder_close( id );
         return VLC_EGENERIC;
     }
 
@@ -221,9 +252,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     if( p_sys->pp_pics == NULL )
     {
         msg_Err( p_stream, "cannot create picture fifo" );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        free( id->p_decoder->p_owner );
+        transcode_video_decoder_close( id );
         return VLC_ENOMEM;
     }
     vlc_mutex_init( &p_sys->lock_out );
@@ -236,9 +265,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         vlc_mutex_destroy( &p_sys->lock_out );
         vlc_cond_destroy( &p_sys->cond );
         picture_fifo_Delete( p_sys->pp_pics );
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        free( id->p_decoder->p_owner );
+        transcode_video_decoder_close( id );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -592,12 +619,7 @@ void transcode_video_close( sout_stream_t *p_stream,
     vlc_cond_destroy( &p_stream->p_sys->cond );
 
     /* Close decoder */
-    if( id->p_decoder->p_module )
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-    if( id->p_decoder->p_description )
-        vlc_meta_Delete( id->p_decoder->p_description );
-
-    free( id->p_decoder->p_owner );
+    transcode_video_decoder_close( id );
 
     /* Close encoder */
     if( id->p_encoder->p_module )
@@ -637,9 +659,11 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         /* Overlay subpicture */
         if( p_subpic )
         {
-            if( picture_IsReferenced( p_pic ) && !filter_chain_GetLength( id->p_f_chain ) )
+            if( ( picture_IsReferenced( p_pic ) || id->shared.p_group ) &&
+                !filter_chain_GetLength( id->p_f_chain ) )
             {
-                /* We can't modify the picture, we need to duplicate it,
+                /* We can't modify the picture (its pixels may also be used
+                 * by other branches), we need to duplicate it,
                  * in this point the picture is already p_encoder->fmt.in format*/
                 picture_t *p_tmp = video_new_buffer_encoder( id->p_encoder );
                 if( likely( p_tmp ) )
@@ -716,7 +740,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     }
 
 
-    while( (p_pic = id->p_decoder->pf_decode_video( id->p_decoder, &in )) )
+    while( (p_pic = id->shared.p_group
+                  ? transcode_shared_DecodeVideo( id, &in )
+                  : id->p_decoder->pf_decode_video( id->p_decoder, &in )) )
     {
 
         if( unlikely (
@@ -84,6 +84,7 @@ vlc_module_end()
 struct picture_sys_t {
     vout_display_sys_t *sys;
     void *id;
+    unsigned index;
 };
 
 /* NOTE: the callback prototypes must match those of LibVLC */
@@ -97,6 +98,12 @@ struct vout_display_sys_t {
     void (*display)(void *sys, void *id);
     void (*cleanup)(void *sys);
 
+    /* Caller-owned buffers: pictures are never locked nor copied, they are
+     * handed over until released with libvlc_video_frame_release() */
+    void (*buffer)(void *sys, unsigned index, void **plane);
+    void (*frame)(void *sys, picture_t *frame, unsigned index, int64_t pts,
+                  int64_t deadline);
+
     unsigned pitches[PICTURE_PLANE_MAX];
     unsigned lines[PICTURE_PLANE_MAX];
 };
@@ -153,7 +160,15 @@ static int Open(vlc_object_t *object)
     vlc_format_cb setup = var_InheritAddress(vd, "vmem-setup");
 
     sys->lock = var_InheritAddress(vd, "vmem-lock");
-    if (sys->lock == NULL) {
+    sys->buffer = var_InheritAddress(vd, "vmem-buffer");
+    sys->frame = var_InheritAddress(vd, "vmem-frame");
+    if (sys->frame != NULL) {
+        if (setup == NULL || sys->buffer == NULL) {
+            msg_Err(vd, "missing format or buffer callback");
+            free(sys);
+            return VLC_EGENERIC;
+        }
+    } else if (sys->lock == NULL) {
         msg_Err(vd, "missing lock callback");
         free(sys);
         return VLC_EGENERIC;
@@ -241,6 +256,8 @@ static int Open(vlc_object_t *object)
     /* */
     vout_display_info_t info = vd->info;
     info.has_hide_mouse = true;
+    /* The application keeps frames until it releases them */
+    info.has_held_pictures = sys->frame != NULL;
 
     /* */
     vd->sys     = sys;
@@ -267,7 +284,8 @@ static void Close(vlc_object_t *object)
     if (sys->cleanup)
         sys->cleanup(sys->opaque);
 
-    picture_pool_Enum(sys->pool, Unlock, sys);
+    if (sys->frame == NULL)
+        picture_pool_Enum(sys->pool, Unlock, sys);
     picture_pool_Release(sys->pool);
     free(sys);
 }
@@ -293,14 +311,20 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
         }
         picsys->sys = sys;
         picsys->id = NULL;
+        picsys->index = i;
 
         picture_resource_t rsc = { .p_sys = picsys };
+        void *planes[PICTURE_PLANE_MAX] = { NULL };
+
+        /* Either the buffers are registered once and for all, or vmem-lock
+         * is responsible for the allocation */
+        if (sys->frame != NULL)
+            sys->buffer(sys->opaque, i, planes);
 
-        for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
-            /* vmem-lock is responsible for the allocation */
-            rsc.p[i].p_pixels = NULL;
-            rsc.p[i].i_lines  = sys->lines[i];
-            rsc.p[i].i_pitch  = sys->pitches[i];
+        for (unsigned j = 0; j < PICTURE_PLANE_MAX; j++) {
+            rsc.p[j].p_pixels = planes[j];
+            rsc.p[j].i_lines  = sys->lines[j];
+            rsc.p[j].i_pitch  = sys->pitches[j];
         }
 
         pictures[i] = picture_NewFromResource(&vd->fmt, &rsc);
@@ -318,13 +342,24 @@ static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
             picture_Release(pictures[i]);
     }
 
-    picture_pool_Enum(sys->pool, Lock, sys);
+    if (sys->frame == NULL)
+        picture_pool_Enum(sys->pool, Lock, sys);
     return sys->pool;
 }
 
 static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
 {
-    Unlock(vd->sys, pic);
+    vout_display_sys_t *sys = vd->sys;
+
+    if (sys->frame != NULL) {
+        /* Hand the frame over ahead of its deadline, the application
+         * releases it once done */
+        int64_t pts = pic->pts > VLC_TS_INVALID ? pic->pts - VLC_TS_0 : -1;
+
+        picture_Hold(pic);
+        sys->frame(sys->opaque, pic, pic->p_sys->index, pts, pic->date);
+    } else
+        Unlock(sys, pic);
     VLC_UNUSED(subpic);
 }
 
@@ -333,6 +368,12 @@ static void Display(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
 {
     vout_display_sys_t *sys = vd->sys;
 
+    if (sys->frame != NULL) {
+        picture_Release(pic);
+        VLC_UNUSED(subpic);
+        return;
+    }
+
     if (sys->display != NULL)
         sys->display(sys->opaque, pic->p_sys->id);
 
@@ -73,6 +73,7 @@ typedef struct
         unsigned resamp_start_drift; /**< Resampler drift absolute value */
         int resamp_type; /**< Resampler mode (FIXME: redundant / resampling) */
         bool discontinuity;
+        bool unpaced; /**< No drift correction nor late buffers */
     } sync;
 
     audio_sample_format_t input_format;
@@ -134,7 +135,8 @@ bool aout_ChangeFilterString( vlc_object_t *manager, vlc_object_t *aout,
 
 /* From dec.c */
 int aout_DecNew(audio_output_t *, const audio_sample_format_t *,
-                const audio_replay_gain_t *, const aout_request_vout_t *);
+                const audio_replay_gain_t *, const aout_request_vout_t *,
+                bool unpaced);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *, block_t *, int i_input_rate);
 int aout_DecGetResetLost(audio_output_t *);
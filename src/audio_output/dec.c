@@ -43,7 +43,8 @@
 int aout_DecNew( audio_output_t *p_aout,
                  const audio_sample_format_t *p_format,
                  const audio_replay_gain_t *p_replay_gain,
-                 const aout_request_vout_t *p_request_vout )
+                 const aout_request_vout_t *p_request_vout,
+                 bool unpaced )
 {
     /* Sanitize audio format */
     if( p_format->i_channels != aout_FormatNbChannels( p_format ) )
@@ -104,6 +105,7 @@ error:
     owner->sync.end = VLC_TS_INVALID;
     owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
     owner->sync.discontinuity = true;
+    owner->sync.unpaced = unpaced;
     aout_OutputUnlock (p_aout);
 
     atomic_init (&owner->buffers_lost, 0);
@@ -351,8 +353,10 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
     if (unlikely(aout_CheckReady (aout)))
         goto drop; /* Pipeline is unrecoverably broken :-( */
 
+    /* When decoding as fast as possible, buffers are neither early nor late:
+     * the output consumes them at its own pace. */
     const mtime_t now = mdate (), advance = block->i_pts - now;
-    if (advance < -AOUT_MAX_PTS_DELAY)
+    if (!owner->sync.unpaced && advance < -AOUT_MAX_PTS_DELAY)
     {   /* Late buffer can be caused by bugs in the decoder, by scheduling
          * latency spikes (excessive load, SIGSTOP, etc.) or if buffering is
          * insufficient. We assume the PTS is wrong and play the buffer anyway:
@@ -360,7 +364,7 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
         msg_Warn (aout, "buffer too late (%"PRId64" us): dropped", advance);
         goto drop;
     }
-    if (advance > AOUT_MAX_ADVANCE_TIME)
+    if (!owner->sync.unpaced && advance > AOUT_MAX_ADVANCE_TIME)
     {   /* Early buffers can only be caused by bugs in the decoder. */
         msg_Err (aout, "buffer too early (%"PRId64" us): dropped", advance);
         goto drop;
@@ -376,7 +380,8 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
     aout_volume_Amplify (owner->volume, block);
 
     /* Drift correction */
-    aout_DecSynchronize (aout, block->i_pts, input_rate);
+    if (!owner->sync.unpaced)
+        aout_DecSynchronize (aout, block->i_pts, input_rate);
 
     /* Output */
     owner->sync.end = block->i_pts + block->i_length + 1;
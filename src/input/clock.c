@@ -99,6 +99,12 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET (100000)
 
+/* Rate (in 1/256) at which the pts delay is reduced when catching up,
+ * ie how much faster we play. It is small enough for the audio output
+ * to follow by resampling, see AOUT_MAX_RESAMPLING.
+ */
+#define CR_CATCHUP_RATE (8)
+
 /*****************************************************************************
  * Structures
  *****************************************************************************/
@@ -158,6 +164,12 @@ struct input_clock_t
     mtime_t i_next_drift_update;
     average_t drift;
 
+    /* Smallest advance of the clock references on their deadline */
+    mtime_t i_spare_delay;
+
+    /* Pts delay reduction left to apply */
+    mtime_t i_catchup;
+
     /* Late statistics */
     struct
     {
@@ -208,6 +220,9 @@ input_clock_t *input_clock_New( int i_rate )
     cl->i_next_drift_update = VLC_TS_INVALID;
     AvgInit( &cl->drift, 10 );
 
+    cl->i_spare_delay = INT64_MAX;
+    cl->i_catchup = 0;
+
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
         cl->late.pi_value[i] = 0;
@@ -309,6 +324,18 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     }
     //fprintf( stderr, "input_clock_Update: %d :: %lld\n", b_buffering_allowed, cl->i_buffering_duration/1000 );
 
+    /* Catch up by reducing the pts delay slowly, as if playing
+     * CR_CATCHUP_RATE/256 faster */
+    if( cl->i_catchup > 0 && !b_reset_reference )
+    {
+        const mtime_t i_elapsed = __MAX( i_ck_system - cl->last.i_system, 0 );
+        const mtime_t i_step = __MIN( ( i_elapsed * CR_CATCHUP_RATE + 255 ) / 256,
+                                      cl->i_catchup );
+
+        cl->i_pts_delay -= i_step;
+        cl->i_catchup -= i_step;
+    }
+
     /* */
     cl->last = clock_point_Create( i_ck_stream, i_ck_system );
 
@@ -322,6 +349,8 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->late.pi_value[cl->late.i_index] = i_late;
         cl->late.i_index = ( cl->late.i_index + 1 ) % INPUT_CLOCK_LATE_COUNT;
     }
+    if( -i_late < cl->i_spare_delay )
+        cl->i_spare_delay = -i_late;
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -564,7 +593,10 @@ void input_clock_SetJitter( input_clock_t *cl,
      * TODO when increasing -> force rebuffering
      */
     if( cl->i_pts_delay < i_pts_delay )
+    {
         cl->i_pts_delay = i_pts_delay;
+        cl->i_catchup = 0;
+    }
 
     /* */
     if( i_cr_average < 10 )
@@ -576,6 +608,40 @@ void input_clock_SetJitter( input_clock_t *cl,
     vlc_mutex_unlock( &cl->lock );
 }
 
+mtime_t input_clock_GetSpareDelay( input_clock_t *cl )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    /* Nothing received since the last call: nothing to spare */
+    const mtime_t i_spare = cl->i_spare_delay != INT64_MAX ? cl->i_spare_delay : 0;
+    cl->i_spare_delay = INT64_MAX;
+
+    vlc_mutex_unlock( &cl->lock );
+
+    return i_spare;
+}
+
+mtime_t input_clock_ReduceDelay( input_clock_t *cl, mtime_t i_delay, bool b_now )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    /* It replaces any reduction still being applied */
+    i_delay = __MIN( __MAX( i_delay, 0 ), cl->i_pts_delay );
+    if( b_now )
+    {
+        cl->i_pts_delay -= i_delay;
+        cl->i_catchup = 0;
+    }
+    else
+        cl->i_catchup = i_delay;
+
+    const mtime_t i_pts_delay = cl->i_pts_delay - cl->i_catchup;
+
+    vlc_mutex_unlock( &cl->lock );
+
+    return i_pts_delay;
+}
+
 mtime_t input_clock_GetJitter( input_clock_t *cl )
 {
     vlc_mutex_lock( &cl->lock );
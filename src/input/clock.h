@@ -130,6 +130,22 @@ int input_clock_GetState( input_clock_t *,
 void input_clock_SetJitter( input_clock_t *,
                             mtime_t i_pts_delay, int i_cr_average );
 
+/**
+ * This function returns by how much the pts_delay could have been smaller
+ * without any clock reference being late, since its previous call.
+ */
+mtime_t input_clock_GetSpareDelay( input_clock_t * );
+
+/**
+ * This function reduces the pts_delay by i_delay, which lowers the latency,
+ * and returns the resulting pts_delay.
+ *
+ * Unless b_now is true, the reduction is spread over time by playing slightly
+ * faster, and replaces any reduction still in progress. Otherwise, the data
+ * already decoded will be late and dropped.
+ */
+mtime_t input_clock_ReduceDelay( input_clock_t *, mtime_t i_delay, bool b_now );
+
 /**
  * This function returns an estimation of the pts_delay needed to avoid rebufferization.
  * XXX in the current implementation, the pts_delay will never be decreased.
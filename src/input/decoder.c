@@ -53,6 +53,8 @@
 
 #include "../video_output/vout_control.h"
 
+#define DECODER_QUEUE_DATES 64
+
 struct decoder_owner_sys_t
 {
     int64_t         i_preroll_end;
@@ -61,6 +63,7 @@ struct decoder_owner_sys_t
     input_resource_t*p_resource;
     input_clock_t   *p_clock;
     int             i_last_rate;
+    bool            b_unpaced; /* :input-unpaced, never wait for the clock */
 
     vout_thread_t   *p_spu_vout;
     int              i_spu_channel;
@@ -126,6 +129,16 @@ struct decoder_owner_sys_t
 
     /* Delay */
     mtime_t i_ts_delay;
+
+    /* Dates the blocks were queued at, for the latency statistics. They
+     * are protected by the fifo lock, and only kept for the last ones. */
+    struct
+    {
+        mtime_t  pi_dates[DECODER_QUEUE_DATES];
+        uint64_t i_in;
+        uint64_t i_out;
+    } queue;
+    mtime_t i_block_date; /* of the block being decoded */
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -256,7 +269,7 @@ static int aout_update_format( decoder_t *p_dec )
         {
             if( aout_DecNew( p_aout, &format,
                              &p_dec->fmt_out.audio_replay_gain,
-                             &request_vout ) )
+                             &request_vout, p_owner->b_unpaced ) )
             {
                 input_resource_PutAout( p_owner->p_resource, p_aout );
                 p_aout = NULL;
@@ -636,6 +649,26 @@ static inline void DecoderUpdatePreroll( int64_t *pi_preroll, const block_t *p )
         *pi_preroll = __MIN( *pi_preroll, p->i_pts );
 }
 
+/* Keeps the worst demux to output delay for the live latency budget */
+static void DecoderUpdateLatency( decoder_t *p_dec, mtime_t i_date )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    input_thread_t *p_input = p_owner->p_input;
+
+    if( p_input == NULL || p_input->p->latency.i_budget <= 0 ||
+        p_owner->i_block_date <= VLC_TS_INVALID || i_date <= VLC_TS_INVALID )
+        return;
+
+    const int_fast64_t i_latency = i_date - p_owner->i_block_date;
+    int_fast64_t i_max = atomic_load_explicit( &p_input->p->latency.i_max,
+                                               memory_order_relaxed );
+    while( i_latency > i_max
+        && !atomic_compare_exchange_weak_explicit( &p_input->p->latency.i_max,
+                                                   &i_max, i_latency,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed ) );
+}
+
 static void DecoderFixTs( decoder_t *p_dec, mtime_t *pi_ts0, mtime_t *pi_ts1,
                           mtime_t *pi_duration, int *pi_rate, mtime_t i_ts_bound )
 {
@@ -696,7 +729,7 @@ static void DecoderWaitDate( decoder_t *p_dec,
 
     vlc_assert_locked( &p_owner->lock );
 
-    if( *pb_reject || i_deadline < 0 )
+    if( *pb_reject || i_deadline < 0 || p_owner->b_unpaced )
         return;
 
     do
@@ -890,8 +923,9 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
 
     const bool b_dated = p_picture->date > VLC_TS_INVALID;
     int i_rate = INPUT_RATE_DEFAULT;
-    DecoderFixTs( p_dec, &p_picture->date, NULL, NULL,
-                  &i_rate, DECODER_BOGUS_VIDEO_DELAY );
+    p_picture->pts = p_picture->date;
+    DecoderFixTs( p_dec, &p_picture->date, NULL, NULL, &i_rate,
+                  p_owner->b_unpaced ? INT64_MAX : DECODER_BOGUS_VIDEO_DELAY );
 
     vlc_mutex_unlock( &p_owner->lock );
 
@@ -901,6 +935,13 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
 
     if( !b_reject )
     {
+        /* From the last block sent to the decoder, reordered pictures
+         * came from earlier ones */
+        if( p_owner->p_input != NULL && p_owner->i_block_date > VLC_TS_INVALID )
+            stats_HistogramAdd( p_owner->p_input->p->counters.p_display_latency,
+                                p_picture->date - p_owner->i_block_date );
+        DecoderUpdateLatency( p_dec, p_picture->date );
+
         if( i_rate != p_owner->i_last_rate || b_first_after_wait )
         {
             /* Be sure to not display old picture after our own */
@@ -930,13 +971,23 @@ static void DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
 static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    input_thread_t *p_input = p_owner->p_input;
+    stats_histogram_t *p_decode_time =
+        p_input != NULL ? p_input->p->counters.p_decode_time : NULL;
     picture_t      *p_pic;
     int i_lost = 0;
     int i_decoded = 0;
     int i_displayed = 0;
 
-    while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
+    for( ;; )
     {
+        mtime_t i_start = p_decode_time != NULL ? mdate() : 0;
+        p_pic = p_dec->pf_decode_video( p_dec, &p_block );
+        if( p_pic == NULL )
+            break;
+        if( p_decode_time != NULL )
+            stats_HistogramAdd( p_decode_time, mdate() - i_start );
+
         vout_thread_t  *p_vout = p_owner->p_vout;
         if( DecoderIsFlushing( p_dec ) )
         {   /* It prevent freezing VLC in case of broken decoder */
@@ -971,16 +1022,12 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
     }
 
     /* Update ugly stat */
-    input_thread_t *p_input = p_owner->p_input;
-
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_displayed > 0) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
-        stats_Update( p_input->p->counters.p_decoded_video, i_decoded, NULL );
-        stats_Update( p_input->p->counters.p_lost_pictures, i_lost , NULL);
+        stats_Update( p_input->p->counters.p_decoded_video, i_decoded );
+        stats_Update( p_input->p->counters.p_lost_pictures, i_lost );
         stats_Update( p_input->p->counters.p_displayed_pictures,
-                      i_displayed, NULL);
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+                      i_displayed );
     }
 }
 
@@ -1079,8 +1126,8 @@ race:
     /* */
     int i_rate = INPUT_RATE_DEFAULT;
 
-    DecoderFixTs( p_dec, &p_audio->i_pts, NULL, &p_audio->i_length,
-                  &i_rate, AOUT_MAX_ADVANCE_TIME );
+    DecoderFixTs( p_dec, &p_audio->i_pts, NULL, &p_audio->i_length, &i_rate,
+                  p_owner->b_unpaced ? INT64_MAX : AOUT_MAX_ADVANCE_TIME );
 
     if( p_audio->i_pts <= VLC_TS_INVALID
      || i_rate < INPUT_RATE_DEFAULT/AOUT_MAX_INPUT_RATE
@@ -1098,6 +1145,7 @@ race:
     if( !b_reject )
     {
         assert( !p_owner->b_paused );
+        DecoderUpdateLatency( p_dec, p_audio->i_pts );
         if( !aout_DecPlay( p_aout, p_audio, i_rate ) )
             *pi_played_sum += 1;
         *pi_lost_sum += aout_DecGetResetLost( p_aout );
@@ -1114,13 +1162,23 @@ race:
 static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    input_thread_t *p_input = p_owner->p_input;
+    stats_histogram_t *p_decode_time =
+        p_input != NULL ? p_input->p->counters.p_decode_time : NULL;
     block_t *p_aout_buf;
     int i_decoded = 0;
     int i_lost = 0;
     int i_played = 0;
 
-    while( (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) )
+    for( ;; )
     {
+        mtime_t i_start = p_decode_time != NULL ? mdate() : 0;
+        p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block );
+        if( p_aout_buf == NULL )
+            break;
+        if( p_decode_time != NULL )
+            stats_HistogramAdd( p_decode_time, mdate() - i_start );
+
         if( DecoderIsFlushing( p_dec ) )
         {
             /* It prevent freezing VLC in case of broken decoder */
@@ -1151,15 +1209,11 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     }
 
     /* Update ugly stat */
-    input_thread_t  *p_input = p_owner->p_input;
-
     if( p_input != NULL && (i_decoded > 0 || i_lost > 0 || i_played > 0) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock);
-        stats_Update( p_input->p->counters.p_lost_abuffers, i_lost, NULL );
-        stats_Update( p_input->p->counters.p_played_abuffers, i_played, NULL );
-        stats_Update( p_input->p->counters.p_decoded_audio, i_decoded, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock);
+        stats_Update( p_input->p->counters.p_lost_abuffers, i_lost );
+        stats_Update( p_input->p->counters.p_played_abuffers, i_played );
+        stats_Update( p_input->p->counters.p_decoded_audio, i_decoded );
     }
 }
 
@@ -1264,11 +1318,7 @@ static void DecoderProcessSpu( decoder_t *p_dec, block_t *p_block, bool b_flush
     while( (p_spu = p_dec->pf_decode_sub( p_dec, p_block ? &p_block : NULL ) ) )
     {
         if( p_input != NULL )
-        {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
-            stats_Update( p_input->p->counters.p_decoded_sub, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
-        }
+            stats_Update( p_input->p->counters.p_decoded_sub, 1 );
 
         p_vout = input_resource_HoldVout( p_owner->p_resource );
         if( p_vout && p_owner->p_spu_vout == p_vout )
@@ -1435,6 +1485,14 @@ static void *DecoderThread( void *p_data )
         }
 
         p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+        if( p_block != NULL )
+        {
+            uint64_t i_out = p_owner->queue.i_out++;
+            p_owner->i_block_date =
+                p_owner->queue.i_in - i_out <= DECODER_QUEUE_DATES
+                ? p_owner->queue.pi_dates[i_out % DECODER_QUEUE_DATES]
+                : VLC_TS_INVALID;
+        }
         vlc_cleanup_pop();
         vlc_fifo_Unlock( p_owner->p_fifo );
 
@@ -1502,6 +1560,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     }
     p_owner->i_preroll_end = VLC_TS_INVALID;
     p_owner->i_last_rate = INPUT_RATE_DEFAULT;
+    p_owner->b_unpaced = var_InheritBool( p_dec, "input-unpaced" );
     p_owner->p_input = p_input;
     p_owner->p_resource = p_resource;
     p_owner->p_aout = NULL;
@@ -1517,6 +1576,9 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_fmt_description = false;
     p_owner->p_description = NULL;
 
+    /* Late frames are kept when decoding as fast as possible */
+    p_dec->b_frame_drop_allowed = !p_owner->b_unpaced;
+
     p_owner->b_paused = false;
     p_owner->pause.i_date = VLC_TS_INVALID;
     p_owner->pause.i_ignore = 0;
@@ -1528,6 +1590,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_flushing = false;
     p_owner->b_draining = false;
     p_owner->b_drained = false;
+    p_owner->queue.i_in = p_owner->queue.i_out = 0;
+    p_owner->i_block_date = VLC_TS_INVALID;
     p_owner->b_idle = false;
 
     es_format_Init( &p_owner->fmt, UNKNOWN_ES, 0 );
@@ -1866,6 +1930,7 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            p_owner->queue.i_out = p_owner->queue.i_in;
         }
     }
     else
@@ -1877,7 +1942,22 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
     }
 
+    if( p_owner->p_input != NULL &&
+        ( p_owner->p_input->p->counters.p_decoder_queue != NULL ||
+          p_owner->p_input->p->latency.i_budget > 0 ) )
+    {
+        mtime_t i_now = mdate();
+        for( block_t *p = p_block; p != NULL; p = p->p_next )
+            p_owner->queue.pi_dates[p_owner->queue.i_in++ % DECODER_QUEUE_DATES] = i_now;
+    }
+    else
+        for( block_t *p = p_block; p != NULL; p = p->p_next )
+            p_owner->queue.i_in++;
+
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
+    if( p_owner->p_input != NULL )
+        stats_HistogramAdd( p_owner->p_input->p->counters.p_decoder_queue,
+                            vlc_fifo_GetCount( p_owner->p_fifo ) );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -1931,6 +2011,7 @@ static void DecoderFlush( decoder_t *p_dec )
     vlc_fifo_Lock( p_owner->p_fifo );
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    p_owner->queue.i_out = p_owner->queue.i_in;
     p_owner->b_draining = false; /* flush supersedes drain */
     vlc_fifo_Unlock( p_owner->p_fifo );
 
@@ -25,14 +25,22 @@
 # include "config.h"
 #endif
 
+#include <stdio.h>
+#include <ctype.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
 #include "access.h"
 #include "demux.h"
+#include "../config/configuration.h"
 #include <libvlc.h>
 #include <vlc_codec.h>
 #include <vlc_meta.h>
 #include <vlc_url.h>
 #include <vlc_modules.h>
 #include <vlc_strings.h>
+#include <vlc_fs.h>
 
 static bool SkipID3Tag( demux_t * );
 static bool SkipAPETag( demux_t *p_demux );
@@ -73,6 +81,281 @@ static const char *demux_FromContentType(const char *mime)
     return (type != NULL) ? type->demux : "any";
 }
 
+/*****************************************************************************
+ * Strong signatures, checked before probing the modules
+ *****************************************************************************/
+static const char *demux_FromMagic( const uint8_t *p_peek, size_t i_peek )
+{
+    static const struct
+    {
+        uint8_t i_offset;
+        char magic[8];
+        uint8_t i_offset2;
+        char magic2[5];
+        char demux[5];
+    } magics[] =
+    {
+        {  0, "\x1A\x45\xDF\xA3",  0, "",     "mkv"  },
+        {  0, "OggS",              0, "",     "ogg"  },
+        {  0, "fLaC",              0, "",     "flac" },
+        {  0, "\x30\x26\xB2\x75\x8E\x66\xCF\x11", 0, "", "asf" },
+        {  0, "RIFF",              8, "AVI ", "avi"  },
+        {  0, "FORM",              8, "AIFF", "aiff" },
+        {  0, "MThd",              0, "",     "smf"  },
+        {  0, "NSVf",              0, "",     "nsv"  },
+        {  0, "NSVs",              0, "",     "nsv"  },
+        {  0, ".snd",              0, "",     "au"   },
+        {  4, "ftyp",              0, "",     "mp4"  },
+        {  4, "moov",              0, "",     "mp4"  },
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE(magics); i++ )
+    {
+        size_t i_len = strnlen( magics[i].magic, sizeof(magics[i].magic) );
+        size_t i_len2 = strlen( magics[i].magic2 );
+
+        if( magics[i].i_offset + i_len > i_peek ||
+            memcmp( &p_peek[magics[i].i_offset], magics[i].magic, i_len ) )
+            continue;
+        if( i_len2 > 0 &&
+            ( magics[i].i_offset2 + i_len2 > i_peek ||
+              memcmp( &p_peek[magics[i].i_offset2], magics[i].magic2, i_len2 ) ) )
+            continue;
+        return magics[i].demux;
+    }
+
+    /* MPEG-TS, sync bytes of three packets */
+    if( i_peek >= 2 * 188 + 1 && p_peek[0] == 0x47 && p_peek[188] == 0x47 &&
+        p_peek[2 * 188] == 0x47 )
+        return "ts";
+
+    return NULL;
+}
+
+/*****************************************************************************
+ * Probe results cache
+ *****************************************************************************
+ * Remembers which module opened the files starting with the same bytes and
+ * with the same extension, so that it is tried first for the next ones.
+ * It is kept in the user cache directory. New entries are written at most
+ * once per PROBE_CACHE_DELAY, and when libvlc exits.
+ *****************************************************************************/
+#define PROBE_SIG_SIZE  4
+#define PROBE_CACHE_MAX 256
+#define PROBE_CACHE_DELAY (60 * CLOCK_FREQ)
+
+struct probe_entry
+{
+    uint8_t sig[PROBE_SIG_SIZE];
+    char    ext[8];
+    char    demux[24];
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_mutex_t save_lock; /* serializes the writers of the file */
+    bool        b_loaded;
+    bool        b_dirty;
+    mtime_t     i_saved;
+    unsigned    i_count;
+    struct probe_entry entries[PROBE_CACHE_MAX];
+} probe_cache = { VLC_STATIC_MUTEX, VLC_STATIC_MUTEX, false, false, 0, 0,
+                  { { { 0 }, "", "" } } };
+
+static char *ProbeCachePath( void )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_path;
+
+    if( psz_dir == NULL ||
+        asprintf( &psz_path, "%s"DIR_SEP"demux-probe", psz_dir ) == -1 )
+        psz_path = NULL;
+    free( psz_dir );
+    return psz_path;
+}
+
+/* Must be called with the lock held */
+static void ProbeCacheLoad( void )
+{
+    probe_cache.b_loaded = true;
+
+    char *psz_path = ProbeCachePath();
+    FILE *file = psz_path ? vlc_fopen( psz_path, "rt" ) : NULL;
+    free( psz_path );
+    if( file == NULL )
+        return;
+
+    char line[64];
+    while( probe_cache.i_count < PROBE_CACHE_MAX &&
+           fgets( line, sizeof(line), file ) != NULL )
+    {
+        struct probe_entry *p_entry = &probe_cache.entries[probe_cache.i_count];
+        unsigned i_sig;
+
+        if( sscanf( line, "%8x %7s %23s", &i_sig, p_entry->ext,
+                    p_entry->demux ) != 3 )
+            continue;
+        SetDWBE( p_entry->sig, i_sig );
+        if( !strcmp( p_entry->ext, "-" ) )
+            p_entry->ext[0] = '\0';
+        probe_cache.i_count++;
+    }
+    fclose( file );
+}
+
+static void ProbeCacheWrite( vlc_object_t *p_obj,
+                             const struct probe_entry *p_entries,
+                             unsigned i_count )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir == NULL )
+        return;
+    int i_ret = config_CreateDir( p_obj, psz_dir );
+    free( psz_dir );
+    if( i_ret )
+        return;
+
+    char *psz_path = ProbeCachePath(), *psz_tmp;
+    if( psz_path == NULL )
+        return;
+    if( asprintf( &psz_tmp, "%s.tmp%u", psz_path, (unsigned)getpid() ) == -1 )
+    {
+        free( psz_path );
+        return;
+    }
+
+    FILE *file = vlc_fopen( psz_tmp, "wt" );
+    if( file != NULL )
+    {
+        for( unsigned i = 0; i < i_count; i++ )
+        {
+            const struct probe_entry *p_entry = &p_entries[i];
+            fprintf( file, "%08"PRIx32" %s %s\n", GetDWBE( p_entry->sig ),
+                     p_entry->ext[0] ? p_entry->ext : "-", p_entry->demux );
+        }
+        if( fclose( file ) || vlc_rename( psz_tmp, psz_path ) )
+            vlc_unlink( psz_tmp );
+    }
+    free( psz_tmp );
+    free( psz_path );
+}
+
+/* Writes the entries added since the last save, if any. The file is written
+ * from a copy, so that lookups are not held up by the I/O. */
+static void ProbeCacheSave( vlc_object_t *p_obj )
+{
+    vlc_mutex_lock( &probe_cache.save_lock );
+    vlc_mutex_lock( &probe_cache.lock );
+
+    struct probe_entry *p_entries = NULL;
+    unsigned i_count = probe_cache.i_count;
+
+    if( probe_cache.b_dirty )
+    {
+        p_entries = malloc( i_count * sizeof(*p_entries) );
+        if( p_entries != NULL )
+        {
+            memcpy( p_entries, probe_cache.entries,
+                    i_count * sizeof(*p_entries) );
+            probe_cache.b_dirty = false;
+            probe_cache.i_saved = mdate();
+        }
+    }
+    vlc_mutex_unlock( &probe_cache.lock );
+
+    if( p_entries != NULL )
+    {
+        ProbeCacheWrite( p_obj, p_entries, i_count );
+        free( p_entries );
+    }
+    vlc_mutex_unlock( &probe_cache.save_lock );
+}
+
+/**
+ * Writes the pending probe results to the cache file.
+ */
+void demux_ProbeCacheFlush( vlc_object_t *p_obj )
+{
+    ProbeCacheSave( p_obj );
+}
+
+static void ProbeCacheKey( demux_t *p_demux, const uint8_t *p_peek,
+                           struct probe_entry *p_key )
+{
+    memcpy( p_key->sig, p_peek, PROBE_SIG_SIZE );
+    p_key->ext[0] = '\0';
+
+    const char *psz_ext = p_demux->psz_file ? strrchr( p_demux->psz_file, '.' )
+                                            : NULL;
+    if( psz_ext == NULL || strlen( ++psz_ext ) >= sizeof(p_key->ext) ||
+        strchr( psz_ext, DIR_SEP_CHAR ) != NULL )
+        return;
+
+    /* The extension is stored as a word in the cache file */
+    size_t i;
+    for( i = 0; psz_ext[i] != '\0'; i++ )
+        p_key->ext[i] = isspace( (unsigned char)psz_ext[i] )
+                      ? '_' : vlc_ascii_tolower( psz_ext[i] );
+    p_key->ext[i] = '\0';
+}
+
+/* Returns the module that opened files like this one, or NULL */
+static const char *ProbeCacheFind( const struct probe_entry *p_key,
+                                   char *psz_demux, size_t i_demux )
+{
+    const char *psz_ret = NULL;
+
+    vlc_mutex_lock( &probe_cache.lock );
+    if( !probe_cache.b_loaded )
+        ProbeCacheLoad();
+    for( unsigned i = 0; i < probe_cache.i_count; i++ )
+    {
+        const struct probe_entry *p_entry = &probe_cache.entries[i];
+        if( !memcmp( p_entry->sig, p_key->sig, PROBE_SIG_SIZE ) &&
+            !strcmp( p_entry->ext, p_key->ext ) )
+        {
+            strlcpy( psz_demux, p_entry->demux, i_demux );
+            psz_ret = psz_demux;
+            break;
+        }
+    }
+    vlc_mutex_unlock( &probe_cache.lock );
+    return psz_ret;
+}
+
+static void ProbeCacheAdd( vlc_object_t *p_obj, struct probe_entry *p_key,
+                           const char *psz_demux )
+{
+    if( strlen( psz_demux ) >= sizeof(p_key->demux) )
+        return;
+    strcpy( p_key->demux, psz_demux );
+
+    vlc_mutex_lock( &probe_cache.lock );
+    unsigned i;
+    for( i = 0; i < probe_cache.i_count; i++ )
+    {
+        const struct probe_entry *p_entry = &probe_cache.entries[i];
+        if( !memcmp( p_entry->sig, p_key->sig, PROBE_SIG_SIZE ) &&
+            !strcmp( p_entry->ext, p_key->ext ) )
+            break;
+    }
+    bool b_save = false;
+    if( i < PROBE_CACHE_MAX )
+    {
+        /* Replaces the entry if another module won this time */
+        probe_cache.entries[i] = *p_key;
+        if( i == probe_cache.i_count )
+            probe_cache.i_count++;
+        probe_cache.b_dirty = true;
+        b_save = mdate() - probe_cache.i_saved >= PROBE_CACHE_DELAY;
+    }
+    vlc_mutex_unlock( &probe_cache.lock );
+
+    if( b_save )
+        ProbeCacheSave( p_obj );
+}
+
 #undef demux_New
 /*****************************************************************************
  * demux_New:
@@ -203,9 +486,43 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input,
           ;
         SkipAPETag( p_demux );
 
+        /* Without hints, try the signatures, then what opened similar files.
+         * Like extensions, these only set the first module to try. */
+        struct probe_entry key;
+        char psz_cached[sizeof(key.demux)];
+        const char *psz_found = NULL;
+        bool b_learn = false;
+        const uint8_t *p_peek;
+        ssize_t i_peek;
+
+        if( !strcmp( psz_module, "any" ) &&
+            ( i_peek = stream_Peek( s, &p_peek, 2 * 188 + 1 ) ) > 0 )
+        {
+            const char *psz_magic = demux_FromMagic( p_peek, i_peek );
+            if( psz_magic != NULL )
+                psz_module = psz_magic;
+            else if( i_peek >= PROBE_SIG_SIZE &&
+                     var_InheritBool( p_demux, "demux-probe-cache" ) )
+            {
+                ProbeCacheKey( p_demux, p_peek, &key );
+                psz_found = ProbeCacheFind( &key, psz_cached,
+                                            sizeof(psz_cached) );
+                if( psz_found != NULL )
+                    psz_module = psz_found;
+                b_learn = true;
+            }
+        }
+
         p_demux->p_module =
             module_need( p_demux, "demux", psz_module,
                          !strcmp( psz_module, p_demux->psz_demux ) );
+
+        if( b_learn && p_demux->p_module != NULL )
+        {
+            const char *psz_winner = module_get_object( p_demux->p_module );
+            if( psz_found == NULL || strcmp( psz_found, psz_winner ) )
+                ProbeCacheAdd( VLC_OBJECT(p_demux), &key, psz_winner );
+        }
     }
     else
     {
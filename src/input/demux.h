@@ -36,6 +36,8 @@ demux_t *demux_New( vlc_object_t *p_obj, input_thread_t *p_parent_input, const c
 
 void demux_Delete( demux_t * );
 
+void demux_ProbeCacheFlush( vlc_object_t * );
+
 static inline int demux_Demux( demux_t *p_demux )
 {
     if( !p_demux->pf_demux )
@@ -157,8 +157,12 @@ struct es_out_sys_t
     bool        b_paused;
     mtime_t     i_pause_date;
 
+    /* Next check of the live latency */
+    mtime_t     i_latency_check;
+
     /* Current preroll */
     mtime_t     i_preroll_end;
+    mtime_t     i_preroll_delay; /* relative to the first timestamp */
 
     /* Used for buffering */
     bool        b_buffering;
@@ -297,6 +301,7 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
 
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
+    p_sys->i_preroll_delay = -1;
     p_sys->i_prev_stream_level = -1;
 
     return out;
@@ -377,12 +382,14 @@ static mtime_t EsOutGetWakeup( es_out_t *out )
         return 0;
 
     /* We do not have a wake up date if the input cannot have its speed
-     * controlled or sout is imposing its own or while buffering
+     * controlled or sout is imposing its own or while buffering, nor when
+     * decoding as fast as possible
      *
      * FIXME for !p_input->p->b_can_pace_control a wake-up time is still needed
      * to avoid too heavy buffering */
     if( !p_input->p->b_can_pace_control ||
         p_input->p->b_out_pace_control ||
+        p_input->p->b_unpaced ||
         p_sys->b_buffering )
         return 0;
 
@@ -597,6 +604,7 @@ static void EsOutChangePosition( es_out_t *out )
     p_sys->i_buffering_extra_stream = 0;
     p_sys->i_buffering_extra_system = 0;
     p_sys->i_preroll_end = -1;
+    p_sys->i_preroll_delay = -1;
     p_sys->i_prev_stream_level = -1;
 }
 
@@ -647,6 +655,7 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
               (int)(i_stream_duration/1000), (int)(i_system_duration/1000) );
     p_sys->b_buffering = false;
     p_sys->i_preroll_end = -1;
+    p_sys->i_preroll_delay = -1;
     p_sys->i_prev_stream_level = -1;
 
     if( p_sys->i_buffering_extra_initial > 0 )
@@ -735,6 +744,47 @@ static bool EsOutIsExtraBufferingAllowed( es_out_t *out )
     return i_size < i_level_high;
 }
 
+/* Shrinks the pts delay of live streams while the demux to output delay
+ * is over the budget and the clock references arrive early enough */
+static void EsOutUpdateLatency( es_out_t *out )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    input_thread_private_t *p_priv = p_sys->p_input->p;
+    const mtime_t i_budget = p_priv->latency.i_budget;
+    const mtime_t i_now = mdate();
+
+    if( i_budget <= 0 || p_priv->b_can_pace_control ||
+        i_now < p_sys->i_latency_check )
+        return;
+    p_sys->i_latency_check = i_now + CLOCK_FREQ;
+
+    input_clock_t *p_clock = p_sys->p_pgrm->p_clock;
+    const mtime_t i_spare = input_clock_GetSpareDelay( p_clock );
+    const mtime_t i_latency = atomic_exchange( &p_priv->latency.i_max, 0 );
+    if( i_latency <= 0 )
+        return;
+    p_priv->latency.i_current = i_latency;
+
+    /* Keep a tenth of the budget for the jitter not seen yet */
+    const mtime_t i_cut = __MIN( i_latency - i_budget, i_spare - i_budget / 10 );
+    if( i_cut <= 0 )
+        return;
+
+    /* Play slightly faster, unless too far behind: then the outputs drop
+     * whatever is late */
+    const bool b_now = i_cut > i_budget;
+    const mtime_t i_pts_delay = input_clock_ReduceDelay( p_clock, i_cut, b_now );
+
+    msg_Dbg( p_sys->p_input, "latency %"PRId64" ms over budget: %s, "
+             "pts delay down to %"PRId64" ms", (i_latency - i_budget) / 1000,
+             b_now ? "dropping" : "catching up", i_pts_delay / 1000 );
+    stats_Update( b_now ? p_priv->counters.p_latency_drops
+                        : p_priv->counters.p_latency_catchups, 1 );
+
+    p_sys->i_pts_delay = __MIN( p_sys->i_pts_delay, i_pts_delay );
+    p_sys->i_pts_jitter = __MIN( p_sys->i_pts_jitter, p_sys->i_pts_delay );
+}
+
 static void EsOutProgramChangePause( es_out_t *out, bool b_paused, mtime_t i_date )
 {
     es_out_sys_t *p_sys = out->p_sys;
@@ -835,6 +885,7 @@ static void EsOutFrameNext( es_out_t *out )
                                                 INPUT_RATE_DEFAULT / i_rate;
 
     p_sys->i_preroll_end = -1;
+    p_sys->i_preroll_delay = -1;
     p_sys->i_prev_stream_level = -1;
 }
 static mtime_t EsOutGetBuffering( es_out_t *out )
@@ -1923,29 +1974,37 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     if( libvlc_stats( p_input ) )
     {
-        uint64_t i_total;
-
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
-        stats_Update( p_input->p->counters.p_demux_read,
-                      p_block->i_buffer, &i_total );
-        stats_Update( p_input->p->counters.p_demux_bitrate, i_total, NULL );
+        stats_Update( p_input->p->counters.p_demux_read, p_block->i_buffer );
 
         /* Update number of corrupted data packats */
         if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
         {
-            stats_Update( p_input->p->counters.p_demux_corrupted, 1, NULL );
+            stats_Update( p_input->p->counters.p_demux_corrupted, 1 );
         }
         /* Update number of discontinuities */
         if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
         {
-            stats_Update( p_input->p->counters.p_demux_discontinuity, 1, NULL );
+            stats_Update( p_input->p->counters.p_demux_discontinuity, 1 );
         }
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 
     vlc_mutex_lock( &p_sys->lock );
 
-    /* Mark preroll blocks */
+    /* Mark preroll blocks. The requested time is an offset from the
+     * first video timestamp: the other ES may start earlier or later */
+    if( p_sys->i_preroll_delay >= 0 &&
+        ( p_sys->p_es_video == NULL || es == p_sys->p_es_video ) )
+    {
+        int64_t i_date = p_block->i_pts;
+        if( p_block->i_pts <= VLC_TS_INVALID )
+            i_date = p_block->i_dts;
+
+        if( i_date > VLC_TS_INVALID )
+        {
+            p_sys->i_preroll_end = i_date + p_sys->i_preroll_delay;
+            p_sys->i_preroll_delay = -1;
+        }
+    }
     if( p_sys->i_preroll_end >= 0 )
     {
         int64_t i_date = p_block->i_pts;
@@ -2383,6 +2442,8 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
 
                 es_out_SetJitter( out, i_pts_delay_base, i_pts_delay - i_pts_delay_base, p_sys->i_cr_average );
             }
+            else
+                EsOutUpdateLatency( out );
         }
         return VLC_SUCCESS;
     }
@@ -2449,6 +2510,7 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
             return VLC_EGENERIC;
 
         p_sys->i_preroll_end = i_date;
+        p_sys->i_preroll_delay = -1;
 
         return VLC_SUCCESS;
     }
@@ -2610,6 +2672,18 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
         EsOutFrameNext( out );
         return VLC_SUCCESS;
 
+    case ES_OUT_SET_PREROLL_DELAY:
+    {
+        const mtime_t i_delay = (mtime_t)va_arg( args, mtime_t );
+
+        /* The demuxer already knows where the requested frame is */
+        if( i_delay < 0 || p_sys->i_preroll_end >= 0 )
+            return VLC_EGENERIC;
+
+        p_sys->i_preroll_delay = i_delay;
+        return VLC_SUCCESS;
+    }
+
     case ES_OUT_SET_TIMES:
     {
         double f_position = (double)va_arg( args, double );
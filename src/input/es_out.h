@@ -71,6 +71,9 @@ enum es_out_query_private_e
     /* Set next frame */
     ES_OUT_SET_FRAME_NEXT,                          /*                          res=can fail */
 
+    /* Set preroll relative to the first timestamp, unless the demuxer set one */
+    ES_OUT_SET_PREROLL_DELAY,                       /* arg1=mtime_t             res=can fail */
+
     /* Set position/time/length */
     ES_OUT_SET_TIMES,                               /* arg1=double f_position arg2=mtime_t i_time arg3=mtime_t i_length res=cannot fail */
 
@@ -138,6 +141,10 @@ static inline int es_out_SetFrameNext( es_out_t *p_out )
 {
     return es_out_Control( p_out, ES_OUT_SET_FRAME_NEXT );
 }
+static inline int es_out_SetPrerollDelay( es_out_t *p_out, mtime_t i_delay )
+{
+    return es_out_Control( p_out, ES_OUT_SET_PREROLL_DELAY, i_delay );
+}
 static inline void es_out_SetTimes( es_out_t *p_out, double f_position, mtime_t i_time, mtime_t i_length )
 {
     int i_ret = es_out_Control( p_out, ES_OUT_SET_TIMES, f_position, i_time, i_length );
@@ -662,6 +662,14 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
     {
         return ControlLockedSetFrameNext( p_out );
     }
+    case ES_OUT_SET_PREROLL_DELAY:
+    {
+        const mtime_t i_delay = (mtime_t)va_arg( args, mtime_t );
+
+        if( p_sys->b_delayed )
+            return VLC_EGENERIC;
+        return es_out_SetPrerollDelay( p_sys->p_out, i_delay );
+    }
     case ES_OUT_GET_PCR_SYSTEM:
     {
         if( p_sys->b_delayed )
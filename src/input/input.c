@@ -46,6 +46,7 @@
 #include "stream.h"
 #include "item.h"
 #include "resource.h"
+#include "info.h"
 
 #include <vlc_sout.h>
 #include <vlc_dialog.h>
@@ -190,6 +191,46 @@ int input_Preparse( vlc_object_t *p_parent, input_item_t *p_item )
     return VLC_SUCCESS;
 }
 
+/**
+ * Open the demuxer of an item without starting an input thread
+ * This function is blocking. As for preparsing, only regular (access and
+ * demux) inputs are accepted. The elementary streams are sent to p_out.
+ *
+ * \param p_parent a vlc_object_t
+ * \param p_item an input item
+ * \param p_out the es_out receiving the elementary streams
+ * \return the input owning the demuxer, to be closed with input_CloseDemux
+ */
+input_thread_t *input_OpenDemux( vlc_object_t *p_parent, input_item_t *p_item,
+                                 es_out_t *p_out )
+{
+    input_thread_t *p_input = Create( p_parent, p_item, NULL, true, NULL );
+    if( !p_input )
+        return NULL;
+
+    p_input->p->p_es_out = p_out;
+    if( InputSourceInit( p_input, &p_input->p->input,
+                         p_input->p->p_item->psz_uri, NULL, true ) )
+    {
+        p_input->p->p_es_out = NULL;
+        vlc_interrupt_deinit( &p_input->p->interrupt );
+        vlc_object_release( p_input );
+        return NULL;
+    }
+    return p_input;
+}
+
+/**
+ * Close an input opened by input_OpenDemux
+ */
+void input_CloseDemux( input_thread_t *p_input )
+{
+    InputSourceClean( &p_input->p->input );
+    p_input->p->p_es_out = NULL;
+    vlc_interrupt_deinit( &p_input->p->interrupt );
+    vlc_object_release( p_input );
+}
+
 /**
  * Start a input_thread_t created by input_Create.
  *
@@ -425,6 +466,16 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     /* Create Objects variables for public Get and Set */
     input_ControlVarInit( p_input );
 
+    p_input->p->b_unpaced = !p_input->b_preparsing &&
+                            var_GetBool( p_input, "input-unpaced" );
+    if( p_input->p->b_unpaced )
+        msg_Dbg( p_input, "decoding as fast as possible" );
+
+    p_input->p->latency.i_budget = p_input->b_preparsing || p_input->p->b_unpaced ? 0 :
+        INT64_C(1000) * var_GetInteger( p_input, "live-latency" );
+    atomic_init( &p_input->p->latency.i_max, 0 );
+    p_input->p->latency.i_current = 0;
+
     /* */
     if( !p_input->b_preparsing )
     {
@@ -635,6 +686,77 @@ static int MainLoopTryRepeat( input_thread_t *p_input, mtime_t *pi_start_mdate )
     return VLC_SUCCESS;
 }
 
+/**
+ * Publishes the transport stream analysis counters, if the demuxer has any.
+ */
+static void MainLoopTSStatistics( input_thread_t *p_input )
+{
+    demux_ts_stats_t *p_stats;
+
+    /* Other demuxers do not know the query: do not ask them again */
+    if( !p_input->p->input.b_ts_stats )
+        return;
+
+    int i_ret = demux_Control( p_input->p->input.p_demux,
+                               DEMUX_GET_TS_STATS, &p_stats );
+    if( i_ret != VLC_SUCCESS )
+    {
+        if( i_ret != VLC_ENOMEM )
+            p_input->p->input.b_ts_stats = false;
+        return;
+    }
+
+    uint64_t i_cc_errors = 0, i_pcr_errors = 0, i_scrambled = 0;
+    uint64_t i_psi_errors = p_stats->i_pat_errors;
+    mtime_t i_pcr_accuracy = 0;
+
+    for( unsigned i = 0; i < p_stats->i_pids; i++ )
+    {
+        const demux_ts_pid_stats_t *p_pid = &p_stats->p_pids[i];
+
+        i_cc_errors += p_pid->i_cc_errors;
+        i_pcr_errors += p_pid->i_pcr_errors;
+        i_scrambled += p_pid->i_scrambled;
+        if( p_pid->i_pcr_accuracy_max > i_pcr_accuracy )
+            i_pcr_accuracy = p_pid->i_pcr_accuracy_max;
+    }
+    for( unsigned i = 0; i < p_stats->i_programs; i++ )
+        i_psi_errors += p_stats->p_programs[i].i_pmt_errors;
+
+    input_stats_t *p_item_stats = p_input->p->p_item->p_stats;
+    vlc_mutex_lock( &p_item_stats->lock );
+    p_item_stats->i_ts_packets = p_stats->i_packets;
+    p_item_stats->i_ts_sync_losses = p_stats->i_sync_losses;
+    p_item_stats->i_ts_cc_errors = i_cc_errors;
+    p_item_stats->i_ts_pcr_errors = i_pcr_errors;
+    p_item_stats->i_ts_pcr_accuracy = i_pcr_accuracy;
+    p_item_stats->i_ts_psi_errors = i_psi_errors;
+    p_item_stats->i_ts_scrambled = i_scrambled;
+    vlc_mutex_unlock( &p_item_stats->lock );
+
+    info_category_t *p_cat = info_category_New( _("Transport stream") );
+    if( p_cat != NULL )
+    {
+        info_category_AddInfo( p_cat, _("Bitrate"), _("%"PRIu64" kb/s"),
+                               p_stats->i_bitrate / 1000 );
+        info_category_AddInfo( p_cat, _("Sync losses"), "%"PRIu64,
+                               p_stats->i_sync_losses );
+        info_category_AddInfo( p_cat, _("Continuity errors"), "%"PRIu64,
+                               i_cc_errors );
+        info_category_AddInfo( p_cat, _("PCR errors"), "%"PRIu64,
+                               i_pcr_errors );
+        info_category_AddInfo( p_cat, _("PCR accuracy"), _("%"PRId64" ns"),
+                               i_pcr_accuracy );
+        info_category_AddInfo( p_cat, _("PAT/PMT errors"), "%"PRIu64,
+                               i_psi_errors );
+        info_category_AddInfo( p_cat, _("Scrambled"), "%.1f%%",
+                               p_stats->i_packets ?
+                               100. * i_scrambled / p_stats->i_packets : 0. );
+        input_Control( p_input, INPUT_REPLACE_INFOS, p_cat );
+    }
+    free( p_stats );
+}
+
 /**
  * Update timing infos and statistics.
  */
@@ -667,9 +789,37 @@ static void MainLoopStatistics( input_thread_t *p_input )
     vlc_mutex_unlock( &p_input->p->p_item->lock );
 
     stats_ComputeInputStats( p_input, p_input->p->p_item->p_stats );
+    if( libvlc_stats( p_input ) )
+        MainLoopTSStatistics( p_input );
     input_SendEventStatistics( p_input );
 }
 
+/**
+ * Reports the decoding speed of an unpaced input
+ */
+static void MainLoopUnpacedStatistics( input_thread_t *p_input,
+                                       mtime_t i_elapsed )
+{
+    input_stats_t *p_stats = p_input->p->p_item->p_stats;
+
+    if( !libvlc_stats( p_input ) || i_elapsed <= 0 )
+        return;
+
+    /* Refresh the time and the counters */
+    MainLoopStatistics( p_input );
+
+    vlc_mutex_lock( &p_stats->lock );
+    const int64_t i_video = p_stats->i_decoded_video;
+    const int64_t i_audio = p_stats->i_decoded_audio;
+    vlc_mutex_unlock( &p_stats->lock );
+
+    msg_Info( p_input, "decoded %"PRId64" video frames and %"PRId64" audio "
+              "blocks in %"PRId64" ms: %.1f frames/s, %.1fx real time",
+              i_video, i_audio, i_elapsed / 1000,
+              (double)i_video * CLOCK_FREQ / i_elapsed,
+              (double)p_input->p->i_time / i_elapsed );
+}
+
 /**
  * MainLoop
  * The main input loop.
@@ -785,6 +935,12 @@ static void MainLoop( input_thread_t *p_input, bool b_interactive )
                 i_wakeup = es_out_GetWakeup( p_input->p->p_es_out );
         }
     }
+
+    /* The last refresh may predate the end of the input */
+    if( p_input->p->b_unpaced )
+        MainLoopUnpacedStatistics( p_input, mdate() - i_start_mdate );
+    else
+        MainLoopStatistics( p_input );
 }
 
 static void InitStatistics( input_thread_t * p_input )
@@ -792,25 +948,27 @@ static void InitStatistics( input_thread_t * p_input )
     if( p_input->b_preparsing ) return;
 
     /* Prepare statistics */
-#define INIT_COUNTER( c, compute ) p_input->p->counters.p_##c = \
- stats_CounterCreate( STATS_##compute);
+#define INIT_COUNTER( c ) p_input->p->counters.p_##c = stats_CounterCreate();
+#define INIT_HISTOGRAM( h ) p_input->p->counters.p_##h = stats_HistogramCreate();
     if( libvlc_stats( p_input ) )
     {
-        INIT_COUNTER( read_bytes, COUNTER );
-        INIT_COUNTER( read_packets, COUNTER );
-        INIT_COUNTER( demux_read, COUNTER );
-        INIT_COUNTER( input_bitrate, DERIVATIVE );
-        INIT_COUNTER( demux_bitrate, DERIVATIVE );
-        INIT_COUNTER( demux_corrupted, COUNTER );
-        INIT_COUNTER( demux_discontinuity, COUNTER );
-        INIT_COUNTER( played_abuffers, COUNTER );
-        INIT_COUNTER( lost_abuffers, COUNTER );
-        INIT_COUNTER( displayed_pictures, COUNTER );
-        INIT_COUNTER( lost_pictures, COUNTER );
-        INIT_COUNTER( decoded_audio, COUNTER );
-        INIT_COUNTER( decoded_video, COUNTER );
-        INIT_COUNTER( decoded_sub, COUNTER );
-        p_input->p->counters.p_sout_send_bitrate = NULL;
+        INIT_COUNTER( read_bytes );
+        INIT_COUNTER( read_packets );
+        INIT_COUNTER( demux_read );
+        INIT_COUNTER( demux_corrupted );
+        INIT_COUNTER( demux_discontinuity );
+        INIT_COUNTER( played_abuffers );
+        INIT_COUNTER( lost_abuffers );
+        INIT_COUNTER( displayed_pictures );
+        INIT_COUNTER( lost_pictures );
+        INIT_COUNTER( decoded_audio );
+        INIT_COUNTER( decoded_video );
+        INIT_COUNTER( decoded_sub );
+        INIT_COUNTER( latency_catchups );
+        INIT_COUNTER( latency_drops );
+        INIT_HISTOGRAM( decode_time );
+        INIT_HISTOGRAM( display_latency );
+        INIT_HISTOGRAM( decoder_queue );
         p_input->p->counters.p_sout_sent_packets = NULL;
         p_input->p->counters.p_sout_sent_bytes = NULL;
     }
@@ -837,9 +995,8 @@ static int InitSout( input_thread_t * p_input )
         }
         if( libvlc_stats( p_input ) )
         {
-            INIT_COUNTER( sout_sent_packets, COUNTER );
-            INIT_COUNTER( sout_sent_bytes, COUNTER );
-            INIT_COUNTER( sout_send_bitrate, DERIVATIVE );
+            INIT_COUNTER( sout_sent_packets );
+            INIT_COUNTER( sout_sent_bytes );
         }
     }
     else
@@ -1069,6 +1226,11 @@ static void UpdatePtsDelay( input_thread_t *p_input )
     if( i_pts_delay < 0 )
         i_pts_delay = 0;
 
+    /* Never cache more than the whole latency budget of live streams */
+    if( p_sys->latency.i_budget > 0 && !p_sys->b_can_pace_control &&
+        i_pts_delay > p_sys->latency.i_budget )
+        i_pts_delay = p_sys->latency.i_budget;
+
     /* Take care of audio/spu delay */
     const mtime_t i_audio_delay = var_GetInteger( p_input, "audio-delay" );
     const mtime_t i_spu_delay   = var_GetInteger( p_input, "spu-delay" );
@@ -1272,8 +1434,6 @@ error:
         EXIT_COUNTER( read_bytes );
         EXIT_COUNTER( read_packets );
         EXIT_COUNTER( demux_read );
-        EXIT_COUNTER( input_bitrate );
-        EXIT_COUNTER( demux_bitrate );
         EXIT_COUNTER( demux_corrupted );
         EXIT_COUNTER( demux_discontinuity );
         EXIT_COUNTER( played_abuffers );
@@ -1283,12 +1443,19 @@ error:
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
+        EXIT_COUNTER( latency_catchups );
+        EXIT_COUNTER( latency_drops );
+#define EXIT_HISTOGRAM( h ) do { stats_HistogramClean( p_input->p->counters.p_##h );\
+                                 p_input->p->counters.p_##h = NULL; } while(0)
+        EXIT_HISTOGRAM( decode_time );
+        EXIT_HISTOGRAM( display_latency );
+        EXIT_HISTOGRAM( decoder_queue );
+#undef EXIT_HISTOGRAM
 
         if( p_input->p->p_sout )
         {
             EXIT_COUNTER( sout_sent_packets );
             EXIT_COUNTER( sout_sent_bytes );
-            EXIT_COUNTER( sout_send_bitrate );
         }
 #undef EXIT_COUNTER
     }
@@ -1343,8 +1510,6 @@ static void End( input_thread_t * p_input )
             CL_CO( read_bytes );
             CL_CO( read_packets );
             CL_CO( demux_read );
-            CL_CO( input_bitrate );
-            CL_CO( demux_bitrate );
             CL_CO( demux_corrupted );
             CL_CO( demux_discontinuity );
             CL_CO( played_abuffers );
@@ -1354,6 +1519,13 @@ static void End( input_thread_t * p_input )
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
+            CL_CO( latency_catchups );
+            CL_CO( latency_drops );
+#define CL_HI( h ) stats_HistogramClean( p_input->p->counters.p_##h ); p_input->p->counters.p_##h = NULL;
+            CL_HI( decode_time );
+            CL_HI( display_latency );
+            CL_HI( decoder_queue );
+#undef CL_HI
         }
 
         /* Close optional stream output instance */
@@ -1361,7 +1533,6 @@ static void End( input_thread_t * p_input )
         {
             CL_CO( sout_sent_packets );
             CL_CO( sout_sent_bytes );
-            CL_CO( sout_send_bitrate );
         }
 #undef CL_CO
     }
@@ -1431,6 +1602,7 @@ static int ControlGetReducedIndexLocked( input_thread_t *p_input )
               i_ct == INPUT_CONTROL_SET_RATE ||
               i_ct == INPUT_CONTROL_SET_POSITION ||
               i_ct == INPUT_CONTROL_SET_TIME ||
+              i_ct == INPUT_CONTROL_SET_TIME_EXACT ||
               i_ct == INPUT_CONTROL_SET_PROGRAM ||
               i_ct == INPUT_CONTROL_SET_TITLE ||
               i_ct == INPUT_CONTROL_SET_SEEKPOINT ||
@@ -1503,6 +1675,7 @@ static bool ControlIsSeekRequest( int i_type )
     {
     case INPUT_CONTROL_SET_POSITION:
     case INPUT_CONTROL_SET_TIME:
+    case INPUT_CONTROL_SET_TIME_EXACT:
     case INPUT_CONTROL_SET_TITLE:
     case INPUT_CONTROL_SET_TITLE_NEXT:
     case INPUT_CONTROL_SET_TITLE_PREV:
@@ -1640,7 +1813,11 @@ static bool Control( input_thread_t *p_input,
         }
 
         case INPUT_CONTROL_SET_TIME:
+        case INPUT_CONTROL_SET_TIME_EXACT:
         {
+            /* An exact seek is always precise, whatever input-fast-seek */
+            const bool b_precise = i_type == INPUT_CONTROL_SET_TIME_EXACT ||
+                                   !p_input->p->b_fast_seek;
             int64_t i_time;
             int i_ret;
 
@@ -1658,8 +1835,7 @@ static bool Control( input_thread_t *p_input,
             es_out_SetTime( p_input->p->p_es_out, -1 );
 
             i_ret = demux_Control( p_input->p->input.p_demux,
-                                   DEMUX_SET_TIME, i_time,
-                                   !p_input->p->b_fast_seek );
+                                   DEMUX_SET_TIME, i_time, b_precise );
             if( i_ret )
             {
                 int64_t i_length;
@@ -1671,7 +1847,7 @@ static bool Control( input_thread_t *p_input,
                     double f_pos = (double)i_time / (double)i_length;
                     i_ret = demux_Control( p_input->p->input.p_demux,
                                             DEMUX_SET_POSITION, f_pos,
-                                            !p_input->p->b_fast_seek );
+                                            b_precise );
                 }
             }
             if( i_ret )
@@ -1681,6 +1857,18 @@ static bool Control( input_thread_t *p_input,
             }
             else
             {
+                int64_t i_landed;
+
+                /* Demuxers landing on the previous key frame without
+                 * telling the es_out where the requested one is: drop
+                 * everything decoded before it */
+                if( i_type == INPUT_CONTROL_SET_TIME_EXACT &&
+                    !demux_Control( p_input->p->input.p_demux,
+                                    DEMUX_GET_TIME, &i_landed ) &&
+                    i_landed >= 0 && i_landed < i_time )
+                    es_out_SetPrerollDelay( p_input->p->p_es_out,
+                                            i_time - i_landed );
+
                 if( p_input->p->i_slave > 0 )
                     SlaveSeek( p_input );
                 p_input->p->input.b_eof = false;
@@ -2432,6 +2620,9 @@ static int InputSourceInit( input_thread_t *p_input,
     if( var_GetInteger( p_input, "clock-synchro" ) != -1 )
         in->b_can_pace_control = !var_GetInteger( p_input, "clock-synchro" );
 
+    /* Until it says otherwise */
+    in->b_ts_stats = true;
+
     return VLC_SUCCESS;
 
 error:
@@ -3009,10 +3200,9 @@ void input_UpdateStatistic( input_thread_t *p_input,
 {
     assert( p_input->p->i_state != INIT_S );
 
-    vlc_mutex_lock( &p_input->p->counters.counters_lock);
     switch( i_type )
     {
-#define I(c) stats_Update( p_input->p->counters.c, i_delta, NULL )
+#define I(c) stats_Update( p_input->p->counters.c, i_delta )
     case INPUT_STATISTIC_DECODED_VIDEO:
         I(p_decoded_video);
         break;
@@ -3025,20 +3215,14 @@ void input_UpdateStatistic( input_thread_t *p_input,
     case INPUT_STATISTIC_SENT_PACKET:
         I(p_sout_sent_packets);
         break;
-#undef I
     case INPUT_STATISTIC_SENT_BYTE:
-    {
-        uint64_t bytes;
-
-        stats_Update( p_input->p->counters.p_sout_sent_bytes, i_delta, &bytes );
-        stats_Update( p_input->p->counters.p_sout_send_bitrate, bytes, NULL );
+        I(p_sout_sent_bytes);
         break;
-    }
+#undef I
     default:
         msg_Err( p_input, "Invalid statistic type %d (internal error)", i_type );
         break;
     }
-    vlc_mutex_unlock( &p_input->p->counters.counters_lock);
 }
 
 /**/
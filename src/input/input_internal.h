@@ -27,6 +27,7 @@
 #include <vlc_access.h>
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 #include <libvlc.h>
 #include "input_interface.h"
 #include "misc/interrupt.h"
@@ -61,6 +62,7 @@ typedef struct
     bool b_can_rate_control;
     bool b_can_stream_record;
     bool b_rescale_ts;
+    bool b_ts_stats; /* demux answers DEMUX_GET_TS_STATS */
 
     /* */
     int64_t i_pts_delay;
@@ -97,6 +99,16 @@ struct input_thread_private_t
     int64_t     i_run;      /* :run-time, 0 if none */
     int64_t     i_time;     /* Current time */
     bool        b_fast_seek;/* :input-fast-seek */
+    bool        b_unpaced;  /* :input-unpaced */
+
+    /* Low latency live mode */
+    struct
+    {
+        mtime_t             i_budget;  /* :live-latency, 0 if disabled */
+        atomic_int_fast64_t i_max;     /* worst demux to output delay seen by
+                                          the decoders since the last check */
+        mtime_t             i_current; /* as of the last check */
+    } latency;
 
     /* Output */
     bool            b_out_pace_control; /* XXX Move it ot es_sout ? */
@@ -140,9 +152,7 @@ struct input_thread_private_t
     struct {
         counter_t *p_read_packets;
         counter_t *p_read_bytes;
-        counter_t *p_input_bitrate;
         counter_t *p_demux_read;
-        counter_t *p_demux_bitrate;
         counter_t *p_demux_corrupted;
         counter_t *p_demux_discontinuity;
         counter_t *p_decoded_audio;
@@ -150,12 +160,16 @@ struct input_thread_private_t
         counter_t *p_decoded_sub;
         counter_t *p_sout_sent_packets;
         counter_t *p_sout_sent_bytes;
-        counter_t *p_sout_send_bitrate;
         counter_t *p_played_abuffers;
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
-        vlc_mutex_t counters_lock;
+        counter_t *p_latency_catchups;
+        counter_t *p_latency_drops;
+        stats_histogram_t *p_decode_time;     /* per frame or buffer */
+        stats_histogram_t *p_display_latency; /* from demux to display */
+        stats_histogram_t *p_decoder_queue;   /* blocks in decoder fifos */
+        vlc_mutex_t counters_lock; /* readers only, updates are lock-free */
     } counters;
 
     /* Buffer of pending actions */
@@ -180,6 +194,7 @@ enum input_control_e
     INPUT_CONTROL_SET_POSITION,
 
     INPUT_CONTROL_SET_TIME,
+    INPUT_CONTROL_SET_TIME_EXACT,
 
     INPUT_CONTROL_SET_PROGRAM,
 
@@ -252,6 +267,8 @@ int subtitles_Filter( const char *);
 /* input.c */
 void input_SplitMRL( const char **, const char **, const char **,
                      const char **, char * );
+input_thread_t *input_OpenDemux( vlc_object_t *, input_item_t *, es_out_t * );
+void input_CloseDemux( input_thread_t * );
 
 /* meta.c */
 void vlc_audio_replay_gain_MergeFromMeta( audio_replay_gain_t *p_dst,
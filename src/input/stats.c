@@ -25,44 +25,262 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include "input/input_internal.h"
 
+/* Counters are split in slots, each on its own cache line, and each thread
+ * adds to one of them: updates do not lock nor bounce cache lines between
+ * decoder threads. The slots are only summed when the statistics are read. */
+#define STATS_SLOTS      8
+#define STATS_CACHE_LINE 64
+
+typedef struct
+{
+    uint64_t value;
+    mtime_t  date;
+} counter_sample_t;
+
+struct counter_t
+{
+    struct
+    {
+        atomic_uint_fast64_t value;
+        char padding[STATS_CACHE_LINE - sizeof (atomic_uint_fast64_t)];
+    } slots[STATS_SLOTS];
+
+    /* Totals sampled by the reader (with the counters lock) for the rates */
+    counter_sample_t samples[2];
+    unsigned         i_samples;
+};
+
+/* The slot of each thread, plus one, is kept in a thread variable. The
+ * variable exists as long as there are counters to update. */
+static unsigned stats_refs = 0;
+static vlc_mutex_t stats_lock = VLC_STATIC_MUTEX;
+static vlc_threadvar_t stats_slot_var;
+
+static unsigned stats_Slot(void)
+{
+    static atomic_uint next = ATOMIC_VAR_INIT(0);
+    void *value = vlc_threadvar_get(stats_slot_var);
+    uintptr_t slot = (uintptr_t)value;
+
+    if (unlikely(slot == 0))
+    {
+        slot = atomic_fetch_add(&next, 1) % STATS_SLOTS + 1;
+        vlc_threadvar_set(stats_slot_var, (void *)slot);
+    }
+    return slot - 1;
+}
+
 /**
  * Create a statistics counter
- * \param i_compute_type the aggregation type. One of STATS_LAST (always
- * keep the last value), STATS_COUNTER (increment by the passed value),
- * STATS_MAX (keep the maximum passed value), STATS_MIN, or STATS_DERIVATIVE
- * (keep a time derivative of the value)
  */
-counter_t * stats_CounterCreate( int i_compute_type )
+counter_t *stats_CounterCreate(void)
 {
-    counter_t *p_counter = (counter_t*) malloc( sizeof( counter_t ) ) ;
+    counter_t *p_counter = vlc_memalign(STATS_CACHE_LINE, sizeof (*p_counter));
 
-    if( !p_counter ) return NULL;
-    p_counter->i_compute_type = i_compute_type;
-    p_counter->i_samples = 0;
-    p_counter->pp_samples = NULL;
+    if (!p_counter) return NULL;
 
-    p_counter->last_update = 0;
+    vlc_mutex_lock(&stats_lock);
+    if (stats_refs == 0 && vlc_threadvar_create(&stats_slot_var, NULL))
+    {
+        vlc_mutex_unlock(&stats_lock);
+        vlc_free(p_counter);
+        return NULL;
+    }
+    stats_refs++;
+    vlc_mutex_unlock(&stats_lock);
+
+    for (unsigned i = 0; i < STATS_SLOTS; i++)
+        atomic_init(&p_counter->slots[i].value, 0);
+    p_counter->i_samples = 0;
 
     return p_counter;
 }
 
-static inline int64_t stats_GetTotal(const counter_t *counter)
+void stats_CounterClean(counter_t *p_c)
+{
+    if (p_c == NULL)
+        return;
+    vlc_free(p_c);
+
+    vlc_mutex_lock(&stats_lock);
+    assert(stats_refs > 0);
+    if (--stats_refs == 0)
+        vlc_threadvar_delete(&stats_slot_var);
+    vlc_mutex_unlock(&stats_lock);
+}
+
+/** Add to a counter
+ * This can be called from any thread, without lock.
+ * \param p_counter the counter to update, or NULL
+ * \param val the value to add
+ */
+void stats_Update(counter_t *p_counter, uint64_t val)
 {
-    if (counter == NULL || counter->i_samples == 0)
+    if (!p_counter)
+        return;
+
+    atomic_fetch_add_explicit(&p_counter->slots[stats_Slot()].value, val,
+                              memory_order_relaxed);
+}
+
+static uint64_t stats_GetTotal(const counter_t *counter)
+{
+    uint64_t total = 0;
+
+    if (counter == NULL)
         return 0;
-    return counter->pp_samples[0]->value;
+    for (unsigned i = 0; i < STATS_SLOTS; i++)
+        total += atomic_load_explicit(&counter->slots[i].value,
+                                      memory_order_relaxed);
+    return total;
 }
 
-static inline float stats_GetRate(const counter_t *counter)
+/* Keeps the last two totals, at least a second apart */
+static void stats_Sample(counter_t *counter, mtime_t now)
+{
+    if (counter == NULL ||
+        (counter->i_samples > 0 && now - counter->samples[0].date < CLOCK_FREQ))
+        return;
+
+    counter->samples[1] = counter->samples[0];
+    counter->samples[0].value = stats_GetTotal(counter);
+    counter->samples[0].date = now;
+    if (counter->i_samples < 2)
+        counter->i_samples++;
+}
+
+static float stats_GetRate(const counter_t *counter)
 {
     if (counter == NULL || counter->i_samples < 2)
         return 0.;
 
-    return (counter->pp_samples[0]->value - counter->pp_samples[1]->value)
-        / (float)(counter->pp_samples[0]->date - counter->pp_samples[1]->date);
+    return (counter->samples[0].value - counter->samples[1].value)
+        / (float)(counter->samples[0].date - counter->samples[1].date);
+}
+
+/* Histograms have linear buckets for the small values, then 8 buckets per
+ * power of two, so that any value is known within 12.5%, like HDR
+ * histograms. Samples are added with relaxed atomics. */
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_LINEAR   (2 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS  (HISTOGRAM_LINEAR + \
+                            ((63 - HISTOGRAM_SUB_BITS) << HISTOGRAM_SUB_BITS))
+
+struct stats_histogram_t
+{
+    atomic_uint_fast64_t buckets[HISTOGRAM_BUCKETS];
+    atomic_uint_fast64_t count;
+    atomic_int_fast64_t  max;
+};
+
+static unsigned stats_HistogramBucket(uint64_t value)
+{
+    if (value < HISTOGRAM_LINEAR)
+        return value;
+
+    unsigned exp = (value >> 32) ? 63 - clz32(value >> 32)
+                                 : 31 - clz32(value);
+    unsigned sub = (value >> (exp - HISTOGRAM_SUB_BITS))
+                 & ((1 << HISTOGRAM_SUB_BITS) - 1);
+    return HISTOGRAM_LINEAR
+         + ((exp - HISTOGRAM_SUB_BITS - 1) << HISTOGRAM_SUB_BITS) + sub;
+}
+
+/* Middle of the values of a bucket */
+static int64_t stats_HistogramValue(unsigned bucket)
+{
+    if (bucket < HISTOGRAM_LINEAR)
+        return bucket;
+
+    bucket -= HISTOGRAM_LINEAR;
+    unsigned shift = (bucket >> HISTOGRAM_SUB_BITS) + 1;
+    uint64_t low = (uint64_t)((1 << HISTOGRAM_SUB_BITS)
+                 + (bucket & ((1 << HISTOGRAM_SUB_BITS) - 1))) << shift;
+    return low + ((UINT64_C(1) << shift) >> 1);
+}
+
+stats_histogram_t *stats_HistogramCreate(void)
+{
+    stats_histogram_t *h = malloc(sizeof (*h));
+
+    if (!h) return NULL;
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+        atomic_init(&h->buckets[i], 0);
+    atomic_init(&h->count, 0);
+    atomic_init(&h->max, 0);
+    return h;
+}
+
+void stats_HistogramClean(stats_histogram_t *h)
+{
+    free(h);
+}
+
+/** Record a sample in a histogram
+ * This can be called from any thread, without lock.
+ * \param h the histogram, or NULL
+ * \param value the sample, negative ones count as zero
+ */
+void stats_HistogramAdd(stats_histogram_t *h, int64_t value)
+{
+    if (!h)
+        return;
+    if (value < 0)
+        value = 0;
+
+    atomic_fetch_add_explicit(&h->buckets[stats_HistogramBucket(value)], 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+
+    int_fast64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (value > max
+        && !atomic_compare_exchange_weak_explicit(&h->max, &max, value,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+}
+
+static void stats_HistogramSummarize(const stats_histogram_t *h,
+                                     input_stats_distribution_t *d)
+{
+    uint64_t buckets[HISTOGRAM_BUCKETS], count = 0;
+
+    memset(d, 0, sizeof (*d));
+    if (h == NULL)
+        return;
+
+    /* Copy first, the histogram can be updated meanwhile */
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        buckets[i] = atomic_load_explicit(&h->buckets[i],
+                                          memory_order_relaxed);
+        count += buckets[i];
+    }
+    d->i_count = count;
+    d->i_max = atomic_load_explicit(&h->max, memory_order_relaxed);
+    if (count == 0)
+        return;
+
+    uint64_t median = (count + 1) / 2, p99 = count - count / 100, sum = 0;
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        if (sum < median && sum + buckets[i] >= median)
+            d->i_median = stats_HistogramValue(i);
+        sum += buckets[i];
+        if (sum >= p99)
+        {
+            d->i_p99 = stats_HistogramValue(i);
+            break;
+        }
+    }
+    /* Bucket middles can be past the largest sample */
+    d->i_median = __MIN(d->i_median, d->i_max);
+    d->i_p99 = __MIN(d->i_p99, d->i_max);
 }
 
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
@@ -83,15 +301,21 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     if (!libvlc_stats(input))
         return;
 
+    mtime_t now = mdate();
+
     vlc_mutex_lock(&input->p->counters.counters_lock);
+    stats_Sample(input->p->counters.p_read_bytes, now);
+    stats_Sample(input->p->counters.p_demux_read, now);
+    stats_Sample(input->p->counters.p_sout_sent_bytes, now);
+
     vlc_mutex_lock(&st->lock);
 
     /* Input */
     st->i_read_packets = stats_GetTotal(input->p->counters.p_read_packets);
     st->i_read_bytes = stats_GetTotal(input->p->counters.p_read_bytes);
-    st->f_input_bitrate = stats_GetRate(input->p->counters.p_input_bitrate);
+    st->f_input_bitrate = stats_GetRate(input->p->counters.p_read_bytes);
     st->i_demux_read_bytes = stats_GetTotal(input->p->counters.p_demux_read);
-    st->f_demux_bitrate = stats_GetRate(input->p->counters.p_demux_bitrate);
+    st->f_demux_bitrate = stats_GetRate(input->p->counters.p_demux_read);
     st->i_demux_corrupted = stats_GetTotal(input->p->counters.p_demux_corrupted);
     st->i_demux_discontinuity = stats_GetTotal(input->p->counters.p_demux_discontinuity);
 
@@ -100,11 +324,11 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     st->i_decoded_audio = stats_GetTotal(input->p->counters.p_decoded_audio);
 
     /* Sout */
-    if (input->p->counters.p_sout_send_bitrate)
+    if (input->p->counters.p_sout_sent_bytes)
     {
         st->i_sent_packets = stats_GetTotal(input->p->counters.p_sout_sent_packets);
         st->i_sent_bytes = stats_GetTotal(input->p->counters.p_sout_sent_bytes);
-        st->f_send_bitrate = stats_GetRate(input->p->counters.p_sout_send_bitrate);
+        st->f_send_bitrate = stats_GetRate(input->p->counters.p_sout_sent_bytes);
     }
 
     /* Aout */
@@ -115,6 +339,19 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     st->i_displayed_pictures = stats_GetTotal(input->p->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(input->p->counters.p_lost_pictures);
 
+    /* Distributions */
+    stats_HistogramSummarize(input->p->counters.p_decode_time,
+                             &st->decode_time);
+    stats_HistogramSummarize(input->p->counters.p_display_latency,
+                             &st->display_latency);
+    stats_HistogramSummarize(input->p->counters.p_decoder_queue,
+                             &st->decoder_queue);
+
+    /* Latency budget */
+    st->i_latency = input->p->latency.i_current;
+    st->i_latency_catchups = stats_GetTotal(input->p->counters.p_latency_catchups);
+    st->i_latency_drops = stats_GetTotal(input->p->counters.p_latency_drops);
+
     vlc_mutex_unlock(&st->lock);
     vlc_mutex_unlock(&input->p->counters.counters_lock);
 }
@@ -130,79 +367,14 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
-    p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
-     = 0;
+    p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate =
+    p_stats->i_latency = p_stats->i_latency_catchups = p_stats->i_latency_drops =
+    p_stats->i_ts_packets = p_stats->i_ts_sync_losses =
+    p_stats->i_ts_cc_errors = p_stats->i_ts_pcr_errors =
+    p_stats->i_ts_pcr_accuracy = p_stats->i_ts_psi_errors =
+    p_stats->i_ts_scrambled = 0;
+    memset( &p_stats->decode_time, 0, sizeof(p_stats->decode_time) );
+    memset( &p_stats->display_latency, 0, sizeof(p_stats->display_latency) );
+    memset( &p_stats->decoder_queue, 0, sizeof(p_stats->decoder_queue) );
     vlc_mutex_unlock( &p_stats->lock );
 }
-
-void stats_CounterClean( counter_t *p_c )
-{
-    if( p_c )
-    {
-        int i = p_c->i_samples - 1 ;
-        while( i >= 0 )
-        {
-            counter_sample_t *p_s = p_c->pp_samples[i];
-            REMOVE_ELEM( p_c->pp_samples, p_c->i_samples, i );
-            free( p_s );
-            i--;
-        }
-        free( p_c );
-    }
-}
-
-
-/** Update a counter element with new values
- * \param p_counter the counter to update
- * \param val the vlc_value union containing the new value to aggregate. For
- * more information on how data is aggregated, \see stats_Create
- * \param val_new a pointer that will be filled with new data
- */
-void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
-{
-    if( !p_counter )
-        return;
-
-    switch( p_counter->i_compute_type )
-    {
-    case STATS_DERIVATIVE:
-    {
-        counter_sample_t *p_new, *p_old;
-        mtime_t now = mdate();
-        if( now - p_counter->last_update < CLOCK_FREQ )
-            return;
-        p_counter->last_update = now;
-        /* Insert the new one at the beginning */
-        p_new = (counter_sample_t*)malloc( sizeof( counter_sample_t ) );
-        p_new->value = val;
-        p_new->date = p_counter->last_update;
-        INSERT_ELEM( p_counter->pp_samples, p_counter->i_samples,
-                     0, p_new );
-
-        if( p_counter->i_samples == 3 )
-        {
-            p_old = p_counter->pp_samples[2];
-            REMOVE_ELEM( p_counter->pp_samples, p_counter->i_samples, 2 );
-            free( p_old );
-        }
-        break;
-    }
-    case STATS_COUNTER:
-        if( p_counter->i_samples == 0 )
-        {
-            counter_sample_t *p_new = (counter_sample_t*)malloc(
-                                               sizeof( counter_sample_t ) );
-            p_new->value = 0;
-
-            INSERT_ELEM( p_counter->pp_samples, p_counter->i_samples,
-                         p_counter->i_samples, p_new );
-        }
-        if( p_counter->i_samples == 1 )
-        {
-            p_counter->pp_samples[0]->value += val;
-            if( new_val )
-                *new_val = p_counter->pp_samples[0]->value;
-        }
-        break;
-    }
-}
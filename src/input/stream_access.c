@@ -1162,13 +1162,8 @@ static ssize_t AReadStream( stream_t *s, void *p_read, size_t i_read )
     i_read = vlc_access_Read( p_sys->p_access, p_read, i_read );
     if( p_input != NULL )
     {
-        uint64_t total;
-
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
-        stats_Update( p_input->p->counters.p_read_bytes, i_read, &total );
-        stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
-        stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+        stats_Update( p_input->p->counters.p_read_bytes, i_read );
+        stats_Update( p_input->p->counters.p_read_packets, 1 );
     }
     return i_read;
 }
@@ -1186,14 +1181,8 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
 
     if( p_input != NULL && p_block != NULL && libvlc_stats (p_access) )
     {
-        uint64_t total;
-
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
-        stats_Update( p_input->p->counters.p_read_bytes, p_block->i_buffer,
-                      &total );
-        stats_Update( p_input->p->counters.p_input_bitrate, total, NULL );
-        stats_Update( p_input->p->counters.p_read_packets, 1, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+        stats_Update( p_input->p->counters.p_read_bytes, p_block->i_buffer );
+        stats_Update( p_input->p->counters.p_read_packets, 1 );
     }
     return p_block;
 }
@@ -0,0 +1,498 @@
+/*****************************************************************************
+ * thumbnailer.c: keyframe extraction without playback
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_input.h>
+#include <vlc_es_out.h>
+#include <vlc_block.h>
+#include <vlc_codec.h>
+#include <vlc_image.h>
+#include <vlc_meta.h>
+#include <vlc_modules.h>
+
+#include "input_internal.h"
+#include "demux.h"
+
+/* Maximum number of video blocks decoded to get one picture */
+#define THUMBNAIL_MAX_BLOCKS 1000
+
+/*
+ * The thumbnailer drives the demuxer itself through a private es_out that
+ * only keeps the first video ES. Nothing is played: there is no clock, no
+ * audio and no video output, the blocks go straight to a decoder.
+ */
+struct es_out_id_t
+{
+    bool b_video;
+};
+
+struct es_out_sys_t
+{
+    es_out_id_t *p_video;
+    es_format_t fmt;
+
+    block_t *p_blocks;
+    block_t **pp_blocks_last;
+};
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *p_fmt )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    es_out_id_t *p_es = malloc( sizeof( *p_es ) );
+    if( !p_es )
+        return NULL;
+
+    p_es->b_video = p_fmt->i_cat == VIDEO_ES && !p_sys->p_video &&
+                    p_sys->fmt.i_cat == UNKNOWN_ES;
+    if( p_es->b_video )
+    {
+        p_sys->p_video = p_es;
+        es_format_Copy( &p_sys->fmt, p_fmt );
+    }
+    return p_es;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *p_es, block_t *p_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( !p_es->b_video )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+    block_ChainLastAppend( &p_sys->pp_blocks_last, p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *p_es )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+
+    if( p_es == p_sys->p_video )
+        p_sys->p_video = NULL;
+    free( p_es );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *p_es = va_arg( args, es_out_id_t * );
+            bool *pb = va_arg( args, bool * );
+            *pb = p_es->b_video;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+        {
+            bool *pb = va_arg( args, bool * );
+            *pb = out->p_sys->p_blocks == NULL;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_PCR_SYSTEM:
+        case ES_OUT_MODIFY_PCR_SYSTEM:
+            return VLC_EGENERIC;
+        default:
+            return VLC_SUCCESS;
+    }
+}
+
+static block_t *EsOutGet( es_out_sys_t *p_sys )
+{
+    block_t *p_block = p_sys->p_blocks;
+    if( p_block )
+    {
+        p_sys->p_blocks = p_block->p_next;
+        if( !p_sys->p_blocks )
+            p_sys->pp_blocks_last = &p_sys->p_blocks;
+        p_block->p_next = NULL;
+    }
+    return p_block;
+}
+
+static void EsOutFlush( es_out_sys_t *p_sys )
+{
+    block_ChainRelease( p_sys->p_blocks );
+    p_sys->p_blocks = NULL;
+    p_sys->pp_blocks_last = &p_sys->p_blocks;
+}
+
+/*****************************************************************************
+ * Decoding
+ *****************************************************************************/
+static int video_update_format( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return 0;
+}
+
+static picture_t *video_new_buffer( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static decoder_t *CreateDecoder( vlc_object_t *p_this, const es_format_t *p_fmt )
+{
+    decoder_t *p_dec = vlc_custom_create( p_this, sizeof( *p_dec ),
+                                          "thumbnail decoder" );
+    if( p_dec == NULL )
+        return NULL;
+
+    p_dec->p_module = NULL;
+    es_format_Copy( &p_dec->fmt_in, p_fmt );
+    es_format_Init( &p_dec->fmt_out, VIDEO_ES, 0 );
+    p_dec->b_frame_drop_allowed = true;
+
+    p_dec->pf_vout_format_update = video_update_format;
+    p_dec->pf_vout_buffer_new = video_new_buffer;
+
+    p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+    if( !p_dec->p_module )
+    {
+        msg_Err( p_dec, "no suitable decoder module for fourcc `%4.4s'",
+                 (char *)&p_dec->fmt_in.i_codec );
+        es_format_Clean( &p_dec->fmt_in );
+        es_format_Clean( &p_dec->fmt_out );
+        vlc_object_release( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    module_unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+
+    vlc_object_release( p_dec );
+}
+
+typedef struct
+{
+    demux_t *p_demux;
+    es_out_sys_t *p_out;
+    decoder_t *p_packetizer;
+    decoder_t *p_decoder;
+} thumbnailer_t;
+
+/* Decodes one block, keeping only the first picture it gives */
+static picture_t *DecodeBlock( decoder_t *p_dec, block_t *p_block )
+{
+    picture_t *p_pic = NULL, *p_tmp;
+
+    while( (p_tmp = p_dec->pf_decode_video( p_dec, &p_block )) != NULL )
+    {
+        if( p_pic == NULL )
+            p_pic = p_tmp;
+        else
+            picture_Release( p_tmp );
+    }
+    return p_pic;
+}
+
+static picture_t *Decode( thumbnailer_t *p_th, block_t *p_block )
+{
+    if( !p_th->p_packetizer )
+        return DecodeBlock( p_th->p_decoder, p_block );
+
+    decoder_t *p_packetizer = p_th->p_packetizer;
+    decoder_t *p_dec = p_th->p_decoder;
+    picture_t *p_pic = NULL;
+    block_t *p_packetized;
+
+    while( (p_packetized =
+            p_packetizer->pf_packetize( p_packetizer, &p_block )) != NULL )
+    {
+        if( p_packetizer->fmt_out.i_extra && !p_dec->fmt_in.i_extra )
+        {
+            es_format_Clean( &p_dec->fmt_in );
+            es_format_Copy( &p_dec->fmt_in, &p_packetizer->fmt_out );
+        }
+
+        while( p_packetized )
+        {
+            block_t *p_next = p_packetized->p_next;
+            p_packetized->p_next = NULL;
+
+            if( p_pic != NULL )
+                block_Release( p_packetized );
+            else
+                p_pic = DecodeBlock( p_dec, p_packetized );
+            p_packetized = p_next;
+        }
+    }
+    return p_pic;
+}
+
+/* Drops whatever the packetizer and the decoder kept from the last seek */
+static block_t *FlushBlockNew( void )
+{
+    block_t *p_null = block_Alloc( 128 );
+    if( !p_null )
+        return NULL;
+
+    p_null->i_flags |= BLOCK_FLAG_DISCONTINUITY | BLOCK_FLAG_CORRUPTED;
+    memset( p_null->p_buffer, 0, p_null->i_buffer );
+
+    return p_null;
+}
+
+static void Flush( thumbnailer_t *p_th )
+{
+    block_t *p_null;
+
+    if( p_th->p_packetizer && (p_null = FlushBlockNew()) != NULL )
+    {
+        decoder_t *p_packetizer = p_th->p_packetizer;
+        block_t *p_out;
+
+        while( (p_out = p_packetizer->pf_packetize( p_packetizer,
+                                                    &p_null )) != NULL )
+            block_ChainRelease( p_out );
+    }
+
+    if( (p_null = FlushBlockNew()) != NULL )
+    {
+        picture_t *p_pic = DecodeBlock( p_th->p_decoder, p_null );
+        if( p_pic )
+            picture_Release( p_pic );
+    }
+}
+
+/* Decodes the first picture available from the current demuxer position.
+ * Bidirectional frames are never referenced, so they are not even decoded. */
+static picture_t *DecodeNext( thumbnailer_t *p_th )
+{
+    for( unsigned i_blocks = 0; i_blocks < THUMBNAIL_MAX_BLOCKS; )
+    {
+        block_t *p_block = EsOutGet( p_th->p_out );
+        if( !p_block )
+        {
+            if( p_th->p_out->p_video == NULL ||
+                demux_Demux( p_th->p_demux ) <= 0 )
+                return NULL;
+            continue;
+        }
+
+        if( p_block->i_flags & BLOCK_FLAG_TYPE_B )
+        {
+            block_Release( p_block );
+            continue;
+        }
+
+        i_blocks++;
+        picture_t *p_pic = Decode( p_th, p_block );
+        if( p_pic )
+            return p_pic;
+    }
+    return NULL;
+}
+
+static int Seek( demux_t *p_demux, mtime_t i_time )
+{
+    if( !demux_Control( p_demux, DEMUX_SET_TIME, (int64_t)i_time, false ) )
+        return VLC_SUCCESS;
+
+    int64_t i_length;
+    if( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length ) ||
+        i_length <= 0 )
+        return VLC_EGENERIC;
+    return demux_Control( p_demux, DEMUX_SET_POSITION,
+                          (double)i_time / i_length, false );
+}
+
+/* Converts a decoded picture, computing the missing dimension from the
+ * display aspect ratio */
+static picture_t *Convert( image_handler_t *p_image, picture_t *p_pic,
+                           const video_format_t *p_fmt_in,
+                           const video_format_t *p_fmt )
+{
+    video_format_t fmt_in = *p_fmt_in, fmt_out;
+    unsigned i_sar_num = fmt_in.i_sar_num, i_sar_den = fmt_in.i_sar_den;
+
+    if( !fmt_in.i_visible_width || !fmt_in.i_visible_height )
+    {
+        fmt_in.i_visible_width = fmt_in.i_width;
+        fmt_in.i_visible_height = fmt_in.i_height;
+    }
+    if( !i_sar_num || !i_sar_den )
+        i_sar_num = i_sar_den = 1;
+
+    video_format_Init( &fmt_out, p_fmt->i_chroma );
+    fmt_out.i_width = p_fmt->i_width;
+    fmt_out.i_height = p_fmt->i_height;
+    if( !fmt_out.i_width && fmt_out.i_height )
+        fmt_out.i_width = (uint64_t)fmt_in.i_visible_width * i_sar_num *
+                          fmt_out.i_height / fmt_in.i_visible_height /
+                          i_sar_den;
+    if( !fmt_out.i_height && fmt_out.i_width )
+        fmt_out.i_height = (uint64_t)fmt_in.i_visible_height * i_sar_den *
+                           fmt_out.i_width / fmt_in.i_visible_width /
+                           i_sar_num;
+    fmt_out.i_visible_width = fmt_out.i_width;
+    fmt_out.i_visible_height = fmt_out.i_height;
+    fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+    return image_Convert( p_image, p_pic, &fmt_in, &fmt_out );
+}
+
+#undef input_Thumbnails
+/**
+ * Extract thumbnails from an item without playing it.
+ */
+int input_Thumbnails( vlc_object_t *p_parent, input_item_t *p_item,
+                      const mtime_t *pi_times, size_t i_count,
+                      const video_format_t *p_fmt,
+                      input_thumbnail_cb pf_thumbnail, void *p_opaque )
+{
+    vlc_object_t *p_obj = vlc_object_create( p_parent, sizeof( *p_obj ) );
+    if( !p_obj )
+        return -1;
+
+    /* Favor speed over quality: cheapest scaler, no hardware decoding setup
+     * and no decoding of frames nothing else references */
+    var_Create( p_obj, "swscale-mode", VLC_VAR_INTEGER );
+    var_SetInteger( p_obj, "swscale-mode", 0 );
+    var_Create( p_obj, "avcodec-skip-frame", VLC_VAR_INTEGER );
+    var_SetInteger( p_obj, "avcodec-skip-frame", 1 );
+    var_Create( p_obj, "avcodec-hw", VLC_VAR_STRING );
+    var_SetString( p_obj, "avcodec-hw", "none" );
+
+    es_out_sys_t sys = {
+        .p_video = NULL,
+        .p_blocks = NULL,
+        .pp_blocks_last = &sys.p_blocks,
+    };
+    es_format_Init( &sys.fmt, UNKNOWN_ES, 0 );
+    es_out_t out = {
+        .pf_add = EsOutAdd,
+        .pf_send = EsOutSend,
+        .pf_del = EsOutDel,
+        .pf_control = EsOutControl,
+        .p_sys = &sys,
+    };
+
+    thumbnailer_t th = { .p_out = &sys };
+    image_handler_t *p_image = NULL;
+    int i_done = -1;
+
+    input_thread_t *p_input = input_OpenDemux( p_obj, p_item, &out );
+    if( !p_input )
+        goto error;
+    th.p_demux = p_input->p->input.p_demux;
+
+    bool b_playlist;
+    if( !demux_Control( th.p_demux, DEMUX_IS_PLAYLIST, &b_playlist ) &&
+        b_playlist )
+        goto error;
+
+    /* Most demuxers declare their ES when opening, the others do it when
+     * reading the first blocks */
+    while( sys.fmt.i_cat == UNKNOWN_ES )
+        if( demux_Demux( th.p_demux ) <= 0 )
+        {
+            msg_Warn( p_obj, "no video to take thumbnails from" );
+            goto error;
+        }
+
+    es_format_t fmt;
+    es_format_Copy( &fmt, &sys.fmt );
+    if( !fmt.b_packetized )
+    {
+        th.p_packetizer = demux_PacketizerNew( th.p_demux, &fmt, "thumbnail" );
+        if( !th.p_packetizer )
+            goto error;
+        es_format_Copy( &fmt, &sys.fmt );
+        fmt.b_packetized = true;
+    }
+    th.p_decoder = CreateDecoder( p_obj, &fmt );
+    es_format_Clean( &fmt );
+    if( !th.p_decoder )
+        goto error;
+
+    p_image = image_HandlerCreate( p_obj );
+    if( !p_image )
+        goto error;
+
+    /* Without seeking, the demuxer is still at the start: a picture at
+     * time 0 can be taken from there */
+    bool b_at_start = true;
+
+    i_done = 0;
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( Seek( th.p_demux, pi_times[i] ) == VLC_SUCCESS )
+        {
+            EsOutFlush( &sys );
+            Flush( &th );
+        }
+        else if( pi_times[i] != 0 || !b_at_start )
+        {
+            msg_Warn( p_obj, "cannot seek to %"PRId64, pi_times[i] );
+            continue;
+        }
+
+        picture_t *p_pic = DecodeNext( &th );
+        b_at_start = false;
+        if( !p_pic )
+        {
+            msg_Warn( p_obj, "no picture at %"PRId64, pi_times[i] );
+            continue;
+        }
+
+        picture_t *p_thumb = Convert( p_image, p_pic,
+                                      &th.p_decoder->fmt_out.video, p_fmt );
+        picture_Release( p_pic );
+        if( !p_thumb )
+            continue;
+
+        pf_thumbnail( p_opaque, i, p_thumb );
+        picture_Release( p_thumb );
+        i_done++;
+    }
+
+error:
+    if( p_image )
+        image_HandlerDelete( p_image );
+    if( th.p_decoder )
+        DeleteDecoder( th.p_decoder );
+    if( th.p_packetizer )
+        demux_PacketizerDestroy( th.p_packetizer );
+    if( p_input )
+        input_CloseDemux( p_input );
+    EsOutFlush( &sys );
+    es_format_Clean( &sys.fmt );
+    vlc_object_release( p_obj );
+    return i_done;
+}
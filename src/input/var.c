@@ -93,6 +93,7 @@ static const vlc_input_callback_t p_input_callbacks[] =
     CALLBACK( "position", PositionCallback ),
     CALLBACK( "position-offset", PositionCallback ),
     CALLBACK( "time", TimeCallback ),
+    CALLBACK( "time-exact", TimeCallback ),
     CALLBACK( "time-offset", TimeOffsetCallback ),
     CALLBACK( "bookmark", BookmarkCallback ),
     CALLBACK( "program", ProgramCallback ),
@@ -149,6 +150,7 @@ void input_ControlVarInit ( input_thread_t *p_input )
     /* Time */
     var_Create( p_input, "time", VLC_VAR_INTEGER );
     var_Create( p_input, "time-offset", VLC_VAR_INTEGER );    /* relative */
+    var_Create( p_input, "time-exact", VLC_VAR_INTEGER );     /* precise */
 
     /* Bookmark */
     var_Create( p_input, "bookmark", VLC_VAR_INTEGER | VLC_VAR_HASCHOICE |
@@ -445,6 +447,8 @@ void input_ConfigVarInit ( input_thread_t *p_input )
         var_Create( p_input, "stop-time", VLC_VAR_FLOAT|VLC_VAR_DOINHERIT );
         var_Create( p_input, "run-time", VLC_VAR_FLOAT|VLC_VAR_DOINHERIT );
         var_Create( p_input, "input-fast-seek", VLC_VAR_BOOL|VLC_VAR_DOINHERIT );
+        var_Create( p_input, "input-unpaced", VLC_VAR_BOOL|VLC_VAR_DOINHERIT );
+        var_Create( p_input, "live-latency", VLC_VAR_INTEGER|VLC_VAR_DOINHERIT );
 
         var_Create( p_input, "input-slave",
                     VLC_VAR_STRING | VLC_VAR_DOINHERIT );
@@ -601,7 +605,7 @@ static int TimeCallback( vlc_object_t *p_this, char const *psz_cmd,
                          vlc_value_t oldval, vlc_value_t newval, void *p_data )
 {
     input_thread_t *p_input = (input_thread_t*)p_this;
-    VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval); VLC_UNUSED(p_data);
+    VLC_UNUSED(oldval); VLC_UNUSED(p_data);
 
     /* Update "position" for better intf behavour */
     const int64_t i_length = var_GetInteger( p_input, "length" );
@@ -618,7 +622,10 @@ static int TimeCallback( vlc_object_t *p_this, char const *psz_cmd,
         var_SetInteger( p_input, "intf-event", INPUT_EVENT_POSITION );
     }
 
-    input_ControlPush( p_input, INPUT_CONTROL_SET_TIME, &newval );
+    if( !strcmp( psz_cmd, "time-exact" ) )
+        input_ControlPush( p_input, INPUT_CONTROL_SET_TIME_EXACT, &newval );
+    else
+        input_ControlPush( p_input, INPUT_CONTROL_SET_TIME, &newval );
     return VLC_SUCCESS;
 }
 
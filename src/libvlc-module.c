@@ -85,6 +85,14 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_RATE_LIMIT_TEXT N_("Messages rate limit")
+#define LOG_RATE_LIMIT_LONGTEXT N_( \
+    "Maximum number of messages per second from a same module, errors " \
+    "excepted, or 0 for no limit. Further messages are dropped and counted. " \
+    "There is no limit by default, so that debug logs are complete. " \
+    "Messages above the logger verbosity are discarded before being " \
+    "formatted anyway.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -523,6 +531,13 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define LIVE_LATENCY_TEXT N_("Live latency budget (ms)")
+#define LIVE_LATENCY_LONGTEXT N_( \
+    "Target delay from the reception of live streams to their display, in " \
+    "milliseconds. The caching is reduced to fit, then shrunk while the " \
+    "data keeps arriving early enough, by playing slightly faster or by " \
+    "dropping frames when far behind. 0 disables it." )
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -636,6 +651,22 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define INPUT_UNPACED_TEXT N_("Decode as fast as possible")
+#define INPUT_UNPACED_LONGTEXT N_( \
+    "Do not synchronize decoding to the clock, and never drop late frames. " \
+    "Decoders are only held back by their outputs. This is meant for " \
+    "analysis of local files, not for playback." )
+
+#define DEMUX_PROBE_CACHE_TEXT N_("Remember probed formats")
+#define DEMUX_PROBE_CACHE_LONGTEXT N_( \
+    "Remember which demuxer opened files with the same leading bytes and " \
+    "extension, and try it first on the next ones.")
+
+#define INPUT_INDEX_CACHE_TEXT N_("Cache seek indexes")
+#define INPUT_INDEX_CACHE_LONGTEXT N_( \
+    "Keep the seek indexes that demuxers build by scanning local files " \
+    "without one, and reuse them when the same file is opened again." )
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -1090,6 +1121,17 @@ static const char *const ppsz_prefres[] = {
     "Automatically preparse files added to the playlist " \
     "(to retrieve some metadata)." )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsing threads")
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of items preparsed at the same time. Network items " \
+    "are not given all of them, so that local files keep being preparsed." )
+
+#define PREPARSE_TIMEOUT_TEXT N_( "Preparsing timeout (ms)")
+#define PREPARSE_TIMEOUT_LONGTEXT N_( \
+    "Preparsing an item is aborted after this delay, so that a broken " \
+    "file or a slow share does not hold back the other items " \
+    "(0 to disable)." )
+
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
 #define SD_TEXT N_( "Services discovery modules")
@@ -1688,6 +1730,13 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_bool( "input-unpaced", false,
+              INPUT_UNPACED_TEXT, INPUT_UNPACED_LONGTEXT, true )
+        change_safe ()
+    add_bool( "input-index-cache", true,
+              INPUT_INDEX_CACHE_TEXT, INPUT_INDEX_CACHE_LONGTEXT, true )
+    add_bool( "demux-probe-cache", true,
+              DEMUX_PROBE_CACHE_TEXT, DEMUX_PROBE_CACHE_LONGTEXT, true )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -1825,6 +1874,10 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_integer( "live-latency", 0, LIVE_LATENCY_TEXT,
+                 LIVE_LATENCY_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -2008,6 +2061,11 @@ vlc_module_begin ()
 
     add_bool( "auto-preparse", true, PREPARSE_TEXT,
               PREPARSE_LONGTEXT, false )
+    add_integer( "preparse-threads", 2, PREPARSE_THREADS_TEXT,
+                 PREPARSE_THREADS_LONGTEXT, true )
+        change_integer_range( 1, 32 )
+    add_integer( "preparse-timeout", 5000, PREPARSE_TIMEOUT_TEXT,
+                 PREPARSE_TIMEOUT_LONGTEXT, true )
 
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
@@ -2024,6 +2082,8 @@ vlc_module_begin ()
                  false )
         change_short('v')
         change_volatile ()
+    add_integer( "log-rate-limit", 0, LOG_RATE_LIMIT_TEXT,
+                 LOG_RATE_LIMIT_LONGTEXT, true )
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
@@ -43,6 +43,7 @@
 #include "modules/modules.h"
 #include "config/configuration.h"
 #include "playlist/preparser.h"
+#include "input/demux.h"
 
 #include <stdio.h>                                              /* sprintf() */
 #include <string.h>
@@ -235,6 +236,9 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
     }
 #endif
 
+    /* The logger thread would not survive the fork to daemon mode */
+    vlc_LogStart( p_libvlc );
+
 /* FIXME: could be replaced by using Unix sockets */
 #ifdef HAVE_DBUS
 
@@ -526,6 +530,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if (priv->parser != NULL)
         playlist_preparser_Delete(priv->parser);
 
+    demux_ProbeCacheFlush( VLC_OBJECT(p_libvlc) );
+
     vlc_DeinitActions( p_libvlc, priv->actions );
 
     /* Save the configuration */
@@ -616,6 +622,22 @@ int libvlc_MetaRequest(libvlc_int_t *libvlc, input_item_t *item,
     return VLC_SUCCESS;
 }
 
+/**
+ * Gets the progress of the meta data requests.
+ */
+void libvlc_MetaRequestStats(libvlc_int_t *libvlc,
+                             input_preparser_stats_t *stats)
+{
+    libvlc_priv_t *priv = libvlc_priv(libvlc);
+
+    if (unlikely(priv->parser == NULL))
+    {
+        memset(stats, 0, sizeof (*stats));
+        return;
+    }
+    playlist_preparser_GetStats(priv->parser, stats);
+}
+
 /**
  * Requests retrieving/downloading art for an input item.
  * The retrieval is performed asynchronously.
@@ -77,6 +77,7 @@ typedef struct vlc_logger_t vlc_logger_t;
 
 int vlc_LogPreinit(libvlc_int_t *);
 int vlc_LogInit(libvlc_int_t *);
+void vlc_LogStart(libvlc_int_t *);
 void vlc_LogDeinit(libvlc_int_t *);
 
 /*
@@ -181,26 +182,8 @@ void var_OptionParse (vlc_object_t *, const char *, bool trusted);
 /*
  * Stats stuff
  */
-enum
-{
-    STATS_COUNTER,
-    STATS_DERIVATIVE,
-};
-
-typedef struct counter_sample_t
-{
-    uint64_t value;
-    mtime_t  date;
-} counter_sample_t;
-
-typedef struct counter_t
-{
-    int                 i_compute_type;
-    int                 i_samples;
-    counter_sample_t ** pp_samples;
-
-    mtime_t             last_update;
-} counter_t;
+typedef struct counter_t counter_t;
+typedef struct stats_histogram_t stats_histogram_t;
 
 enum
 {
@@ -225,10 +208,14 @@ enum
     STATS_LOST_PICTURES,
 };
 
-counter_t * stats_CounterCreate (int);
-void stats_Update (counter_t *, uint64_t, uint64_t *);
+counter_t * stats_CounterCreate (void);
+void stats_Update (counter_t *, uint64_t);
 void stats_CounterClean (counter_t * );
 
+stats_histogram_t *stats_HistogramCreate (void);
+void stats_HistogramAdd (stats_histogram_t *, int64_t);
+void stats_HistogramClean (stats_histogram_t *);
+
 void stats_ComputeInputStats(input_thread_t*, input_stats_t*);
 void stats_ReinitInputStats(input_stats_t *);
 
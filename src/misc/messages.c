@@ -41,8 +41,31 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
+#define LOG_QUEUE_SIZE  1024 /* power of two */
+#define LOG_TEXT_SIZE   256
+#define LOG_RATE_SLOTS  64
+
+/* A message waiting for the logger thread. The slot sequence number tells
+ * whose turn it is: equal to its position when free for a producer, one more
+ * when filled for the consumer. */
+typedef struct
+{
+    atomic_size_t seq;
+    int type;
+    uintptr_t object_id;
+    const char *object_type; /* static */
+    const char *file;
+    const char *func;
+    unsigned line;
+    char module[32];
+    char header[64];
+    char *long_text; /* if the message did not fit in text */
+    char text[LOG_TEXT_SIZE];
+} vlc_log_slot_t;
+
 struct vlc_logger_t
 {
     VLC_COMMON_MEMBERS
@@ -50,6 +73,28 @@ struct vlc_logger_t
     vlc_log_cb log;
     void *sys;
     module_t *module;
+    atomic_int threshold; /* most verbose message type delivered, or -1 */
+
+    /* Messages are queued by the emitting threads, and delivered by the
+     * logger thread, so that slow loggers do not block them */
+    struct
+    {
+        vlc_log_slot_t *slots;
+        atomic_size_t tail; /* next position to fill */
+        size_t head; /* next position to deliver, logger thread only */
+        vlc_sem_t wait; /* one count per filled slot */
+        vlc_thread_t thread;
+        atomic_bool running;
+        atomic_uint users; /* emitters that may be queuing */
+        vlc_mutex_t users_lock;
+        vlc_cond_t users_wait; /* signaled when stopping and users drain */
+        atomic_bool stop;
+
+        atomic_uint dropped; /* since the last report */
+        atomic_uint limited; /* since the last report */
+        unsigned rate_limit; /* messages per second and module, 0 if none */
+        atomic_uint_fast64_t rate[LOG_RATE_SLOTS]; /* second << 32 | count */
+    } queue;
 };
 
 static void vlc_vaLogCallback(libvlc_int_t *vlc, int type,
@@ -82,6 +127,264 @@ static void Win32DebugOutputMsg (void *, int , const vlc_log_t *,
                                  const char *, va_list);
 #endif
 
+/**
+ * Counts a message against the budget of its module for the current second.
+ * Modules hashing to the same slot share their budget. Errors are never
+ * limited.
+ */
+static bool vlc_LogRateLimited(vlc_logger_t *logger, int type,
+                               const char *module)
+{
+    unsigned limit = logger->queue.rate_limit;
+    if (limit == 0 || type == VLC_MSG_ERR)
+        return false;
+
+    uint32_t hash = 2166136261u;
+    for (const char *p = module; *p; p++)
+        hash = (hash ^ (unsigned char)*p) * 16777619u;
+
+    atomic_uint_fast64_t *slot = &logger->queue.rate[hash % LOG_RATE_SLOTS];
+    uint_fast64_t second = (uint32_t)(mdate() / CLOCK_FREQ);
+    uint_fast64_t state = atomic_load_explicit(slot, memory_order_relaxed);
+    uint_fast64_t next;
+
+    do
+    {
+        if ((state >> 32) != second)
+            next = (second << 32) | 1;
+        else if ((state & UINT32_MAX) >= limit)
+            return true;
+        else
+            next = state + 1;
+    }
+    while (!atomic_compare_exchange_weak_explicit(slot, &state, next,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+    return false;
+}
+
+/**
+ * Queues a message for the logger thread. The message is formatted right
+ * away, as its arguments may not outlive the call. This never blocks: if the
+ * queue is full, the message is dropped and counted.
+ */
+static void vlc_vaLogQueue(vlc_logger_t *logger, int type,
+                           const vlc_log_t *item, const char *format,
+                           va_list ap)
+{
+    if (vlc_LogRateLimited(logger, type, item->psz_module))
+    {
+        atomic_fetch_add_explicit(&logger->queue.limited, 1,
+                                  memory_order_relaxed);
+        return;
+    }
+
+    size_t pos = atomic_load_explicit(&logger->queue.tail,
+                                      memory_order_relaxed);
+    vlc_log_slot_t *slot;
+
+    for (;;)
+    {
+        slot = &logger->queue.slots[pos % LOG_QUEUE_SIZE];
+
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&logger->queue.tail,
+                                                      &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {   /* Full: the slot still holds a message from the previous lap */
+            atomic_fetch_add_explicit(&logger->queue.dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        }
+        else
+            pos = atomic_load_explicit(&logger->queue.tail,
+                                       memory_order_relaxed);
+    }
+
+    slot->type = type;
+    slot->object_id = item->i_object_id;
+    slot->object_type = item->psz_object_type;
+    slot->file = item->file;
+    slot->func = item->func;
+    slot->line = item->line;
+    strlcpy(slot->module, item->psz_module, sizeof (slot->module));
+    strlcpy(slot->header, item->psz_header ? item->psz_header : "",
+            sizeof (slot->header));
+    slot->long_text = NULL;
+
+    va_list aq;
+    va_copy(aq, ap);
+    int len = vsnprintf(slot->text, sizeof (slot->text), format, aq);
+    va_end(aq);
+    if (len < 0)
+        strcpy(slot->text, "message lost");
+    else if ((size_t)len >= sizeof (slot->text)
+          && vasprintf(&slot->long_text, format, ap) == -1)
+        slot->long_text = NULL; /* keep the truncated text */
+
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    vlc_sem_post(&logger->queue.wait);
+}
+
+static void vlc_LogReportDrops(vlc_logger_t *logger)
+{
+    libvlc_int_t *vlc = logger->p_libvlc;
+    unsigned dropped = atomic_exchange(&logger->queue.dropped, 0);
+    unsigned limited = atomic_exchange(&logger->queue.limited, 0);
+
+    if (dropped == 0 && limited == 0)
+        return;
+
+    vlc_log_t meta = {
+        .i_object_id = (uintptr_t)logger,
+        .psz_object_type = "logger",
+        .psz_module = "core",
+    };
+
+    if (dropped > 0)
+        vlc_LogCallback(vlc, VLC_MSG_WARN, &meta,
+                        "%u message(s) dropped (queue full)", dropped);
+    if (limited > 0)
+        vlc_LogCallback(vlc, VLC_MSG_WARN, &meta,
+                        "%u message(s) dropped (over %u per second and module)",
+                        limited, logger->queue.rate_limit);
+}
+
+/* Delivers the message of the slot at the head of the queue, and frees it
+ * for the next lap */
+static void vlc_LogDeliver(vlc_logger_t *logger, libvlc_int_t *vlc,
+                           vlc_log_slot_t *slot, size_t head)
+{
+    vlc_log_t meta = {
+        .i_object_id = slot->object_id,
+        .psz_object_type = slot->object_type,
+        .psz_module = slot->module,
+        .psz_header = slot->header[0] ? slot->header : NULL,
+        .file = slot->file,
+        .line = slot->line,
+        .func = slot->func,
+    };
+
+    vlc_LogCallback(vlc, slot->type, &meta, "%s",
+                    slot->long_text ? slot->long_text : slot->text);
+    free(slot->long_text);
+
+    atomic_store_explicit(&slot->seq, head + LOG_QUEUE_SIZE,
+                          memory_order_release);
+    logger->queue.head = head + 1;
+
+    vlc_LogReportDrops(logger);
+}
+
+static void *vlc_LogThread(void *data)
+{
+    vlc_logger_t *logger = data;
+    libvlc_int_t *vlc = logger->p_libvlc;
+    size_t pending = 0; /* signaled messages not delivered yet */
+
+    for (;;)
+    {
+        vlc_sem_wait(&logger->queue.wait);
+        pending++;
+
+        /* Messages are delivered in order: if another thread is still
+         * formatting an earlier message, wait for it to signal that one. */
+        while (pending > 0)
+        {
+            size_t head = logger->queue.head;
+            vlc_log_slot_t *slot =
+                &logger->queue.slots[head % LOG_QUEUE_SIZE];
+
+            if (atomic_load_explicit(&slot->seq,
+                                     memory_order_acquire) != head + 1)
+                break;
+
+            vlc_LogDeliver(logger, vlc, slot, head);
+            pending--;
+        }
+
+        if (atomic_load(&logger->queue.stop)
+         && atomic_load_explicit(&logger->queue.tail, memory_order_relaxed)
+                == logger->queue.head)
+            break; /* all emitters are gone and everything was delivered */
+    }
+
+    vlc_LogReportDrops(logger);
+    return NULL;
+}
+
+static void vlc_LogQueueStart(vlc_logger_t *logger)
+{
+    logger->queue.slots = malloc(LOG_QUEUE_SIZE
+                                 * sizeof (*logger->queue.slots));
+    if (unlikely(logger->queue.slots == NULL))
+        return;
+
+    for (size_t i = 0; i < LOG_QUEUE_SIZE; i++)
+        atomic_init(&logger->queue.slots[i].seq, i);
+    atomic_init(&logger->queue.tail, 0);
+    logger->queue.head = 0;
+    vlc_sem_init(&logger->queue.wait, 0);
+    atomic_init(&logger->queue.stop, false);
+    atomic_init(&logger->queue.dropped, 0);
+    atomic_init(&logger->queue.limited, 0);
+    logger->queue.rate_limit = var_InheritInteger(logger, "log-rate-limit");
+    for (size_t i = 0; i < LOG_RATE_SLOTS; i++)
+        atomic_init(&logger->queue.rate[i], 0);
+
+    if (vlc_clone(&logger->queue.thread, vlc_LogThread, logger,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_sem_destroy(&logger->queue.wait);
+        free(logger->queue.slots);
+        return;
+    }
+    atomic_store_explicit(&logger->queue.running, true, memory_order_release);
+}
+
+/* Delivers the queued messages and stops the logger thread. Messages
+ * emitted from then on are delivered synchronously. */
+static void vlc_LogQueueStop(vlc_logger_t *logger)
+{
+    if (!atomic_load(&logger->queue.running))
+        return;
+
+    atomic_store(&logger->queue.running, false);
+    /* Wait for the emitters that saw the queue running */
+    vlc_mutex_lock(&logger->queue.users_lock);
+    while (atomic_load(&logger->queue.users) > 0)
+        vlc_cond_wait(&logger->queue.users_wait, &logger->queue.users_lock);
+    vlc_mutex_unlock(&logger->queue.users_lock);
+
+    atomic_store(&logger->queue.stop, true);
+    vlc_sem_post(&logger->queue.wait);
+    vlc_join(logger->queue.thread, NULL);
+
+    vlc_sem_destroy(&logger->queue.wait);
+    free(logger->queue.slots);
+}
+
+/* Ends the use of the queue by an emitter. The last one to leave while the
+ * queue is stopping wakes vlc_LogQueueStop() up. */
+static void vlc_LogQueueLeave(vlc_logger_t *logger)
+{
+    if (atomic_fetch_sub(&logger->queue.users, 1) == 1
+     && !atomic_load(&logger->queue.running))
+    {
+        vlc_mutex_lock(&logger->queue.users_lock);
+        vlc_cond_signal(&logger->queue.users_wait);
+        vlc_mutex_unlock(&logger->queue.users_lock);
+    }
+}
+
 /**
  * Emit a log message. This function is the variable argument list equivalent
  * to vlc_Log().
@@ -135,8 +438,25 @@ void vlc_vaLog (vlc_object_t *obj, int type, const char *module,
 #endif
 
     /* Pass message to the callback */
-    if (obj != NULL)
+    if (obj == NULL)
+        return;
+
+    vlc_logger_t *logger = libvlc_priv(obj->p_libvlc)->logger;
+    /* Do not format nor queue messages that the logger would discard */
+    if (type > atomic_load_explicit(&logger->threshold, memory_order_relaxed))
+        return;
+
+    atomic_fetch_add(&logger->queue.users, 1);
+    if (atomic_load(&logger->queue.running))
+    {
+        vlc_vaLogQueue(logger, type, &msg, format, args);
+        vlc_LogQueueLeave(logger);
+    }
+    else
+    {
+        vlc_LogQueueLeave(logger);
         vlc_vaLogCallback(obj->p_libvlc, type, &msg, format, args);
+    }
 }
 
 /**
@@ -329,6 +649,12 @@ int vlc_LogPreinit(libvlc_int_t *vlc)
         return -1;
 
     vlc_rwlock_init(&logger->lock);
+    /* Early messages are kept until the logger is known */
+    atomic_init(&logger->threshold, VLC_MSG_DBG);
+    atomic_init(&logger->queue.running, false);
+    atomic_init(&logger->queue.users, 0);
+    vlc_mutex_init(&logger->queue.users_lock);
+    vlc_cond_init(&logger->queue.users_wait);
 
     if (vlc_LogEarlyOpen(logger))
     {
@@ -358,12 +684,22 @@ int vlc_LogInit(libvlc_int_t *vlc)
 
     vlc_log_cb cb;
     void *sys, *early_sys = NULL;
+    int threshold = -1;
+
+    /* Logger modules that filter messages by type set "verbosity" to the
+     * most verbose type they output, so that the others are not even
+     * formatted */
+    var_Create(logger, "verbosity", VLC_VAR_INTEGER);
+    var_SetInteger(logger, "verbosity", VLC_MSG_DBG);
 
     /* TODO: module configuration item */
     module_t *module = vlc_module_load(logger, "logger", NULL, false,
                                        vlc_logger_load, logger, &cb, &sys);
     if (module == NULL)
         cb = vlc_vaLogDiscard;
+    else
+        threshold = var_GetInteger(logger, "verbosity");
+    var_Destroy(logger, "verbosity");
 
     vlc_rwlock_wrlock(&logger->lock);
     if (logger->log == vlc_vaLogEarly)
@@ -373,14 +709,27 @@ int vlc_LogInit(libvlc_int_t *vlc)
     logger->sys = sys;
     assert(logger->module == NULL); /* Only one call to vlc_LogInit()! */
     logger->module = module;
+    atomic_store(&logger->threshold, threshold);
     vlc_rwlock_unlock(&logger->lock);
 
     if (early_sys != NULL)
         vlc_LogEarlyClose(logger, early_sys);
-
     return 0;
 }
 
+/**
+ * Starts delivering the messages from the logger thread, so that slow
+ * loggers do not block the emitters. Until then, messages are delivered
+ * synchronously. This must be called after forking, if ever.
+ */
+void vlc_LogStart(libvlc_int_t *vlc)
+{
+    vlc_logger_t *logger = libvlc_priv(vlc)->logger;
+
+    if (likely(logger != NULL))
+        vlc_LogQueueStart(logger);
+}
+
 /**
  * Sets the message logging callback.
  * \param cb message callback, or NULL to clear
@@ -406,6 +755,9 @@ void vlc_LogSet(libvlc_int_t *vlc, vlc_log_cb cb, void *opaque)
     logger->log = cb;
     logger->sys = opaque;
     logger->module = NULL;
+    /* The callback filters the messages itself, if at all */
+    atomic_store(&logger->threshold,
+                 (cb != vlc_vaLogDiscard) ? VLC_MSG_DBG : -1);
     vlc_rwlock_unlock(&logger->lock);
 
     if (module != NULL)
@@ -425,6 +777,8 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
     if (unlikely(logger == NULL))
         return;
 
+    vlc_LogQueueStop(logger);
+
     if (logger->module != NULL)
         vlc_module_unload(logger->module, vlc_logger_unload, logger->sys);
     else
@@ -435,6 +789,8 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
         vlc_LogEarlyClose(logger, logger->sys);
     }
 
+    vlc_cond_destroy(&logger->queue.users_wait);
+    vlc_mutex_destroy(&logger->queue.users_lock);
     vlc_rwlock_destroy(&logger->lock);
     vlc_object_release(logger);
     libvlc_priv(vlc)->logger = NULL;
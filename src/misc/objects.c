@@ -102,9 +102,14 @@ void *vlc_custom_create (vlc_object_t *parent, size_t length,
     if (unlikely(priv == NULL))
         return NULL;
     priv->psz_name = NULL;
-    priv->var_root = NULL;
+    atomic_init (&priv->var_table, 0);
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
+    atomic_init (&priv->var_epoch, 0);
+    atomic_init (&priv->var_readers[0], 0);
+    atomic_init (&priv->var_readers[1], 0);
+    priv->var_pending.vars = priv->var_retired.vars = NULL;
+    priv->var_pending.tables = priv->var_retired.tables = NULL;
     atomic_init (&priv->refs, 1);
     priv->pf_destructor = NULL;
     priv->prev = NULL;
@@ -122,6 +122,7 @@ void picture_Reset( picture_t *p_picture )
 {
     /* */
     p_picture->date = VLC_TS_INVALID;
+    p_picture->pts = VLC_TS_INVALID;
     p_picture->b_force = false;
     p_picture->b_progressive = false;
     p_picture->i_nb_fields = 2;
@@ -359,6 +360,7 @@ void plane_CopyPixels( plane_t *p_dst, const plane_t *p_src )
 void picture_CopyProperties( picture_t *p_dst, const picture_t *p_src )
 {
     p_dst->date = p_src->date;
+    p_dst->pts = p_src->pts;
     p_dst->b_force = p_src->b_force;
 
     p_dst->b_progressive = p_src->b_progressive;
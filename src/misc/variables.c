@@ -28,9 +28,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -72,10 +69,13 @@ typedef struct callback_table_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     i_hash;   /**< Hash of the name */
 
     /** The variable's exported value */
     vlc_value_t  val;
+    /** Odd while the value is being written, see ReadValue() */
+    atomic_uint  i_seq;
 
     /** The variable display name, mainly for use by the interfaces */
     char *       psz_text;
@@ -103,6 +103,9 @@ struct variable_t
     callback_table_t    value_callbacks;
     /** Registered list callbacks */
     callback_table_t    list_callbacks;
+
+    /** Next removed variable waiting to be freed, see VarRetire() */
+    struct variable_t  *p_retired;
 };
 
 static int CmpBool( vlc_value_t v, vlc_value_t w )
@@ -143,23 +146,286 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/*
+ * The variables of an object are kept in an open addressing hash table.
+ * The table is only modified with the variable lock held, but can be looked
+ * up without it: removed variables leave a tombstone, and the variables and
+ * tables that are removed are only freed once no lock-free readers can see
+ * them anymore (see VarRetire()).
+ */
+typedef struct var_table_t
+{
+    size_t i_mask;   /**< Number of slots minus one */
+    size_t i_count;  /**< Number of variables */
+    size_t i_filled; /**< Number of variables and tombstones */
+    struct var_table_t *p_retired; /**< Next replaced table, see VarRetire() */
+    atomic_uintptr_t slots[];
+} var_table_t;
+
+#define VAR_DELETED   ((uintptr_t)1)
+#define VAR_TABLE_MIN 16
+
+static uint32_t VarHash( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    uint32_t i_hash = 2166136261u;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    while( *psz_name )
+        i_hash = (i_hash ^ (unsigned char)*psz_name++) * 16777619u;
+    return i_hash;
 }
 
-static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+static var_table_t *VarTable( vlc_object_internals_t *priv )
+{
+    return (var_table_t *)atomic_load_explicit( &priv->var_table,
+                                                memory_order_acquire );
+}
+
+static variable_t *Find( const var_table_t *tab, const char *psz_name,
+                         uint32_t i_hash )
+{
+    if( tab == NULL )
+        return NULL;
+
+    for( size_t i = i_hash & tab->i_mask;; i = (i + 1) & tab->i_mask )
+    {
+        uintptr_t slot = atomic_load_explicit( &tab->slots[i],
+                                               memory_order_acquire );
+        if( slot == 0 )
+            return NULL;
+
+        variable_t *p_var = (variable_t *)slot;
+        if( slot != VAR_DELETED && p_var->i_hash == i_hash
+         && !strcmp( p_var->psz_name, psz_name ) )
+            return p_var;
+    }
+}
+
+/**
+ * Starts a lock-free look-up. The variables and tables seen until
+ * VarReadUnlock() are not freed in the mean time.
+ */
+static unsigned VarReadLock( vlc_object_internals_t *priv )
+{
+    for( ;; )
+    {
+        unsigned epoch = atomic_load( &priv->var_epoch );
+
+        atomic_fetch_add( &priv->var_readers[epoch & 1], 1 );
+        if( likely(atomic_load( &priv->var_epoch ) == epoch) )
+            return epoch;
+        /* Raced with VarReclaim(), which might not have counted us */
+        atomic_fetch_sub( &priv->var_readers[epoch & 1], 1 );
+    }
+}
+
+static void VarReadUnlock( vlc_object_internals_t *priv, unsigned epoch )
+{
+    atomic_fetch_sub_explicit( &priv->var_readers[epoch & 1], 1,
+                               memory_order_release );
+}
+
+static void Destroy( variable_t * );
+
+static void FreeRetired( var_retired_t *p_retired )
+{
+    for( variable_t *p_var = p_retired->vars, *p_next; p_var; p_var = p_next )
+    {
+        p_next = p_var->p_retired;
+        Destroy( p_var );
+    }
+    for( var_table_t *tab = p_retired->tables, *p_next; tab; tab = p_next )
+    {
+        p_next = tab->p_retired;
+        free( tab );
+    }
+    p_retired->vars = NULL;
+    p_retired->tables = NULL;
+}
+
+/**
+ * Frees the removed variables and tables that lock-free readers cannot see
+ * anymore. This never waits: what is still visible is kept for a later call,
+ * or for var_DestroyAll().
+ */
+static void VarReclaim( vlc_object_internals_t *priv )
+{
+    vlc_assert_locked( &priv->var_lock );
+
+    for( ;; )
+    {
+        var_retired_t *p_retired = &priv->var_retired;
+
+        if( p_retired->vars != NULL || p_retired->tables != NULL )
+        {
+            /* They were removed before the last generation change, only the
+             * readers of the previous generation may still see them */
+            unsigned epoch = atomic_load( &priv->var_epoch );
+
+            if( atomic_load( &priv->var_readers[(epoch - 1) & 1] ) != 0 )
+                return;
+            FreeRetired( p_retired );
+        }
+
+        if( priv->var_pending.vars == NULL && priv->var_pending.tables == NULL )
+            return;
+
+        /* New readers cannot see the pending ones: start a new generation,
+         * with at most one generation waiting for its readers */
+        *p_retired = priv->var_pending;
+        priv->var_pending.vars = NULL;
+        priv->var_pending.tables = NULL;
+        atomic_fetch_add( &priv->var_epoch, 1 );
+    }
+}
+
+/**
+ * Frees a variable removed from the table, once no lock-free readers may
+ * still see it.
+ */
+static void VarRetire( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    p_var->p_retired = priv->var_pending.vars;
+    priv->var_pending.vars = p_var;
+    VarReclaim( priv );
+}
+
+static void TableRetire( vlc_object_internals_t *priv, var_table_t *tab )
+{
+    tab->p_retired = priv->var_pending.tables;
+    priv->var_pending.tables = tab;
+    VarReclaim( priv );
+}
+
+static int TableResize( vlc_object_internals_t *priv, size_t i_count )
+{
+    var_table_t *old = VarTable( priv );
+    size_t i_size = VAR_TABLE_MIN;
+
+    while( i_size < 2 * i_count )
+        i_size *= 2;
+
+    var_table_t *tab = malloc( sizeof( *tab )
+                               + i_size * sizeof( tab->slots[0] ) );
+    if( unlikely(tab == NULL) )
+        return VLC_ENOMEM;
+
+    tab->i_mask = i_size - 1;
+    tab->i_count = tab->i_filled = 0;
+    for( size_t i = 0; i < i_size; i++ )
+        atomic_init( &tab->slots[i], 0 );
+
+    if( old != NULL )
+        for( size_t i = 0; i <= old->i_mask; i++ )
+        {
+            uintptr_t slot = atomic_load_explicit( &old->slots[i],
+                                                   memory_order_relaxed );
+            if( slot == 0 || slot == VAR_DELETED )
+                continue;
+
+            size_t j = ((variable_t *)slot)->i_hash & tab->i_mask;
+            while( atomic_load_explicit( &tab->slots[j],
+                                         memory_order_relaxed ) != 0 )
+                j = (j + 1) & tab->i_mask;
+            atomic_init( &tab->slots[j], slot );
+            tab->i_count++;
+        }
+    tab->i_filled = tab->i_count;
+
+    atomic_store_explicit( &priv->var_table, (uintptr_t)tab,
+                           memory_order_release );
+    if( old != NULL )
+        TableRetire( priv, old );
+    return VLC_SUCCESS;
+}
+
+/* Adds a variable not in the table yet */
+static int TableInsert( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    var_table_t *tab = VarTable( priv );
+
+    /* Keep free slots to end the look-ups */
+    if( tab == NULL || (tab->i_filled + 1) * 4 > (tab->i_mask + 1) * 3 )
+    {
+        if( TableResize( priv, (tab != NULL ? tab->i_count : 0) + 1 ) )
+            return VLC_ENOMEM;
+        tab = VarTable( priv );
+    }
+
+    size_t i = p_var->i_hash & tab->i_mask;
+    uintptr_t slot;
+
+    while( (slot = atomic_load_explicit( &tab->slots[i],
+                                         memory_order_relaxed )) != 0
+        && slot != VAR_DELETED )
+        i = (i + 1) & tab->i_mask;
+
+    if( slot == 0 )
+        tab->i_filled++;
+    tab->i_count++;
+    atomic_store_explicit( &tab->slots[i], (uintptr_t)p_var,
+                           memory_order_release );
+    return VLC_SUCCESS;
+}
+
+/* Removes a variable, which is freed once lock-free readers are done */
+static void TableRemove( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    var_table_t *tab = VarTable( priv );
+    size_t i = p_var->i_hash & tab->i_mask;
+
+    while( atomic_load_explicit( &tab->slots[i], memory_order_relaxed )
+           != (uintptr_t)p_var )
+        i = (i + 1) & tab->i_mask;
+
+    atomic_store_explicit( &tab->slots[i], VAR_DELETED,
+                           memory_order_relaxed );
+    tab->i_count--;
+    VarRetire( priv, p_var );
+}
+
+static variable_t *LookupHashed( vlc_object_t *obj, const char *psz_name,
+                                 uint32_t i_hash )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    variable_t **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    return Find( VarTable( priv ), psz_name, i_hash );
+}
+
+static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+{
+    return LookupHashed( obj, psz_name, VarHash( psz_name ) );
+}
+
+/**
+ * Reads the value of a variable, with or without the lock. Only values that
+ * need no duplication can be read without the lock.
+ */
+static void ReadValue( variable_t *var, vlc_value_t *val )
+{
+    unsigned seq;
+
+    do
+    {
+        seq = atomic_load_explicit( &var->i_seq, memory_order_acquire );
+        *val = var->val;
+        atomic_thread_fence( memory_order_acquire );
+    }
+    while( (seq & 1)
+        || atomic_load_explicit( &var->i_seq, memory_order_relaxed ) != seq );
+}
+
+/**
+ * Sets the value of a variable, with the lock held.
+ */
+static void WriteValue( variable_t *var, vlc_value_t val )
+{
+    unsigned seq = atomic_load_explicit( &var->i_seq, memory_order_relaxed );
+
+    atomic_store_explicit( &var->i_seq, seq + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+    var->val = val;
+    atomic_store_explicit( &var->i_seq, seq + 2, memory_order_release );
 }
 
 static void Destroy( variable_t *p_var )
@@ -240,6 +506,15 @@ static void CheckValue(variable_t *var, vlc_value_t *val)
     }
 }
 
+/* Adjusts the current value of a variable to its constraints */
+static void CheckVarValue(variable_t *var)
+{
+    vlc_value_t val = var->val;
+
+    CheckValue(var, &val);
+    WriteValue(var, val);
+}
+
 /**
  * Waits until the variable is inactive (i.e. not executing a callback)
  */
@@ -307,9 +582,9 @@ static void TriggerListCallback(vlc_object_t *obj, variable_t *var,
 /**
  * Initialize a vlc variable
  *
- * We hash the given string and insert it into the sorted list. The insertion
- * may require slow memory copies, but think about what we gain in the log(n)
- * lookup phase when setting/getting the variable value!
+ * We hash the given string and insert the variable into the hash table of
+ * the object, so that it can be found in constant time when setting or
+ * getting its value.
  *
  * \param p_this The object in which to create the variable
  * \param psz_name The name of the variable
@@ -325,7 +600,9 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = VarHash( psz_name );
     p_var->psz_text = NULL;
+    atomic_init( &p_var->i_seq, 0 );
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
 
@@ -394,16 +671,18 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
     }
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    variable_t **pp_var, *p_oldvar;
+    variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = Find( VarTable( p_priv ), p_var->psz_name, p_var->i_hash );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = TableInsert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -421,8 +700,8 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 /**
  * Destroy a vlc variable
  *
- * Look for the variable and destroy it if it is found. As in var_Create we
- * do a call to memmove() but we have performance counterparts elsewhere.
+ * Look for the variable and destroy it if it is found. It is freed once no
+ * threads read variables of the object without locking, if any.
  *
  * \param p_this The object that holds the variable
  * \param psz_name The name of the variable
@@ -445,26 +724,31 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     WaitUnused( p_this, p_var );
 
     if( --p_var->i_usage == 0 )
-        tdelete( p_var, &p_priv->var_root, varcmp );
-    else
-        p_var = NULL;
+        TableRemove( p_priv, p_var );
     vlc_mutex_unlock( &p_priv->var_lock );
-
-    if( p_var != NULL )
-        Destroy( p_var );
-}
-
-static void CleanupVar( void *var )
-{
-    Destroy( var );
 }
 
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
+    var_table_t *tab = VarTable( priv );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    /* There are no readers left */
+    FreeRetired( &priv->var_pending );
+    FreeRetired( &priv->var_retired );
+
+    if( tab == NULL )
+        return;
+
+    for( size_t i = 0; i <= tab->i_mask; i++ )
+    {
+        uintptr_t slot = atomic_load_explicit( &tab->slots[i],
+                                               memory_order_relaxed );
+        if( slot != 0 && slot != VAR_DELETED )
+            Destroy( (variable_t *)slot );
+    }
+    free( tab );
+    atomic_store_explicit( &priv->var_table, 0, memory_order_relaxed );
 }
 
 #undef var_Change
@@ -506,7 +790,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             p_var->i_type |= VLC_VAR_HASMIN;
             p_var->min = *p_val;
             p_var->ops->pf_dup( &p_var->min );
-            CheckValue( p_var, &p_var->val );
+            CheckVarValue( p_var );
             break;
         case VLC_VAR_GETMIN:
             if( p_var->i_type & VLC_VAR_HASMIN )
@@ -522,7 +806,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             p_var->i_type |= VLC_VAR_HASMAX;
             p_var->max = *p_val;
             p_var->ops->pf_dup( &p_var->max );
-            CheckValue( p_var, &p_var->val );
+            CheckVarValue( p_var );
             break;
         case VLC_VAR_GETMAX:
             if( p_var->i_type & VLC_VAR_HASMAX )
@@ -538,7 +822,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             p_var->i_type |= VLC_VAR_HASSTEP;
             p_var->step = *p_val;
             p_var->ops->pf_dup( &p_var->step );
-            CheckValue( p_var, &p_var->val );
+            CheckVarValue( p_var );
             break;
         case VLC_VAR_GETSTEP:
             if( p_var->i_type & VLC_VAR_HASSTEP )
@@ -559,7 +843,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
                 ( p_val2 && p_val2->psz_string ) ?
                 strdup( p_val2->psz_string ) : NULL;
 
-            CheckValue( p_var, &p_var->val );
+            CheckVarValue( p_var );
 
             TriggerListCallback(p_this, p_var, psz_name, VLC_VAR_ADDCHOICE, p_val);
             break;
@@ -590,7 +874,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             REMOVE_ELEM( p_var->choices_text.p_values,
                          p_var->choices_text.i_count, i );
 
-            CheckValue( p_var, &p_var->val );
+            CheckVarValue( p_var );
 
             TriggerListCallback(p_this, p_var, psz_name, VLC_VAR_DELCHOICE, p_val);
             break;
@@ -627,7 +911,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
                 break;
 
             p_var->i_default = i;
-            CheckValue( p_var, &p_var->val );
+            CheckVarValue( p_var );
             break;
         }
         case VLC_VAR_SETVALUE:
@@ -639,7 +923,7 @@ int var_Change( vlc_object_t *p_this, const char *psz_name,
             /* Check boundaries and list */
             CheckValue( p_var, &newval );
             /* Set the variable */
-            p_var->val = newval;
+            WriteValue( p_var, newval );
             /* Free data if needed */
             p_var->ops->pf_free( &oldval );
             break;
@@ -725,24 +1009,26 @@ int var_GetAndSet( vlc_object_t *p_this, const char *psz_name, int i_action,
     /* Backup needed stuff */
     oldval = p_var->val;
 
+    vlc_value_t newval = oldval;
+
     /* depending of the action requiered */
     switch( i_action )
     {
     case VLC_VAR_BOOL_TOGGLE:
         assert( ( p_var->i_type & VLC_VAR_BOOL ) == VLC_VAR_BOOL );
-        p_var->val.b_bool = !p_var->val.b_bool;
+        newval.b_bool = !newval.b_bool;
         break;
     case VLC_VAR_INTEGER_ADD:
         assert( ( p_var->i_type & VLC_VAR_INTEGER ) == VLC_VAR_INTEGER );
-        p_var->val.i_int += p_val->i_int;
+        newval.i_int += p_val->i_int;
         break;
     case VLC_VAR_INTEGER_OR:
         assert( ( p_var->i_type & VLC_VAR_INTEGER ) == VLC_VAR_INTEGER );
-        p_var->val.i_int |= p_val->i_int;
+        newval.i_int |= p_val->i_int;
         break;
     case VLC_VAR_INTEGER_NAND:
         assert( ( p_var->i_type & VLC_VAR_INTEGER ) == VLC_VAR_INTEGER );
-        p_var->val.i_int &= ~p_val->i_int;
+        newval.i_int &= ~p_val->i_int;
         break;
     default:
         vlc_mutex_unlock( &p_priv->var_lock );
@@ -750,8 +1036,9 @@ int var_GetAndSet( vlc_object_t *p_this, const char *psz_name, int i_action,
     }
 
     /*  Check boundaries */
-    CheckValue( p_var, &p_var->val );
-    *p_val = p_var->val;
+    CheckValue( p_var, &newval );
+    WriteValue( p_var, newval );
+    *p_val = newval;
 
     /* Deal with callbacks.*/
     TriggerCallback( p_this, p_var, psz_name, oldval );
@@ -823,7 +1110,7 @@ int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
     CheckValue( p_var, &val );
 
     /* Set the variable */
-    p_var->val = val;
+    WriteValue( p_var, val );
 
     /* Deal with callbacks */
     TriggerCallback( p_this, p_var, psz_name, oldval );
@@ -848,17 +1135,39 @@ int var_Set( vlc_object_t *p_this, const char *psz_name, vlc_value_t val )
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
-#undef var_GetChecked
-int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
-                    int expected_type, vlc_value_t *p_val )
+/**
+ * Gets the value of a variable whose name hash is known. Values which need
+ * no duplication are read without taking the variable lock.
+ */
+static int GetHashed( vlc_object_t *p_this, const char *psz_name,
+                      uint32_t i_hash, int expected_type, vlc_value_t *p_val )
 {
-    assert( p_this );
-
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
     variable_t *p_var;
     int err = VLC_SUCCESS;
 
-    p_var = Lookup( p_this, psz_name );
+    unsigned epoch = VarReadLock( p_priv );
+    p_var = Find( VarTable( p_priv ), psz_name, i_hash );
+    if( p_var == NULL )
+        err = VLC_ENOVAR;
+    else if( p_var->ops->pf_dup == DupDummy )
+    {
+        assert( expected_type == 0 ||
+                (p_var->i_type & VLC_VAR_CLASS) == expected_type );
+        assert( p_var->ops != &void_ops );
+        ReadValue( p_var, p_val );
+    }
+    else
+        err = VLC_EGENERIC;
+    VarReadUnlock( p_priv, epoch );
+
+    if( err != VLC_EGENERIC )
+        return err;
+
+    /* Strings are duplicated with the lock held, and the variable may have
+     * been replaced since, look it up again */
+    err = VLC_SUCCESS;
+    p_var = LookupHashed( p_this, psz_name, i_hash );
     if( p_var != NULL )
     {
         assert( expected_type == 0 ||
@@ -878,6 +1187,16 @@ int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
     return err;
 }
 
+#undef var_GetChecked
+int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
+                    int expected_type, vlc_value_t *p_val )
+{
+    assert( p_this );
+
+    return GetHashed( p_this, psz_name, VarHash( psz_name ), expected_type,
+                      p_val );
+}
+
 #undef var_Get
 /**
  * Get a variable's value
@@ -1253,10 +1572,12 @@ int var_LocationParse (vlc_object_t *obj, const char *mrl, const char *pref)
 int var_Inherit( vlc_object_t *p_this, const char *psz_name, int i_type,
                  vlc_value_t *p_val )
 {
+    uint32_t i_hash = VarHash( psz_name );
+
     i_type &= VLC_VAR_CLASS;
     for( vlc_object_t *obj = p_this; obj != NULL; obj = obj->p_parent )
     {
-        if( var_GetChecked( obj, psz_name, i_type, p_val ) == VLC_SUCCESS )
+        if( GetHashed( obj, psz_name, i_hash, i_type, p_val ) == VLC_SUCCESS )
             return VLC_SUCCESS;
     }
 
@@ -1379,13 +1700,16 @@ void var_FreeList( vlc_value_t *p_val, vlc_value_t *p_val2 )
     }
 }
 
-static void DumpVariable(const void *data, const VISIT which, const int depth)
+static int DumpCompare(const void *a, const void *b)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
+    const variable_t *va = *(const variable_t **)a;
+    const variable_t *vb = *(const variable_t **)b;
+
+    return strcmp(va->psz_name, vb->psz_name);
+}
 
-    const variable_t *var = *(const variable_t **)data;
+static void DumpVariable(const variable_t *var)
+{
     const char *typename = "unknown";
 
     switch (var->i_type & VLC_VAR_TYPE)
@@ -1440,10 +1764,29 @@ static void DumpVariable(const void *data, const VISIT which, const int depth)
 
 void DumpVariables(vlc_object_t *obj)
 {
-    vlc_mutex_lock(&vlc_internals(obj)->var_lock);
-    if (vlc_internals(obj)->var_root == NULL)
+    vlc_object_internals_t *priv = vlc_internals(obj);
+
+    vlc_mutex_lock(&priv->var_lock);
+    var_table_t *tab = VarTable(priv);
+    if (tab == NULL || tab->i_count == 0)
         puts(" `-o No variables");
     else
-        twalk(vlc_internals(obj)->var_root, DumpVariable);
-    vlc_mutex_unlock(&vlc_internals(obj)->var_lock);
+    {
+        /* List them in the alphabetical order */
+        const variable_t *vars[tab->i_count];
+        size_t n = 0;
+
+        for (size_t i = 0; i <= tab->i_mask; i++)
+        {
+            uintptr_t slot = atomic_load_explicit(&tab->slots[i],
+                                                  memory_order_relaxed);
+            if (slot != 0 && slot != VAR_DELETED)
+                vars[n++] = (const variable_t *)slot;
+        }
+        assert(n == tab->i_count);
+        qsort(vars, n, sizeof (vars[0]), DumpCompare);
+        for (size_t i = 0; i < n; i++)
+            DumpVariable(vars[i]);
+    }
+    vlc_mutex_unlock(&priv->var_lock);
 }
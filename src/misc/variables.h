@@ -30,14 +30,28 @@
  */
 typedef struct vlc_object_internals vlc_object_internals_t;
 
+/**
+ * Variables and tables removed from an object, and not freed yet as
+ * lock-free readers may still see them.
+ */
+typedef struct var_retired
+{
+    struct variable_t  *vars;
+    struct var_table_t *tables;
+} var_retired_t;
+
 struct vlc_object_internals
 {
     char           *psz_name; /* given name */
 
     /* Object variables */
-    void           *var_root;
+    atomic_uintptr_t var_table; /* hash table, see variables.c */
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
+    atomic_uint     var_epoch; /* lock-free readers generation */
+    atomic_uint     var_readers[2]; /* lock-free readers, by generation */
+    var_retired_t   var_pending; /* removed in the current generation */
+    var_retired_t   var_retired; /* removed in the previous generation */
 
     /* Objects management */
     atomic_uint     refs;
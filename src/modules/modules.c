@@ -169,15 +169,25 @@ static bool module_match_name (const module_t *m, const char *name)
      return false;
 }
 
+/* Time spent in the modules that declined */
+struct module_rejects
+{
+    unsigned count;
+    mtime_t total;
+    mtime_t slowest;
+    const module_t *slowest_module;
+};
+
 static int module_load (vlc_object_t *obj, module_t *m,
-                        vlc_activate_t init, va_list args)
+                        vlc_activate_t init, va_list args,
+                        struct module_rejects *rejects)
 {
     int ret = VLC_SUCCESS;
+    mtime_t start = mdate ();
 
     if (module_Map (obj, m))
-        return VLC_EGENERIC;
-
-    if (m->pf_activate != NULL)
+        ret = VLC_EGENERIC;
+    else if (m->pf_activate != NULL)
     {
         va_list ap;
 
@@ -185,6 +195,21 @@ static int module_load (vlc_object_t *obj, module_t *m,
         ret = init (m->pf_activate, ap);
         va_end (ap);
     }
+
+    if (ret != VLC_SUCCESS)
+    {
+        mtime_t duration = mdate () - start;
+
+        msg_Dbg (obj, "%s module \"%s\" declined in %"PRId64" us",
+                 m->psz_capability, module_get_object (m), duration);
+        rejects->count++;
+        rejects->total += duration;
+        if (rejects->slowest_module == NULL || duration > rejects->slowest)
+        {
+            rejects->slowest = duration;
+            rejects->slowest_module = m;
+        }
+    }
     return ret;
 }
 
@@ -240,6 +265,7 @@ module_t *vlc_module_load(vlc_object_t *obj, const char *capability,
 
     module_t *module = NULL;
     const bool b_force_backup = obj->b_force; /* FIXME: remove this */
+    struct module_rejects rejects = { 0, 0, 0, NULL };
     va_list args;
 
     va_start(args, probe);
@@ -274,7 +300,7 @@ module_t *vlc_module_load(vlc_object_t *obj, const char *capability,
                 continue;
             mods[i] = NULL; // only try each module once at most...
 
-            int ret = module_load (obj, cand, probe, args);
+            int ret = module_load (obj, cand, probe, args, &rejects);
             switch (ret)
             {
                 case VLC_SUCCESS:
@@ -296,7 +322,7 @@ module_t *vlc_module_load(vlc_object_t *obj, const char *capability,
             if (cand == NULL || module_get_score (cand) <= 0)
                 continue;
 
-            int ret = module_load (obj, cand, probe, args);
+            int ret = module_load (obj, cand, probe, args, &rejects);
             switch (ret)
             {
                 case VLC_SUCCESS:
@@ -310,6 +336,13 @@ module_t *vlc_module_load(vlc_object_t *obj, const char *capability,
 done:
     va_end (args);
     obj->b_force = b_force_backup;
+
+    if (rejects.count > 0)
+        msg_Dbg (obj, "%u %s modules declined in %"PRId64" us, "
+                 "slowest \"%s\" in %"PRId64" us", rejects.count, capability,
+                 rejects.total, module_get_object (rejects.slowest_module),
+                 rejects.slowest);
+
     module_list_free (mods);
     free (var);
 
@@ -221,7 +221,12 @@ playlist_t *playlist_Create( vlc_object_t *p_parent )
     pl_priv(p_playlist)->p_input = NULL;
 
     ARRAY_INIT( p_playlist->items );
-    ARRAY_INIT( p_playlist->all_items );
+    ARRAY_INIT( pl_priv(p_playlist)->all_items );
+    p->input_index.pp_buckets = NULL;
+    p->input_index.i_mask = 0;
+    p->input_index.i_count = 0;
+    p->i_all_items_deleted = 0;
+    playlist_LiveSearchInit( p_playlist );
     ARRAY_INIT( pl_priv(p_playlist)->items_to_delete );
     ARRAY_INIT( p_playlist->current );
 
@@ -347,13 +352,19 @@ void playlist_Destroy( playlist_t *p_playlist )
     vlc_mutex_destroy( &p_sys->lock );
 
     /* Remove all remaining items */
-    FOREACH_ARRAY( playlist_item_t *p_del, p_playlist->all_items )
+    FOREACH_ARRAY( playlist_item_t *p_del, p_sys->all_items )
+        if( pl_item_priv( p_del )->b_deleted )
+            continue; /* also in items_to_delete */
+        free( pl_item_priv( p_del )->psz_search );
         free( p_del->pp_children );
         vlc_gc_decref( p_del->p_input );
         free( p_del );
     FOREACH_END();
-    ARRAY_RESET( p_playlist->all_items );
+    ARRAY_RESET( p_sys->all_items );
+    playlist_InputIndexClean( p_playlist );
+    playlist_LiveSearchDestroy( p_playlist );
     FOREACH_ARRAY( playlist_item_t *p_del, p_sys->items_to_delete )
+        free( pl_item_priv( p_del )->psz_search );
         free( p_del->pp_children );
         vlc_gc_decref( p_del->p_input );
         free( p_del );
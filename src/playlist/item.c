@@ -196,6 +196,13 @@ static void input_item_changed( const vlc_event_t * p_event,
     var_SetAddress( p_item->p_playlist, "item-change", p_item->p_input );
 }
 
+static void input_item_meta_changed( const vlc_event_t * p_event,
+                                     void * user_data )
+{
+    playlist_LiveSearchStale( user_data );
+    input_item_changed( p_event, user_data );
+}
+
 /*****************************************************************************
  * Listen to vlc_InputItemAddSubItem event
  *****************************************************************************/
@@ -207,9 +214,9 @@ static void install_input_item_observer( playlist_item_t * p_item )
     vlc_event_attach( p_em, vlc_InputItemDurationChanged,
                       input_item_changed, p_item );
     vlc_event_attach( p_em, vlc_InputItemMetaChanged,
-                      input_item_changed, p_item );
+                      input_item_meta_changed, p_item );
     vlc_event_attach( p_em, vlc_InputItemNameChanged,
-                      input_item_changed, p_item );
+                      input_item_meta_changed, p_item );
     vlc_event_attach( p_em, vlc_InputItemInfoChanged,
                       input_item_changed, p_item );
     vlc_event_attach( p_em, vlc_InputItemErrorWhenReadingChanged,
@@ -222,11 +229,11 @@ static void uninstall_input_item_observer( playlist_item_t * p_item )
     vlc_event_detach( p_em, vlc_InputItemSubItemTreeAdded,
                       input_item_add_subitem_tree, p_item );
     vlc_event_detach( p_em, vlc_InputItemMetaChanged,
-                      input_item_changed, p_item );
+                      input_item_meta_changed, p_item );
     vlc_event_detach( p_em, vlc_InputItemDurationChanged,
                       input_item_changed, p_item );
     vlc_event_detach( p_em, vlc_InputItemNameChanged,
-                      input_item_changed, p_item );
+                      input_item_meta_changed, p_item );
     vlc_event_detach( p_em, vlc_InputItemInfoChanged,
                       input_item_changed, p_item );
     vlc_event_detach( p_em, vlc_InputItemErrorWhenReadingChanged,
@@ -239,10 +246,12 @@ static void uninstall_input_item_observer( playlist_item_t * p_item )
 playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
                                               input_item_t *p_input )
 {
-    playlist_item_t* p_item = malloc( sizeof( playlist_item_t ) );
-    if( !p_item )
+    playlist_item_private_t *p_priv = malloc( sizeof( *p_priv ) );
+    if( !p_priv )
         return NULL;
 
+    playlist_item_t *p_item = &p_priv->item;
+
     assert( p_input );
 
     p_item->p_input = p_input;
@@ -256,6 +265,15 @@ playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
     p_item->i_nb_played = 0;
     p_item->i_flags = 0;
     p_item->p_playlist = p_playlist;
+    p_priv->i_children_max = 0;
+    p_priv->i_index = 0;
+    p_priv->b_deleted = false;
+    p_priv->p_input_next = NULL;
+    p_priv->psz_search = NULL;
+    p_priv->i_search_trigrams = 0;
+    p_priv->i_search_match = 0;
+    atomic_init( &p_priv->b_search_stale, false );
+    playlist_LiveSearchStale( p_item );
 
     install_input_item_observer( p_item );
 
@@ -587,47 +605,6 @@ int playlist_InsertInputItemTree (
  * Playlist item misc operations
  *****************************************************************************/
 
-/**
- * Find an item within a root, given its input id.
- *
- * \param p_playlist the playlist object
- * \param p_item the input item
- * \param p_root root playlist item
- * \param b_items_only TRUE if we want the item himself
- * \return the first found item, or NULL if not found
- */
-playlist_item_t *playlist_ItemFindFromInputAndRoot( playlist_t *p_playlist,
-                                                    input_item_t *p_item,
-                                                    playlist_item_t *p_root,
-                                                    bool b_items_only )
-{
-    int i;
-    for( i = 0 ; i< p_root->i_children ; i++ )
-    {
-        if( ( b_items_only ? p_root->pp_children[i]->i_children == -1 : 1 ) &&
-            p_root->pp_children[i]->p_input == p_item )
-        {
-            return p_root->pp_children[i];
-        }
-        else if( p_root->pp_children[i]->i_children >= 0 )
-        {
-            playlist_item_t *p_search =
-                 playlist_ItemFindFromInputAndRoot( p_playlist, p_item,
-                                                    p_root->pp_children[i],
-                                                    b_items_only );
-            if( p_search ) return p_search;
-        }
-    }
-    return NULL;
-}
-
-
-static int ItemIndex ( playlist_item_t *p_item )
-{
-    for( int i = 0; i < p_item->p_parent->i_children; i++ )
-        if( p_item->p_parent->pp_children[i] == p_item ) return i;
-    return -1;
-}
 
 /**
  * Moves an item
@@ -648,15 +625,14 @@ int playlist_TreeMove( playlist_t * p_playlist, playlist_item_t *p_item,
     if( p_node->i_children == -1 ) return VLC_EGENERIC;
 
     playlist_item_t *p_detach = p_item->p_parent;
-    int i_index = ItemIndex( p_item );
+    int i_index = playlist_ItemIndex( p_item );
 
-    REMOVE_ELEM( p_detach->pp_children, p_detach->i_children, i_index );
+    playlist_NodeRemoveItem( p_playlist, p_item, p_detach );
 
     if( p_detach == p_node && i_index < i_newpos )
         i_newpos--;
 
-    INSERT_ELEM( p_node->pp_children, p_node->i_children, i_newpos, p_item );
-    p_item->p_parent = p_node;
+    playlist_NodeInsert( p_playlist, p_item, p_node, i_newpos );
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
@@ -687,17 +663,13 @@ int playlist_TreeMoveMany( playlist_t *p_playlist,
     for( i = 0; i < i_items; i++ )
     {
         playlist_item_t *p_item = pp_items[i];
-        int i_index = ItemIndex( p_item );
+        int i_index = playlist_ItemIndex( p_item );
         playlist_item_t *p_parent = p_item->p_parent;
-        REMOVE_ELEM( p_parent->pp_children, p_parent->i_children, i_index );
+        playlist_NodeRemoveItem( p_playlist, p_item, p_parent );
         if ( p_parent == p_node && i_index < i_newpos ) i_newpos--;
     }
     for( i = i_items - 1; i >= 0; i-- )
-    {
-        playlist_item_t *p_item = pp_items[i];
-        INSERT_ELEM( p_node->pp_children, p_node->i_children, i_newpos, p_item );
-        p_item->p_parent = p_node;
-    }
+        playlist_NodeInsert( p_playlist, pp_items[i], p_node, i_newpos );
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
@@ -792,7 +764,8 @@ static void AddItem( playlist_t *p_playlist, playlist_item_t *p_item,
 {
     PL_ASSERT_LOCKED;
     ARRAY_APPEND(p_playlist->items, p_item);
-    ARRAY_APPEND(p_playlist->all_items, p_item);
+    ARRAY_APPEND(pl_priv(p_playlist)->all_items, p_item);
+    playlist_InputIndexAdd( p_playlist, p_item );
 
     if( i_pos == PLAYLIST_END )
         playlist_NodeAppend( p_playlist, p_item, p_node );
@@ -36,12 +36,31 @@
 
 #include "input/input_interface.h"
 #include <assert.h>
+#include <vlc_atomic.h>
 
 #include "art.h"
 #include "preparser.h"
 
 typedef struct vlc_sd_internal_t vlc_sd_internal_t;
 
+typedef struct playlist_item_private_t playlist_item_private_t;
+
+struct playlist_item_private_t
+{
+    playlist_item_t item;
+    int  i_children_max;    /**< Allocated size of pp_children */
+    int  i_index;           /**< Last known position in the parent node */
+    bool b_deleted;         /**< Left in all_items until its compaction */
+    playlist_item_private_t *p_input_next; /**< Next in the input index */
+
+    char    *psz_search;        /**< Folded live search fields, or NULL */
+    unsigned i_search_trigrams; /**< Entries in the trigram index */
+    unsigned i_search_match;    /**< Last live search it matched */
+    atomic_bool b_search_stale; /**< Meta changed since it was indexed */
+};
+
+#define pl_item_priv( it ) ((playlist_item_private_t *)(it))
+
 void playlist_ServicesDiscoveryKillAll( playlist_t *p_playlist );
 
 typedef struct playlist_private_t
@@ -83,6 +102,30 @@ typedef struct playlist_private_t
     vlc_cond_t signal; /**< wakes up the playlist engine thread */
     bool     killed; /**< playlist is shutting down */
 
+    /* Items and nodes sorted by id. Deleted ones are only flagged, and
+     * left in the array until it is compacted. */
+    playlist_item_array_t all_items;
+
+    struct {
+        playlist_item_private_t **pp_buckets;
+        unsigned i_mask;
+        unsigned i_count;
+    } input_index; /**< Items and nodes of all_items by input item */
+    int      i_all_items_deleted; /**< Deleted entries left in all_items */
+
+    struct {
+        struct playlist_trigram_t *p_table; /**< Posting lists by trigram */
+        unsigned i_mask;
+        unsigned i_used;
+        size_t   i_postings; /**< Entries in all the posting lists */
+        size_t   i_garbage;  /**< Entries of removed or reindexed items */
+        bool     b_complete; /**< Every indexed item is in the lists */
+        atomic_bool b_stale; /**< Some item has to be (re)indexed */
+        unsigned i_generation; /**< Live search counter */
+        char    *psz_last;   /**< Last folded query */
+        playlist_item_array_t last_matches; /**< Items that matched it */
+    } search; /**< Live search index, built by the first live search */
+
     int      i_last_playlist_id; /**< Last id to an item */
     bool     b_reset_currently_playing; /** Reset current item array */
 
@@ -127,7 +170,20 @@ playlist_item_t * playlist_NodeAddInput( playlist_t *, input_item_t *,
 int playlist_InsertInputItemTree ( playlist_t *,
         playlist_item_t *, input_item_node_t *, int, bool );
 
+/* Input item index */
+void playlist_InputIndexAdd( playlist_t *, playlist_item_t * );
+void playlist_InputIndexRemove( playlist_t *, playlist_item_t * );
+void playlist_InputIndexClean( playlist_t * );
+
+/* Live search index */
+void playlist_LiveSearchInit( playlist_t * );
+void playlist_LiveSearchStale( playlist_item_t * );
+void playlist_LiveSearchRemove( playlist_t *, playlist_item_t * );
+void playlist_LiveSearchDestroy( playlist_t * );
+char *playlist_CaseFold( char *, const char *, bool * );
+
 /* Tree walking */
+int playlist_ItemIndex( playlist_item_t * );
 playlist_item_t *playlist_ItemFindFromInputAndRoot( playlist_t *p_playlist,
                                 input_item_t *p_input, playlist_item_t *p_root,
                                 bool );
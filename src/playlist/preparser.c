@@ -26,6 +26,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_interrupt.h>
 
 #include "fetcher.h"
 #include "preparser.h"
@@ -40,6 +41,24 @@ struct preparser_entry_t
 {
     input_item_t    *p_item;
     input_item_meta_request_option_t i_options;
+    preparser_entry_t *p_next;
+};
+
+typedef struct
+{
+    preparser_entry_t  *p_first;
+    preparser_entry_t **pp_last;
+} preparser_queue_t;
+
+typedef struct preparser_worker_t preparser_worker_t;
+
+struct preparser_worker_t
+{
+    playlist_preparser_t *p_preparser;
+    vlc_timer_t      timer;
+    vlc_interrupt_t *p_interrupt; /* of the current item, if any */
+    mtime_t          i_deadline;  /* of the current item */
+    bool             b_timeout;
 };
 
 struct playlist_preparser_t
@@ -49,13 +68,64 @@ struct playlist_preparser_t
 
     vlc_mutex_t     lock;
     vlc_cond_t      wait;
-    bool            b_live;
-    preparser_entry_t  **pp_waiting;
-    int             i_waiting;
+    bool            b_closing;
+    /* Network items are queued separately, so that a slow share does not
+     * hold back local files */
+    preparser_queue_t local;
+    preparser_queue_t network;
+    unsigned        i_waiting;
+
+    unsigned        i_max_threads;
+    unsigned        i_max_network; /* workers allowed on network items */
+    unsigned        i_network;     /* workers on network items */
+    mtime_t         i_timeout;
+    int             i_workers;     /* workers still taking items */
+    preparser_worker_t **pp_workers;
+    unsigned        i_live;        /* threads, including exiting ones */
+
+    /* Statistics */
+    uint64_t        i_done;
+    uint64_t        i_timeouts;
+    mtime_t         i_busy;
 };
 
 static void *Thread( void * );
 
+static void QueueInit( preparser_queue_t *p_queue )
+{
+    p_queue->p_first = NULL;
+    p_queue->pp_last = &p_queue->p_first;
+}
+
+static void QueuePush( preparser_queue_t *p_queue, preparser_entry_t *p_entry )
+{
+    p_entry->p_next = NULL;
+    *p_queue->pp_last = p_entry;
+    p_queue->pp_last = &p_entry->p_next;
+}
+
+static preparser_entry_t *QueuePop( preparser_queue_t *p_queue )
+{
+    preparser_entry_t *p_entry = p_queue->p_first;
+    if( p_entry != NULL )
+    {
+        p_queue->p_first = p_entry->p_next;
+        if( p_queue->p_first == NULL )
+            p_queue->pp_last = &p_queue->p_first;
+    }
+    return p_entry;
+}
+
+static void QueueClear( preparser_queue_t *p_queue )
+{
+    preparser_entry_t *p_entry;
+    while( (p_entry = QueuePop( p_queue )) != NULL )
+    {
+        vlc_gc_decref( p_entry->p_item );
+        free( p_entry );
+    }
+}
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -72,9 +142,23 @@ playlist_preparser_t *playlist_preparser_New( vlc_object_t *parent )
 
     vlc_mutex_init( &p_preparser->lock );
     vlc_cond_init( &p_preparser->wait );
-    p_preparser->b_live = false;
+    p_preparser->b_closing = false;
+    QueueInit( &p_preparser->local );
+    QueueInit( &p_preparser->network );
     p_preparser->i_waiting = 0;
-    p_preparser->pp_waiting = NULL;
+
+    int i_threads = var_InheritInteger( parent, "preparse-threads" );
+    p_preparser->i_max_threads = VLC_CLIP( i_threads, 1, 32 );
+    p_preparser->i_max_network = __MAX( p_preparser->i_max_threads - 1, 1 );
+    p_preparser->i_network = 0;
+    p_preparser->i_timeout =
+        __MAX( var_InheritInteger( parent, "preparse-timeout" ), 0 ) * 1000;
+    TAB_INIT( p_preparser->i_workers, p_preparser->pp_workers );
+    p_preparser->i_live = 0;
+
+    p_preparser->i_done = 0;
+    p_preparser->i_timeouts = 0;
+    p_preparser->i_busy = 0;
 
     return p_preparser;
 }
@@ -90,16 +174,37 @@ void playlist_preparser_Push( playlist_preparser_t *p_preparser, input_item_t *p
     p_entry->i_options = i_options;
     vlc_gc_incref( p_entry->p_item );
 
+    vlc_mutex_lock( &p_item->lock );
+    bool b_net = p_item->b_net;
+    vlc_mutex_unlock( &p_item->lock );
+
     vlc_mutex_lock( &p_preparser->lock );
-    INSERT_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting,
-                 p_preparser->i_waiting, p_entry );
-    if( !p_preparser->b_live )
+    QueuePush( b_net ? &p_preparser->network : &p_preparser->local, p_entry );
+    p_preparser->i_waiting++;
+
+    /* Workers exit when there is nothing left for them, spawn one more as
+     * long as the limit is not reached */
+    if( (unsigned)p_preparser->i_workers < p_preparser->i_max_threads )
     {
-        if( vlc_clone_detach( NULL, Thread, p_preparser,
-                              VLC_THREAD_PRIORITY_LOW ) )
-            msg_Warn( p_preparser->object, "cannot spawn pre-parser thread" );
-        else
-            p_preparser->b_live = true;
+        preparser_worker_t *p_worker = malloc( sizeof(*p_worker) );
+        if( p_worker != NULL )
+        {
+            p_worker->p_preparser = p_preparser;
+            p_worker->p_interrupt = NULL;
+            p_worker->b_timeout = false;
+            TAB_APPEND( p_preparser->i_workers, p_preparser->pp_workers,
+                        p_worker );
+            if( vlc_clone_detach( NULL, Thread, p_worker,
+                                  VLC_THREAD_PRIORITY_LOW ) )
+            {
+                msg_Warn( p_preparser->object, "cannot spawn pre-parser thread" );
+                TAB_REMOVE( p_preparser->i_workers, p_preparser->pp_workers,
+                            p_worker );
+                free( p_worker );
+            }
+            else
+                p_preparser->i_live++;
+        }
     }
     vlc_mutex_unlock( &p_preparser->lock );
 }
@@ -111,23 +216,40 @@ void playlist_preparser_fetcher_Push( playlist_preparser_t *p_preparser,
         playlist_fetcher_Push( p_preparser->p_fetcher, p_item, i_options );
 }
 
+void playlist_preparser_GetStats( playlist_preparser_t *p_preparser,
+                                  input_preparser_stats_t *p_stats )
+{
+    vlc_mutex_lock( &p_preparser->lock );
+    p_stats->i_waiting = p_preparser->i_waiting;
+    p_stats->i_running = 0;
+    for( int i = 0; i < p_preparser->i_workers; i++ )
+        if( p_preparser->pp_workers[i]->p_interrupt != NULL )
+            p_stats->i_running++;
+    p_stats->i_done = p_preparser->i_done;
+    p_stats->i_timeouts = p_preparser->i_timeouts;
+    p_stats->i_busy = p_preparser->i_busy;
+    vlc_mutex_unlock( &p_preparser->lock );
+}
+
 void playlist_preparser_Delete( playlist_preparser_t *p_preparser )
 {
     vlc_mutex_lock( &p_preparser->lock );
-    /* Remove pending item to speed up preparser thread exit */
-    while( p_preparser->i_waiting > 0 )
-    {
-        preparser_entry_t *p_entry = p_preparser->pp_waiting[0];
-        vlc_gc_decref( p_entry->p_item );
-        free( p_entry );
-        REMOVE_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting, 0 );
-    }
+    /* Remove pending items and abort the current ones to speed up the
+     * preparser threads exit */
+    p_preparser->b_closing = true;
+    QueueClear( &p_preparser->local );
+    QueueClear( &p_preparser->network );
+    p_preparser->i_waiting = 0;
+    for( int i = 0; i < p_preparser->i_workers; i++ )
+        if( p_preparser->pp_workers[i]->p_interrupt != NULL )
+            vlc_interrupt_kill( p_preparser->pp_workers[i]->p_interrupt );
 
-    while( p_preparser->b_live )
+    while( p_preparser->i_live > 0 )
         vlc_cond_wait( &p_preparser->wait, &p_preparser->lock );
     vlc_mutex_unlock( &p_preparser->lock );
 
     /* Destroy the item preparser */
+    TAB_CLEAN( p_preparser->i_workers, p_preparser->pp_workers );
     vlc_cond_destroy( &p_preparser->wait );
     vlc_mutex_destroy( &p_preparser->lock );
 
@@ -171,7 +293,9 @@ static void Preparse( vlc_object_t *obj, input_item_t *p_item,
     if( !input_item_IsPreparsed( p_item ) )
     {
         input_Preparse( obj, p_item );
-        input_item_SetPreparsed( p_item, true );
+        /* An aborted item (timed out or closing) may be preparsed again */
+        if( !vlc_killed() )
+            input_item_SetPreparsed( p_item, true );
 
         var_SetAddress( obj, "item-change", p_item );
     }
@@ -219,45 +343,133 @@ static void Art( playlist_preparser_t *p_preparser, input_item_t *p_item )
         playlist_fetcher_Push( p_fetcher, p_item, 0 );
 }
 
+/**
+ * Aborts the item of a worker that exceeded its deadline
+ */
+static void Timeout( void *data )
+{
+    preparser_worker_t *p_worker = data;
+    playlist_preparser_t *p_preparser = p_worker->p_preparser;
+
+    /* Disarming the timer does not wait for a callback already running:
+     * this one may be late for a previous item of the worker */
+    vlc_mutex_lock( &p_preparser->lock );
+    if( p_worker->p_interrupt != NULL && mdate() >= p_worker->i_deadline )
+    {
+        p_worker->b_timeout = true;
+        vlc_interrupt_kill( p_worker->p_interrupt );
+    }
+    vlc_mutex_unlock( &p_preparser->lock );
+}
+
+/**
+ * Takes the next item for a worker, local ones first.
+ * Must be called with the lock held.
+ */
+static preparser_entry_t *Dequeue( playlist_preparser_t *p_preparser,
+                                   bool *pb_net )
+{
+    preparser_entry_t *p_entry = QueuePop( &p_preparser->local );
+    *pb_net = false;
+
+    if( p_entry == NULL &&
+        p_preparser->i_network < p_preparser->i_max_network )
+    {
+        p_entry = QueuePop( &p_preparser->network );
+        *pb_net = p_entry != NULL;
+    }
+    if( p_entry != NULL )
+        p_preparser->i_waiting--;
+    return p_entry;
+}
+
 /**
  * This function does the preparsing and issues the art fetching requests
  */
 static void *Thread( void *data )
 {
-    playlist_preparser_t *p_preparser = data;
+    preparser_worker_t *p_worker = data;
+    playlist_preparser_t *p_preparser = p_worker->p_preparser;
     vlc_object_t *obj = p_preparser->object;
 
+    bool b_timer = p_preparser->i_timeout > 0 &&
+                   !vlc_timer_create( &p_worker->timer, Timeout, p_worker );
+
+    vlc_mutex_lock( &p_preparser->lock );
     for( ;; )
     {
-        input_item_t *p_current;
-        input_item_meta_request_option_t i_options;
+        bool b_net;
+        preparser_entry_t *p_entry = Dequeue( p_preparser, &b_net );
+        if( p_entry == NULL )
+            break;
 
-        /* */
-        vlc_mutex_lock( &p_preparser->lock );
-        if( p_preparser->i_waiting > 0 )
-        {
-            preparser_entry_t *p_entry = p_preparser->pp_waiting[0];
-            p_current = p_entry->p_item;
-            i_options = p_entry->i_options;
-            free( p_entry );
-            REMOVE_ELEM( p_preparser->pp_waiting, p_preparser->i_waiting, 0 );
-        }
-        else
-        {
-            p_current = NULL;
-            p_preparser->b_live = false;
-            vlc_cond_signal( &p_preparser->wait );
-        }
+        /* Each item gets its own interruption context, as a killed context
+         * cannot be reused */
+        vlc_interrupt_t *p_interrupt = vlc_interrupt_create();
+        mtime_t i_start = mdate();
+        p_worker->p_interrupt = p_interrupt;
+        p_worker->i_deadline = i_start + p_preparser->i_timeout;
+        p_worker->b_timeout = false;
+        if( b_net )
+            p_preparser->i_network++;
+        if( p_preparser->b_closing && p_interrupt != NULL )
+            vlc_interrupt_kill( p_interrupt );
         vlc_mutex_unlock( &p_preparser->lock );
 
-        if( !p_current )
-            break;
+        input_item_t *p_current = p_entry->p_item;
+        input_item_meta_request_option_t i_options = p_entry->i_options;
+        free( p_entry );
+
+        vlc_interrupt_t *p_old = vlc_interrupt_set( p_interrupt );
+        if( b_timer )
+            vlc_timer_schedule( p_worker->timer, true,
+                                p_worker->i_deadline, 0 );
 
         Preparse( obj, p_current, i_options );
 
+        if( b_timer )
+            vlc_timer_schedule( p_worker->timer, false, 0, 0 );
+        vlc_interrupt_set( p_old );
+        mtime_t i_duration = mdate() - i_start;
+
+        vlc_mutex_lock( &p_preparser->lock );
+        p_worker->p_interrupt = NULL;
+        bool b_timeout = p_worker->b_timeout;
+        if( b_net )
+            p_preparser->i_network--;
+        p_preparser->i_done++;
+        p_preparser->i_busy += i_duration;
+        if( b_timeout )
+            p_preparser->i_timeouts++;
+        vlc_mutex_unlock( &p_preparser->lock );
+
+        if( p_interrupt != NULL )
+            vlc_interrupt_destroy( p_interrupt );
+        if( b_timeout )
+        {
+            char *psz_uri = input_item_GetURI( p_current );
+            msg_Warn( obj, "preparsing %s timed out after %"PRId64" ms",
+                      psz_uri ? psz_uri : "(null)", i_duration / 1000 );
+            free( psz_uri );
+        }
+
         Art( p_preparser, p_current );
         vlc_gc_decref(p_current);
+
+        vlc_mutex_lock( &p_preparser->lock );
     }
+
+    /* Leave room for a new worker right away, items may be pushed while
+     * the timer is destroyed; its callback takes the lock */
+    TAB_REMOVE( p_preparser->i_workers, p_preparser->pp_workers, p_worker );
+    vlc_mutex_unlock( &p_preparser->lock );
+    if( b_timer )
+        vlc_timer_destroy( p_worker->timer );
+    free( p_worker );
+
+    vlc_mutex_lock( &p_preparser->lock );
+    p_preparser->i_live--;
+    vlc_cond_signal( &p_preparser->wait );
+    vlc_mutex_unlock( &p_preparser->lock );
     return NULL;
 }
-
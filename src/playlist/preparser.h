@@ -36,7 +36,12 @@
 typedef struct playlist_preparser_t playlist_preparser_t;
 
 /**
- * This function creates the preparser object and thread.
+ * This function creates the preparser object.
+ *
+ * Items are preparsed by up to "preparse-threads" threads, started on
+ * demand. Network items are queued separately from local ones, and are not
+ * given all the threads. Preparsing an item is aborted after
+ * "preparse-timeout" milliseconds.
  */
 playlist_preparser_t *playlist_preparser_New( vlc_object_t * );
 
@@ -55,9 +60,16 @@ void playlist_preparser_fetcher_Push( playlist_preparser_t *, input_item_t *,
                                       input_item_meta_request_option_t );
 
 /**
- * This function destroys the preparser object and thread.
+ * This function returns the preparser progress counters.
+ */
+void playlist_preparser_GetStats( playlist_preparser_t *,
+                                  input_preparser_stats_t * );
+
+/**
+ * This function destroys the preparser object and threads.
  *
- * All pending input items will be released.
+ * All pending input items will be released, and the ones being preparsed
+ * will be aborted.
  */
 void playlist_preparser_Delete( playlist_preparser_t * );
 
@@ -28,6 +28,8 @@
 #include <vlc_common.h>
 #include <vlc_playlist.h>
 #include <vlc_charset.h>
+#include <wctype.h>
+#include "../libvlc.h"
 #include "playlist_internal.h"
 
 /***************************************************************************
@@ -43,15 +45,117 @@
  */
 playlist_item_t* playlist_ItemGetById( playlist_t * p_playlist , int i_id )
 {
+    playlist_private_t *p_sys = pl_priv( p_playlist );
     int i;
     PL_ASSERT_LOCKED;
-    ARRAY_BSEARCH( p_playlist->all_items,->i_id, int, i_id, i );
-    if( i != -1 )
-        return ARRAY_VAL( p_playlist->all_items, i );
+    ARRAY_BSEARCH( p_sys->all_items,->i_id, int, i_id, i );
+    if( i != -1 && !pl_item_priv( ARRAY_VAL( p_sys->all_items, i ) )->b_deleted )
+        return ARRAY_VAL( p_sys->all_items, i );
     else
         return NULL;
 }
 
+/***************************************************************************
+ * Input item index
+ ***************************************************************************
+ * Hash table of the items and nodes of all_items, by input item. Several
+ * playlist items can share an input item, they are then in the same chain.
+ ***************************************************************************/
+
+static unsigned InputIndexHash( const input_item_t *p_input, unsigned i_mask )
+{
+    uint64_t i_hash = (uintptr_t)p_input;
+    return ((i_hash >> 4) * UINT64_C(0x9E3779B97F4A7C15) >> 32) & i_mask;
+}
+
+static void InputIndexResize( playlist_private_t *p_sys, unsigned i_size )
+{
+    playlist_item_private_t **pp_buckets =
+        calloc( i_size, sizeof(*pp_buckets) );
+    if( unlikely(pp_buckets == NULL) )
+        return; /* keep the current table, only the lookups are slower */
+
+    for( unsigned i = 0; i <= p_sys->input_index.i_mask &&
+                         p_sys->input_index.pp_buckets != NULL; i++ )
+    {
+        playlist_item_private_t *p_entry = p_sys->input_index.pp_buckets[i];
+        while( p_entry != NULL )
+        {
+            playlist_item_private_t *p_next = p_entry->p_input_next;
+            unsigned i_bucket = InputIndexHash( p_entry->item.p_input,
+                                                i_size - 1 );
+            p_entry->p_input_next = pp_buckets[i_bucket];
+            pp_buckets[i_bucket] = p_entry;
+            p_entry = p_next;
+        }
+    }
+    free( p_sys->input_index.pp_buckets );
+    p_sys->input_index.pp_buckets = pp_buckets;
+    p_sys->input_index.i_mask = i_size - 1;
+}
+
+/**
+ * Adds an item or node to the input item index.
+ * Must be called when it is added to all_items, with the playlist lock.
+ */
+void playlist_InputIndexAdd( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+    PL_ASSERT_LOCKED;
+
+    if( p_sys->input_index.pp_buckets == NULL ||
+        p_sys->input_index.i_count > p_sys->input_index.i_mask )
+        InputIndexResize( p_sys, p_sys->input_index.pp_buckets == NULL ? 256 :
+                                 2 * (p_sys->input_index.i_mask + 1) );
+    if( unlikely(p_sys->input_index.pp_buckets == NULL) )
+        abort();
+
+    unsigned i_bucket = InputIndexHash( p_item->p_input,
+                                        p_sys->input_index.i_mask );
+    playlist_item_private_t *p_entry = pl_item_priv( p_item );
+    p_entry->p_input_next = p_sys->input_index.pp_buckets[i_bucket];
+    p_sys->input_index.pp_buckets[i_bucket] = p_entry;
+    p_sys->input_index.i_count++;
+}
+
+/**
+ * Removes an item or node from the input item index.
+ * Must be called when it is removed from all_items, with the playlist lock.
+ */
+void playlist_InputIndexRemove( playlist_t *p_playlist,
+                                playlist_item_t *p_item )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+    PL_ASSERT_LOCKED;
+
+    if( p_sys->input_index.pp_buckets == NULL )
+        return;
+
+    unsigned i_bucket = InputIndexHash( p_item->p_input,
+                                        p_sys->input_index.i_mask );
+    for( playlist_item_private_t **pp_entry =
+             &p_sys->input_index.pp_buckets[i_bucket];
+         *pp_entry != NULL; pp_entry = &(*pp_entry)->p_input_next )
+    {
+        if( &(*pp_entry)->item == p_item )
+        {
+            *pp_entry = pl_item_priv( p_item )->p_input_next;
+            p_sys->input_index.i_count--;
+            return;
+        }
+    }
+}
+
+void playlist_InputIndexClean( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+
+    free( p_sys->input_index.pp_buckets );
+    p_sys->input_index.pp_buckets = NULL;
+    p_sys->input_index.i_mask = 0;
+    p_sys->input_index.i_count = 0;
+}
+
 /**
  * Search an item by its input_item_t
  * The playlist have to be locked
@@ -62,22 +166,515 @@ playlist_item_t* playlist_ItemGetById( playlist_t * p_playlist , int i_id )
 playlist_item_t* playlist_ItemGetByInput( playlist_t * p_playlist,
                                           input_item_t *p_item )
 {
-    int i;
+    playlist_private_t *p_sys = pl_priv( p_playlist );
     PL_ASSERT_LOCKED;
     if( get_current_status_item( p_playlist ) &&
         get_current_status_item( p_playlist )->p_input == p_item )
     {
         return get_current_status_item( p_playlist );
     }
-    /** \todo Check if this is always incremental and whether we can bsearch */
-    for( i =  0 ; i < p_playlist->all_items.i_size; i++ )
+    if( p_sys->input_index.pp_buckets == NULL )
+        return NULL;
+
+    /* The oldest one, as the first one of all_items */
+    playlist_item_t *p_found = NULL;
+    unsigned i_bucket = InputIndexHash( p_item, p_sys->input_index.i_mask );
+    for( playlist_item_private_t *p_entry =
+             p_sys->input_index.pp_buckets[i_bucket];
+         p_entry != NULL; p_entry = p_entry->p_input_next )
+    {
+        if( p_entry->item.p_input == p_item &&
+            ( p_found == NULL || p_entry->item.i_id < p_found->i_id ) )
+            p_found = &p_entry->item;
+    }
+    return p_found;
+}
+
+/**
+ * Find an item within a root, given its input item.
+ * The playlist have to be locked
+ *
+ * \param p_playlist the playlist object
+ * \param p_item the input item
+ * \param p_root root playlist item
+ * \param b_items_only TRUE if we want the item himself
+ * \return the oldest matching item, or NULL if not found
+ */
+playlist_item_t *playlist_ItemFindFromInputAndRoot( playlist_t *p_playlist,
+                                                    input_item_t *p_item,
+                                                    playlist_item_t *p_root,
+                                                    bool b_items_only )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+    PL_ASSERT_LOCKED;
+
+    if( p_sys->input_index.pp_buckets == NULL )
+        return NULL;
+
+    playlist_item_t *p_found = NULL;
+    unsigned i_bucket = InputIndexHash( p_item, p_sys->input_index.i_mask );
+    for( playlist_item_private_t *p_entry =
+             p_sys->input_index.pp_buckets[i_bucket];
+         p_entry != NULL; p_entry = p_entry->p_input_next )
+    {
+        playlist_item_t *p_cand = &p_entry->item;
+        if( p_cand->p_input != p_item ||
+            ( b_items_only && p_cand->i_children != -1 ) ||
+            ( p_found != NULL && p_cand->i_id > p_found->i_id ) )
+            continue;
+
+        /* Check that it is below the root */
+        for( playlist_item_t *p_up = p_cand->p_parent; p_up != NULL;
+             p_up = p_up->p_parent )
+        {
+            if( p_up == p_root )
+            {
+                p_found = p_cand;
+                break;
+            }
+        }
+    }
+    return p_found;
+}
+
+
+/***************************************************************************
+ * Live search index
+ ***************************************************************************
+ * The searched fields of each item are cached lower-cased, and every three
+ * bytes sequence of them points to the items containing it. A query is then
+ * only compared with the items of its rarest trigram, or with the items that
+ * matched the previous query when it was refined. Items are (re)indexed by
+ * the next live search after they were added or their meta changed.
+ ***************************************************************************/
+
+struct playlist_trigram_t
+{
+    uint32_t i_key;  /**< Three bytes, 0 for an empty slot */
+    unsigned i_count;
+    unsigned i_size;
+    playlist_item_t **pp_items;
+};
+
+void playlist_LiveSearchInit( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+
+    p_sys->search.p_table = NULL;
+    p_sys->search.i_mask = 0;
+    p_sys->search.i_used = 0;
+    p_sys->search.i_postings = 0;
+    p_sys->search.i_garbage = 0;
+    p_sys->search.b_complete = true;
+    atomic_init( &p_sys->search.b_stale, false );
+    p_sys->search.i_generation = 0;
+    p_sys->search.psz_last = NULL;
+    ARRAY_INIT( p_sys->search.last_matches );
+}
+
+static void TrigramsClear( playlist_private_t *p_sys )
+{
+    for( unsigned i = 0; i <= p_sys->search.i_mask &&
+                         p_sys->search.p_table != NULL; i++ )
+        free( p_sys->search.p_table[i].pp_items );
+    free( p_sys->search.p_table );
+    p_sys->search.p_table = NULL;
+    p_sys->search.i_mask = 0;
+    p_sys->search.i_used = 0;
+    p_sys->search.i_postings = 0;
+    p_sys->search.i_garbage = 0;
+}
+
+void playlist_LiveSearchDestroy( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+
+    TrigramsClear( p_sys );
+    free( p_sys->search.psz_last );
+    p_sys->search.psz_last = NULL;
+    ARRAY_RESET( p_sys->search.last_matches );
+}
+
+/**
+ * Flags an item to be indexed again by the next live search.
+ * Can be called from any thread.
+ */
+void playlist_LiveSearchStale( playlist_item_t *p_item )
+{
+    atomic_store( &pl_item_priv( p_item )->b_search_stale, true );
+    atomic_store( &pl_priv( p_item->p_playlist )->search.b_stale, true );
+}
+
+/**
+ * Drops an item from the live search index.
+ * Must be called when it is removed from all_items, with the playlist lock.
+ */
+void playlist_LiveSearchRemove( playlist_t *p_playlist,
+                                playlist_item_t *p_item )
+{
+    playlist_item_private_t *p_priv = pl_item_priv( p_item );
+    PL_ASSERT_LOCKED;
+
+    /* Its posting list entries are skipped until the next rebuild */
+    pl_priv( p_playlist )->search.i_garbage += p_priv->i_search_trigrams;
+    p_priv->i_search_trigrams = 0;
+    free( p_priv->psz_search );
+    p_priv->psz_search = NULL;
+}
+
+/* Appends the code point, UTF-8 encoded */
+static char *PutChar( char *p, uint32_t cp )
+{
+    if( cp < 0x80 )
+        *p++ = cp;
+    else if( cp < 0x800 )
+    {
+        *p++ = 0xC0 | (cp >> 6);
+        *p++ = 0x80 | (cp & 0x3F);
+    }
+    else if( cp < 0x10000 )
+    {
+        *p++ = 0xE0 | (cp >> 12);
+        *p++ = 0x80 | ((cp >> 6) & 0x3F);
+        *p++ = 0x80 | (cp & 0x3F);
+    }
+    else
+    {
+        *p++ = 0xF0 | (cp >> 18);
+        *p++ = 0x80 | ((cp >> 12) & 0x3F);
+        *p++ = 0x80 | ((cp >> 6) & 0x3F);
+        *p++ = 0x80 | (cp & 0x3F);
+    }
+    return p;
+}
+
+/**
+ * Lower-cases a string the way vlc_strcasestr() compares it, so that a plain
+ * strstr() on folded strings gives the same result. Invalid sequences become
+ * 0xFF bytes, which never appear in a valid string.
+ * The output needs twice the length of the input, plus one.
+ * \return the end of the output string
+ */
+char *playlist_CaseFold( char *p_out, const char *psz, bool *pb_valid )
+{
+    for( ;; )
+    {
+        uint32_t cp;
+        size_t i_len = vlc_towc( psz, &cp );
+        if( i_len == 0 )
+            break;
+        if( unlikely(i_len == (size_t)-1) )
+        {
+            *p_out++ = '\xFF';
+            *pb_valid = false;
+            psz++;
+            continue;
+        }
+        p_out = PutChar( p_out, towlower( cp ) );
+        psz += i_len;
+    }
+    *p_out = '\0';
+    return p_out;
+}
+
+/**
+ * Returns the folded title (or name), album and artist of an input item,
+ * each terminated by a nul byte, then an empty string.
+ */
+static char *SearchText( input_item_t *p_input )
+{
+    const char *ppsz_fields[3] = { NULL, NULL, NULL };
+
+    vlc_mutex_lock( &p_input->lock );
+    if( p_input->p_meta )
     {
-        if( ARRAY_VAL(p_playlist->all_items, i)->p_input == p_item )
+        ppsz_fields[0] = vlc_meta_Get( p_input->p_meta, vlc_meta_Title );
+        if( !ppsz_fields[0] )
+            ppsz_fields[0] = p_input->psz_name;
+        ppsz_fields[1] = vlc_meta_Get( p_input->p_meta, vlc_meta_Album );
+        ppsz_fields[2] = vlc_meta_Get( p_input->p_meta, vlc_meta_Artist );
+    }
+    else
+        ppsz_fields[0] = p_input->psz_name;
+
+    size_t i_size = 1;
+    for( unsigned i = 0; i < 3; i++ )
+        if( ppsz_fields[i] )
+            i_size += 2 * strlen( ppsz_fields[i] ) + 1;
+
+    char *psz_text = malloc( i_size ), *p = psz_text;
+    if( likely(psz_text != NULL) )
+    {
+        for( unsigned i = 0; i < 3; i++ )
         {
-            return ARRAY_VAL(p_playlist->all_items, i);
+            bool b_valid = true;
+            if( ppsz_fields[i] && *ppsz_fields[i] )
+                p = playlist_CaseFold( p, ppsz_fields[i], &b_valid ) + 1;
         }
+        *p++ = '\0';
+    }
+    vlc_mutex_unlock( &p_input->lock );
+
+    if( likely(psz_text != NULL) )
+    {
+        char *psz_shrunk = realloc( psz_text, p - psz_text );
+        if( likely(psz_shrunk != NULL) )
+            psz_text = psz_shrunk;
     }
-    return NULL;
+    return psz_text;
+}
+
+static uint32_t TrigramKey( const char *p )
+{
+    return ((uint8_t)p[0] << 16) | ((uint8_t)p[1] << 8) | (uint8_t)p[2];
+}
+
+static struct playlist_trigram_t *TrigramSlot(
+        struct playlist_trigram_t *p_table, unsigned i_mask, uint32_t i_key )
+{
+    unsigned i = (i_key * 0x9E3779B1u >> 8) & i_mask;
+    while( p_table[i].i_key != 0 && p_table[i].i_key != i_key )
+        i = (i + 1) & i_mask;
+    return &p_table[i];
+}
+
+static struct playlist_trigram_t *TrigramFind( playlist_private_t *p_sys,
+                                               uint32_t i_key )
+{
+    if( p_sys->search.p_table == NULL )
+        return NULL;
+    struct playlist_trigram_t *p_slot =
+        TrigramSlot( p_sys->search.p_table, p_sys->search.i_mask, i_key );
+    return p_slot->i_key != 0 ? p_slot : NULL;
+}
+
+static int TrigramsResize( playlist_private_t *p_sys, unsigned i_size )
+{
+    struct playlist_trigram_t *p_table = calloc( i_size, sizeof(*p_table) );
+    if( unlikely(p_table == NULL) )
+        return VLC_ENOMEM;
+
+    for( unsigned i = 0; i <= p_sys->search.i_mask &&
+                         p_sys->search.p_table != NULL; i++ )
+        if( p_sys->search.p_table[i].i_key != 0 )
+            *TrigramSlot( p_table, i_size - 1,
+                          p_sys->search.p_table[i].i_key ) =
+                p_sys->search.p_table[i];
+    free( p_sys->search.p_table );
+    p_sys->search.p_table = p_table;
+    p_sys->search.i_mask = i_size - 1;
+    return VLC_SUCCESS;
+}
+
+/* Adds an item to the posting list of each trigram of its cached fields */
+static int TrigramsAdd( playlist_private_t *p_sys, playlist_item_t *p_item )
+{
+    playlist_item_private_t *p_priv = pl_item_priv( p_item );
+
+    for( const char *psz = p_priv->psz_search; *psz; psz += strlen( psz ) + 1 )
+    {
+        for( const char *p = psz; p[0] && p[1] && p[2]; p++ )
+        {
+            if( ( p_sys->search.i_used + 1 ) * 2 > p_sys->search.i_mask + 1 &&
+                TrigramsResize( p_sys, p_sys->search.p_table == NULL ? 4096 :
+                                2 * (p_sys->search.i_mask + 1) ) )
+                return VLC_ENOMEM;
+
+            uint32_t i_key = TrigramKey( p );
+            struct playlist_trigram_t *p_slot =
+                TrigramSlot( p_sys->search.p_table, p_sys->search.i_mask,
+                             i_key );
+            if( p_slot->i_key == 0 )
+            {
+                p_slot->i_key = i_key;
+                p_sys->search.i_used++;
+            }
+            /* Items are indexed one at a time: a repeated trigram of the
+             * same item is at the end of the list */
+            else if( p_slot->pp_items[p_slot->i_count - 1] == p_item )
+                continue;
+
+            if( p_slot->i_count == p_slot->i_size )
+            {
+                unsigned i_size = p_slot->i_size ? 2 * p_slot->i_size : 4;
+                playlist_item_t **pp_items =
+                    realloc( p_slot->pp_items, i_size * sizeof(*pp_items) );
+                if( unlikely(pp_items == NULL) )
+                    return VLC_ENOMEM;
+                p_slot->pp_items = pp_items;
+                p_slot->i_size = i_size;
+            }
+            p_slot->pp_items[p_slot->i_count++] = p_item;
+            p_priv->i_search_trigrams++;
+            p_sys->search.i_postings++;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+/* Rebuilds the posting lists from the cached fields, without the entries of
+ * removed and reindexed items. Searches scan all the items if it fails. */
+static void TrigramsRebuild( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+
+    TrigramsClear( p_sys );
+    p_sys->search.b_complete = false;
+    FOREACH_ARRAY( playlist_item_t *p_item, p_sys->all_items )
+        pl_item_priv( p_item )->i_search_trigrams = 0;
+    FOREACH_END();
+    FOREACH_ARRAY( playlist_item_t *p_item, p_sys->all_items )
+        if( pl_item_priv( p_item )->psz_search != NULL &&
+            TrigramsAdd( p_sys, p_item ) )
+        {
+            TrigramsClear( p_sys );
+            return;
+        }
+    FOREACH_END();
+    p_sys->search.b_complete = true;
+}
+
+/**
+ * Indexes the items added or changed since the last live search.
+ * \return true if the fields of some item changed
+ */
+static bool LiveSearchRefresh( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+    bool b_changed = false;
+
+    if( !atomic_exchange( &p_sys->search.b_stale, false ) )
+        return false;
+
+    FOREACH_ARRAY( playlist_item_t *p_item, p_sys->all_items )
+        playlist_item_private_t *p_priv = pl_item_priv( p_item );
+        if( p_priv->b_deleted ||
+            !atomic_exchange( &p_priv->b_search_stale, false ) )
+            continue;
+
+        char *psz_text = SearchText( p_item->p_input );
+        if( unlikely(psz_text == NULL) )
+        {
+            playlist_LiveSearchStale( p_item );
+            continue;
+        }
+
+        if( p_priv->psz_search != NULL )
+        {
+            const char *a = p_priv->psz_search, *b = psz_text;
+            while( *a && !strcmp( a, b ) )
+            {
+                a += strlen( a ) + 1;
+                b += strlen( b ) + 1;
+            }
+            if( !*a && !*b )
+            {   /* Other meta changed */
+                free( psz_text );
+                continue;
+            }
+        }
+
+        b_changed = true;
+        p_sys->search.i_garbage += p_priv->i_search_trigrams;
+        p_priv->i_search_trigrams = 0;
+        free( p_priv->psz_search );
+        p_priv->psz_search = psz_text;
+        if( p_sys->search.b_complete && TrigramsAdd( p_sys, p_item ) )
+            p_sys->search.b_complete = false;
+    FOREACH_END();
+
+    if( !p_sys->search.b_complete ||
+        p_sys->search.i_garbage > 4096 + p_sys->search.i_postings / 2 )
+        TrigramsRebuild( p_playlist );
+    return b_changed;
+}
+
+static bool LiveSearchMatch( const char *psz_text, const char *psz_query )
+{
+    for( ; *psz_text; psz_text += strlen( psz_text ) + 1 )
+        if( strstr( psz_text, psz_query ) )
+            return true;
+    return false;
+}
+
+/**
+ * Marks the items matching the query with a new search generation.
+ * \return the generation
+ */
+static unsigned LiveSearchFind( playlist_t *p_playlist, const char *psz_string )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+
+    if( ++p_sys->search.i_generation == 0 )
+    {   /* Wrapped around, forget the old marks */
+        FOREACH_ARRAY( playlist_item_t *p_item, p_sys->all_items )
+            pl_item_priv( p_item )->i_search_match = 0;
+        FOREACH_END();
+        p_sys->search.i_generation = 1;
+    }
+    const unsigned i_gen = p_sys->search.i_generation;
+
+    bool b_changed = LiveSearchRefresh( p_playlist );
+
+    bool b_valid = true;
+    char *psz_query = malloc( 2 * strlen( psz_string ) + 1 );
+    if( unlikely(psz_query == NULL) )
+        return i_gen;
+    playlist_CaseFold( psz_query, psz_string, &b_valid );
+    if( !b_valid )
+    {   /* vlc_strcasestr() never matches an invalid query */
+        free( psz_query );
+        return i_gen;
+    }
+
+    /* Pick the smallest set of candidates */
+    playlist_item_t **pp_cands = p_sys->all_items.p_elems;
+    size_t i_cands = p_sys->all_items.i_size;
+
+    if( !b_changed && p_sys->search.psz_last != NULL &&
+        strstr( psz_query, p_sys->search.psz_last ) )
+    {   /* Refined query: only the previous matches can still match */
+        pp_cands = p_sys->search.last_matches.p_elems;
+        i_cands = p_sys->search.last_matches.i_size;
+    }
+    else if( p_sys->search.b_complete && strlen( psz_query ) >= 3 )
+    {
+        for( const char *p = psz_query; p[2]; p++ )
+        {
+            struct playlist_trigram_t *p_slot =
+                TrigramFind( p_sys, TrigramKey( p ) );
+            if( p_slot == NULL )
+            {
+                i_cands = 0;
+                break;
+            }
+            if( p_slot->i_count < i_cands )
+            {
+                pp_cands = p_slot->pp_items;
+                i_cands = p_slot->i_count;
+            }
+        }
+    }
+
+    playlist_item_array_t matches;
+    ARRAY_INIT( matches );
+    for( size_t i = 0; i < i_cands; i++ )
+    {
+        playlist_item_t *p_item = pp_cands[i];
+        playlist_item_private_t *p_priv = pl_item_priv( p_item );
+        if( p_priv->b_deleted || p_priv->psz_search == NULL ||
+            p_priv->i_search_match == i_gen ||
+            !LiveSearchMatch( p_priv->psz_search, psz_query ) )
+            continue;
+        p_priv->i_search_match = i_gen;
+        ARRAY_APPEND( matches, p_item );
+    }
+
+    ARRAY_RESET( p_sys->search.last_matches );
+    p_sys->search.last_matches = matches;
+    free( p_sys->search.psz_last );
+    p_sys->search.psz_last = psz_query;
+    return i_gen;
 }
 
 
@@ -102,13 +699,13 @@ static void playlist_LiveSearchClean( playlist_item_t *p_root )
 
 
 /**
- * Enable/Disable items in the playlist according to the search argument
+ * Enable/Disable items in the playlist according to the search result
  * @param p_root: the current root item
- * @param psz_string: the string to search
+ * @param i_gen: the generation of the matching items
  * @return true if an item match
  */
 static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
-                                               const char *psz_string, bool b_recursive )
+                                               unsigned i_gen, bool b_recursive )
 {
     int i;
     bool b_match = false;
@@ -118,31 +715,13 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
         playlist_item_t *p_item = p_root->pp_children[i];
         // Go recurssively if their is some children
         if( b_recursive && p_item->i_children >= 0 &&
-            playlist_LiveSearchUpdateInternal( p_item, psz_string, true ) )
+            playlist_LiveSearchUpdateInternal( p_item, i_gen, true ) )
         {
             b_enable = true;
         }
 
         if( !b_enable )
-        {
-            vlc_mutex_lock( &p_item->p_input->lock );
-            // Do we have some meta ?
-            if( p_item->p_input->p_meta )
-            {
-                // Use Title or fall back to psz_name
-                const char *psz_title = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Title );
-                if( !psz_title )
-                    psz_title = p_item->p_input->psz_name;
-                const char *psz_album = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Album );
-                const char *psz_artist = vlc_meta_Get( p_item->p_input->p_meta, vlc_meta_Artist );
-                b_enable = ( psz_title && vlc_strcasestr( psz_title, psz_string ) ) ||
-                           ( psz_album && vlc_strcasestr( psz_album, psz_string ) ) ||
-                           ( psz_artist && vlc_strcasestr( psz_artist, psz_string ) );
-            }
-            else
-                b_enable = p_item->p_input->psz_name && vlc_strcasestr( p_item->p_input->psz_name, psz_string );
-            vlc_mutex_unlock( &p_item->p_input->lock );
-        }
+            b_enable = pl_item_priv( p_item )->i_search_match == i_gen;
 
         if( b_enable )
             p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
@@ -169,10 +748,11 @@ int playlist_LiveSearchUpdate( playlist_t *p_playlist, playlist_item_t *p_root,
     PL_ASSERT_LOCKED;
     pl_priv(p_playlist)->b_reset_currently_playing = true;
     if( *psz_string )
-        playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
+        playlist_LiveSearchUpdateInternal( p_root,
+                                           LiveSearchFind( p_playlist, psz_string ),
+                                           b_recursive );
     else
         playlist_LiveSearchClean( p_root );
     vlc_cond_signal( &pl_priv(p_playlist)->signal );
     return VLC_SUCCESS;
 }
-
@@ -33,77 +33,217 @@
 #include "playlist_internal.h"
 
 
+/* Sort keys */
+
+/* Nodes with more children are sorted by several threads */
+#define SORT_PARALLEL_MIN 8192
+
+/**
+ * A field of an item as it is compared: the collation key of a text, or a
+ * number.
+ */
+typedef struct
+{
+    bool    b_set;  /**< false if the item lacks it */
+    char   *psz;    /**< Collation key, NULL for numbers */
+    int64_t i;
+} sort_field_t;
+
+/**
+ * Everything a sort compares about an item, read once before sorting
+ * rather than at each comparison.
+ */
+typedef struct
+{
+    playlist_item_t *p_item;
+    sort_field_t     title;     /**< Title, or name */
+    sort_field_t     fields[3]; /**< Compared in order, for meta sorts */
+} sort_key_t;
+
+/**
+ * Returns a string that compares with strcmp() like the given one would
+ * case insensitively and in the collation order of the locale.
+ */
+static char *SortCollationKey( const char *psz )
+{
+    bool b_valid = true;
+    char *psz_folded = malloc( 2 * strlen( psz ) + 1 );
+    if( unlikely(psz_folded == NULL) )
+        return NULL;
+    playlist_CaseFold( psz_folded, psz, &b_valid );
+#ifdef _WIN32
+    /* The C run-time does not collate UTF-8, code points order it is */
+    return psz_folded;
+#else
+    size_t i_len = strxfrm( NULL, psz_folded, 0 );
+    char *psz_key = malloc( i_len + 1 );
+    if( likely(psz_key != NULL) )
+        strxfrm( psz_key, psz_folded, i_len + 1 );
+    free( psz_folded );
+    return psz_key;
+#endif
+}
+
+static void SortFieldText( sort_field_t *p_field, const char *psz )
+{
+    p_field->b_set = false;
+    p_field->psz = NULL;
+    p_field->i = 0;
+    if( psz != NULL )
+    {
+        p_field->psz = SortCollationKey( psz );
+        p_field->b_set = p_field->psz != NULL;
+    }
+}
+
+static void SortFieldNumber( sort_field_t *p_field, const char *psz )
+{
+    p_field->b_set = psz != NULL;
+    p_field->psz = NULL;
+    p_field->i = psz != NULL ? atoi( psz ) : 0;
+}
+
+/**
+ * Reads the fields of an item compared by a sort mode, with a single lock
+ * of its input item.
+ */
+static void SortKeyInit( sort_key_t *p_key, playlist_item_t *p_item,
+                         int i_mode )
+{
+    input_item_t *p_input = p_item->p_input;
+    const char *psz_title;
+
+    p_key->p_item = p_item;
+    SortFieldNumber( &p_key->title, NULL );
+    for( unsigned i = 0; i < ARRAY_SIZE(p_key->fields); i++ )
+        SortFieldNumber( &p_key->fields[i], NULL );
+    if( i_mode == SORT_ID )
+        return; /* nothing to read */
+
+    vlc_mutex_lock( &p_input->lock );
+#define META( m ) \
+    ( p_input->p_meta ? vlc_meta_Get( p_input->p_meta, vlc_meta_##m ) : NULL )
+
+    psz_title = META( Title );
+    if( EMPTY_STR( psz_title ) )
+        psz_title = p_input->psz_name;
+
+    switch( i_mode )
+    {
+        case SORT_DURATION:
+            p_key->fields[0].b_set = true;
+            p_key->fields[0].i = p_input->i_duration;
+            break;
+        case SORT_TITLE_NUMERIC:
+            SortFieldNumber( &p_key->title, psz_title );
+            break;
+        case SORT_URI:
+            SortFieldText( &p_key->fields[0], p_input->psz_uri );
+            break;
+        default:
+            SortFieldText( &p_key->title, psz_title );
+            break;
+    }
+
+    switch( i_mode )
+    {
+        case SORT_ARTIST:
+            SortFieldText( &p_key->fields[0], META( Artist ) );
+            SortFieldText( &p_key->fields[1], META( Album ) );
+            SortFieldNumber( &p_key->fields[2], META( TrackNumber ) );
+            break;
+        case SORT_ALBUM:
+            SortFieldText( &p_key->fields[0], META( Album ) );
+            SortFieldNumber( &p_key->fields[1], META( TrackNumber ) );
+            break;
+        case SORT_GENRE:
+            SortFieldText( &p_key->fields[0], META( Genre ) );
+            break;
+        case SORT_DESCRIPTION:
+            SortFieldText( &p_key->fields[0], META( Description ) );
+            break;
+        case SORT_RATING:
+            SortFieldNumber( &p_key->fields[0], META( Rating ) );
+            break;
+        case SORT_TRACK_NUMBER:
+            SortFieldNumber( &p_key->fields[0], META( TrackNumber ) );
+            break;
+    }
+#undef META
+    vlc_mutex_unlock( &p_input->lock );
+}
+
+static void SortKeyClean( sort_key_t *p_key )
+{
+    free( p_key->title.psz );
+    for( unsigned i = 0; i < ARRAY_SIZE(p_key->fields); i++ )
+        free( p_key->fields[i].psz );
+}
+
 /* General comparison functions */
+
+/**
+ * Compare two fields, the missing ones last
+ * @return -1, 0 or 1 like strcmp
+ */
+static inline int field_cmp( const sort_field_t *first,
+                             const sort_field_t *second )
+{
+    if( first->b_set && second->b_set )
+    {
+        if( first->psz && second->psz )
+            return strcmp( first->psz, second->psz );
+        return ( first->i > second->i ) - ( first->i < second->i );
+    }
+    else if( !first->b_set && second->b_set )
+        return 1;
+    else if( first->b_set && !second->b_set )
+        return -1;
+    else
+        return 0;
+}
+
 /**
  * Compare two items using their title or name
  * @param first: the first item
  * @param second: the second item
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_strcasecmp_title( const playlist_item_t *first,
-                              const playlist_item_t *second )
+static inline int meta_strcasecmp_title( const sort_key_t *first,
+                                         const sort_key_t *second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-    free( psz_first );
-    free( psz_second );
-
-    return i_ret;
+    return field_cmp( &first->title, &second->title );
 }
 
 /**
- * Compare two intems accoring to the given meta type
+ * Compare two intems accoring to one of their meta
  * @param first: the first item
  * @param second: the second item
- * @param meta: the meta type to use to sort the items
- * @param b_integer: true if the meta are integers
+ * @param i_field: the index of the meta in the keys
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_sort( const playlist_item_t *first,
-                             const playlist_item_t *second,
-                             vlc_meta_type_t meta, bool b_integer )
+static inline int meta_sort( const sort_key_t *first,
+                             const sort_key_t *second, unsigned i_field )
 {
-    int i_ret;
-    char *psz_first = input_item_GetMeta( first->p_input, meta );
-    char *psz_second = input_item_GetMeta( second->p_input, meta );
+    const playlist_item_t *p_first = first->p_item;
+    const playlist_item_t *p_second = second->p_item;
+    const sort_field_t *p_meta1 = &first->fields[i_field];
+    const sort_field_t *p_meta2 = &second->fields[i_field];
 
     /* Nodes go first */
-    if( first->i_children == -1 && second->i_children >= 0 )
-        i_ret = 1;
-    else if( first->i_children >= 0 && second->i_children == -1 )
-       i_ret = -1;
+    if( p_first->i_children == -1 && p_second->i_children >= 0 )
+        return 1;
+    else if( p_first->i_children >= 0 && p_second->i_children == -1 )
+        return -1;
     /* Both are nodes, sort by name */
-    else if( first->i_children >= 0 && second->i_children >= 0 )
-        i_ret = meta_strcasecmp_title( first, second );
-    /* Both are items */
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
+    else if( p_first->i_children >= 0 && p_second->i_children >= 0 )
+        return meta_strcasecmp_title( first, second );
     /* No meta, sort by name */
-    else if( !psz_first && !psz_second )
-        i_ret = meta_strcasecmp_title( first, second );
+    else if( !p_meta1->b_set && !p_meta2->b_set )
+        return meta_strcasecmp_title( first, second );
+    /* Both are items */
     else
-    {
-        if( b_integer )
-            i_ret = atoi( psz_first ) - atoi( psz_second );
-        else
-            i_ret = strcasecmp( psz_first, psz_second );
-    }
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+        return field_cmp( p_meta1, p_meta2 );
 }
 
 /* Comparison functions */
@@ -125,34 +265,153 @@ static inline sortfn_t find_sorting_fn( unsigned i_mode, unsigned i_type )
 }
 
 /**
- * Sort an array of items recursively
+ * Shuffle an array of items
  * @param i_items: number of items
  * @param pp_items: the array of items
- * @param p_sortfn: the sorting function
  * @return nothing
  */
-static inline
-void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
-                             sortfn_t p_sortfn )
+static void playlist_ItemArrayShuffle( unsigned i_items,
+                                       playlist_item_t **pp_items )
 {
-    if( p_sortfn )
+    unsigned i_position;
+    unsigned i_new;
+    playlist_item_t *p_temp;
+
+    if( i_items < 2 )
+        return;
+    for( i_position = i_items - 1; i_position > 0; i_position-- )
     {
-        qsort( pp_items, i_items, sizeof( pp_items[0] ), p_sortfn );
+        i_new = ((unsigned)vlc_mrand48()) % (i_position+1);
+        p_temp = pp_items[i_position];
+        pp_items[i_position] = pp_items[i_new];
+        pp_items[i_new] = p_temp;
     }
-    else /* Randomise */
+}
+
+/* A part of the keys of a node, sorted by a thread */
+typedef struct
+{
+    sort_key_t **pp_keys;
+    size_t       i_count;
+    int          i_mode;
+    sortfn_t     p_sortfn;
+    vlc_thread_t thread;
+    bool         b_thread;
+} sort_run_t;
+
+static void *SortRun( void *data )
+{
+    sort_run_t *p_run = data;
+
+    for( size_t i = 0; i < p_run->i_count; i++ )
+        SortKeyInit( p_run->pp_keys[i], p_run->pp_keys[i]->p_item,
+                     p_run->i_mode );
+    qsort( p_run->pp_keys, p_run->i_count, sizeof(*p_run->pp_keys),
+           p_run->p_sortfn );
+    return NULL;
+}
+
+/* Merges two adjacent sorted runs through the spare array */
+static void SortMerge( sort_key_t **pp_keys, sort_key_t **pp_spare,
+                       size_t i_left, size_t i_right, sortfn_t p_sortfn )
+{
+    size_t a = 0, b = i_left, i = 0;
+
+    while( a < i_left && b < i_left + i_right )
+        pp_spare[i++] = p_sortfn( &pp_keys[b], &pp_keys[a] ) < 0 ? pp_keys[b++]
+                                                                 : pp_keys[a++];
+    while( a < i_left )
+        pp_spare[i++] = pp_keys[a++];
+    while( b < i_left + i_right )
+        pp_spare[i++] = pp_keys[b++];
+    memcpy( pp_keys, pp_spare, i * sizeof(*pp_keys) );
+}
+
+/**
+ * Sort an array of items
+ *
+ * The compared fields are read once per item. Large arrays are cut in runs
+ * which are sorted by as many threads, then merged.
+ * @param i_items: number of items
+ * @param pp_items: the array of items
+ * @param i_mode: the SORT_* mode of the sorting function
+ * @param p_sortfn: the sorting function
+ * @return VLC_SUCCESS, or VLC_ENOMEM with the items left unsorted
+ */
+static int playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
+                                   int i_mode, sortfn_t p_sortfn )
+{
+    if( i_items < 2 )
+        return VLC_SUCCESS;
+
+    unsigned i_runs = 1;
+    if( i_items >= 2 * SORT_PARALLEL_MIN )
     {
-        unsigned i_position;
-        unsigned i_new;
-        playlist_item_t *p_temp;
+        i_runs = __MIN( vlc_GetCPUCount(), i_items / SORT_PARALLEL_MIN );
+        i_runs = __MAX( __MIN( i_runs, 16 ), 1 );
+    }
 
-        for( i_position = i_items - 1; i_position > 0; i_position-- )
+    /* Pointers to the keys are sorted, the keys are large */
+    sort_key_t *p_keys = malloc( i_items * sizeof(*p_keys) );
+    sort_key_t **pp_keys = malloc( 2 * i_items * sizeof(*pp_keys) );
+    sort_run_t *p_runs = malloc( i_runs * sizeof(*p_runs) );
+    if( unlikely(p_keys == NULL || pp_keys == NULL || p_runs == NULL) )
+    {
+        free( p_runs );
+        free( pp_keys );
+        free( p_keys );
+        return VLC_ENOMEM;
+    }
+
+    for( unsigned i = 0; i < i_items; i++ )
+    {
+        p_keys[i].p_item = pp_items[i];
+        pp_keys[i] = &p_keys[i];
+    }
+
+    for( unsigned i = 0; i < i_runs; i++ )
+    {
+        size_t i_start = (size_t)i_items * i / i_runs;
+        p_runs[i].pp_keys = &pp_keys[i_start];
+        p_runs[i].i_count = (size_t)i_items * (i + 1) / i_runs - i_start;
+        p_runs[i].i_mode = i_mode;
+        p_runs[i].p_sortfn = p_sortfn;
+        /* The first run is sorted by this thread */
+        p_runs[i].b_thread = i > 0 &&
+            !vlc_clone( &p_runs[i].thread, SortRun, &p_runs[i],
+                        VLC_THREAD_PRIORITY_LOW );
+    }
+    for( unsigned i = 0; i < i_runs; i++ )
+    {
+        if( p_runs[i].b_thread )
+            vlc_join( p_runs[i].thread, NULL );
+        else
+            SortRun( &p_runs[i] );
+    }
+
+    /* Merge the runs pairwise */
+    for( unsigned i_width = 1; i_width < i_runs; i_width *= 2 )
+        for( unsigned i = 0; i + i_width < i_runs; i += 2 * i_width )
         {
-            i_new = ((unsigned)vlc_mrand48()) % (i_position+1);
-            p_temp = pp_items[i_position];
-            pp_items[i_position] = pp_items[i_new];
-            pp_items[i_new] = p_temp;
+            size_t i_left = 0, i_right = 0;
+            for( unsigned j = i; j < i + i_width; j++ )
+                i_left += p_runs[j].i_count;
+            for( unsigned j = i + i_width; j < __MIN(i + 2 * i_width, i_runs); j++ )
+                i_right += p_runs[j].i_count;
+            SortMerge( p_runs[i].pp_keys, &pp_keys[i_items], i_left, i_right,
+                       p_sortfn );
         }
+
+    for( unsigned i = 0; i < i_items; i++ )
+    {
+        pp_items[i] = pp_keys[i]->p_item;
+        SortKeyClean( &p_keys[i] );
     }
+
+    free( p_runs );
+    free( pp_keys );
+    free( p_keys );
+    return VLC_SUCCESS;
 }
 
 
@@ -161,22 +420,28 @@ void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
  * This function must be entered with the playlist lock !
  * @param p_playlist the playlist
  * @param p_node the node to sort
+ * @param i_mode the SORT_* mode of the sorting function
  * @param p_sortfn the sorting function
  * @return VLC_SUCCESS on success
  */
 static int recursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
-                              sortfn_t p_sortfn )
+                              int i_mode, sortfn_t p_sortfn )
 {
-    int i;
-    playlist_ItemArraySort(p_node->i_children,p_node->pp_children,p_sortfn);
+    int i, i_ret = VLC_SUCCESS;
+    if( p_sortfn )
+        i_ret = playlist_ItemArraySort( p_node->i_children, p_node->pp_children,
+                                        i_mode, p_sortfn );
+    else /* Randomise */
+        playlist_ItemArrayShuffle( p_node->i_children, p_node->pp_children );
     for( i = 0 ; i< p_node->i_children; i++ )
     {
-        if( p_node->pp_children[i]->i_children != -1 )
-        {
-            recursiveNodeSort( p_playlist, p_node->pp_children[i], p_sortfn );
-        }
+        pl_item_priv( p_node->pp_children[i] )->i_index = i;
+        if( p_node->pp_children[i]->i_children != -1 &&
+            recursiveNodeSort( p_playlist, p_node->pp_children[i], i_mode,
+                               p_sortfn ) )
+            i_ret = VLC_ENOMEM;
     }
-    return VLC_SUCCESS;
+    return i_ret;
 }
 
 /**
@@ -197,70 +462,73 @@ int playlist_RecursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
     pl_priv(p_playlist)->b_reset_currently_playing = true;
 
     /* Do the real job recursively */
-    return recursiveNodeSort(p_playlist,p_node,find_sorting_fn(i_mode,i_type));
+    return recursiveNodeSort( p_playlist, p_node, i_mode,
+                              find_sorting_fn( i_mode, i_type ) );
 }
 
 
 /* This is the stuff the sorting functions are made of. The proto_##
  * functions are wrapped in cmp_a_## and cmp_d_## functions that do
- * void * to const playlist_item_t * casting and dereferencing and
- * cmp_d_## inverts the result, too. proto_## are static inline,
- * cmp_[ad]_## are merely static as they're the target of pointers.
+ * void * to const sort_key_t * casting and dereferencing and cmp_d_##
+ * inverts the result, too. proto_## are static inline, cmp_[ad]_## are merely static as
+ * they're the target of pointers.
  *
  * In any case, each SORT_## constant (except SORT_RANDOM) must have
- * a matching SORTFN( )-declared function here.
+ * a matching SORTFN( )-declared function here, and SortKeyInit() must
+ * read the fields it compares.
  */
 
 #define SORTFN( SORT, first, second ) static inline int proto_##SORT \
-	( const playlist_item_t *first, const playlist_item_t *second )
+	( const sort_key_t *first, const sort_key_t *second )
 
 SORTFN( SORT_ALBUM, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Album, false );
+    int i_ret = meta_sort( first, second, 0 );
     /* Items came from the same album: compare the track numbers */
     if( i_ret == 0 )
-        i_ret = meta_sort( first, second, vlc_meta_TrackNumber, true );
+        i_ret = meta_sort( first, second, 1 );
 
     return i_ret;
 }
 
 SORTFN( SORT_ARTIST, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Artist, false );
+    int i_ret = meta_sort( first, second, 0 );
     /* Items came from the same artist: compare the albums */
     if( i_ret == 0 )
-        i_ret = proto_SORT_ALBUM( first, second );
+    {
+        i_ret = meta_sort( first, second, 1 );
+        /* And then the track numbers */
+        if( i_ret == 0 )
+            i_ret = meta_sort( first, second, 2 );
+    }
 
     return i_ret;
 }
 
 SORTFN( SORT_DESCRIPTION, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Description, false );
+    return meta_sort( first, second, 0 );
 }
 
 SORTFN( SORT_DURATION, first, second )
 {
-    mtime_t time1 = input_item_GetDuration( first->p_input );
-    mtime_t time2 = input_item_GetDuration( second->p_input );
-    int i_ret = time1 > time2 ? 1 :
-                    ( time1 == time2 ? 0 : -1 );
-    return i_ret;
+    return field_cmp( &first->fields[0], &second->fields[0] );
 }
 
 SORTFN( SORT_GENRE, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Genre, false );
+    return meta_sort( first, second, 0 );
 }
 
 SORTFN( SORT_ID, first, second )
 {
-    return first->i_id - second->i_id;
+    return first->p_item->i_id - second->p_item->i_id;
 }
 
 SORTFN( SORT_RATING, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Rating, true );
+    return meta_sort( first, second, 0 );
 }
 
 SORTFN( SORT_TITLE, first, second )
@@ -271,10 +539,10 @@ SORTFN( SORT_TITLE, first, second )
 SORTFN( SORT_TITLE_NODES_FIRST, first, second )
 {
     /* If first is a node but not second */
-    if( first->i_children == -1 && second->i_children >= 0 )
+    if( first->p_item->i_children == -1 && second->p_item->i_children >= 0 )
         return -1;
     /* If second is a node but not first */
-    else if( first->i_children >= 0 && second->i_children == -1 )
+    else if( first->p_item->i_children >= 0 && second->p_item->i_children == -1 )
         return 1;
     /* Both are nodes or both are not nodes */
     else
@@ -283,47 +551,17 @@ SORTFN( SORT_TITLE_NODES_FIRST, first, second )
 
 SORTFN( SORT_TITLE_NUMERIC, first, second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = atoi( psz_first ) - atoi( psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+    return meta_strcasecmp_title( first, second );
 }
 
 SORTFN( SORT_TRACK_NUMBER, first, second )
 {
-    return meta_sort( first, second, vlc_meta_TrackNumber, true );
+    return meta_sort( first, second, 0 );
 }
 
 SORTFN( SORT_URI, first, second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetURI( first->p_input );
-    char *psz_second = input_item_GetURI( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+    return field_cmp( &first->fields[0], &second->fields[0] );
 }
 
 #undef  SORTFN
@@ -338,11 +576,11 @@ SORTFN( SORT_URI, first, second )
 
 #define DEF( s ) \
 	static int cmp_a_##s(const void *l,const void *r) \
-	{ return proto_##s(*(const playlist_item_t *const *)l, \
-                           *(const playlist_item_t *const *)r); } \
+	{ return proto_##s(*(const sort_key_t *const *)l, \
+                           *(const sort_key_t *const *)r); } \
 	static int cmp_d_##s(const void *l,const void *r) \
-	{ return -1*proto_##s(*(const playlist_item_t * const *)l, \
-                              *(const playlist_item_t * const *)r); }
+	{ return -1*proto_##s(*(const sort_key_t * const *)l, \
+                              *(const sort_key_t * const *)r); }
 
 	VLC_DEFINE_SORT_FUNCTIONS
 
@@ -44,6 +44,37 @@ playlist_item_t *GetPrevItem( playlist_t *p_playlist,
                               playlist_item_t *p_item,
                               playlist_item_t *p_root );
 
+/**
+ * Removes an item or node from all_items.
+ *
+ * Entries are only flagged, and the array is compacted once half of them
+ * are deleted, rather than moving the end of the array at each deletion.
+ */
+static void AllItemsRemove( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_private_t *p_sys = pl_priv( p_playlist );
+    int i;
+
+    ARRAY_BSEARCH( p_sys->all_items, ->i_id, int, p_item->i_id, i );
+    if( i == -1 || pl_item_priv( p_item )->b_deleted )
+        return;
+
+    pl_item_priv( p_item )->b_deleted = true;
+    playlist_InputIndexRemove( p_playlist, p_item );
+    playlist_LiveSearchRemove( p_playlist, p_item );
+
+    if( ++p_sys->i_all_items_deleted <= p_sys->all_items.i_size / 2 )
+        return;
+
+    int j = 0;
+    FOREACH_ARRAY( playlist_item_t *p_entry, p_sys->all_items )
+        if( !pl_item_priv( p_entry )->b_deleted )
+            ARRAY_VAL( p_sys->all_items, j++ ) = p_entry;
+    FOREACH_END();
+    p_sys->all_items.i_size = j;
+    p_sys->i_all_items_deleted = 0;
+}
+
 /**
  * Create a playlist node
  *
@@ -77,7 +108,8 @@ playlist_item_t * playlist_NodeCreate( playlist_t *p_playlist,
     if( p_item == NULL )  return NULL;
     p_item->i_children = 0;
 
-    ARRAY_APPEND(p_playlist->all_items, p_item);
+    ARRAY_APPEND(pl_priv(p_playlist)->all_items, p_item);
+    playlist_InputIndexAdd( p_playlist, p_item );
 
     if( p_parent != NULL )
         playlist_NodeInsert( p_playlist, p_item, p_parent,
@@ -156,9 +188,7 @@ int playlist_NodeDelete( playlist_t *p_playlist, playlist_item_t *p_root,
 
     int i;
     var_SetInteger( p_playlist, "playlist-item-deleted", p_root->i_id );
-    ARRAY_BSEARCH( p_playlist->all_items, ->i_id, int, p_root->i_id, i );
-    if( i != -1 )
-        ARRAY_REMOVE( p_playlist->all_items, i );
+    AllItemsRemove( p_playlist, p_root );
 
     if( p_root->i_children == -1 ) {
         ARRAY_BSEARCH( p_playlist->items,->i_id, int, p_root->i_id, i );
@@ -217,14 +247,73 @@ int playlist_NodeInsert( playlist_t *p_playlist,
     if( i_position == -1 ) i_position = p_parent->i_children ;
     assert( i_position <= p_parent->i_children);
 
-    INSERT_ELEM( p_parent->pp_children,
-                 p_parent->i_children,
-                 i_position,
-                 p_item );
+    /* Grow geometrically, not at each insertion */
+    playlist_item_private_t *p_priv = pl_item_priv( p_parent );
+    if( p_parent->i_children >= p_priv->i_children_max )
+    {
+        int i_max = p_priv->i_children_max ? 2 * p_priv->i_children_max : 8;
+        playlist_item_t **pp_children =
+            realloc( p_parent->pp_children, i_max * sizeof(*pp_children) );
+        if( unlikely(pp_children == NULL) )
+            abort();
+        p_parent->pp_children = pp_children;
+        p_priv->i_children_max = i_max;
+    }
+
+    memmove( &p_parent->pp_children[i_position + 1],
+             &p_parent->pp_children[i_position],
+             (p_parent->i_children - i_position) * sizeof(p_item) );
+    p_parent->pp_children[i_position] = p_item;
+    p_parent->i_children++;
     p_item->p_parent = p_parent;
+    pl_item_priv( p_item )->i_index = i_position;
     return VLC_SUCCESS;
 }
 
+/**
+ * Finds the position of an item in its parent node.
+ *
+ * The search starts from the last known position of the item, as it only
+ * moves when items are inserted or removed before it.
+ *
+ * \param p_item the item
+ * \return the position, or -1 if the item is not a child of its parent
+ */
+int playlist_ItemIndex( playlist_item_t *p_item )
+{
+    playlist_item_t *p_parent = p_item->p_parent;
+    playlist_item_private_t *p_priv = pl_item_priv( p_item );
+
+    if( p_parent == NULL || p_parent->i_children <= 0 )
+        return -1;
+
+    const int i_count = p_parent->i_children;
+    const int i_hint = __MIN( p_priv->i_index, i_count - 1 );
+    int i_index = -1, d;
+    for( d = 0; i_hint + d < i_count || i_hint - d >= 0; d++ )
+    {
+        if( i_hint + d < i_count && p_parent->pp_children[i_hint + d] == p_item )
+        {
+            i_index = i_hint + d;
+            break;
+        }
+        if( i_hint - d >= 0 && p_parent->pp_children[i_hint - d] == p_item )
+        {
+            i_index = i_hint - d;
+            break;
+        }
+    }
+
+    /* The positions of the siblings are likely as stale, refresh them all
+     * once the search gets longer than the square root of their number */
+    if( d > 16 && d * d > i_count )
+        for( int i = 0; i < i_count; i++ )
+            pl_item_priv( p_parent->pp_children[i] )->i_index = i;
+    else if( i_index != -1 )
+        p_priv->i_index = i_index;
+    return i_index;
+}
+
 /**
  * Deletes an item from the children of a node
  *
@@ -240,23 +329,35 @@ int playlist_NodeRemoveItem( playlist_t *p_playlist,
     PL_ASSERT_LOCKED;
     (void)p_playlist;
 
-    int ret = VLC_EGENERIC;
+    if( p_item->p_parent != p_parent )
+        return VLC_EGENERIC;
+
+    int i = playlist_ItemIndex( p_item );
+    if( i == -1 )
+        return VLC_EGENERIC;
+
+    memmove( &p_parent->pp_children[i], &p_parent->pp_children[i + 1],
+             (p_parent->i_children - i - 1) * sizeof(p_item) );
+    p_parent->i_children--;
 
-    for(int i= 0; i< p_parent->i_children ; i++ )
+    /* Give memory back once the node got much smaller */
+    playlist_item_private_t *p_priv = pl_item_priv( p_parent );
+    if( p_parent->i_children == 0 )
     {
-        if( p_parent->pp_children[i] == p_item )
-        {
-            REMOVE_ELEM( p_parent->pp_children, p_parent->i_children, i );
-            ret = VLC_SUCCESS;
-        }
+        free( p_parent->pp_children );
+        p_parent->pp_children = NULL;
+        p_priv->i_children_max = 0;
     }
-
-    if( ret == VLC_SUCCESS ) {
-        assert( p_item->p_parent == p_parent );
-        p_item->p_parent = NULL;
+    else if( p_priv->i_children_max > 8 &&
+             p_parent->i_children < p_priv->i_children_max / 4 )
+    {
+        p_priv->i_children_max /= 2;
+        p_parent->pp_children = realloc_down( p_parent->pp_children,
+                p_priv->i_children_max * sizeof(*p_parent->pp_children) );
     }
 
-    return ret;
+    p_item->p_parent = NULL;
+    return VLC_SUCCESS;
 }
 
 /**
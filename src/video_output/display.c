@@ -93,6 +93,7 @@ static vout_display_t *vout_display_New(vlc_object_t *obj,
     vd->info.has_hide_mouse = false;
     vd->info.has_pictures_invalid = false;
     vd->info.has_event_thread = false;
+    vd->info.has_held_pictures = false;
     vd->info.subpicture_chromas = NULL;
 
     vd->cfg = cfg;
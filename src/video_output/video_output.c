@@ -111,6 +111,12 @@ static bool VideoFormatIsCropArEqual(video_format_t *dst,
            dst->i_visible_height == src->i_visible_height;
 }
 
+/* Pictures of unpaced inputs are displayed as soon as they are decoded */
+static bool VoutIsUnpaced(const vout_configuration_t *cfg)
+{
+    return cfg->input != NULL && var_InheritBool(cfg->input, "input-unpaced");
+}
+
 static vout_thread_t *VoutCreate(vlc_object_t *object,
                                  const vout_configuration_t *cfg)
 {
@@ -132,6 +138,7 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
 
     vout->p->original = original;
     vout->p->dpb_size = cfg->dpb_size;
+    atomic_init(&vout->p->is_unpaced, VoutIsUnpaced(cfg));
 
     vout_control_Init(&vout->p->control);
     vout_control_PushVoid(&vout->p->control, VOUT_CONTROL_INIT);
@@ -236,6 +243,7 @@ vout_thread_t *vout_Request(vlc_object_t *object,
             if (vout->p->input)
                 spu_Attach(vout->p->spu, vout->p->input, true);
         }
+        atomic_store(&vout->p->is_unpaced, VoutIsUnpaced(cfg));
 
         if (cfg->change_fmt) {
             vout_control_cmd_t cmd;
@@ -754,7 +762,8 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
 {
-    bool is_late_dropped = vout->p->is_late_dropped && !vout->p->pause.is_on && !frame_by_frame;
+    bool is_late_dropped = vout->p->is_late_dropped && !vout->p->pause.is_on && !frame_by_frame
+                        && !atomic_load(&vout->p->is_unpaced);
 
     vlc_mutex_lock(&vout->p->filter.lock);
 
@@ -805,9 +814,10 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
         return VLC_EGENERIC;
 
     assert(!vout->p->displayed.next);
-    if (!vout->p->displayed.current)
-        vout->p->displayed.current = picture;
-    else
+    if (!vout->p->displayed.current) {
+        vout->p->displayed.current  = picture;
+        vout->p->displayed.is_shown = false;
+    } else
         vout->p->displayed.next    = picture;
     return VLC_SUCCESS;
 }
@@ -1017,6 +1027,7 @@ static int ThreadDisplayPicture(vout_thread_t *vout, mtime_t *deadline)
     bool frame_by_frame = !deadline;
     bool paused = vout->p->pause.is_on;
     bool first = !vout->p->displayed.current;
+    bool unpaced = !paused && atomic_load(&vout->p->is_unpaced);
 
     if (first)
         if (ThreadDisplayPreparePicture(vout, true, frame_by_frame)) /* FIXME not sure it is ok */
@@ -1033,7 +1044,11 @@ static int ThreadDisplayPicture(vout_thread_t *vout, mtime_t *deadline)
     mtime_t date_next = VLC_TS_INVALID;
     if (!paused && vout->p->displayed.next) {
         date_next = vout->p->displayed.next->date - render_delay;
-        if (date_next /* + 0 FIXME */ <= date)
+        /* Unpaced, move on as soon as the current picture was displayed,
+         * but never skip it: the decoder waits meanwhile */
+        if (unpaced)
+            drop_next_frame = vout->p->displayed.is_shown;
+        else if (date_next /* + 0 FIXME */ <= date)
             drop_next_frame = true;
     }
 
@@ -1049,13 +1064,15 @@ static int ThreadDisplayPicture(vout_thread_t *vout, mtime_t *deadline)
     bool refresh = false;
 
     mtime_t date_refresh = VLC_TS_INVALID;
-    if (vout->p->displayed.date > VLC_TS_INVALID) {
+    if (vout->p->displayed.date > VLC_TS_INVALID && !unpaced) {
         date_refresh = vout->p->displayed.date + VOUT_REDISPLAY_DELAY - render_delay;
         refresh = date_refresh <= date;
     }
     bool force_refresh = !drop_next_frame && refresh;
+    /* Unpaced, a picture that could not be displayed is tried again */
+    bool retry = unpaced && !vout->p->displayed.is_shown;
 
-    if (!first && !refresh && !drop_next_frame) {
+    if (!first && !refresh && !drop_next_frame && !retry) {
         if (!frame_by_frame) {
             if (date_refresh != VLC_TS_INVALID)
                 *deadline = date_refresh;
@@ -1067,16 +1084,22 @@ static int ThreadDisplayPicture(vout_thread_t *vout, mtime_t *deadline)
 
     if (drop_next_frame) {
         picture_Release(vout->p->displayed.current);
-        vout->p->displayed.current = vout->p->displayed.next;
-        vout->p->displayed.next    = NULL;
+        vout->p->displayed.current  = vout->p->displayed.next;
+        vout->p->displayed.next     = NULL;
+        vout->p->displayed.is_shown = false;
     }
 
     if (!vout->p->displayed.current)
         return VLC_EGENERIC;
 
     /* display the picture immediately */
-    bool is_forced = frame_by_frame || force_refresh || vout->p->displayed.current->b_force;
+    bool is_forced = frame_by_frame || force_refresh || unpaced ||
+                     vout->p->displayed.current->b_force;
     int ret = ThreadDisplayRenderPicture(vout, is_forced);
+    if (ret == VLC_SUCCESS)
+        vout->p->displayed.is_shown = true;
+    else if (unpaced && !frame_by_frame)
+        *deadline = date + VOUT_MWAIT_TOLERANCE;
     return force_refresh ? VLC_EGENERIC : ret;
 }
 
@@ -1174,7 +1197,12 @@ static void ThreadReset(vout_thread_t *vout)
             picture_pool_Release(vout->p->private_pool);
         }
 
-        leaks = picture_pool_Reset(vout->p->decoder_pool);
+        /* Pictures held by the display are not leaked, and must not be
+         * handed out again before it releases them */
+        if (vout->p->display.vd->info.has_held_pictures)
+            leaks = 0;
+        else
+            leaks = picture_pool_Reset(vout->p->decoder_pool);
         if (leaks > 0)
             msg_Err(vout, "%u picture(s) leaked by decoder", leaks);
 
@@ -1336,6 +1364,7 @@ static int ThreadStart(vout_thread_t *vout, const vout_display_state_t *state)
     vout->p->displayed.date          = VLC_TS_INVALID;
     vout->p->displayed.timestamp     = VLC_TS_INVALID;
     vout->p->displayed.is_interlaced = false;
+    vout->p->displayed.is_shown      = false;
 
     vout->p->step.last               = VLC_TS_INVALID;
     vout->p->step.timestamp          = VLC_TS_INVALID;
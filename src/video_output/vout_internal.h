@@ -88,6 +88,7 @@ struct vout_thread_sys_t
         mtime_t     date;
         mtime_t     timestamp;
         bool        is_interlaced;
+        bool        is_shown; /* current was displayed */
         picture_t   *decoded;
         picture_t   *current;
         picture_t   *next;
@@ -112,6 +113,7 @@ struct vout_thread_sys_t
 
     /* */
     bool            is_late_dropped;
+    atomic_bool     is_unpaced; /* display pictures as soon as decoded */
 
     /* Video filter2 chain */
     struct {
@@ -23,6 +23,10 @@
 
 #include "test.h"
 
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
 static void preparsed_changed(const libvlc_event_t *event, void *user_data)
 {
     (void)event;
@@ -73,11 +77,153 @@ static void test_media_preparsed(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+static void wait_parse_idle(libvlc_instance_t *vlc,
+                            libvlc_media_parse_stats_t *stats)
+{
+    /* The parsing thread accounts for a media after signaling it */
+    for (unsigned i = 0; i < 200; i++)
+    {
+        libvlc_media_parse_get_stats (vlc, stats);
+        if (stats->i_running == 0)
+            return;
+        usleep (10000);
+    }
+    assert (!"parsing thread still running");
+}
+
+static void test_media_parse_stats(const char** argv, int argc)
+{
+    const char *args[argc + 1];
+    libvlc_media_parse_stats_t stats;
+
+    log ("Testing parse statistics\n");
+
+    for (int i = 0; i < argc; i++)
+        args[i] = argv[i];
+    args[argc] = "--preparse-timeout=200";
+
+    libvlc_instance_t *vlc = libvlc_new (argc + 1, args);
+    assert (vlc != NULL);
+
+    libvlc_media_parse_get_stats (vlc, &stats);
+    assert (stats.i_pending == 0 && stats.i_running == 0);
+    assert (stats.i_parsed == 0 && stats.i_timed_out == 0);
+
+    libvlc_media_t *media =
+        libvlc_media_new_path (vlc, SRCDIR"/samples/image.jpg");
+    assert (media != NULL);
+    libvlc_media_parse (media);
+    assert (libvlc_media_is_parsed (media));
+    libvlc_media_release (media);
+
+    wait_parse_idle (vlc, &stats);
+    assert (stats.i_pending == 0);
+    assert (stats.i_parsed == 1 && stats.i_timed_out == 0);
+
+    /* Nothing is ever written to the pipe: parsing it times out */
+    char fifo[] = "/tmp/libvlc_parse_statsXXXXXX";
+    int fd = mkstemp (fifo);
+    assert (fd != -1);
+    close (fd);
+    unlink (fifo);
+    assert (mkfifo (fifo, 0600) == 0);
+    fd = open (fifo, O_RDWR);
+    assert (fd != -1);
+
+    media = libvlc_media_new_path (vlc, fifo);
+    assert (media != NULL);
+    libvlc_media_parse (media);
+    assert (!libvlc_media_is_parsed (media));
+    libvlc_media_release (media);
+
+    wait_parse_idle (vlc, &stats);
+    assert (stats.i_pending == 0);
+    assert (stats.i_parsed == 2 && stats.i_timed_out == 1);
+    assert (stats.i_parse_time >= 200);
+
+    close (fd);
+    unlink (fifo);
+    libvlc_release (vlc);
+}
+
+struct thumbnails
+{
+    unsigned count;
+    unsigned width, height;
+    uint8_t luma[3];
+};
+
+static void thumbnail(void *opaque, unsigned index, const void *pixels,
+                      unsigned width, unsigned height, unsigned pitch)
+{
+    struct thumbnails *thumbnails = opaque;
+
+    assert(index == thumbnails->count);
+    assert(pitch >= width * 4);
+    thumbnails->count++;
+    thumbnails->width = width;
+    thumbnails->height = height;
+    /* Gray frames: the middle pixel gives the luma back */
+    thumbnails->luma[index] =
+        ((const uint8_t *)pixels)[(height / 2) * pitch + (width / 2) * 4];
+}
+
+static void test_media_thumbnails(const char** argv, int argc)
+{
+    char file[] = "/tmp/libvlc_thumbnailsXXXXXX.yuv";
+    int fd = mkstemps(file, 4);
+    assert(fd != -1);
+
+    /* 176x144 YV12 frames, getting lighter every frame */
+    static uint8_t frame[176 * 144 * 3 / 2];
+    for (unsigned i = 0; i < 25; i++)
+    {
+        memset(frame, 16 + 8 * i, 176 * 144);
+        memset(frame + 176 * 144, 128, 176 * 144 / 2);
+        assert(write(fd, frame, sizeof (frame)) == sizeof (frame));
+    }
+    close(fd);
+
+    log ("Testing thumbnails\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    libvlc_media_t *media = libvlc_media_new_path (vlc, file);
+    assert (media != NULL);
+    libvlc_media_add_option (media, ":rawvid-fps=25");
+
+    static const libvlc_time_t times[] = { 0, 400, 800 };
+    struct thumbnails thumbnails = { 0 };
+    int count = libvlc_media_thumbnails (media, times, 3, "RV32", 0, 0,
+                                         thumbnail, &thumbnails);
+    assert (count == 3 && thumbnails.count == 3);
+    assert (thumbnails.width == 176 && thumbnails.height == 144);
+    assert (thumbnails.luma[0] < thumbnails.luma[1]);
+    assert (thumbnails.luma[1] < thumbnails.luma[2]);
+
+    /* The height follows the aspect ratio */
+    thumbnails.count = 0;
+    count = libvlc_media_thumbnails (media, times, 1, "RV32", 88, 0,
+                                     thumbnail, &thumbnails);
+    assert (count == 1 && thumbnails.count == 1);
+    assert (thumbnails.width == 88 && thumbnails.height == 72);
+
+    assert (libvlc_media_thumbnails (media, times, 1, "I420", 0, 0,
+                                     thumbnail, &thumbnails) == -1);
+
+    libvlc_media_release (media);
+    libvlc_release (vlc);
+    unlink(file);
+}
+
 int main (void)
 {
     test_init();
 
     test_media_preparsed (test_defaults_args, test_defaults_nargs);
+    test_media_parse_stats (test_defaults_args, test_defaults_nargs);
+    test_media_thumbnails (test_defaults_args, test_defaults_nargs);
 
     return 0;
 }
@@ -23,6 +23,9 @@
 
 #include "test.h"
 
+#include <stdarg.h>
+#include <string.h>
+
 static void wait_playing(libvlc_media_player_t *mp)
 {
     libvlc_state_t state;
@@ -176,6 +179,346 @@ static void test_media_player_pause_stop(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+#define BUFFERS 24
+
+struct buffers
+{
+    uint8_t *planes[BUFFERS][3];
+    libvlc_video_frame_t *held;
+    int64_t last_pts;
+    volatile unsigned frames;
+};
+
+static unsigned buffers_setup(void **opaque, char *chroma,
+                              unsigned *width, unsigned *height,
+                              unsigned *pitches, unsigned *lines)
+{
+    struct buffers *buffers = *opaque;
+
+    /* Keep the decoded format, so that nothing gets converted */
+    assert(!strcmp(chroma, "YV12"));
+    assert(*width == 176 && *height == 144);
+    pitches[0] = 192;
+    pitches[1] = pitches[2] = 96;
+    lines[0] = 144;
+    lines[1] = lines[2] = 72;
+
+    for (unsigned i = 0; i < BUFFERS; i++)
+    {
+        buffers->planes[i][0] = aligned_alloc(32, 192 * 144);
+        buffers->planes[i][1] = aligned_alloc(32, 96 * 72);
+        buffers->planes[i][2] = aligned_alloc(32, 96 * 72);
+        assert(buffers->planes[i][0] && buffers->planes[i][1] &&
+               buffers->planes[i][2]);
+    }
+    return BUFFERS;
+}
+
+static void buffers_register(void *opaque, unsigned index, void **planes)
+{
+    struct buffers *buffers = opaque;
+
+    assert(index < BUFFERS);
+    for (unsigned i = 0; i < 3; i++)
+        planes[i] = buffers->planes[index][i];
+}
+
+static void buffers_frame(void *opaque, libvlc_video_frame_t *frame,
+                          unsigned index, int64_t pts, int64_t deadline)
+{
+    struct buffers *buffers = opaque;
+
+    assert(index < BUFFERS);
+    assert(pts > buffers->last_pts);
+    assert(deadline > 0);
+    buffers->last_pts = pts;
+
+    /* Hold one frame at a time, released once the next one arrives */
+    if (buffers->held != NULL)
+        libvlc_video_frame_release(buffers->held);
+    buffers->held = frame;
+    buffers->frames++;
+}
+
+static void buffers_cleanup(void *opaque)
+{
+    struct buffers *buffers = opaque;
+
+    if (buffers->held != NULL)
+        libvlc_video_frame_release(buffers->held);
+    buffers->held = NULL;
+}
+
+static void buffers_log(void *opaque, int level, const libvlc_log_t *ctx,
+                        const char *fmt, va_list ap)
+{
+    unsigned *leaks = opaque;
+    char msg[256];
+
+    (void) level; (void) ctx;
+    vsnprintf(msg, sizeof (msg), fmt, ap);
+    /* Frames held by the application must not be taken back */
+    if (strstr(msg, "leaked by decoder") != NULL)
+        (*leaks)++;
+}
+
+static void test_media_player_buffers(const char** argv, int argc)
+{
+    char file[] = "/tmp/libvlc_buffersXXXXXX.yuv";
+    int fd = mkstemps(file, 4);
+    assert(fd != -1);
+
+    static uint8_t frame[176 * 144 * 3 / 2];
+    memset(frame, 128, sizeof (frame));
+    for (unsigned i = 0; i < 25; i++)
+        assert(write(fd, frame, sizeof (frame)) == sizeof (frame));
+    close(fd);
+
+    log ("Testing video buffer callbacks\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    unsigned leaks = 0;
+    libvlc_log_set (vlc, buffers_log, &leaks);
+
+    libvlc_media_t *md = libvlc_media_new_path (vlc, file);
+    assert (md != NULL);
+    libvlc_media_add_option (md, ":rawvid-fps=25");
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    struct buffers buffers = { .last_pts = -1 };
+    libvlc_video_set_buffer_callbacks (mp, buffers_setup, buffers_register,
+                                       buffers_frame, buffers_cleanup,
+                                       &buffers);
+    libvlc_media_player_play (mp);
+    while (buffers.frames < 10)
+        usleep (10000);
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_release (mp);
+    libvlc_release (vlc);
+    assert (leaks == 0);
+
+    for (unsigned i = 0; i < BUFFERS; i++)
+        for (unsigned j = 0; j < 3; j++)
+            free (buffers.planes[i][j]);
+    unlink (file);
+}
+
+static void test_media_player_unpaced(const char** argv, int argc)
+{
+    char file[] = "/tmp/libvlc_unpacedXXXXXX.yuv";
+    int fd = mkstemps(file, 4);
+    assert(fd != -1);
+
+    /* Four seconds of video at nominal speed */
+    static uint8_t frame[176 * 144 * 3 / 2];
+    memset(frame, 128, sizeof (frame));
+    for (unsigned i = 0; i < 100; i++)
+        assert(write(fd, frame, sizeof (frame)) == sizeof (frame));
+    close(fd);
+
+    log ("Testing unpaced decoding\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    libvlc_media_t *md = libvlc_media_new_path (vlc, file);
+    assert (md != NULL);
+    libvlc_media_add_option (md, ":rawvid-fps=25");
+    libvlc_media_add_option (md, ":input-unpaced");
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    struct buffers buffers = { .last_pts = -1 };
+    libvlc_video_set_buffer_callbacks (mp, buffers_setup, buffers_register,
+                                       buffers_frame, buffers_cleanup,
+                                       &buffers);
+
+    /* Every frame is delivered, in well under the media duration (and the
+     * alarm of the whole test) */
+    int64_t start = libvlc_clock ();
+    libvlc_media_player_play (mp);
+    while (buffers.frames < 100 && libvlc_clock () - start < 3000000)
+        usleep (10000);
+    assert (buffers.frames == 100);
+
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_release (mp);
+    libvlc_release (vlc);
+
+    for (unsigned i = 0; i < BUFFERS; i++)
+        for (unsigned j = 0; j < 3; j++)
+            free (buffers.planes[i][j]);
+    unlink (file);
+}
+
+struct exact
+{
+    struct buffers buffers;
+    volatile int landed;
+};
+
+static void exact_frame(void *opaque, libvlc_video_frame_t *frame,
+                        unsigned index, int64_t pts, int64_t deadline)
+{
+    struct exact *exact = opaque;
+    /* Each frame is filled with its own index */
+    const int luma = exact->buffers.planes[index][0][0];
+
+    if (luma >= 50 && exact->landed < 0)
+        exact->landed = luma;
+    buffers_frame(opaque, frame, index, pts, deadline);
+}
+
+static void test_media_player_exact_seek(const char** argv, int argc)
+{
+    char file[] = "/tmp/libvlc_exactXXXXXX.yuv";
+    int fd = mkstemps(file, 4);
+    assert(fd != -1);
+
+    static uint8_t frame[176 * 144 * 3 / 2];
+    for (unsigned i = 0; i < 100; i++)
+    {
+        memset(frame, i, sizeof (frame));
+        assert(write(fd, frame, sizeof (frame)) == sizeof (frame));
+    }
+    close(fd);
+
+    log ("Testing frame accurate seeking\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    libvlc_media_t *md = libvlc_media_new_path (vlc, file);
+    assert (md != NULL);
+    libvlc_media_add_option (md, ":rawvid-fps=25");
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    struct exact exact = { .buffers = { .last_pts = -1 }, .landed = -1 };
+    libvlc_video_set_buffer_callbacks (mp, buffers_setup, buffers_register,
+                                       exact_frame, buffers_cleanup, &exact);
+    libvlc_media_player_play (mp);
+    while (exact.buffers.frames < 1)
+        usleep (10000);
+
+    /* The demuxer lands on frame 75 (3000 ms): it must not be shown */
+    libvlc_media_player_set_time_exact (mp, 3010);
+    int64_t start = libvlc_clock ();
+    while (exact.landed < 0 && libvlc_clock () - start < 2000000)
+        usleep (10000);
+    assert (exact.landed == 76);
+
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_release (mp);
+    libvlc_release (vlc);
+
+    for (unsigned i = 0; i < BUFFERS; i++)
+        for (unsigned j = 0; j < 3; j++)
+            free (exact.buffers.planes[i][j]);
+    unlink (file);
+}
+
+#define PERIOD 1000
+#define RING 4
+
+struct periods
+{
+    float ring[RING][2 * PERIOD];
+    unsigned calls;
+    unsigned samples;
+    int64_t last_pts;
+    volatile bool drained;
+};
+
+static void periods_play(void *opaque, const void *samples, unsigned count,
+                         int64_t pts)
+{
+    struct periods *periods = opaque;
+    const float *planes = samples;
+
+    /* Periods are filled in turn, one plane per channel */
+    assert(planes == periods->ring[periods->calls % RING]);
+    assert(count == PERIOD || (count < PERIOD && !periods->drained));
+    assert(pts > periods->last_pts);
+    for (unsigned i = 0; i < count; i++)
+    {
+        assert(planes[i] == .5f);
+        assert(planes[count + i] == -.25f);
+    }
+    periods->last_pts = pts;
+    periods->samples += count;
+    periods->calls++;
+}
+
+static void periods_drain(void *opaque)
+{
+    struct periods *periods = opaque;
+
+    periods->drained = true;
+}
+
+static void test_media_player_periods(const char** argv, int argc)
+{
+    char file[] = "/tmp/libvlc_periodsXXXXXX.wav";
+    int fd = mkstemps(file, 4);
+    assert(fd != -1);
+
+    /* Half a second of 16-bits stereo at 44100 Hz */
+    static const uint8_t header[44] = {
+        'R', 'I', 'F', 'F', 0xAC, 0x58, 0x01, 0x00, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0,
+        0x44, 0xAC, 0, 0, 0x10, 0xB1, 0x02, 0, 4, 0, 16, 0,
+        'd', 'a', 't', 'a', 0x88, 0x58, 0x01, 0x00,
+    };
+    static int16_t data[22050][2];
+    for (unsigned i = 0; i < 22050; i++)
+    {
+        data[i][0] = 16384;
+        data[i][1] = -8192;
+    }
+    assert(write(fd, header, sizeof (header)) == sizeof (header));
+    assert(write(fd, data, sizeof (data)) == sizeof (data));
+    close(fd);
+
+    log ("Testing audio periods\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    libvlc_media_t *md = libvlc_media_new_path (vlc, file);
+    assert (md != NULL);
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    static struct periods periods;
+    periods.last_pts = -1;
+    libvlc_audio_set_callbacks (mp, periods_play, NULL, NULL, NULL,
+                                periods_drain, &periods);
+    libvlc_audio_set_format (mp, "FLTP", 44100, 2);
+    libvlc_audio_set_period (mp, PERIOD);
+    libvlc_audio_set_ring_buffer (mp, periods.ring, RING);
+    libvlc_media_player_play (mp);
+    while (!periods.drained)
+        usleep (10000);
+    assert (periods.samples == 22050);
+    assert (periods.calls == 23);
+
+    libvlc_media_player_stop (mp);
+    libvlc_media_player_release (mp);
+    libvlc_release (vlc);
+    unlink (file);
+}
 
 int main (void)
 {
@@ -184,6 +527,10 @@ int main (void)
     test_media_player_set_media (test_defaults_args, test_defaults_nargs);
     test_media_player_play_stop (test_defaults_args, test_defaults_nargs);
     test_media_player_pause_stop (test_defaults_args, test_defaults_nargs);
+    test_media_player_buffers (test_defaults_args, test_defaults_nargs);
+    test_media_player_periods (test_defaults_args, test_defaults_nargs);
+    test_media_player_unpaced (test_defaults_args, test_defaults_nargs);
+    test_media_player_exact_seek (test_defaults_args, test_defaults_nargs);
 
     return 0;
 }
@@ -0,0 +1,375 @@
+/*****************************************************************************
+ * mp4.c: MP4 demuxer sample tables benchmark
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/* 10 hours at 60 fps, in chunks of one second */
+#define TIMESCALE       60000
+#define FRAME_DURATION  1000
+#define SAMPLE_COUNT    (10 * 3600 * 60)
+#define CHUNK_SAMPLES   60
+
+typedef struct
+{
+    uint8_t *p;
+    size_t   i_size;
+    size_t   i_alloc;
+} buffer_t;
+
+static void Put( buffer_t *b, const void *p, size_t i_size )
+{
+    if( b->i_size + i_size > b->i_alloc )
+    {
+        b->i_alloc = ( b->i_size + i_size ) * 2;
+        b->p = realloc( b->p, b->i_alloc );
+        assert( b->p != NULL );
+    }
+    memcpy( &b->p[b->i_size], p, i_size );
+    b->i_size += i_size;
+}
+
+static void Put32( buffer_t *b, uint32_t i )
+{
+    uint8_t p[4] = { i >> 24, i >> 16, i >> 8, i };
+    Put( b, p, 4 );
+}
+
+static void Put16( buffer_t *b, uint16_t i )
+{
+    uint8_t p[2] = { i >> 8, i };
+    Put( b, p, 2 );
+}
+
+static void PutZero( buffer_t *b, size_t i_size )
+{
+    while( i_size-- )
+        Put( b, "", 1 );
+}
+
+static size_t BoxStart( buffer_t *b, const char *psz_type )
+{
+    size_t i_pos = b->i_size;
+    Put32( b, 0 );
+    Put( b, psz_type, 4 );
+    return i_pos;
+}
+
+static void BoxEnd( buffer_t *b, size_t i_pos )
+{
+    uint32_t i_size = b->i_size - i_pos;
+    uint8_t p[4] = { i_size >> 24, i_size >> 16, i_size >> 8, i_size };
+    memcpy( &b->p[i_pos], p, 4 );
+}
+
+static void PutMatrix( buffer_t *b )
+{
+    static const uint32_t matrix[9] = { 0x10000, 0, 0, 0, 0x10000, 0, 0, 0,
+                                        0x40000000 };
+    for( unsigned i = 0; i < 9; i++ )
+        Put32( b, matrix[i] );
+}
+
+static uint32_t SampleDuration( uint32_t i_sample )
+{
+    /* some jitter every 10s, so that stts has many runs */
+    return ( i_sample % 600 == 599 ) ? FRAME_DURATION + 1 : FRAME_DURATION;
+}
+
+static uint32_t SampleSize( uint32_t i_sample )
+{
+    return 4 + i_sample % 8;
+}
+
+/* Writes a single video track file, with per sample composition offsets,
+ * returns its duration in ms */
+static int64_t WriteFile( FILE *p_file )
+{
+    buffer_t b = { NULL, 0, 0 };
+    uint64_t i_duration = 0;
+    uint32_t i_mdat_size = 0;
+
+    for( uint32_t i = 0; i < SAMPLE_COUNT; i++ )
+    {
+        i_duration += SampleDuration( i );
+        i_mdat_size += SampleSize( i );
+    }
+
+    size_t ftyp = BoxStart( &b, "ftyp" );
+    Put( &b, "isom", 4 );
+    Put32( &b, 0 );
+    Put( &b, "isom", 4 );
+    BoxEnd( &b, ftyp );
+
+    size_t moov = BoxStart( &b, "moov" );
+
+    size_t mvhd = BoxStart( &b, "mvhd" );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put32( &b, 1000 );
+    Put32( &b, i_duration * 1000 / TIMESCALE );
+    Put32( &b, 0x10000 );
+    Put16( &b, 0x100 );
+    PutZero( &b, 10 );
+    PutMatrix( &b );
+    PutZero( &b, 24 );
+    Put32( &b, 2 );
+    BoxEnd( &b, mvhd );
+
+    size_t trak = BoxStart( &b, "trak" );
+
+    size_t tkhd = BoxStart( &b, "tkhd" );
+    Put32( &b, 3 );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put32( &b, 1 );
+    Put32( &b, 0 );
+    Put32( &b, i_duration * 1000 / TIMESCALE );
+    PutZero( &b, 8 );
+    PutZero( &b, 8 );
+    PutMatrix( &b );
+    Put32( &b, 320 << 16 );
+    Put32( &b, 240 << 16 );
+    BoxEnd( &b, tkhd );
+
+    size_t mdia = BoxStart( &b, "mdia" );
+
+    size_t mdhd = BoxStart( &b, "mdhd" );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put32( &b, TIMESCALE );
+    Put32( &b, i_duration );
+    Put16( &b, 0x55c4 ); /* und */
+    Put16( &b, 0 );
+    BoxEnd( &b, mdhd );
+
+    size_t hdlr = BoxStart( &b, "hdlr" );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put( &b, "vide", 4 );
+    PutZero( &b, 12 );
+    PutZero( &b, 1 );
+    BoxEnd( &b, hdlr );
+
+    size_t minf = BoxStart( &b, "minf" );
+
+    size_t vmhd = BoxStart( &b, "vmhd" );
+    Put32( &b, 1 );
+    PutZero( &b, 8 );
+    BoxEnd( &b, vmhd );
+
+    size_t dinf = BoxStart( &b, "dinf" );
+    size_t dref = BoxStart( &b, "dref" );
+    Put32( &b, 0 );
+    Put32( &b, 1 );
+    size_t url = BoxStart( &b, "url " );
+    Put32( &b, 1 );
+    BoxEnd( &b, url );
+    BoxEnd( &b, dref );
+    BoxEnd( &b, dinf );
+
+    size_t stbl = BoxStart( &b, "stbl" );
+
+    size_t stsd = BoxStart( &b, "stsd" );
+    Put32( &b, 0 );
+    Put32( &b, 1 );
+    size_t jpeg = BoxStart( &b, "jpeg" );
+    PutZero( &b, 6 );
+    Put16( &b, 1 );
+    PutZero( &b, 16 );
+    Put16( &b, 320 );
+    Put16( &b, 240 );
+    Put32( &b, 0x480000 );
+    Put32( &b, 0x480000 );
+    Put32( &b, 0 );
+    Put16( &b, 1 );
+    PutZero( &b, 32 );
+    Put16( &b, 24 );
+    Put16( &b, 0xffff );
+    BoxEnd( &b, jpeg );
+    BoxEnd( &b, stsd );
+
+    /* run length encoded durations */
+    size_t stts = BoxStart( &b, "stts" );
+    Put32( &b, 0 );
+    size_t i_stts_count = b.i_size;
+    Put32( &b, 0 );
+    uint32_t i_entries = 0;
+    for( uint32_t i = 0; i < SAMPLE_COUNT; )
+    {
+        uint32_t i_run = 1;
+        while( i + i_run < SAMPLE_COUNT &&
+               SampleDuration( i + i_run ) == SampleDuration( i ) )
+            i_run++;
+        Put32( &b, i_run );
+        Put32( &b, SampleDuration( i ) );
+        i_entries++;
+        i += i_run;
+    }
+    b.p[i_stts_count] = i_entries >> 24;
+    b.p[i_stts_count + 1] = i_entries >> 16;
+    b.p[i_stts_count + 2] = i_entries >> 8;
+    b.p[i_stts_count + 3] = i_entries;
+    BoxEnd( &b, stts );
+
+    /* I P B pattern, one run per sample */
+    size_t ctts = BoxStart( &b, "ctts" );
+    Put32( &b, 0 );
+    Put32( &b, SAMPLE_COUNT );
+    for( uint32_t i = 0; i < SAMPLE_COUNT; i++ )
+    {
+        static const uint32_t offsets[3] = { 1, 3, 0 };
+        Put32( &b, 1 );
+        Put32( &b, offsets[i % 3] * FRAME_DURATION );
+    }
+    BoxEnd( &b, ctts );
+
+    size_t stss = BoxStart( &b, "stss" );
+    Put32( &b, 0 );
+    Put32( &b, SAMPLE_COUNT / CHUNK_SAMPLES );
+    for( uint32_t i = 0; i < SAMPLE_COUNT; i += CHUNK_SAMPLES )
+        Put32( &b, i + 1 );
+    BoxEnd( &b, stss );
+
+    size_t stsc = BoxStart( &b, "stsc" );
+    Put32( &b, 0 );
+    Put32( &b, 1 );
+    Put32( &b, 1 );
+    Put32( &b, CHUNK_SAMPLES );
+    Put32( &b, 1 );
+    BoxEnd( &b, stsc );
+
+    size_t stsz = BoxStart( &b, "stsz" );
+    Put32( &b, 0 );
+    Put32( &b, 0 );
+    Put32( &b, SAMPLE_COUNT );
+    for( uint32_t i = 0; i < SAMPLE_COUNT; i++ )
+        Put32( &b, SampleSize( i ) );
+    BoxEnd( &b, stsz );
+
+    /* chunk offsets are patched once the moov size is known */
+    size_t stco = BoxStart( &b, "stco" );
+    Put32( &b, 0 );
+    Put32( &b, SAMPLE_COUNT / CHUNK_SAMPLES );
+    size_t i_stco_entries = b.i_size;
+    PutZero( &b, 4 * ( SAMPLE_COUNT / CHUNK_SAMPLES ) );
+    BoxEnd( &b, stco );
+
+    BoxEnd( &b, stbl );
+    BoxEnd( &b, minf );
+    BoxEnd( &b, mdia );
+    BoxEnd( &b, trak );
+    BoxEnd( &b, moov );
+
+    uint32_t i_offset = b.i_size + 8;
+    for( uint32_t i = 0; i < SAMPLE_COUNT; i++ )
+    {
+        if( i % CHUNK_SAMPLES == 0 )
+        {
+            uint8_t *p = &b.p[i_stco_entries + 4 * ( i / CHUNK_SAMPLES )];
+            p[0] = i_offset >> 24;
+            p[1] = i_offset >> 16;
+            p[2] = i_offset >> 8;
+            p[3] = i_offset;
+        }
+        i_offset += SampleSize( i );
+    }
+
+    Put32( &b, 8 + i_mdat_size );
+    Put( &b, "mdat", 4 );
+    assert( fwrite( b.p, 1, b.i_size, p_file ) == b.i_size );
+    free( b.p );
+
+    /* sample data is not decoded, zeroes will do */
+    uint8_t zero[4096] = { 0 };
+    for( uint32_t i_left = i_mdat_size; i_left > 0; )
+    {
+        size_t i_write = i_left < sizeof(zero) ? i_left : sizeof(zero);
+        assert( fwrite( zero, 1, i_write, p_file ) == i_write );
+        i_left -= i_write;
+    }
+
+    return i_duration * 1000 / TIMESCALE;
+}
+
+static int64_t Now( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static long MaxRSS( void )
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss;
+}
+
+static void test_mp4_open( const char **argv, int argc )
+{
+    char psz_path[] = "/tmp/vlc-test-mp4-XXXXXX";
+    int fd = mkstemp( psz_path );
+    assert( fd != -1 );
+    FILE *p_file = fdopen( fd, "wb" );
+    assert( p_file != NULL );
+
+    log( "Writing a 10 hours 60 fps file\n" );
+    int64_t i_duration = WriteFile( p_file );
+    fclose( p_file );
+
+    libvlc_instance_t *vlc = libvlc_new( argc, argv );
+    assert( vlc != NULL );
+
+    libvlc_media_t *media = libvlc_media_new_path( vlc, psz_path );
+    assert( media != NULL );
+
+    long i_rss = MaxRSS();
+    int64_t i_start = Now();
+
+    libvlc_media_parse( media );
+
+    int64_t i_time = Now() - i_start;
+    log( "Opened in %"PRId64" ms, max RSS grew by %ld KiB\n",
+         i_time / 1000, MaxRSS() - i_rss );
+
+    log( "Duration %"PRId64" ms, expected %"PRId64" ms\n",
+         libvlc_media_get_duration( media ), i_duration );
+    assert( libvlc_media_get_duration( media ) / 1000 == i_duration / 1000 );
+
+    libvlc_media_release( media );
+    libvlc_release( vlc );
+    unlink( psz_path );
+}
+
+int main( void )
+{
+    test_init();
+
+    test_mp4_open( test_defaults_args, test_defaults_nargs );
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * ts.c: MPEG-TS demuxer analysis counters test
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PACKET_SIZE     188
+#define PMT_PID         0x100
+#define PCR_PID         0x101
+
+/* One PCR every 20ms for 2s, PAT and PMT every 100ms */
+#define SLOT_DURATION   20000  /* us */
+#define SLOT_COUNT      100
+#define PSI_SLOTS       5
+
+/* Errors: a 60ms PCR gap, no PAT for 1s, a skipped PAT continuity counter */
+#define PCR_GAP_SLOT    50     /* slots 50 and 51 are missing */
+#define PAT_GAP_START   30
+#define PAT_GAP_END     75
+#define PAT_CC_SLOT     80
+
+static uint32_t Crc32( const uint8_t *p, size_t i_size )
+{
+    uint32_t i_crc = 0xffffffff;
+
+    while( i_size-- )
+    {
+        i_crc ^= (uint32_t)*p++ << 24;
+        for( int i = 0; i < 8; i++ )
+            i_crc = (i_crc << 1) ^ ((i_crc & 0x80000000) ? 0x04c11db7 : 0);
+    }
+    return i_crc;
+}
+
+static void WriteSection( FILE *p_file, uint16_t i_pid, uint8_t i_cc,
+                          const uint8_t *p_section, size_t i_size )
+{
+    uint8_t p[PACKET_SIZE];
+
+    memset( p, 0xff, sizeof(p) );
+    p[0] = 0x47;
+    p[1] = 0x40 | (i_pid >> 8); /* payload_unit_start_indicator */
+    p[2] = i_pid;
+    p[3] = 0x10 | (i_cc & 0x0f);
+    p[4] = 0; /* pointer_field */
+    memcpy( &p[5], p_section, i_size );
+
+    uint32_t i_crc = Crc32( p_section, i_size );
+    p[5 + i_size] = i_crc >> 24;
+    p[6 + i_size] = i_crc >> 16;
+    p[7 + i_size] = i_crc >> 8;
+    p[8 + i_size] = i_crc;
+
+    assert( fwrite( p, 1, sizeof(p), p_file ) == sizeof(p) );
+}
+
+static void WritePAT( FILE *p_file, uint8_t i_cc )
+{
+    static const uint8_t pat[] = {
+        0x00, 0xb0, 13,             /* table_id, section_length */
+        0x00, 0x01, 0xc1, 0x00, 0x00,
+        0x00, 0x01,                 /* program 1 */
+        0xe0 | (PMT_PID >> 8), PMT_PID & 0xff,
+    };
+    WriteSection( p_file, 0, i_cc, pat, sizeof(pat) );
+}
+
+static void WritePMT( FILE *p_file, uint8_t i_cc )
+{
+    static const uint8_t pmt[] = {
+        0x02, 0xb0, 18,             /* table_id, section_length */
+        0x00, 0x01, 0xc1, 0x00, 0x00,
+        0xe0 | (PCR_PID >> 8), PCR_PID & 0xff,
+        0xf0, 0x00,                 /* no program descriptors */
+        0x03,                       /* MPEG audio */
+        0xe0 | (PCR_PID >> 8), PCR_PID & 0xff,
+        0xf0, 0x00,
+    };
+    WriteSection( p_file, PMT_PID, i_cc, pmt, sizeof(pmt) );
+}
+
+/* Adaptation field only, continuity counter unchanged */
+static void WritePCR( FILE *p_file, int64_t i_time )
+{
+    uint8_t p[PACKET_SIZE];
+    int64_t i_base = i_time * 9 / 100; /* 90kHz */
+
+    memset( p, 0xff, sizeof(p) );
+    p[0] = 0x47;
+    p[1] = PCR_PID >> 8;
+    p[2] = PCR_PID & 0xff;
+    p[3] = 0x20;
+    p[4] = PACKET_SIZE - 5;
+    p[5] = 0x10; /* PCR_flag */
+    p[6] = i_base >> 25;
+    p[7] = i_base >> 17;
+    p[8] = i_base >> 9;
+    p[9] = i_base >> 1;
+    p[10] = (i_base << 7) | 0x7e;
+    p[11] = 0;
+
+    assert( fwrite( p, 1, sizeof(p), p_file ) == sizeof(p) );
+}
+
+static void WriteFile( FILE *p_file )
+{
+    uint8_t i_pat_cc = 0, i_pmt_cc = 0;
+
+    for( int i = 0; i < SLOT_COUNT; i++ )
+    {
+        if( i == PCR_GAP_SLOT || i == PCR_GAP_SLOT + 1 )
+            continue;
+
+        WritePCR( p_file, (int64_t)i * SLOT_DURATION );
+        if( i % PSI_SLOTS )
+            continue;
+
+        if( i <= PAT_GAP_START || i >= PAT_GAP_END )
+        {
+            if( i == PAT_CC_SLOT )
+                i_pat_cc++;
+            WritePAT( p_file, i_pat_cc++ );
+        }
+        WritePMT( p_file, i_pmt_cc++ );
+    }
+}
+
+static void test_ts_stats( const char **argv, int argc )
+{
+    char psz_path[] = "/tmp/vlc-test-ts-XXXXXX.ts";
+    int fd = mkstemps( psz_path, 3 );
+    assert( fd != -1 );
+    FILE *p_file = fdopen( fd, "wb" );
+    assert( p_file != NULL );
+
+    log( "Writing a stream with continuity, PCR and PAT errors\n" );
+    WriteFile( p_file );
+    fclose( p_file );
+
+    libvlc_instance_t *vlc = libvlc_new( argc, argv );
+    assert( vlc != NULL );
+
+    libvlc_media_t *media = libvlc_media_new_path( vlc, psz_path );
+    assert( media != NULL );
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media( media );
+    assert( mp != NULL );
+
+    libvlc_media_player_play( mp );
+    for( ;; )
+    {
+        libvlc_state_t state = libvlc_media_get_state( media );
+        if( state == libvlc_Ended || state == libvlc_Error )
+            break;
+        usleep( 10000 );
+    }
+    /* Wait for the input thread, which publishes the final counters */
+    libvlc_media_player_stop( mp );
+
+    libvlc_media_stats_t stats;
+    assert( libvlc_media_get_stats( media, &stats ) );
+
+    libvlc_media_player_release( mp );
+    libvlc_media_release( media );
+    libvlc_release( vlc );
+    unlink( psz_path );
+
+    if( stats.i_ts_packets == 0 )
+    {
+        log( "Skipped: not demuxed as a transport stream\n" );
+        exit( 77 );
+    }
+
+    log( "%d packets, %d continuity errors, %d PCR errors, "
+         "%d PAT/PMT errors\n", stats.i_ts_packets, stats.i_ts_cc_errors,
+         stats.i_ts_pcr_errors, stats.i_ts_psi_errors );
+    assert( stats.i_ts_sync_losses == 0 );
+    assert( stats.i_ts_cc_errors == 1 );
+    assert( stats.i_ts_pcr_errors == 1 );
+    assert( stats.i_ts_psi_errors == 1 );
+    assert( stats.i_ts_scrambled == 0 );
+}
+
+int main( void )
+{
+    test_init();
+
+    test_ts_stats( test_defaults_args, test_defaults_nargs );
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * ts.c: MPEG-TS muxer constant bitrate test
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define PACKET_SIZE     188
+
+/* One packet per millisecond */
+#define MUXRATE         (PACKET_SIZE * 8 * 1000)
+#define PACKET_TICKS    27000   /* 27MHz */
+#define MAX_PCR_ERROR   (27 * 500 / 1000) /* 500ns */
+
+/* MPEG-1 layer II, 128 kb/s, 48kHz: 384 bytes and 24ms per frame */
+#define FRAME_SIZE      384
+#define FRAME_COUNT     250
+
+static void WriteInput( FILE *p_file )
+{
+    uint8_t frame[FRAME_SIZE] = { 0xff, 0xfd, 0x84, 0x00 };
+
+    for( unsigned i = 0; i < FRAME_COUNT; i++ )
+        assert( fwrite( frame, 1, sizeof(frame), p_file ) == sizeof(frame) );
+}
+
+static void Run( const char *psz_file, const char *psz_dst )
+{
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    libvlc_media_t *md = libvlc_media_new_path( vlc, psz_file );
+    assert( md != NULL );
+
+    char *psz_sout;
+    assert( asprintf( &psz_sout, ":sout=#std{access=file,"
+                      "mux=ts{muxrate=%d},dst=%s}", MUXRATE, psz_dst ) != -1 );
+    libvlc_media_add_option( md, psz_sout );
+    free( psz_sout );
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media( md );
+    assert( mp != NULL );
+    libvlc_media_release( md );
+
+    libvlc_media_player_play( mp );
+
+    libvlc_state_t state;
+    do
+    {
+        usleep( 10000 );
+        state = libvlc_media_player_get_state( mp );
+    }
+    while( state != libvlc_Ended && state != libvlc_Error );
+
+    libvlc_media_player_stop( mp );
+    libvlc_media_player_release( mp );
+    libvlc_release( vlc );
+}
+
+static int64_t GetPCR( const uint8_t *p )
+{
+    if( !(p[3] & 0x20) || p[4] < 7 || !(p[5] & 0x10) )
+        return -1;
+
+    int64_t i_base = ((int64_t)p[6] << 25) | (p[7] << 17) | (p[8] << 9) |
+                     (p[9] << 1) | (p[10] >> 7);
+    return i_base * 300 + (((p[10] & 0x01) << 8) | p[11]);
+}
+
+static void Check( const uint8_t *p, size_t i_size )
+{
+    assert( i_size % PACKET_SIZE == 0 );
+
+    const size_t i_packets = i_size / PACKET_SIZE;
+    int64_t i_first_pcr = -1, i_second_pcr = -1;
+    size_t i_first = 0, i_second = 0;
+    unsigned i_pcrs = 0, i_seconds = 0;
+    int64_t i_error_max = 0;
+
+    for( size_t i = 0; i < i_packets; i++ )
+    {
+        const uint8_t *p_pkt = &p[i * PACKET_SIZE];
+        assert( p_pkt[0] == 0x47 );
+
+        int64_t i_pcr = GetPCR( p_pkt );
+        if( i_pcr < 0 )
+            continue;
+        i_pcrs++;
+
+        if( i_first_pcr < 0 )
+        {
+            i_first_pcr = i_second_pcr = i_pcr;
+            i_first = i_second = i;
+            continue;
+        }
+
+        /* The PCR must match the byte position at the multiplex rate */
+        int64_t i_error = llabs( i_pcr - i_first_pcr -
+                                 (int64_t)(i - i_first) * PACKET_TICKS );
+        if( i_error > i_error_max )
+            i_error_max = i_error;
+        assert( i_error <= MAX_PCR_ERROR );
+
+        /* Packets per second of PCR time */
+        if( i_pcr - i_second_pcr >= 1000 * PACKET_TICKS )
+        {
+            int64_t i_count = i - i_second;
+            int64_t i_expected = (i_pcr - i_second_pcr) / PACKET_TICKS;
+            assert( llabs( i_count - i_expected ) <= 1 );
+            i_second_pcr = i_pcr;
+            i_second = i;
+            i_seconds++;
+        }
+    }
+
+    log( "%zu packets, %u PCRs over %u seconds, PCR error up to %"PRId64
+         " ns\n", i_packets, i_pcrs, i_seconds, i_error_max * 1000 / 27 );
+    assert( i_seconds >= FRAME_COUNT * 24 / 1000 - 2 );
+}
+
+int main( void )
+{
+    test_init();
+
+    char file[] = "/tmp/vlc_mux_tsXXXXXX.mp2";
+    int fd = mkstemps( file, 4 );
+    assert( fd != -1 );
+    FILE *p_file = fdopen( fd, "wb" );
+    assert( p_file != NULL );
+    WriteInput( p_file );
+    fclose( p_file );
+
+    char dst[] = "/tmp/vlc_mux_tsXXXXXX.ts";
+    fd = mkstemps( dst, 3 );
+    assert( fd != -1 );
+    close( fd );
+
+    log( "Muxing at %d bits/s\n", MUXRATE );
+    Run( file, dst );
+    unlink( file );
+
+    struct stat st;
+    assert( stat( dst, &st ) == 0 );
+    if( st.st_size == 0 )
+    {
+        log( "Skipped: no TS muxer\n" );
+        unlink( dst );
+        return 77;
+    }
+
+    uint8_t *p = malloc( st.st_size );
+    assert( p != NULL );
+    p_file = fopen( dst, "rb" );
+    assert( p_file != NULL );
+    assert( fread( p, 1, st.st_size, p_file ) == (size_t)st.st_size );
+    fclose( p_file );
+    unlink( dst );
+
+    Check( p, st.st_size );
+    free( p );
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * transcode.c: transcode branches of a duplicate sharing their decoder
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define FRAMES 25
+#define WIDTH  176
+#define HEIGHT 144
+
+/* The first branch encodes on a thread: its pictures go through a queue */
+#define BRANCH_FULL "transcode{vcodec=png,threads=2}"
+#define BRANCH_HALF "transcode{vcodec=png,width=88,height=72}"
+
+static atomic_uint shared;
+
+static void Log( void *opaque, int level, const libvlc_log_t *ctx,
+                 const char *fmt, va_list ap )
+{
+    char psz_msg[256];
+
+    (void)opaque; (void)level; (void)ctx;
+    vsnprintf( psz_msg, sizeof (psz_msg), fmt, ap );
+    if( !strncmp( psz_msg, "sharing decoder", 15 ) )
+        atomic_fetch_add( &shared, 1 );
+}
+
+static void Run( const char *psz_file, const char *psz_sout )
+{
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+    libvlc_log_set( vlc, Log, NULL );
+
+    libvlc_media_t *md = libvlc_media_new_path( vlc, psz_file );
+    assert( md != NULL );
+    libvlc_media_add_option( md, ":rawvid-fps=25" );
+    libvlc_media_add_option( md, ":rawvid-width=176" );
+    libvlc_media_add_option( md, ":rawvid-height=144" );
+    /* The PNG encoder takes RGB: no chroma conversion in the full branch */
+    libvlc_media_add_option( md, ":rawvid-chroma=RV24" );
+    libvlc_media_add_option( md, psz_sout );
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media( md );
+    assert( mp != NULL );
+    libvlc_media_release( md );
+
+    libvlc_media_player_play( mp );
+
+    /* Transcoding to files is not paced: this is well within the alarm */
+    int64_t start = libvlc_clock();
+    libvlc_state_t state;
+    do
+    {
+        usleep( 10000 );
+        state = libvlc_media_player_get_state( mp );
+    }
+    while( state != libvlc_Ended && state != libvlc_Error &&
+           libvlc_clock() - start < 3000000 );
+    assert( state == libvlc_Ended );
+
+    libvlc_media_player_stop( mp );
+    libvlc_media_player_release( mp );
+    libvlc_release( vlc );
+}
+
+static char *Output( const char *psz_branch, const char *psz_dst )
+{
+    char *psz;
+
+    assert( asprintf( &psz, "%s:std{access=file,mux=raw,dst=%s}",
+                      psz_branch, psz_dst ) != -1 );
+    return psz;
+}
+
+static uint8_t *Load( const char *psz_dst, size_t *pi_size )
+{
+    struct stat st;
+    FILE *f = fopen( psz_dst, "rb" );
+
+    assert( f != NULL );
+    assert( fstat( fileno( f ), &st ) == 0 );
+    uint8_t *p = malloc( st.st_size );
+    assert( p != NULL );
+    assert( fread( p, 1, st.st_size, f ) == (size_t)st.st_size );
+    fclose( f );
+    unlink( psz_dst );
+
+    *pi_size = st.st_size;
+    return p;
+}
+
+static unsigned CountPNG( const uint8_t *p, size_t i_size )
+{
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    unsigned i_count = 0;
+
+    for( size_t i = 0; i + sizeof (sig) <= i_size; i++ )
+        if( !memcmp( &p[i], sig, sizeof (sig) ) )
+            i_count++;
+    return i_count;
+}
+
+static void Compare( const char *psz_dst, const char *psz_ref )
+{
+    size_t i_size, i_ref;
+    uint8_t *p = Load( psz_dst, &i_size ), *p_ref = Load( psz_ref, &i_ref );
+
+    assert( CountPNG( p, i_size ) == FRAMES );
+    assert( i_size == i_ref );
+    assert( !memcmp( p, p_ref, i_size ) );
+    free( p );
+    free( p_ref );
+}
+
+int main( void )
+{
+    test_init();
+
+    char file[] = "/tmp/vlc_transcodeXXXXXX.yuv";
+    int fd = mkstemps( file, 4 );
+    assert( fd != -1 );
+
+    /* Every frame differs, so that mixed up outputs cannot go unnoticed */
+    static uint8_t frame[WIDTH * HEIGHT * 3];
+    for( unsigned i = 0; i < FRAMES; i++ )
+    {
+        for( unsigned j = 0; j < WIDTH * HEIGHT; j++ )
+        {
+            frame[3 * j] = 8 * i;
+            frame[3 * j + 1] = 255 - 8 * i;
+            frame[3 * j + 2] = j / WIDTH;
+        }
+        assert( write( fd, frame, sizeof (frame) ) == sizeof (frame) );
+    }
+    close( fd );
+
+    char full[] = "/tmp/vlc_transcode_fullXXXXXX";
+    char half[] = "/tmp/vlc_transcode_halfXXXXXX";
+    char full_ref[] = "/tmp/vlc_transcode_fullrefXXXXXX";
+    char half_ref[] = "/tmp/vlc_transcode_halfrefXXXXXX";
+    char *ppsz_tmp[] = { full, half, full_ref, half_ref };
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        fd = mkstemp( ppsz_tmp[i] );
+        assert( fd != -1 );
+        close( fd );
+    }
+
+    /* Both branches of the duplicate share one decoder... */
+    char *psz_full = Output( BRANCH_FULL, full );
+    char *psz_half = Output( BRANCH_HALF, half );
+    char *psz_sout;
+    assert( asprintf( &psz_sout, ":sout=#duplicate{dst=\"%s\",dst=\"%s\"}",
+                      psz_full, psz_half ) != -1 );
+    log( "Testing shared decoders with %s\n", psz_sout );
+    Run( file, psz_sout );
+    assert( atomic_load( &shared ) == 1 );
+    free( psz_sout );
+    free( psz_half );
+    free( psz_full );
+
+    /* ...and produce the same output as when transcoding on their own */
+    psz_full = Output( BRANCH_FULL, full_ref );
+    assert( asprintf( &psz_sout, ":sout=#%s", psz_full ) != -1 );
+    Run( file, psz_sout );
+    free( psz_sout );
+    free( psz_full );
+
+    psz_half = Output( BRANCH_HALF, half_ref );
+    assert( asprintf( &psz_sout, ":sout=#%s", psz_half ) != -1 );
+    Run( file, psz_sout );
+    free( psz_sout );
+    free( psz_half );
+    assert( atomic_load( &shared ) == 1 );
+
+    Compare( full, full_ref );
+    Compare( half, half_ref );
+
+    unlink( file );
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * clock.c: test the input clock pts delay catch-up
+ *****************************************************************************
+ * Copyright (C) 2015 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include "../src/input/clock.c"
+
+/* The clock includes config.h again, which disables the assertions */
+#undef NDEBUG
+#include <assert.h>
+
+/* Clock references of a live stream, every 100 ms */
+#define PCR_PERIOD  (CLOCK_FREQ / 10)
+#define PTS_DELAY   (CLOCK_FREQ)
+
+static mtime_t i_stream = VLC_TS_0;
+static mtime_t i_system = 10 * CLOCK_FREQ;
+
+/* Feeds the references of the given duration, arriving i_late after their
+ * deadline (or before it if negative) */
+static bool Feed( input_clock_t *cl, mtime_t i_duration, mtime_t i_late )
+{
+    bool b_late = false;
+
+    for( mtime_t i = 0; i < i_duration; i += PCR_PERIOD )
+    {
+        bool b;
+
+        input_clock_Update( cl, NULL, &b, false, false, i_stream,
+                            i_system + i_late );
+        b_late |= b;
+        i_stream += PCR_PERIOD;
+        i_system += PCR_PERIOD;
+    }
+    return b_late;
+}
+
+static mtime_t PtsDelay( input_clock_t *cl )
+{
+    mtime_t i_origin, i_delay;
+
+    input_clock_GetSystemOrigin( cl, &i_origin, &i_delay );
+    return i_delay;
+}
+
+int main( void )
+{
+    test_init();
+
+    input_clock_t *cl = input_clock_New( INPUT_RATE_DEFAULT );
+    assert( cl != NULL );
+    input_clock_SetJitter( cl, PTS_DELAY, 40 );
+
+    /* References on time leave the whole pts delay to spare */
+    assert( !Feed( cl, CLOCK_FREQ, 0 ) );
+    assert( input_clock_GetSpareDelay( cl ) == PTS_DELAY );
+    /* Nothing received since */
+    assert( input_clock_GetSpareDelay( cl ) == 0 );
+    assert( PtsDelay( cl ) == PTS_DELAY );
+
+    /* A slewed reduction shrinks the pts delay by 8/256 of the time played */
+    log( "Slewing the pts delay down by 500 ms\n" );
+    assert( input_clock_ReduceDelay( cl, PTS_DELAY / 2, false )
+            == PTS_DELAY / 2 );
+    assert( PtsDelay( cl ) == PTS_DELAY );
+
+    mtime_t i_delay = PTS_DELAY;
+    for( int i = 0; i < 4; i++ )
+    {
+        assert( !Feed( cl, CLOCK_FREQ, 0 ) );
+        const mtime_t i_new = PtsDelay( cl );
+        assert( i_new < i_delay );
+        assert( i_new >= PTS_DELAY / 2 );
+        assert( i_delay - i_new == CLOCK_FREQ * CR_CATCHUP_RATE / 256 );
+        i_delay = i_new;
+    }
+
+    /* ...and stops at the target */
+    assert( !Feed( cl, 20 * CLOCK_FREQ, 0 ) );
+    assert( PtsDelay( cl ) == PTS_DELAY / 2 );
+    input_clock_GetSpareDelay( cl );
+
+    /* An immediate reduction is applied at once */
+    log( "Cutting the pts delay by 200 ms\n" );
+    assert( input_clock_ReduceDelay( cl, CLOCK_FREQ / 5, true )
+            == PTS_DELAY / 2 - CLOCK_FREQ / 5 );
+    assert( PtsDelay( cl ) == PTS_DELAY / 2 - CLOCK_FREQ / 5 );
+
+    /* A late reference cancels the catch-up in progress: as the es_out does,
+     * raise the pts delay to the jitter once references are late */
+    log( "Late references during a catch-up\n" );
+    i_delay = PtsDelay( cl );
+    assert( input_clock_ReduceDelay( cl, CLOCK_FREQ / 10, false )
+            == i_delay - CLOCK_FREQ / 10 );
+    assert( !Feed( cl, CLOCK_FREQ, 0 ) );
+    assert( PtsDelay( cl ) < i_delay );
+
+    const mtime_t i_late = CLOCK_FREQ / 20;
+    assert( Feed( cl, 3 * PCR_PERIOD, i_delay + i_late ) );
+    const mtime_t i_jitter = input_clock_GetJitter( cl );
+    assert( i_jitter > PtsDelay( cl ) );
+    input_clock_SetJitter( cl, i_jitter, 40 );
+    assert( PtsDelay( cl ) == i_jitter );
+
+    /* The pts delay no longer shrinks */
+    Feed( cl, 5 * CLOCK_FREQ, i_delay + i_late );
+    assert( PtsDelay( cl ) == i_jitter );
+
+    input_clock_Delete( cl );
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * block_helper.c: test block bytestream startcode search
+ *****************************************************************************
+ * Copyright (C) 2015 VideoLAN and authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_block_helper.h>
+
+static const uint8_t annexb[] = { 0x00, 0x00, 0x01 };
+static const uint8_t mpgv[] = { 0x00, 0x00, 0x01, 0xB3 };
+static const uint8_t dirac[] = { 'B', 'B', 'C', 'D' };
+
+static const struct
+{
+    const uint8_t *p_startcode;
+    int i_length;
+} startcodes[] = {
+    { annexb, sizeof(annexb) },
+    { mpgv, sizeof(mpgv) },
+    { dirac, sizeof(dirac) },
+};
+
+/* Fills with random bytes, many zeros, and a few startcodes */
+static void FillBuffer( uint8_t *p, size_t i_size, const uint8_t *p_startcode,
+                        int i_length )
+{
+    for( size_t i = 0; i < i_size; i++ )
+        p[i] = (rand() % 4) ? rand() : 0;
+
+    for( size_t i = 0; i < i_size / 64; i++ )
+    {
+        size_t i_pos = rand() % i_size;
+        for( int j = 0; j < i_length && i_pos + j < i_size; j++ )
+            p[i_pos + j] = p_startcode[j];
+    }
+}
+
+static void PushBuffer( block_bytestream_t *p_bs, const uint8_t *p,
+                        size_t i_size, size_t i_max_block )
+{
+    while( i_size > 0 )
+    {
+        size_t i_block = 1 + rand() % i_max_block;
+        if( i_block > i_size )
+            i_block = i_size;
+
+        block_t *p_block = block_Alloc( i_block );
+        assert( p_block != NULL );
+        memcpy( p_block->p_buffer, p, i_block );
+        block_BytestreamPush( p_bs, p_block );
+        p += i_block;
+        i_size -= i_block;
+    }
+}
+
+static bool FindReference( const uint8_t *p, size_t i_size, size_t *pi_offset,
+                           const uint8_t *p_startcode, int i_length )
+{
+    for( size_t i = *pi_offset; i + i_length <= i_size; i++ )
+    {
+        if( !memcmp( &p[i], p_startcode, i_length ) )
+        {
+            *pi_offset = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_FindStartcode( void )
+{
+    uint8_t buf[4096];
+
+    for( unsigned i = 0; i < ARRAY_SIZE(startcodes); i++ )
+    {
+        const uint8_t *p_startcode = startcodes[i].p_startcode;
+        const int i_length = startcodes[i].i_length;
+
+        for( int i_run = 0; i_run < 200; i_run++ )
+        {
+            size_t i_size = 1 + rand() % sizeof(buf);
+            FillBuffer( buf, i_size, p_startcode, i_length );
+
+            /* Small blocks, so that startcodes straddle block boundaries */
+            block_bytestream_t bs;
+            block_BytestreamInit( &bs );
+            PushBuffer( &bs, buf, i_size, (i_run & 1) ? 5 : 700 );
+
+            size_t i_ref = 0, i_offset = 0;
+            for( ;; )
+            {
+                bool b_ref = FindReference( buf, i_size, &i_ref,
+                                            p_startcode, i_length );
+                int i_ret = block_FindStartcodeFromOffset( &bs, &i_offset,
+                                                           p_startcode, i_length );
+                assert( b_ref == (i_ret == VLC_SUCCESS) );
+                if( !b_ref )
+                    break;
+                assert( i_offset == i_ref );
+                i_ref++;
+                i_offset++;
+            }
+            block_BytestreamRelease( &bs );
+        }
+    }
+}
+
+/* Throughput on a high bitrate like stream: few startcodes, and zero bytes
+ * only from emulation prevention */
+static void bench_FindStartcode( void )
+{
+    const size_t i_size = 16 << 20;
+    uint8_t *p = malloc( i_size );
+    assert( p != NULL );
+
+    for( size_t i = 0; i < i_size; i++ )
+        p[i] = rand();
+    for( size_t i = 2; i < i_size; i++ )
+        if( p[i - 2] == 0 && p[i - 1] == 0 && p[i] <= 3 )
+            p[i] = 3;
+    for( size_t i = 0; i + 3 < i_size; i += 256 << 10 )
+        memcpy( &p[i], annexb, sizeof(annexb) );
+
+    block_bytestream_t bs;
+    block_BytestreamInit( &bs );
+    PushBuffer( &bs, p, i_size, 64 << 10 );
+
+    mtime_t i_start = mdate();
+    size_t i_offset = 0;
+    unsigned i_count = 0;
+    while( block_FindStartcodeFromOffset( &bs, &i_offset, annexb,
+                                          sizeof(annexb) ) == VLC_SUCCESS )
+    {
+        i_count++;
+        i_offset++;
+    }
+    mtime_t i_duration = mdate() - i_start;
+
+    log( "Found %u startcodes in %zu MiB in %"PRId64" us (%"PRId64" MiB/s)\n",
+         i_count, i_size >> 20, i_duration,
+         (int64_t)(i_size >> 20) * CLOCK_FREQ / (i_duration + 1) );
+    assert( i_count == (i_size + (256 << 10) - 4) / (256 << 10) );
+
+    block_BytestreamRelease( &bs );
+    free( p );
+}
+
+int main( void )
+{
+    srand( 42 );
+
+    log( "Testing block_FindStartcodeFromOffset()\n" );
+    test_FindStartcode();
+    log( "Benchmarking block_FindStartcodeFromOffset()\n" );
+    bench_FindStartcode();
+
+    return 0;
+}
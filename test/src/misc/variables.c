@@ -382,6 +382,114 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOVAR );
 }
 
+static void *reader( void *data )
+{
+    vlc_object_t *p_obj = data;
+
+    for( unsigned i = 0; i < 100000; i++ )
+    {
+        int64_t i_val = var_GetInteger( p_obj, "bla" );
+        assert( i_val == 0 || i_val == 42 );
+        char *psz_val = var_GetString( p_obj, "foo" );
+        assert( psz_val == NULL || !strcmp( psz_val, "" )
+             || !strcmp( psz_val, "bar" ) );
+        free( psz_val );
+    }
+    return NULL;
+}
+
+static void test_concurrency( libvlc_int_t *p_libvlc )
+{
+    vlc_thread_t threads[2];
+
+    for( unsigned i = 0; i < ARRAY_SIZE(threads); i++ )
+        assert( vlc_clone( &threads[i], reader, p_libvlc,
+                           VLC_THREAD_PRIORITY_LOW ) == 0 );
+
+    /* Readers see each variable either missing or fully set */
+    for( unsigned i = 0; i < 2000; i++ )
+    {
+        char psz_name[16];
+
+        var_Create( p_libvlc, "bla", VLC_VAR_INTEGER );
+        var_SetInteger( p_libvlc, "bla", 42 );
+        var_Create( p_libvlc, "foo", VLC_VAR_STRING );
+        var_SetString( p_libvlc, "foo", "bar" );
+
+        /* Grow and rehash the table */
+        sprintf( psz_name, "tmp%u", i % 100 );
+        var_Create( p_libvlc, psz_name, VLC_VAR_BOOL );
+        if( i % 100 == 99 )
+            for( unsigned j = 0; j < 100; j++ )
+            {
+                sprintf( psz_name, "tmp%u", j );
+                var_Destroy( p_libvlc, psz_name );
+            }
+
+        var_SetInteger( p_libvlc, "bla", 0 );
+        var_Destroy( p_libvlc, "bla" );
+        var_Destroy( p_libvlc, "foo" );
+    }
+
+    for( unsigned i = 0; i < ARRAY_SIZE(threads); i++ )
+        vlc_join( threads[i], NULL );
+}
+
+static void test_bench( libvlc_int_t *p_libvlc )
+{
+    const unsigned i_count = 1000000;
+    vlc_object_t *p_parent = VLC_OBJECT(p_libvlc);
+    vlc_object_t *pp_objs[3];
+
+    /* Such as a filter of a decoder of an input */
+    for( unsigned i = 0; i < ARRAY_SIZE(pp_objs); i++ )
+    {
+        pp_objs[i] = vlc_object_create( p_parent, sizeof( *pp_objs[i] ) );
+        assert( pp_objs[i] != NULL );
+        for( unsigned j = 0; j < 20; j++ )
+        {
+            char psz_name[16];
+            sprintf( psz_name, "bench-%u-%u", i, j );
+            var_Create( pp_objs[i], psz_name, VLC_VAR_INTEGER );
+        }
+        p_parent = pp_objs[i];
+    }
+    var_Create( p_libvlc, "bench", VLC_VAR_INTEGER );
+    var_SetInteger( p_libvlc, "bench", 1 );
+
+    mtime_t i_start = mdate();
+    int64_t i_sum = 0;
+    for( unsigned i = 0; i < i_count; i++ )
+        i_sum += var_GetInteger( p_libvlc, "bench" );
+    assert( i_sum == i_count );
+    log( "var_GetInteger: %"PRId64" ns\n",
+         (mdate() - i_start) * 1000 / i_count );
+
+    i_start = mdate();
+    i_sum = 0;
+    for( unsigned i = 0; i < i_count; i++ )
+        i_sum += var_InheritInteger( pp_objs[2], "bench" );
+    assert( i_sum == i_count );
+    log( "var_InheritInteger from 3 levels: %"PRId64" ns\n",
+         (mdate() - i_start) * 1000 / i_count );
+
+    i_start = mdate();
+    for( unsigned i = 0; i < i_count / 10; i++ )
+        i_sum += var_InheritInteger( pp_objs[2], "verbose" );
+    log( "var_InheritInteger from the configuration: %"PRId64" ns\n",
+         (mdate() - i_start) * 10000 / i_count );
+
+    i_start = mdate();
+    for( unsigned i = 0; i < i_count / 10; i++ )
+        free( var_InheritString( pp_objs[2], "vout" ) );
+    log( "var_InheritString from the configuration: %"PRId64" ns\n",
+         (mdate() - i_start) * 10000 / i_count );
+
+    var_Destroy( p_libvlc, "bench" );
+    for( unsigned i = ARRAY_SIZE(pp_objs); i-- > 0; )
+        vlc_object_release( pp_objs[i] );
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -416,6 +524,12 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    log( "Testing concurrent accesses\n" );
+    test_concurrency( p_libvlc );
+
+    log( "Benchmarking\n" );
+    test_bench( p_libvlc );
 }
 
 
@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * tree.c: test and benchmark the playlist tree operations
+ *****************************************************************************
+ * Copyright (C) 2015 VideoLAN and authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+#include "../src/libvlc.h"
+
+#include <vlc_common.h>
+#include <vlc_playlist.h>
+#include <vlc_input_item.h>
+#include <vlc_rand.h>
+#include <vlc_charset.h>
+
+#include <ctype.h>
+
+#define ITEMS 100000
+
+static input_item_t *inputs[ITEMS];
+static playlist_item_t *items[ITEMS];
+
+static mtime_t i_start;
+
+static void bench_start( void )
+{
+    i_start = mdate();
+}
+
+static void bench_end( const char *psz_what, unsigned i_count )
+{
+    log( "%s: %u operations in %"PRId64" ms\n", psz_what, i_count,
+         (mdate() - i_start) / 1000 );
+}
+
+/* Checks that the children of the node are the expected items */
+static void check_node( playlist_item_t *p_node, unsigned i_count )
+{
+    assert( p_node->i_children == (int)i_count );
+    for( int i = 0; i < p_node->i_children; i++ )
+        assert( p_node->pp_children[i]->p_parent == p_node );
+}
+
+/* Checks the live search flags against a plain search */
+static void check_search( playlist_item_t *p_node, const char *psz_query )
+{
+    for( int i = 0; i < p_node->i_children; i++ )
+    {
+        input_item_t *p_input = p_node->pp_children[i]->p_input;
+        char *ppsz_fields[] = {
+            input_item_GetTitleFbName( p_input ),
+            input_item_GetArtist( p_input ),
+            input_item_GetAlbum( p_input ),
+        };
+        bool b_match = false;
+        for( unsigned j = 0; j < ARRAY_SIZE(ppsz_fields); j++ )
+        {
+            if( ppsz_fields[j] && vlc_strcasestr( ppsz_fields[j], psz_query ) )
+                b_match = true;
+            free( ppsz_fields[j] );
+        }
+        assert( b_match ==
+                !( p_node->pp_children[i]->i_flags & PLAYLIST_DBL_FLAG ) );
+    }
+}
+
+static void test_tree( playlist_t *p_playlist )
+{
+    PL_LOCK;
+    playlist_item_t *p_node = playlist_NodeCreate( p_playlist, "bench",
+                                                   p_playlist->p_playing,
+                                                   PLAYLIST_END, 0, NULL );
+    assert( p_node != NULL );
+
+    /* Build */
+    for( unsigned i = 0; i < ITEMS; i++ )
+    {
+        char psz_uri[32], psz_name[32];
+        sprintf( psz_uri, "file:///bench/%u.ogg", i );
+        sprintf( psz_name, "%08x", (unsigned)vlc_mrand48() );
+        inputs[i] = input_item_New( psz_uri, psz_name );
+        assert( inputs[i] != NULL );
+
+        char psz_meta[32];
+        sprintf( psz_meta, "artist %04u", i % 1000 );
+        input_item_SetArtist( inputs[i], psz_meta );
+        sprintf( psz_meta, "album %04u", i % 5000 );
+        input_item_SetAlbum( inputs[i], psz_meta );
+        sprintf( psz_meta, "%u", i % 20 );
+        input_item_SetTrackNumber( inputs[i], psz_meta );
+        sprintf( psz_meta, "genre %u", i % 30 );
+        input_item_SetGenre( inputs[i], psz_meta );
+        input_item_SetDuration( inputs[i], (mtime_t)(i % 600) * CLOCK_FREQ );
+    }
+
+    bench_start();
+    for( unsigned i = 0; i < ITEMS; i++ )
+    {
+        /* Half of them at the beginning */
+        items[i] = playlist_NodeAddInput( p_playlist, inputs[i], p_node,
+                                          PLAYLIST_APPEND,
+                                          (i & 1) ? 0 : PLAYLIST_END,
+                                          pl_Locked );
+        assert( items[i] != NULL );
+    }
+    bench_end( "Add", ITEMS );
+    check_node( p_node, ITEMS );
+
+    /* Lookup */
+    bench_start();
+    for( unsigned i = 0; i < ITEMS; i++ )
+        assert( playlist_ItemGetByInput( p_playlist, inputs[i] ) == items[i] );
+    bench_end( "Lookup by input", ITEMS );
+
+    /* Sort */
+    static const struct
+    {
+        int i_mode;
+        const char *psz_what;
+    } modes[] = {
+        { SORT_ID, "Sort by id" },
+        { SORT_TITLE, "Sort by title" },
+        { SORT_TITLE_NODES_FIRST, "Sort by title, nodes first" },
+        { SORT_ARTIST, "Sort by artist" },
+        { SORT_GENRE, "Sort by genre" },
+        { SORT_DURATION, "Sort by duration" },
+        { SORT_TITLE_NUMERIC, "Sort by numeric title" },
+        { SORT_ALBUM, "Sort by album" },
+        { SORT_TRACK_NUMBER, "Sort by track number" },
+        { SORT_DESCRIPTION, "Sort by description" },
+        { SORT_RATING, "Sort by rating" },
+        { SORT_URI, "Sort by URI" },
+        { SORT_RANDOM, "Shuffle" },
+    };
+    for( unsigned i = 0; i < ARRAY_SIZE(modes); i++ )
+    {
+        bench_start();
+        assert( playlist_RecursiveNodeSort( p_playlist, p_node,
+                                            modes[i].i_mode,
+                                            ORDER_NORMAL ) == VLC_SUCCESS );
+        bench_end( modes[i].psz_what, ITEMS );
+        check_node( p_node, ITEMS );
+    }
+
+    playlist_RecursiveNodeSort( p_playlist, p_node, SORT_ARTIST, ORDER_NORMAL );
+    for( int i = 1; i < p_node->i_children; i++ )
+    {
+        input_item_t *p_prev = p_node->pp_children[i - 1]->p_input;
+        input_item_t *p_cur = p_node->pp_children[i]->p_input;
+        char *psz_prev = input_item_GetArtist( p_prev );
+        char *psz_cur = input_item_GetArtist( p_cur );
+        int i_cmp = strcmp( psz_prev, psz_cur );
+        assert( i_cmp <= 0 );
+        free( psz_prev );
+        free( psz_cur );
+        if( i_cmp == 0 )
+        {
+            psz_prev = input_item_GetAlbum( p_prev );
+            psz_cur = input_item_GetAlbum( p_cur );
+            assert( strcmp( psz_prev, psz_cur ) <= 0 );
+            free( psz_prev );
+            free( psz_cur );
+        }
+    }
+
+    playlist_RecursiveNodeSort( p_playlist, p_node, SORT_TITLE, ORDER_NORMAL );
+    for( int i = 1; i < p_node->i_children; i++ )
+        assert( strcmp( p_node->pp_children[i - 1]->p_input->psz_name,
+                        p_node->pp_children[i]->p_input->psz_name ) <= 0 );
+
+    /* Live search, typed one character at a time */
+    char psz_query[9];
+    strcpy( psz_query, inputs[ITEMS / 2]->psz_name );
+    for( char *p = psz_query; *p; p++ )
+        *p = toupper( (unsigned char)*p );
+
+    bench_start();
+    for( unsigned i = 1; i <= 8; i++ )
+    {
+        char psz_typed[9];
+        memcpy( psz_typed, psz_query, i );
+        psz_typed[i] = '\0';
+        playlist_LiveSearchUpdate( p_playlist, p_node, psz_typed, true );
+        check_search( p_node, psz_typed );
+    }
+    bench_end( "Live search", 8 );
+
+    /* Meta changes are indexed */
+    PL_UNLOCK;
+    input_item_SetTitle( inputs[0], "Needle in a haystack" );
+    PL_LOCK;
+    playlist_LiveSearchUpdate( p_playlist, p_node, "HAYST", true );
+    check_search( p_node, "HAYST" );
+    assert( !( items[0]->i_flags & PLAYLIST_DBL_FLAG ) );
+    playlist_LiveSearchUpdate( p_playlist, p_node, "", true );
+
+    /* Move */
+    bench_start();
+    for( unsigned i = 0; i < ITEMS / 10; i++ )
+    {
+        playlist_item_t *p_item = items[(unsigned)vlc_mrand48() % ITEMS];
+        int i_pos = (unsigned)vlc_mrand48() % p_node->i_children;
+        assert( playlist_TreeMove( p_playlist, p_item, p_node, i_pos ) == 0 );
+    }
+    bench_end( "Move", ITEMS / 10 );
+    check_node( p_node, ITEMS );
+
+    /* Delete */
+    bench_start();
+    for( unsigned i = 0; i < ITEMS; i += 2 )
+        assert( playlist_DeleteFromInput( p_playlist, inputs[i],
+                                          pl_Locked ) == 0 );
+    bench_end( "Delete", ITEMS / 2 );
+    check_node( p_node, ITEMS / 2 );
+    for( unsigned i = 0; i < ITEMS; i++ )
+        assert( ( playlist_ItemGetByInput( p_playlist, inputs[i] ) != NULL )
+                == ( i & 1 ) );
+
+    bench_start();
+    playlist_NodeDelete( p_playlist, p_node, true, false );
+    bench_end( "Clear", ITEMS / 2 );
+    PL_UNLOCK;
+
+    for( unsigned i = 0; i < ITEMS; i++ )
+        input_item_Release( inputs[i] );
+}
+
+int main( void )
+{
+    static const char *args[] = {
+        "-v", "--ignore-config", "--no-media-library", "--no-auto-preparse",
+    };
+
+    test_init();
+    alarm( 60 );
+
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( p_vlc != NULL );
+    assert( libvlc_add_intf( p_vlc, "dummy" ) == 0 );
+
+    playlist_t *p_playlist = libvlc_priv( p_vlc->p_libvlc_int )->playlist;
+    assert( p_playlist != NULL );
+
+    log( "Testing the playlist tree with %u items\n", ITEMS );
+    test_tree( p_playlist );
+
+    libvlc_release( p_vlc );
+    return 0;
+}